@@ -33,4 +33,22 @@ void cpu_flush_tlb_all(void);
 /* Get current CPU ID (for SMP, returns 0 for uniprocessor). */
 unsigned cpu_id(void);
 
+/* Read the free-running cycle counter (RDTSC on i386, RDCYCLE on
+ * riscv64).  Only differences between two readings are meaningful;
+ * the counter is not serializing, so it measures code spans of a few
+ * hundred cycles or more reasonably well but not single instructions. */
+static inline uint64_t cpu_cycles(void) {
+#if defined(__i386__)
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+#elif defined(__riscv)
+  uint64_t cycles;
+  asm volatile("rdcycle %0" : "=r"(cycles));
+  return cycles;
+#else
+  return 0;
+#endif
+}
+
 #endif /* ARCH_COMMON_CPU_H */
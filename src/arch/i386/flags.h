@@ -5,6 +5,8 @@
 
 /* EFLAGS Register. */
 #define FLAG_MBS 0x00000002 /* Must be set. */
+#define FLAG_TF 0x00000100  /* Trap Flag. */
 #define FLAG_IF 0x00000200  /* Interrupt Flag. */
+#define FLAG_NT 0x00004000  /* Nested Task. */
 
 #endif /* ARCH_I386_FLAGS_H */
@@ -10,12 +10,22 @@
 #include "threads/loader.h"
 
 /* Segment selectors.
-   More selectors are defined by the loader in loader.h. */
+   More selectors are defined by the loader in loader.h.
+
+   SYSEXIT derives the user selectors from the kernel code
+   selector, so SEL_KCSEG, SEL_KDSEG, SEL_UCSEG, and SEL_UDSEG
+   must stay consecutive and in this order. */
 #define SEL_UCSEG 0x1B /* User code selector. */
 #define SEL_UDSEG 0x23 /* User data selector. */
 #define SEL_TSS 0x28   /* Task-state segment. */
-#define SEL_CNT 6      /* Number of segments. */
+#define SEL_UTSEG 0x33 /* User thread pointer selector (GS). */
+#define SEL_CNT 7      /* Number of segments. */
+
+#ifndef __ASSEMBLER__
+#include <stddef.h>
 
 void gdt_init(void);
+void gdt_set_thread_segment(const void* base, size_t size);
+#endif
 
 #endif /* ARCH_I386_GDT_H */
@@ -22,6 +22,11 @@ enum intr_level intr_set_level(enum intr_level);
 enum intr_level intr_enable(void);
 enum intr_level intr_disable(void);
 
+/* vec_no of the frames that sysenter_entry in intr-stubs.S builds.
+   It is past the last real vector, so it tells system calls made
+   with SYSENTER apart from those made with "int $0x30". */
+#define INTR_SYSENTER 0x100
+
 /* Interrupt stack frame. */
 struct intr_frame {
   /* Pushed by intr_entry in intr-stubs.S.
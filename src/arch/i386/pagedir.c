@@ -5,6 +5,7 @@
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#include "userprog/kdata.h"
 
 static void invalidate_pagedir(uint32_t*);
 
@@ -15,7 +16,7 @@ static void invalidate_pagedir(uint32_t*);
 uint32_t* pagedir_create(void) {
   uint32_t* pd = palloc_get_page(0);
   if (pd != NULL)
-    memcpy(pd, init_page_dir, PGSIZE);
+    copy_page(pd, init_page_dir);
   return pd;
 }
 
@@ -33,9 +34,11 @@ void pagedir_destroy(uint32_t* pd) {
       uint32_t* pt = pde_get_pt(*pde);
 #ifndef VM
       /* Without VM, we must free user pages here.
-         With VM, spt_destroy() frees them via frame_free(). */
+         With VM, spt_destroy() frees them via frame_free().
+         The kernel data region is shared and never freed. */
       for (uint32_t* pte = pt; pte < pt + PGSIZE / sizeof(uint32_t); pte++) {
-        if (*pte & PTE_P) {
+        void* ua = (void*)(((pde - pd) << PDSHIFT) | ((pte - pt) << PTSHIFT));
+        if ((*pte & PTE_P) && !kdata_contains(ua)) {
           palloc_free_page(pte_get_page(*pte));
         }
       }
@@ -73,8 +76,16 @@ bool pagedir_dup(uint32_t* child_pagedir, uint32_t* parent_pagedir) {
 
       // Iterate through all PTEs in this page table
       for (pte = pt; pte < pt + (PGSIZE / sizeof(*pte)); pte++) {
-        // Only process PTEs that are present
-        if (*pte & PTE_P) {
+        // Calculate the PDE and PTE indices from pointer positions
+        size_t pde_index = pde - parent_pagedir;
+        size_t pte_index = pte - pt;
+
+        // Reconstruct the user virtual address from the indices
+        uint32_t* ua = (uint32_t*)((pde_index << PDSHIFT) | (pte_index << PTSHIFT));
+
+        // Only process PTEs that are present.  The kernel data region is
+        // shared, and the child has already mapped it.
+        if ((*pte & PTE_P) && !kdata_contains(ua)) {
           // Get the kernel virtual address of the parent's page
           uint32_t* parent_page = pte_get_page(*pte);
 
@@ -85,14 +96,7 @@ bool pagedir_dup(uint32_t* child_pagedir, uint32_t* parent_pagedir) {
           }
 
           // Copy the parent's page content to the child's page
-          memcpy(child_page, parent_page, PGSIZE);
-
-          // Calculate the PDE and PTE indices from pointer positions
-          size_t pde_index = pde - parent_pagedir;
-          size_t pte_index = pte - pt;
-
-          // Reconstruct the user virtual address from the indices
-          uint32_t* ua = (uint32_t*)((pde_index << PDSHIFT) | (pte_index << PTSHIFT));
+          copy_page(child_page, parent_page);
 
           // Preserve the writable bit from the parent's PTE
           bool write = *pte & PTE_W;
@@ -1,6 +1,7 @@
 #include "userprog/tss.h"
 #include <debug.h>
 #include <stddef.h>
+#include <sysenter.h>
 #include "userprog/gdt.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
@@ -74,15 +75,49 @@ struct tss {
 /* Kernel TSS. */
 static struct tss* tss;
 
+/* SYSENTER model-specific registers.  See [IA32-v3a] 4.8.7
+   "Performing Fast Calls to System Procedures with the SYSENTER
+   and SYSEXIT Instructions". */
+#define MSR_SYSENTER_CS 0x174  /* Kernel code selector. */
+#define MSR_SYSENTER_ESP 0x175 /* Kernel stack pointer. */
+#define MSR_SYSENTER_EIP 0x176 /* Kernel entry point. */
+
+/* SYSENTER entry point, in intr-stubs.S. */
+void sysenter_entry(void);
+
+/* Writes VALUE to model-specific register MSR. */
+static void wrmsr(uint32_t msr, uint32_t value) {
+  asm volatile("wrmsr" : : "c"(msr), "a"(value), "d"(0));
+}
+
+/* Points the SYSENTER MSRs at sysenter_entry, if the CPU has
+   them.  SYSENTER loads ESP from an MSR rather than from the
+   TSS, and rewriting an MSR on every thread switch is slow, so
+   instead the MSR holds the address of the TSS's esp0 member and
+   sysenter_entry loads its stack pointer from there. */
+static void sysenter_init(void) {
+  if (!sysenter_available())
+    return;
+  wrmsr(MSR_SYSENTER_CS, SEL_KCSEG);
+  wrmsr(MSR_SYSENTER_ESP, (uint32_t)&tss->esp0);
+  wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry);
+}
+
 /* Initializes the kernel TSS. */
 void tss_init(void) {
   /* Our TSS is never used in a call gate or task gate, so only a
      few fields of it are ever referenced, and those are the only
      ones we initialize. */
-  tss = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+  uint8_t* page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+
+  /* Put the TSS at the end of its page.  A SYSENTER with TF set
+     traps with ESP still pointing to esp0 (see sysenter_entry), and
+     the CPU pushes the trap frame into the rest of the page. */
+  tss = (struct tss*)(page + PGSIZE - sizeof *tss);
   tss->ss0 = SEL_KDSEG;
   tss->bitmap = 0xdfff;
   tss_update();
+  sysenter_init();
 }
 
 /* Returns the kernel TSS. */
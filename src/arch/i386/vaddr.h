@@ -75,4 +75,21 @@ static inline uintptr_t vtop(const void* vaddr) {
   return (uintptr_t)vaddr - (uintptr_t)PHYS_BASE;
 }
 
+/* Copies the page at SRC to the page at DST.  Both must be
+   page-aligned and must not overlap. */
+static inline void copy_page(void* dst, const void* src) {
+  ASSERT(pg_ofs(dst) == 0 && pg_ofs(src) == 0);
+
+  int words = PGSIZE / 4;
+  asm volatile("rep movsl" : "+D"(dst), "+S"(src), "+c"(words) : : "memory");
+}
+
+/* Fills the page at PAGE, which must be page-aligned, with zeros. */
+static inline void clear_page(void* page) {
+  ASSERT(pg_ofs(page) == 0);
+
+  int words = PGSIZE / 4;
+  asm volatile("rep stosl" : "+D"(page), "+c"(words) : "a"(0) : "memory");
+}
+
 #endif /* ARCH_I386_VADDR_H */
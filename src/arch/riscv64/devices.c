@@ -7,7 +7,9 @@
 
 #include "arch/riscv64/devices.h"
 #include "arch/riscv64/sbi.h"
+#include "devices/input.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /*
@@ -78,3 +80,20 @@ uint8_t input_getc(void) {
   } while (c < 0);
   return (uint8_t)c;
 }
+
+/*
+ * input_empty - Report whether no key is waiting.
+ *
+ * SBI can only be asked for a character by taking it, so input always
+ * looks available; input_getc() then waits for it.
+ */
+bool input_empty(void) { return false; }
+
+/*
+ * input_wait_queue - Queue woken as keys arrive.
+ *
+ * SBI console input raises no interrupt, so arrivals are not signaled.
+ */
+struct wait_queue* input_wait_queue(void) {
+  return NULL;
+}
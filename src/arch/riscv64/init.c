@@ -45,8 +45,14 @@
 #include "arch/riscv64/userprog.h"
 #include "arch/riscv64/boot.h"
 #include "threads/thread.h"
+#include "threads/fpu.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#ifdef USERPROG
+#include "userprog/kdata.h"
+#endif
+#include <bulk.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
@@ -206,6 +212,14 @@ void riscv_init(uint64_t hartid, void* dtb) {
   palloc_init(SIZE_MAX); /* No limit on user pages for now */
   console_puts("  Page allocator initialized\n");
 
+  /* Initialize memory allocators.  Thread creation allocates each
+   * thread's FPU save area from a slab cache, so these come before
+   * thread_start(). */
+  malloc_init();
+  slab_init();
+  fpu_init();
+  bulk_init();
+
   /* Initialize interrupt handling */
   console_puts("\nInitializing interrupts...\n");
   intr_init();
@@ -267,8 +281,9 @@ void riscv_init(uint64_t hartid, void* dtb) {
     }
   }
 
-  /* Initialize memory allocator (needed for various subsystems) */
-  malloc_init();
+#ifdef USERPROG
+  kdata_init();
+#endif
 
   /* Boot complete */
   console_puts("Boot complete.\n");
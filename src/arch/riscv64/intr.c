@@ -9,6 +9,7 @@
 #include "arch/riscv64/sbi.h"
 #include "arch/riscv64/timer.h"
 #include "arch/riscv64/plic.h"
+#include "threads/fpu.h"
 #include "userprog/syscall.h"
 #include "userprog/exception.h"
 #include <stdint.h>
@@ -201,6 +202,12 @@ static void handle_exception(struct intr_frame* f, uint64_t cause) {
       break;
 
     case SCAUSE_ILLEGAL_INST:
+      /* An FPU instruction with sstatus.FS Off: load this thread's
+         FPU registers and retry it. */
+      if ((f->sstatus & SSTATUS_FS) == SSTATUS_FS_OFF) {
+        fpu_claim();
+        break;
+      }
       debug_panic(__FILE__, __LINE__, __func__, "Illegal instruction at sepc=0x%lx, inst=0x%lx",
                   f->sepc, f->stval);
       break;
@@ -12,6 +12,7 @@
 #include "arch/riscv64/vaddr.h"
 #include "arch/riscv64/memlayout.h"
 #include "threads/palloc.h"
+#include "userprog/kdata.h"
 #include <string.h>
 #include <debug.h>
 
@@ -191,6 +192,10 @@ bool pagedir_dup(pagedir_t child_pd, pagedir_t parent_pd) {
         uint64_t va = ((uint64_t)i2 << VPN2_SHIFT) | ((uint64_t)i1 << VPN1_SHIFT) |
                       ((uint64_t)i0 << VPN0_SHIFT);
 
+        /* The kernel data region is shared; the child maps it itself. */
+        if (kdata_contains((void*)va))
+          continue;
+
         /* Get parent's physical page and flags */
         uint64_t pa = pte_get_pa(pl0[i0]);
         bool writable = (pl0[i0] & PTE_W) != 0;
@@ -201,7 +206,7 @@ bool pagedir_dup(pagedir_t child_pd, pagedir_t parent_pd) {
           return false;
 
         void* parent_page = ptov(pa);
-        memcpy(new_page, parent_page, PGSIZE);
+        copy_page(new_page, parent_page);
 
         /* Map in child's address space */
         if (!pagedir_set_page(child_pd, (void*)va, new_page, writable)) {
@@ -16,6 +16,9 @@
 #include "arch/riscv64/intr.h"
 #include "threads/thread.h"
 #include "threads/synch.h"
+#ifdef USERPROG
+#include "userprog/kdata.h"
+#endif
 #include "lib/kernel/list.h"
 #include <debug.h>
 #include <stdint.h>
@@ -95,12 +98,18 @@ void timer_interrupt(struct intr_frame* f UNUSED) {
   /* Notify thread subsystem of timer tick (for preemptive scheduling) */
   thread_tick();
 
+#ifdef USERPROG
+  /* Publish the new time to user programs */
+  kdata_tick(ticks);
+#endif
+
   /* Wake up sleeping threads whose time has come */
   while (!list_empty(&sleeping_threads)) {
     struct thread* t = list_entry(list_front(&sleeping_threads), struct thread, elem);
     if (t->wake_up_tick > ticks)
       break;
     list_pop_front(&sleeping_threads);
+    t->wake_up_tick = 0;
     thread_unblock(t);
   }
 }
@@ -128,6 +137,21 @@ int64_t timer_elapsed(int64_t then) { return timer_ticks() - then; }
  */
 uint64_t timer_ms(void) { return (uint64_t)timer_ticks() * 1000 / TIMER_FREQ; }
 
+/*
+ * add_sleeper - Insert T into sleeping_threads, ordered by wake_up_tick.
+ *
+ * Interrupts must be off.
+ */
+static void add_sleeper(struct thread* t) {
+  struct list_elem* e = list_begin(&sleeping_threads);
+  while (e != list_end(&sleeping_threads)) {
+    if (t->wake_up_tick < list_entry(e, struct thread, elem)->wake_up_tick)
+      break;
+    e = list_next(e);
+  }
+  list_insert(e, &t->elem);
+}
+
 /*
  * timer_sleep - Sleep for the given number of ticks.
  *
@@ -148,17 +172,7 @@ void timer_sleep(int64_t sleep_ticks) {
   struct thread* current_thread = thread_current();
   /* Wake up time is the current tick plus the duration */
   current_thread->wake_up_tick = start + sleep_ticks;
-
-  /* Insert this thread into the sleeping_threads list, ordered by wake_up_tick */
-  struct list_elem* e = list_begin(&sleeping_threads);
-  while (e != list_end(&sleeping_threads)) {
-    struct thread* t = list_entry(e, struct thread, elem);
-    if (current_thread->wake_up_tick < t->wake_up_tick) {
-      break;
-    }
-    e = list_next(e);
-  }
-  list_insert(e, &current_thread->elem);
+  add_sleeper(current_thread);
 
   /* Block this thread - timer interrupt will wake it */
   thread_block();
@@ -166,6 +180,43 @@ void timer_sleep(int64_t sleep_ticks) {
   intr_set_level(old_level);
 }
 
+/*
+ * timer_block - Block until timer_wake() or, if TICKS is positive,
+ * until TICKS ticks pass.
+ *
+ * Interrupts must be off.
+ */
+void timer_block(int64_t block_ticks) {
+  struct thread* cur = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (block_ticks > 0) {
+    cur->wake_up_tick = block_ticks + timer_ticks();
+    add_sleeper(cur);
+  } else {
+    cur->wake_up_tick = INT64_MAX;
+  }
+  thread_block();
+  cur->wake_up_tick = 0;
+}
+
+/*
+ * timer_wake - Wake T from timer_block() unless the timer already has.
+ *
+ * Interrupts must be off.
+ */
+void timer_wake(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (t->wake_up_tick == 0)
+    return;
+  if (t->wake_up_tick != INT64_MAX)
+    list_remove(&t->elem);
+  t->wake_up_tick = 0;
+  thread_unblock(t);
+}
+
 /*
  * timer_msleep - Sleep for the given number of milliseconds.
  */
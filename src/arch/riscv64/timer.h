@@ -35,6 +35,11 @@ void timer_sleep(int64_t ticks);
 /* Sleep for given number of milliseconds */
 void timer_msleep(int64_t ms);
 
+/* Block until woken or timed out; see threads/waitq.h */
+struct thread;
+void timer_block(int64_t ticks);
+void timer_wake(struct thread* t);
+
 /* Read the raw time counter (mtime equivalent) */
 uint64_t timer_read_time(void);
 
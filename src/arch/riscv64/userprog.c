@@ -60,7 +60,7 @@ static void* alloc_user_page(void) {
   for (int i = 0; i < USER_PAGE_POOL_SIZE; i++) {
     if (!user_page_used[i]) {
       user_page_used[i] = true;
-      memset(user_page_pool[i], 0, PGSIZE);
+      clear_page(user_page_pool[i]);
       return user_page_pool[i];
     }
   }
@@ -496,8 +496,9 @@ void user_entry(struct intr_frame* f) {
    * - SPP = 0 (return to User mode)
    * - SPIE = 1 (enable interrupts on sret)
    * - SUM = 1 (allow supervisor access to user pages during syscalls)
+   * - FS unchanged (threads/fpu.c owns it)
    */
-  f->sstatus = SSTATUS_SPIE | SSTATUS_SUM;
+  f->sstatus = SSTATUS_SPIE | SSTATUS_SUM | (csr_read(sstatus) & SSTATUS_FS);
 
   /*
    * Jump to user mode using sret.
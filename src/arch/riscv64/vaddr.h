@@ -81,4 +81,29 @@ static inline uintptr_t vtop(const void* vaddr) {
   return (uintptr_t)vaddr - (uintptr_t)PHYS_BASE + PHYS_RAM_BASE;
 }
 
+/* Copies the page at SRC to the page at DST.  Both must be
+   page-aligned and must not overlap.  Moves eight doublewords per
+   iteration. */
+static inline void copy_page(void* dst, const void* src) {
+  ASSERT(pg_ofs(dst) == 0 && pg_ofs(src) == 0);
+
+  uint64_t* d = dst;
+  const uint64_t* s = src;
+  for (uint64_t* end = d + PGSIZE / sizeof *d; d < end; d += 8, s += 8) {
+    uint64_t a = s[0], b = s[1], c = s[2], e = s[3];
+    uint64_t f = s[4], g = s[5], h = s[6], i = s[7];
+    d[0] = a, d[1] = b, d[2] = c, d[3] = e;
+    d[4] = f, d[5] = g, d[6] = h, d[7] = i;
+  }
+}
+
+/* Fills the page at PAGE, which must be page-aligned, with zeros. */
+static inline void clear_page(void* page) {
+  ASSERT(pg_ofs(page) == 0);
+
+  uint64_t* p = page;
+  for (uint64_t* end = p + PGSIZE / sizeof *p; p < end; p += 8)
+    p[0] = p[1] = p[2] = p[3] = p[4] = p[5] = p[6] = p[7] = 0;
+}
+
 #endif /* ARCH_RISCV64_VADDR_H */
@@ -1,13 +1,21 @@
 #include "devices/input.h"
 #include <debug.h>
+#include <poll.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/waitq.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Woken as keys arrive. */
+static struct wait_queue waitq;
+
 /* Initializes the input buffer. */
-void input_init(void) { intq_init(&buffer); }
+void input_init(void) {
+  intq_init(&buffer);
+  wait_queue_init(&waitq);
+}
 
 /* Adds a key to the input buffer.
    Interrupts must be off and the buffer must not be full. */
@@ -17,6 +25,7 @@ void input_putc(uint8_t key) {
 
   intq_putc(&buffer, key);
   serial_notify();
+  wait_queue_wake(&waitq, POLLIN);
 }
 
 /* Retrieves a key from the input buffer.
@@ -40,3 +49,14 @@ bool input_full(void) {
   ASSERT(intr_get_level() == INTR_OFF);
   return intq_full(&buffer);
 }
+
+/* Returns true if no key is waiting.
+   Interrupts must be off. */
+bool input_empty(void) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  return intq_empty(&buffer);
+}
+
+struct wait_queue* input_wait_queue(void) {
+  return &waitq;
+}
@@ -7,6 +7,7 @@
  */
 
 #include "devices/raid.h"
+#include <bulk.h>
 #include "threads/malloc.h"
 #include <stddef.h>
 #include <stdint.h>
@@ -166,19 +167,17 @@ void raid_write(block_sector_t sector, const void* buffer) {
       block_sector_t phys = raid5_physical_sector(sector);
 
       uint8_t old_data[BLOCK_SECTOR_SIZE];
-      uint8_t old_parity[BLOCK_SECTOR_SIZE];
-      uint8_t new_parity[BLOCK_SECTOR_SIZE];
+      uint8_t parity[BLOCK_SECTOR_SIZE];
 
       block_read(raid_device->disks[data_disk], phys, old_data);
-      block_read(raid_device->disks[parity_disk], phys, old_parity);
+      block_read(raid_device->disks[parity_disk], phys, parity);
 
-      const uint8_t* new_data = (const uint8_t*)buffer;
-      for (size_t i = 0; i < BLOCK_SECTOR_SIZE; i++) {
-        new_parity[i] = old_parity[i] ^ old_data[i] ^ new_data[i];
-      }
+      /* Turn the old parity into the new one in place */
+      const void* delta[] = {old_data, buffer};
+      bulk_xor(parity, delta, 2, BLOCK_SECTOR_SIZE);
 
       block_write(raid_device->disks[data_disk], phys, buffer);
-      block_write(raid_device->disks[parity_disk], phys, new_parity);
+      block_write(raid_device->disks[parity_disk], phys, parity);
       break;
     }
   }
@@ -287,10 +286,5 @@ block_sector_t raid5_physical_sector(block_sector_t sector) {
  */
 void raid5_compute_parity(void* parity, void* data[], size_t count) {
   memset(parity, 0, BLOCK_SECTOR_SIZE);
-  for (size_t i = 0; i < count; i++) {
-    const uint8_t* buf = (const uint8_t*)data[i];
-    for (size_t j = 0; j < BLOCK_SECTOR_SIZE; j++) {
-      ((uint8_t*)parity)[j] ^= buf[j];
-    }
-  }
+  bulk_xor(parity, (const void* const*)data, count, BLOCK_SECTOR_SIZE);
 }
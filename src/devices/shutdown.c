@@ -6,10 +6,14 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "threads/io.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
+#ifdef VM
+#include "vm/vmstat.h"
+#endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "filesys/filesys.h"
@@ -123,7 +127,11 @@ static void print_stats(void) {
   console_print_stats();
   vga_print_stats(); /* Proves VGA driver is being used! */
   kbd_print_stats();
+  slab_print_stats();
 #ifdef USERPROG
   exception_print_stats();
 #endif
+#ifdef VM
+  vmstat_print_stats();
+#endif
 }
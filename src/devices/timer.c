@@ -37,6 +37,9 @@
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#ifdef USERPROG
+#include "userprog/kdata.h"
+#endif
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * COMPILE-TIME CONFIGURATION CHECKS
@@ -113,6 +116,18 @@ int64_t timer_ticks(void) {
    should be a value once returned by timer_ticks(). */
 int64_t timer_elapsed(int64_t then) { return timer_ticks() - then; }
 
+/* Inserts T into sleeping_threads, which is ordered by wake_up_tick.
+   Interrupts must be off. */
+static void add_sleeper(struct thread* t) {
+  struct list_elem* e = list_begin(&sleeping_threads);
+  while (e != list_end(&sleeping_threads)) {
+    if (t->wake_up_tick < list_entry(e, struct thread, elem)->wake_up_tick)
+      break;
+    e = list_next(e);
+  }
+  list_insert(e, &t->elem);
+}
+
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void timer_sleep(int64_t ticks) {
@@ -125,16 +140,7 @@ void timer_sleep(int64_t ticks) {
   struct thread* current_thread = thread_current();
   // Wake up time is the current tick plus the duration
   current_thread->wake_up_tick = start + ticks;
-  // Insert this thread into the sleeping_threads list, ordered by wake_up_tick
-  struct list_elem* e = list_begin(&sleeping_threads);
-  while (e != list_end(&sleeping_threads)) {
-    struct thread* t = list_entry(e, struct thread, elem);
-    if (current_thread->wake_up_tick < t->wake_up_tick) {
-      break;
-    }
-    e = list_next(e);
-  }
-  list_insert(e, &current_thread->elem);
+  add_sleeper(current_thread);
 
   // Move this thread to a waiting queue to stop wasting CPU cycle
   thread_block();
@@ -142,6 +148,37 @@ void timer_sleep(int64_t ticks) {
   intr_set_level(old_level);
 }
 
+/* Blocks the current thread until timer_wake() is called for it or,
+   if TICKS is positive, until TICKS timer ticks pass.  Interrupts
+   must be off. */
+void timer_block(int64_t ticks) {
+  struct thread* cur = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (ticks > 0) {
+    cur->wake_up_tick = ticks + timer_ticks();
+    add_sleeper(cur);
+  } else {
+    cur->wake_up_tick = INT64_MAX;
+  }
+  thread_block();
+  cur->wake_up_tick = 0;
+}
+
+/* Wakes T from timer_block() unless the timer already has.
+   Interrupts must be off. */
+void timer_wake(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (t->wake_up_tick == 0)
+    return;
+  if (t->wake_up_tick != INT64_MAX)
+    list_remove(&t->elem);
+  t->wake_up_tick = 0;
+  thread_unblock(t);
+}
+
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
    turned on. */
 void timer_msleep(int64_t ms) { real_time_sleep(ms, 1000); }
@@ -188,6 +225,9 @@ void timer_print_stats(void) { printf("Timer: %" PRId64 " ticks\n", timer_ticks(
 static void timer_interrupt(struct intr_frame* args UNUSED) {
   ticks++;
   thread_tick();
+#ifdef USERPROG
+  kdata_tick(ticks);
+#endif
 
   /* MLFQS updates */
   if (active_sched_policy == SCHED_MLFQS) {
@@ -210,6 +250,7 @@ static void timer_interrupt(struct intr_frame* args UNUSED) {
     if (t->wake_up_tick > ticks)
       break;
     list_pop_front(&sleeping_threads);
+    t->wake_up_tick = 0;
     thread_unblock(t);
   }
 }
@@ -62,6 +62,11 @@ void timer_msleep(int64_t milliseconds);
 void timer_usleep(int64_t microseconds);
 void timer_nsleep(int64_t nanoseconds);
 
+/* Block until woken or timed out; see threads/waitq.h. */
+struct thread;
+void timer_block(int64_t ticks);
+void timer_wake(struct thread*);
+
 /* Busy waits. */
 void timer_mdelay(int64_t milliseconds);
 void timer_udelay(int64_t microseconds);
@@ -5,6 +5,10 @@
 #include <stdio.h>
 #include <syscall.h>
 
+/* Copy buffer.  Each read() and write() moves up to this much, so a big
+   file takes few system calls. */
+static char buffer[16384];
+
 int main(int argc, char* argv[]) {
   bool success = true;
   int i;
@@ -17,9 +21,8 @@ int main(int argc, char* argv[]) {
       continue;
     }
     for (;;) {
-      char buffer[1024];
       int bytes_read = read(fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
+      if (bytes_read <= 0)
         break;
       write(STDOUT_FILENO, buffer, bytes_read);
     }
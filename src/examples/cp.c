@@ -31,17 +31,20 @@ int main(int argc, char* argv[]) {
     return EXIT_FAILURE;
   }
 
-  /* Copy data. */
+  /* Copy data inside the kernel. */
   for (;;) {
-    char buffer[1024];
-    int bytes_read = read(in_fd, buffer, sizeof buffer);
-    if (bytes_read == 0)
+    int bytes_copied = copy_file_range(in_fd, out_fd, 1 << 20);
+    if (bytes_copied == 0)
       break;
-    if (write(out_fd, buffer, bytes_read) != bytes_read) {
-      printf("%s: write failed\n", argv[2]);
+    if (bytes_copied < 0) {
+      printf("%s: copy failed\n", argv[2]);
       return EXIT_FAILURE;
     }
   }
+  if ((int)tell(out_fd) != filesize(in_fd)) {
+    printf("%s: write failed\n", argv[2]);
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
@@ -5,6 +5,9 @@
 #include <stdio.h>
 #include <syscall.h>
 
+/* Read buffer.  hex_dump() prints each line with a single write(). */
+static char buffer[16384];
+
 int main(int argc, char* argv[]) {
   bool success = true;
   int i;
@@ -16,13 +19,12 @@ int main(int argc, char* argv[]) {
       success = false;
       continue;
     }
-    for (;;) {
-      char buffer[1024];
-      int pos = tell(fd);
+    for (int pos = 0;;) {
       int bytes_read = read(fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
+      if (bytes_read <= 0)
         break;
       hex_dump(pos, buffer, bytes_read, true);
+      pos += bytes_read;
     }
     close(fd);
   }
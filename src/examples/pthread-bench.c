@@ -0,0 +1,61 @@
+/* pthread-bench.c
+
+   Measures how quickly a process can create and join threads.  Each
+   round creates BATCH threads that return at once, then joins them
+   all, so a batch of 1 times a create/join round trip and larger
+   batches time creation with several threads alive.  Threads that
+   exit are parked by the kernel for pthread_create to reuse, up to a
+   limit, so batches larger than that also pay for new kernel threads.
+
+   Usage: pthread-bench [threads] */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#define DEFAULT_THREADS 1024
+#define MAX_BATCH 64
+
+static void nop(void* arg UNUSED) {}
+
+/* Creates and joins THREADS threads, BATCH at a time, and prints the
+   throughput.  Exits if a thread cannot be created or joined. */
+static void measure(int threads, int batch) {
+  tid_t tids[MAX_BATCH];
+  int rounds = threads / batch;
+
+  int64_t start = get_time_ns();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < batch; i++)
+      if ((tids[i] = pthread_create(nop, NULL)) == TID_ERROR) {
+        printf("pthread-bench: pthread_create failed\n");
+        exit(1);
+      }
+    for (int i = 0; i < batch; i++)
+      if (!pthread_join(tids[i])) {
+        printf("pthread-bench: pthread_join(%d) failed\n", tids[i]);
+        exit(1);
+      }
+  }
+  int64_t ns = get_time_ns() - start;
+  int64_t n = (int64_t)rounds * batch;
+
+  printf("batch %3d %8lld ns/thread %8lld threads/s\n", batch, ns / n,
+         ns > 0 ? n * 1000000000LL / ns : 0);
+}
+
+int main(int argc, char* argv[]) {
+  static const int batches[] = {1, 8, 16, MAX_BATCH};
+  int threads = argc > 1 ? atoi(argv[1]) : DEFAULT_THREADS;
+
+  if (threads < MAX_BATCH) {
+    printf("usage: pthread-bench [threads], threads >= %d\n", MAX_BATCH);
+    return 1;
+  }
+
+  printf("create and join %d threads per batch size\n", threads);
+  for (size_t i = 0; i < sizeof batches / sizeof *batches; i++)
+    measure(threads, batches[i]);
+  return 0;
+}
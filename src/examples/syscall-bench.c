@@ -0,0 +1,86 @@
+/* syscall-bench.c
+
+   Measures the round-trip latency of a null system call
+   (practice(), which only increments its argument) through each
+   kernel entry method: "int $0x30" and, if the CPU supports it,
+   SYSENTER/SYSEXIT.  Also times the library wrapper, which picks
+   SYSENTER automatically when it can.
+
+   Usage: syscall-bench [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include <sysenter.h>
+#include <syscall-nr.h>
+
+#define DEFAULT_ITERATIONS 10000
+
+/* Returns the CPU cycle counter. */
+static uint64_t rdtsc(void) {
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+/* practice(I) through "int $0x30". */
+static int practice_int(int i) {
+  int retval;
+  asm volatile("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp"
+               : "=a"(retval)
+               : [number] "i"(SYS_PRACTICE), [arg0] "g"(i)
+               : "memory");
+  return retval;
+}
+
+/* practice(I) through SYSENTER. */
+static int practice_sysenter(int i) {
+  int retval;
+  asm volatile("movl %%esp, %%ecx; movl $1f, %%edx; sysenter; 1:"
+               : "=a"(retval)
+               : "a"(SYS_PRACTICE), "b"(i), "S"(0), "D"(0)
+               : "ecx", "edx", "cc", "memory");
+  return retval;
+}
+
+/* Calls PRACTICE ITERATIONS times and returns the average number
+   of cycles per call, or exits if a result is wrong. */
+static uint64_t measure(const char* name, int (*practice)(int), int iterations) {
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc();
+  for (i = 0; i < iterations; i++)
+    if (practice(i) != i + 1) {
+      printf("%s: wrong result for practice(%d)\n", name, i);
+      exit(1);
+    }
+  cycles = (rdtsc() - start) / iterations;
+
+  printf("%-10s %8llu cycles/call\n", name, cycles);
+  return cycles;
+}
+
+int main(int argc, char* argv[]) {
+  int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+  uint64_t int_cycles, fast_cycles;
+
+  if (iterations <= 0) {
+    printf("usage: syscall-bench [iterations]\n");
+    return 1;
+  }
+
+  printf("null system call, %d iterations\n", iterations);
+  int_cycles = measure("int $0x30", practice_int, iterations);
+  if (!sysenter_available()) {
+    printf("sysenter   not supported by this CPU\n");
+    return 0;
+  }
+  fast_cycles = measure("sysenter", practice_sysenter, iterations);
+  measure("practice()", practice, iterations);
+
+  if (fast_cycles > 0)
+    printf("sysenter speedup: %llu.%02llux\n", int_cycles / fast_cycles,
+           int_cycles * 100 / fast_cycles % 100);
+  return 0;
+}
@@ -0,0 +1,161 @@
+/* systrace.c
+
+   Runs a command with system call tracing on, then prints how many times
+   it made each system call with the average and slowest latency in
+   cycles.  With -l, also prints the most recent calls one per line, with
+   their first three arguments and return value.  With -a, every process
+   is traced while the command runs, this program's wait() included,
+   instead of just the command and its descendants.
+
+   Usage: systrace [-a] [-l] command [arg...] */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Names of the system calls, by number. */
+static const char* names[SYSTRACE_NR] = {
+    [SYS_HALT] = "halt",
+    [SYS_EXIT] = "exit",
+    [SYS_EXEC] = "exec",
+    [SYS_WAIT] = "wait",
+    [SYS_CREATE] = "create",
+    [SYS_REMOVE] = "remove",
+    [SYS_OPEN] = "open",
+    [SYS_FILESIZE] = "filesize",
+    [SYS_READ] = "read",
+    [SYS_WRITE] = "write",
+    [SYS_SEEK] = "seek",
+    [SYS_TELL] = "tell",
+    [SYS_CLOSE] = "close",
+    [SYS_PRACTICE] = "practice",
+    [SYS_PT_CREATE] = "pt_create",
+    [SYS_PT_EXIT] = "pt_exit",
+    [SYS_PT_JOIN] = "pt_join",
+    [SYS_LOCK_INIT] = "lock_init",
+    [SYS_LOCK_ACQUIRE] = "lock_acquire",
+    [SYS_LOCK_RELEASE] = "lock_release",
+    [SYS_SEMA_INIT] = "sema_init",
+    [SYS_SEMA_DOWN] = "sema_down",
+    [SYS_SEMA_UP] = "sema_up",
+    [SYS_GET_TID] = "get_tid",
+    [SYS_FORK] = "fork",
+    [SYS_MMAP] = "mmap",
+    [SYS_MUNMAP] = "munmap",
+    [SYS_CHDIR] = "chdir",
+    [SYS_MKDIR] = "mkdir",
+    [SYS_READDIR] = "readdir",
+    [SYS_ISDIR] = "isdir",
+    [SYS_INUMBER] = "inumber",
+    [SYS_LINK] = "link",
+    [SYS_SYMLINK] = "symlink",
+    [SYS_READLINK] = "readlink",
+    [SYS_PIPE] = "pipe",
+    [SYS_MMAP2] = "mmap2",
+    [SYS_VMSTAT] = "vmstat",
+    [SYS_SHM_OPEN] = "shm_open",
+    [SYS_SHM_UNLINK] = "shm_unlink",
+    [SYS_GET_PID] = "get_pid",
+    [SYS_PREAD] = "pread",
+    [SYS_PWRITE] = "pwrite",
+    [SYS_READV] = "readv",
+    [SYS_WRITEV] = "writev",
+    [SYS_COPY_FILE_RANGE] = "copy_file_range",
+    [SYS_SPLICE] = "splice",
+    [SYS_POLL] = "poll",
+    [SYS_EPOLL_CREATE] = "epoll_create",
+    [SYS_EPOLL_CTL] = "epoll_ctl",
+    [SYS_EPOLL_WAIT] = "epoll_wait",
+    [SYS_IO_URING_SETUP] = "io_uring_setup",
+    [SYS_IO_URING_ENTER] = "io_uring_enter",
+    [SYS_SYSTRACE] = "systrace",
+    [SYS_COND_INIT] = "cond_init",
+    [SYS_COND_WAIT] = "cond_wait",
+    [SYS_COND_SIGNAL] = "cond_signal",
+    [SYS_COND_BROADCAST] = "cond_broadcast",
+    [SYS_BARRIER_INIT] = "barrier_init",
+    [SYS_BARRIER_WAIT] = "barrier_wait",
+    [SYS_RWLOCK_INIT] = "rwlock_init",
+    [SYS_RWLOCK_ACQUIRE] = "rwlock_acquire",
+    [SYS_RWLOCK_RELEASE] = "rwlock_release",
+};
+
+static struct systrace_stats stats;
+static struct systrace_event events[32];
+
+/* Returns the name of system call NR. */
+static const char* name(int nr) {
+  return nr >= 0 && nr < SYSTRACE_NR && names[nr] != NULL ? names[nr] : "?";
+}
+
+static void print_stats(void) {
+  uint64_t total = 0;
+
+  printf("%-16s %10s %12s %12s\n", "syscall", "calls", "avg cycles", "max cycles");
+  for (int nr = 0; nr < SYSTRACE_NR; nr++) {
+    if (stats.calls[nr] == 0)
+      continue;
+    printf("%-16s %10llu %12llu %12llu\n", name(nr), stats.calls[nr],
+           stats.cycles[nr] / stats.calls[nr], stats.max_cycles[nr]);
+    total += stats.calls[nr];
+  }
+  printf("%-16s %10llu\n", "total", total);
+}
+
+static void print_events(void) {
+  int n;
+
+  while ((n = systrace(SYSTRACE_EVENTS, events, sizeof events / sizeof *events)) > 0)
+    for (int i = 0; i < n; i++) {
+      const struct systrace_event* e = &events[i];
+      printf("%d.%d %s(%#llx, %#llx, %#llx) = %d  [%llu cycles]\n", e->pid, e->tid, name(e->nr),
+             e->args[0], e->args[1], e->args[2], e->ret, e->cycles);
+    }
+  if (stats.events_lost != 0)
+    printf("(%llu earlier events lost)\n", stats.events_lost);
+}
+
+int main(int argc, char* argv[]) {
+  int mode = SYSTRACE_CHILDREN;
+  bool log = false;
+  char cmd_line[128];
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (!strcmp(argv[i], "-a"))
+      mode = SYSTRACE_GLOBAL;
+    else if (!strcmp(argv[i], "-l"))
+      log = true;
+    else
+      break;
+  }
+  if (i >= argc) {
+    printf("usage: systrace [-a] [-l] command [arg...]\n");
+    return 1;
+  }
+
+  cmd_line[0] = '\0';
+  for (; i < argc; i++) {
+    if (cmd_line[0] != '\0')
+      strlcat(cmd_line, " ", sizeof cmd_line);
+    strlcat(cmd_line, argv[i], sizeof cmd_line);
+  }
+
+  systrace(SYSTRACE_RESET, NULL, 0);
+  systrace(mode | (log ? SYSTRACE_LOG : 0), NULL, 0);
+  pid_t pid = exec(cmd_line);
+  int status = pid != PID_ERROR ? wait(pid) : -1;
+  systrace(SYSTRACE_OFF, NULL, 0);
+
+  if (pid == PID_ERROR) {
+    printf("systrace: %s: exec failed\n", cmd_line);
+    return 1;
+  }
+
+  systrace(SYSTRACE_STATS, &stats, 0);
+  printf("systrace: %s: exit status %d\n", cmd_line, status);
+  print_stats();
+  if (log)
+    print_events();
+  return 0;
+}
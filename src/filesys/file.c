@@ -2,7 +2,9 @@
 #include <debug.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/vaddr.h"
 
 /*
  * ╔══════════════════════════════════════════════════════════════════════════╗
@@ -146,6 +148,35 @@ off_t file_write_at(struct file* file, const void* buffer, off_t size, off_t fil
   return inode_write_at(file->inode, buffer, size, file_ofs);
 }
 
+/* Copies SIZE bytes from SRC, starting at offset SRC_OFS, into DST,
+   starting at offset DST_OFS, without passing through user memory.
+   Returns the number of bytes copied, which may be less than SIZE at
+   the end of SRC or if DST cannot grow.  If SRC and DST share an inode,
+   the two ranges must not overlap.  Neither file's position is
+   affected. */
+off_t file_copy_at(struct file* dst, off_t dst_ofs, struct file* src, off_t src_ofs, off_t size) {
+  /* Data moves a page at a time: out of the source's cache entries,
+     then straight into the destination's. */
+  uint8_t* page = palloc_get_page(0);
+  if (page == NULL)
+    return 0;
+
+  off_t copied = 0;
+  while (copied < size) {
+    off_t chunk = size - copied < PGSIZE ? size - copied : PGSIZE;
+    off_t n = inode_read_at(src->inode, page, chunk, src_ofs + copied);
+    if (n <= 0)
+      break;
+    off_t written = inode_write_at(dst->inode, page, n, dst_ofs + copied);
+    copied += written;
+    if (written < n || n < chunk)
+      break;
+  }
+
+  palloc_free_page(page);
+  return copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void file_deny_write(struct file* file) {
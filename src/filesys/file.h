@@ -17,6 +17,7 @@ off_t file_read(struct file* file, void* buffer, off_t size);
 off_t file_read_at(struct file* file, void* buffer, off_t size, off_t start);
 off_t file_write(struct file* file, const void* buffer, off_t size);
 off_t file_write_at(struct file* file, const void* buffer, off_t size, off_t start);
+off_t file_copy_at(struct file* dst, off_t dst_ofs, struct file* src, off_t src_ofs, off_t size);
 
 /* Preventing writes. */
 void file_deny_write(struct file* file);
@@ -1,6 +1,6 @@
 #include "filesys/inode.h"
-#include <list.h>
 #include <debug.h>
+#include <rhash.h>
 #include <round.h>
 #include <string.h>
 #include "filesys/cache.h"
@@ -8,6 +8,7 @@
 #include "filesys/free-map.h"
 #include "filesys/wal.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 
 /* Number of direct block pointers.
@@ -61,7 +62,6 @@ static inline size_t bytes_to_sectors(off_t size) { return DIV_ROUND_UP(size, BL
    while serializing operations on the SAME file. This is more efficient
    than a single global lock. */
 struct inode {
-  struct list_elem elem;  /* Element in inode list. */
   block_sector_t sector;  /* Sector number of disk location. */
   int open_cnt;           /* Number of openers. */
   bool removed;           /* True if deleted, false otherwise. */
@@ -112,22 +112,24 @@ static block_sector_t byte_to_sector(const struct inode* inode, off_t pos) {
   return buffer[offset_in_indirect];
 }
 
-/* List of open inodes, so that opening a single inode twice
-   returns the same `struct inode'. */
-static struct list open_inodes;
+/* Open inodes, keyed by sector, so that opening a single inode twice
+   returns the same `struct inode'.  A hash table rather than a list,
+   since every open scans it and a busy directory tree keeps many
+   inodes open. */
+static struct rhash open_inodes;
 
-/* Lock protecting the open_inodes list.
+/* Lock protecting the open_inodes table.
    
-   SYNCHRONIZATION: This lock protects the global list of open inodes.
+   SYNCHRONIZATION: This lock protects the global table of open inodes.
    It prevents races when:
    - Searching for an already-open inode (inode_open)
-   - Adding a newly-opened inode to the list (inode_open)
-   - Removing a closed inode from the list (inode_close)
+   - Adding a newly-opened inode to the table (inode_open)
+   - Removing a closed inode from the table (inode_close)
    
    WHY TWO LOCKS? We need both open_inodes_lock AND per-inode locks because:
    
-   1. The list lock protects the LIST STRUCTURE itself (traversal, insertion,
-      removal). Without it, one thread could be iterating the list while
+   1. The table lock protects the TABLE STRUCTURE itself (lookup, insertion,
+      removal). Without it, one thread could be probing the table while
       another removes an element, causing undefined behavior.
    
    2. The per-inode lock protects INODE CONTENTS (open_cnt, data, etc.).
@@ -139,9 +141,24 @@ static struct list open_inodes;
 static struct lock open_inodes_lock;
 
 /* Initializes the inode module. */
+/* Cache of in-memory inodes.  Each inode's lock is initialized
+   once, by the constructor, and is free whenever the inode is. */
+static struct slab_cache inode_cache;
+
+static void inode_ctor(void* obj, void* aux UNUSED) {
+  struct inode* inode = obj;
+  lock_init(&inode->lock);
+}
+
+/* Returns true if INODE is the inode at the sector KEY points to. */
+static bool inode_eq(const void* inode, const void* key, void* aux UNUSED) {
+  return ((const struct inode*)inode)->sector == *(const block_sector_t*)key;
+}
+
 void inode_init(void) {
-  list_init(&open_inodes);
+  rhash_init(&open_inodes, inode_eq, NULL);
   lock_init(&open_inodes_lock);
+  slab_cache_init(&inode_cache, "inode", sizeof(struct inode), inode_ctor, NULL);
 }
 
 /* Frees all data blocks referenced by DISK_INODE.
@@ -296,36 +313,37 @@ bool inode_create_dir(block_sector_t sector, off_t length) {
    and returns a `struct inode' that contains it.
    Returns a null pointer if memory allocation fails. */
 struct inode* inode_open(block_sector_t sector) {
-  struct list_elem* e;
+  unsigned hash = rhash_int(sector);
   struct inode* inode;
 
   lock_acquire(&open_inodes_lock);
 
   /* Check whether this inode is already open. */
-  for (e = list_begin(&open_inodes); e != list_end(&open_inodes); e = list_next(e)) {
-    inode = list_entry(e, struct inode, elem);
-    if (inode->sector == sector) {
-      inode_reopen(inode);
-      lock_release(&open_inodes_lock);
-      return inode;
-    }
+  inode = rhash_find(&open_inodes, hash, &sector);
+  if (inode != NULL) {
+    inode_reopen(inode);
+    lock_release(&open_inodes_lock);
+    return inode;
   }
 
   /* Allocate memory. */
-  inode = malloc(sizeof *inode);
+  inode = slab_alloc(&inode_cache);
   if (inode == NULL) {
     lock_release(&open_inodes_lock);
     return NULL;
   }
 
   /* Initialize. */
-  list_push_front(&open_inodes, &inode->elem);
   inode->sector = sector;
+  if (!rhash_insert(&open_inodes, hash, &sector, inode)) {
+    slab_free(&inode_cache, inode);
+    lock_release(&open_inodes_lock);
+    return NULL;
+  }
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
   inode->skip_wal = false;
-  lock_init(&inode->lock);
   /* Read inode metadata from cache. */
   cache_read(inode->sector, &inode->data);
 
@@ -361,14 +379,14 @@ void inode_close(struct inode* inode) {
   if (inode == NULL)
     return;
 
-  /* Acquire locks in correct order: list lock first, then inode lock. */
+  /* Acquire locks in correct order: table lock first, then inode lock. */
   lock_acquire(&open_inodes_lock);
   lock_acquire(&inode->lock);
 
   /* Release resources if this was the last opener. */
   if (--inode->open_cnt == 0) {
-    /* Remove from inode list while holding both locks. */
-    list_remove(&inode->elem);
+    /* Remove from inode table while holding both locks. */
+    rhash_delete(&open_inodes, rhash_int(inode->sector), &inode->sector);
     lock_release(&inode->lock);
     lock_release(&open_inodes_lock);
 
@@ -379,7 +397,7 @@ void inode_close(struct inode* inode) {
       inode_deallocate(&inode->data);
     }
 
-    free(inode);
+    slab_free(&inode_cache, inode);
   } else {
     lock_release(&inode->lock);
     lock_release(&open_inodes_lock);
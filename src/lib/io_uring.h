@@ -0,0 +1,79 @@
+#ifndef __LIB_IO_URING_H
+#define __LIB_IO_URING_H
+
+#include <stdint.h>
+
+/* Asynchronous I/O rings, shared between the kernel and user programs.
+
+   A ring lives in memory the program supplies to io_uring_setup(),
+   laid out as a struct io_uring_rings header followed by the
+   submission queue (SQ) entries and then the completion queue (CQ)
+   entries.  The program fills SQ entries and advances sq_tail, then
+   calls io_uring_enter() to hand them to the kernel; kernel worker
+   threads carry the operations out and post one CQ entry for each,
+   advancing cq_tail.  The program consumes CQ entries and advances
+   cq_head.  Each index only grows and wraps naturally; an entry's slot
+   is its index masked by the queue size minus one.
+
+   Each side writes only its own indices: the kernel sq_head and
+   cq_tail, the program sq_tail and cq_head.  The kernel stores an
+   entry before advancing the index that publishes it, and reads an
+   entry only after reading the index that covers it. */
+
+/* Largest SQ size.  The CQ has twice as many entries as the SQ. */
+#define IORING_MAX_ENTRIES 256
+
+/* Operations. */
+enum io_uring_op {
+  IORING_OP_NOP,   /* Nothing; completes with 0. */
+  IORING_OP_READ,  /* read() or pread(): fd, addr, len, off. */
+  IORING_OP_WRITE, /* write() or pwrite(): fd, addr, len, off. */
+  IORING_OP_OPEN,  /* open() of the path at addr; completes with the fd. */
+  IORING_OP_CLOSE, /* close(fd). */
+  IORING_OP_FSYNC, /* Writes the buffer cache back to disk; fd must be a file. */
+  IORING_OP_CNT
+};
+
+/* Value of off that means the descriptor's own position, which the
+   transfer advances, as read() and write() do. */
+#define IORING_OFF_CURRENT ((uint64_t)-1)
+
+/* Submission queue entry. */
+struct io_uring_sqe {
+  uint8_t opcode;     /* IORING_OP_*. */
+  uint8_t pad[3];     /* Must be zero. */
+  int32_t fd;         /* Descriptor operated on. */
+  uint64_t off;       /* File offset, or IORING_OFF_CURRENT. */
+  uint64_t addr;      /* User buffer or path. */
+  uint32_t len;       /* Buffer length in bytes. */
+  uint32_t pad2;      /* Must be zero. */
+  uint64_t user_data; /* Returned unchanged in the completion. */
+};
+
+/* Completion queue entry. */
+struct io_uring_cqe {
+  uint64_t user_data; /* From the submission. */
+  int32_t res;        /* Result, as the equivalent system call returns. */
+  uint32_t flags;     /* Zero. */
+};
+
+/* Ring header.  io_uring_setup() fills in the sizes and zeroes the
+   indices. */
+struct io_uring_rings {
+  uint32_t sq_head;    /* Next SQ entry the kernel consumes.  Kernel-written. */
+  uint32_t sq_tail;    /* One past the last SQ entry filled.  User-written. */
+  uint32_t cq_head;    /* Next CQ entry the program consumes.  User-written. */
+  uint32_t cq_tail;    /* One past the last CQ entry posted.  Kernel-written. */
+  uint32_t sq_entries; /* SQ size, a power of 2. */
+  uint32_t cq_entries; /* CQ size, twice the SQ size. */
+};
+
+/* Offsets of the queues within ring memory, and its total size, for an
+   SQ of ENTRIES entries. */
+#define IORING_SQES_OFFSET sizeof(struct io_uring_rings)
+#define IORING_CQES_OFFSET(ENTRIES)                                                                \
+  (IORING_SQES_OFFSET + (ENTRIES) * sizeof(struct io_uring_sqe))
+#define IORING_MEM_SIZE(ENTRIES)                                                                   \
+  (IORING_CQES_OFFSET(ENTRIES) + 2 * (ENTRIES) * sizeof(struct io_uring_cqe))
+
+#endif /* lib/io_uring.h */
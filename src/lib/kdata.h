@@ -0,0 +1,61 @@
+#ifndef __LIB_KDATA_H
+#define __LIB_KDATA_H
+
+#include <stdint.h>
+
+/* Kernel data page, shared between the kernel and user programs.
+
+   The kernel maps this region read-only at KDATA_BASE in every
+   user process, and keeps it up to date, so that user programs
+   can answer common queries (the current time, their own thread
+   and process IDs) with plain loads instead of system calls.
+
+   The clock fields change on every timer interrupt.  Readers
+   must use the SEQ counter, which is odd while an update is in
+   progress and changes whenever one completes:
+
+     do {
+       seq = kd->seq;
+       ...read fields...
+     } while ((seq & 1) || seq != kd->seq);
+
+   Each user thread owns one entry in THREADS.  On i386 the
+   thread pointer, the base of the segment selected by
+   KDATA_THREAD_SEL, points to the current thread's entry, so
+   %gs:0 is the thread's TID.  Entry 0 is never handed out; a
+   thread whose entry would not fit is pointed at it, and sees a
+   TID of 0. */
+
+/* User virtual address and size of the region, just below the
+   usual executable load address. */
+#define KDATA_BASE 0x07ff0000
+#define KDATA_PAGES 4
+#define KDATA_SIZE (KDATA_PAGES * 4096)
+
+/* Segment selector loaded into GS for user threads on i386.
+   Must match SEL_UTSEG in arch/i386/gdt.h. */
+#define KDATA_THREAD_SEL 0x33
+
+/* Identity of one user thread. */
+struct kdata_thread {
+  int32_t tid; /* Thread ID, or 0 if the entry is unused. */
+  int32_t pid; /* ID of the thread's process. */
+};
+
+/* Number of entries in the thread table. */
+#define KDATA_THREAD_CNT ((KDATA_SIZE - 64) / sizeof(struct kdata_thread))
+
+struct kdata {
+  /* Clock, written by the timer interrupt. */
+  volatile uint32_t seq;    /* Odd while the fields below are updated. */
+  uint32_t timer_freq;      /* Timer ticks per second. */
+  int64_t ticks;            /* Timer ticks since boot. */
+  uint64_t tick_cycles;     /* Cycle counter at the last tick. */
+  uint64_t cycles_per_tick; /* Cycle counter rate, or 0 if not yet known. */
+  uint32_t reserved[8];
+
+  /* Thread identities, indexed by thread pointer. */
+  struct kdata_thread threads[KDATA_THREAD_CNT];
+};
+
+#endif /* lib/kdata.h */
@@ -25,8 +25,9 @@ typedef unsigned long elem_type;
    inside, it's an array of elem_type (defined above) that
    simulates an array of bits. */
 struct bitmap {
-  size_t bit_cnt;  /* Number of bits. */
-  elem_type* bits; /* Elements that represent bits. */
+  size_t bit_cnt;    /* Number of bits. */
+  elem_type* bits;   /* Elements that represent bits. */
+  size_t full_elems; /* Elements before this one have no false bits. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -50,6 +51,64 @@ static inline elem_type last_mask(const struct bitmap* b) {
   return last_bits ? ((elem_type)1 << last_bits) - 1 : (elem_type)-1;
 }
 
+/* Returns a mask of the bits in element IDX that represent bits
+   START through END - 1 of the bitmap.  The range must be nonempty
+   and must overlap element IDX. */
+static inline elem_type range_mask(size_t idx, size_t start, size_t end) {
+  elem_type mask = (elem_type)-1;
+  if (idx == elem_idx(start))
+    mask &= (elem_type)-1 << start % ELEM_BITS;
+  if (idx == elem_idx(end - 1) && end % ELEM_BITS != 0)
+    mask &= bit_mask(end) - 1;
+  return mask;
+}
+
+/* Returns element IDX of B with the bits equal to VALUE set to 1
+   and the rest, including any past the end of B, set to 0. */
+static inline elem_type match_elem(const struct bitmap* b, size_t idx, bool value) {
+  elem_type e = value ? b->bits[idx] : ~b->bits[idx];
+  return idx == elem_cnt(b->bit_cnt) - 1 ? e & last_mask(b) : e;
+}
+
+/* Returns the index of the lowest set bit in X, which must be
+   nonzero. */
+static inline unsigned elem_ctz(elem_type x) {
+  ASSERT(x != 0);
+#ifdef ARCH_I386
+  elem_type bit;
+  asm("bsfl %1, %0" : "=r"(bit) : "rm"(x));
+  return bit;
+#else
+  /* Without Zbb, __builtin_ctzl() would need libgcc. */
+  unsigned bit = 0;
+  for (unsigned width = ELEM_BITS / 2; width > 0; width /= 2)
+    if ((x & (((elem_type)1 << width) - 1)) == 0) {
+      x >>= width;
+      bit += width;
+    }
+  return bit;
+#endif
+}
+
+/* Returns the number of set bits in X. */
+static inline unsigned elem_popcount(elem_type x) {
+  const elem_type m1 = (elem_type)-1 / 3;
+  const elem_type m2 = (elem_type)-1 / 5;
+  const elem_type m4 = (elem_type)-1 / 17;
+  const elem_type h01 = (elem_type)-1 / 255;
+
+  x -= (x >> 1) & m1;
+  x = (x & m2) + ((x >> 2) & m2);
+  x = (x + (x >> 4)) & m4;
+  return (x * h01) >> (ELEM_BITS - CHAR_BIT);
+}
+
+/* Notes that bits in element IDX of B may have become false. */
+static inline void note_false(struct bitmap* b, size_t idx) {
+  if (idx < b->full_elems)
+    b->full_elems = idx;
+}
+
 /* Creation and destruction. */
 
 /* Creates and returns a pointer to a newly allocated bitmap with room for
@@ -61,6 +120,7 @@ struct bitmap* bitmap_create(size_t bit_cnt) {
   if (b != NULL) {
     b->bit_cnt = bit_cnt;
     b->bits = malloc(byte_cnt(bit_cnt));
+    b->full_elems = 0;
     if (b->bits != NULL || bit_cnt == 0) {
       bitmap_set_all(b, false);
       return b;
@@ -80,6 +140,7 @@ struct bitmap* bitmap_create_in_buf(size_t bit_cnt, void* block, size_t block_si
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type*)(b + 1);
+  b->full_elems = 0;
   bitmap_set_all(b, false);
   return b;
 }
@@ -114,11 +175,8 @@ void bitmap_set(struct bitmap* b, size_t idx, bool value) {
     bitmap_reset(b, idx);
 }
 
-/* Atomically sets the bit numbered BIT_IDX in B to true. */
-void bitmap_mark(struct bitmap* b, size_t bit_idx) {
-  size_t idx = elem_idx(bit_idx);
-  elem_type mask = bit_mask(bit_idx);
-
+/* Atomically sets the bits in MASK in element IDX of B to true. */
+static inline void mark_elem(struct bitmap* b, size_t idx, elem_type mask) {
 #ifdef ARCH_I386
   /* This is equivalent to `b->bits[idx] |= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
@@ -131,11 +189,8 @@ void bitmap_mark(struct bitmap* b, size_t bit_idx) {
 #endif
 }
 
-/* Atomically sets the bit numbered BIT_IDX in B to false. */
-void bitmap_reset(struct bitmap* b, size_t bit_idx) {
-  size_t idx = elem_idx(bit_idx);
-  elem_type mask = bit_mask(bit_idx);
-
+/* Atomically sets the bits in MASK in element IDX of B to false. */
+static inline void reset_elem(struct bitmap* b, size_t idx, elem_type mask) {
 #ifdef ARCH_I386
   /* This is equivalent to `b->bits[idx] &= ~mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
@@ -145,6 +200,17 @@ void bitmap_reset(struct bitmap* b, size_t bit_idx) {
   /* Non-atomic version for other architectures. */
   b->bits[idx] &= ~mask;
 #endif
+  note_false(b, idx);
+}
+
+/* Atomically sets the bit numbered BIT_IDX in B to true. */
+void bitmap_mark(struct bitmap* b, size_t bit_idx) {
+  mark_elem(b, elem_idx(bit_idx), bit_mask(bit_idx));
+}
+
+/* Atomically sets the bit numbered BIT_IDX in B to false. */
+void bitmap_reset(struct bitmap* b, size_t bit_idx) {
+  reset_elem(b, elem_idx(bit_idx), bit_mask(bit_idx));
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -163,6 +229,7 @@ void bitmap_flip(struct bitmap* b, size_t bit_idx) {
   /* Non-atomic version for other architectures. */
   b->bits[idx] ^= mask;
 #endif
+  note_false(b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -183,14 +250,19 @@ void bitmap_set_all(struct bitmap* b, bool value) {
 
 /* Sets the CNT bits starting at START in B to VALUE. */
 void bitmap_set_multiple(struct bitmap* b, size_t start, size_t cnt, bool value) {
-  size_t i;
-
   ASSERT(b != NULL);
   ASSERT(start <= b->bit_cnt);
   ASSERT(start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set(b, start + i, value);
+  if (cnt == 0)
+    return;
+  for (size_t idx = elem_idx(start); idx <= elem_idx(start + cnt - 1); idx++) {
+    elem_type mask = range_mask(idx, start, start + cnt);
+    if (value)
+      mark_elem(b, idx, mask);
+    else
+      reset_elem(b, idx, mask);
+  }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -203,9 +275,9 @@ size_t bitmap_count(const struct bitmap* b, size_t start, size_t cnt, bool value
   ASSERT(start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test(b, start + i) == value)
-      value_cnt++;
+  if (cnt > 0)
+    for (i = elem_idx(start); i <= elem_idx(start + cnt - 1); i++)
+      value_cnt += elem_popcount(match_elem(b, i, value) & range_mask(i, start, start + cnt));
   return value_cnt;
 }
 
@@ -218,9 +290,10 @@ bool bitmap_contains(const struct bitmap* b, size_t start, size_t cnt, bool valu
   ASSERT(start <= b->bit_cnt);
   ASSERT(start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test(b, start + i) == value)
-      return true;
+  if (cnt > 0)
+    for (i = elem_idx(start); i <= elem_idx(start + cnt - 1); i++)
+      if ((match_elem(b, i, value) & range_mask(i, start, start + cnt)) != 0)
+        return true;
   return false;
 }
 
@@ -247,17 +320,72 @@ bool bitmap_all(const struct bitmap* b, size_t start, size_t cnt) {
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Works an element at a time: an element with every bit matching
+   extends the current run by ELEM_BITS, one with none ends it, and
+   the runs inside any other element are found with elem_ctz().  A
+   search for false bits starts no earlier than B's first element
+   that is not full. */
 size_t bitmap_scan(const struct bitmap* b, size_t start, size_t cnt, bool value) {
   ASSERT(b != NULL);
   ASSERT(start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) {
-    size_t last = b->bit_cnt - cnt;
-    size_t i;
-    for (i = start; i <= last; i++)
-      if (!bitmap_contains(b, i, cnt, !value))
-        return i;
+  if (cnt == 0)
+    return start;
+  if (cnt > b->bit_cnt)
+    return BITMAP_ERROR;
+
+  if (!value && start < b->full_elems * ELEM_BITS)
+    start = b->full_elems * ELEM_BITS;
+
+  size_t run_start = start; /* First bit of the current run. */
+  size_t run_cnt = 0;       /* Bits in the current run. */
+  for (size_t idx = elem_idx(start); idx < elem_cnt(b->bit_cnt); idx++) {
+    elem_type e = match_elem(b, idx, value);
+    size_t base = idx * ELEM_BITS;
+    size_t ofs = 0;
+
+    if (idx == elem_idx(start)) {
+      e >>= start % ELEM_BITS;
+      ofs = start % ELEM_BITS;
+    }
+
+    if (e == (elem_type)-1) {
+      /* Every bit matches. */
+      if (run_cnt == 0)
+        run_start = base;
+      run_cnt += ELEM_BITS;
+      if (run_cnt >= cnt)
+        return run_start;
+      continue;
+    }
+
+    /* E holds bit OFS of the element in bit 0.  Its upper bits are
+       shifted-in zeros, so ~E is never 0. */
+    while (e != 0) {
+      unsigned skip = elem_ctz(e);
+      if (skip > 0) {
+        run_cnt = 0;
+        e >>= skip;
+        ofs += skip;
+      }
+
+      unsigned ones = elem_ctz(~e);
+      if (run_cnt == 0)
+        run_start = base + ofs;
+      run_cnt += ones;
+      if (run_cnt >= cnt)
+        return run_start;
+      ofs += ones;
+      if (ofs == ELEM_BITS)
+        break;
+      e >>= ones;
+    }
+
+    /* Only a run that reaches the top bit carries into the next element. */
+    if (ofs < ELEM_BITS)
+      run_cnt = 0;
   }
   return BITMAP_ERROR;
 }
@@ -271,8 +399,15 @@ size_t bitmap_scan(const struct bitmap* b, size_t start, size_t cnt, bool value)
    setting them. */
 size_t bitmap_scan_and_flip(struct bitmap* b, size_t start, size_t cnt, bool value) {
   size_t idx = bitmap_scan(b, start, cnt, value);
-  if (idx != BITMAP_ERROR)
+  if (idx != BITMAP_ERROR) {
     bitmap_set_multiple(b, idx, cnt, !value);
+
+    /* Step the hint past elements that are now full, so the next
+       search for false bits resumes after them. */
+    if (!value)
+      while (b->full_elems < elem_cnt(b->bit_cnt) && match_elem(b, b->full_elems, false) == 0)
+        b->full_elems++;
+  }
   return idx;
 }
 
@@ -290,6 +425,7 @@ bool bitmap_read(struct bitmap* b, struct file* file) {
     off_t size = byte_cnt(b->bit_cnt);
     success = file_read_at(file, b->bits, size, 0) == size;
     b->bits[elem_cnt(b->bit_cnt) - 1] &= last_mask(b);
+    b->full_elems = 0;
   }
   return success;
 }
@@ -0,0 +1,430 @@
+/* Bulk data kernels.
+
+   See bulk.h for basic information. */
+
+#include "bulk.h"
+#include "../debug.h"
+#include "threads/fpu.h"
+
+/* Buffers shorter than this take the scalar path even when the SSE
+   one is available. */
+#define SIMD_MIN_SIZE 128
+
+/* A machine word that may alias any other type. */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WORD_SIZE sizeof(word_t)
+
+static void xor_scalar(void* dst, const void* const src[], size_t src_cnt, size_t size);
+static uint32_t csum_scalar(const void* data, size_t len, uint32_t sum);
+static uint32_t crc32_scalar(uint32_t crc, const void* data, size_t len);
+static void xor_range(uint8_t* dst, const void* const src[], size_t src_cnt, size_t ofs, size_t size);
+
+#ifdef __i386__
+static void xor_sse2(void* dst, const void* const src[], size_t src_cnt, size_t size);
+static uint32_t csum_sse2(const void* data, size_t len, uint32_t sum);
+static uint32_t crc32_pclmul(uint32_t crc, const void* data, size_t len);
+
+#define CPUID_FXSR (1u << 24)   /* EDX. */
+#define CPUID_SSE2 (1u << 26)   /* EDX. */
+#define CPUID_PCLMUL (1u << 1)  /* ECX. */
+
+/* Extensions found by bulk_init(). */
+static bool has_sse2;
+static bool has_pclmul;
+#endif
+
+/* Implementations in use. */
+static void (*xor_fn)(void*, const void* const[], size_t, size_t) = xor_scalar;
+static uint32_t (*csum_fn)(const void*, size_t, uint32_t) = csum_scalar;
+static uint32_t (*crc32_fn)(uint32_t, const void*, size_t) = crc32_scalar;
+static const char* impl_name = "scalar";
+
+/* Checks which SIMD extensions the CPU has and selects the fastest
+   implementations.  Must be called after fpu_init(), which enables
+   SSE. */
+void bulk_init(void) {
+#ifdef __i386__
+  uint32_t eax, ebx, ecx, edx;
+
+  asm("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+  has_sse2 = (edx & (CPUID_FXSR | CPUID_SSE2)) == (CPUID_FXSR | CPUID_SSE2);
+  has_pclmul = has_sse2 && (ecx & CPUID_PCLMUL) != 0;
+#endif
+  bulk_select(true);
+}
+
+/* Selects the SIMD implementations if SIMD is true and the CPU has
+   them, and the scalar ones otherwise.  Returns true if any SIMD
+   implementation is now selected.  For tests and benchmarks. */
+bool bulk_select(bool simd) {
+  xor_fn = xor_scalar;
+  csum_fn = csum_scalar;
+  crc32_fn = crc32_scalar;
+  impl_name = "scalar";
+#ifdef __i386__
+  if (simd && has_sse2) {
+    xor_fn = xor_sse2;
+    csum_fn = csum_sse2;
+    impl_name = "sse2";
+  }
+  if (simd && has_pclmul) {
+    crc32_fn = crc32_pclmul;
+    impl_name = "sse2+pclmul";
+  }
+#endif
+  return xor_fn != xor_scalar;
+}
+
+/* Returns the name of the implementations in use. */
+const char* bulk_impl(void) { return impl_name; }
+
+void bulk_xor(void* dst, const void* const src[], size_t src_cnt, size_t size) {
+  xor_fn(dst, src, src_cnt, size);
+}
+
+uint32_t bulk_csum(const void* data, size_t len, uint32_t sum) { return csum_fn(data, len, sum); }
+
+uint32_t bulk_crc32(uint32_t crc, const void* data, size_t len) { return crc32_fn(crc, data, len); }
+
+/* Scalar implementations. */
+
+static void xor_scalar(void* dst, const void* const src[], size_t src_cnt, size_t size) {
+  xor_range(dst, src, src_cnt, 0, size);
+}
+
+/* XORs bytes OFS through SIZE - 1 of the SRC_CNT buffers in SRC into
+   the same bytes of DST, a word at a time if every buffer is aligned
+   alike. */
+static void xor_range(uint8_t* dst, const void* const src[], size_t src_cnt, size_t ofs, size_t size) {
+  uintptr_t misalign = (uintptr_t)(dst + ofs);
+  size_t i;
+
+  for (i = 0; i < src_cnt; i++)
+    misalign |= (uintptr_t)src[i] + ofs;
+
+  if (misalign % WORD_SIZE == 0)
+    for (; ofs + WORD_SIZE <= size; ofs += WORD_SIZE) {
+      word_t w = *(word_t*)(dst + ofs);
+      for (i = 0; i < src_cnt; i++)
+        w ^= *(const word_t*)((const uint8_t*)src[i] + ofs);
+      *(word_t*)(dst + ofs) = w;
+    }
+
+  for (; ofs < size; ofs++) {
+    uint8_t b = dst[ofs];
+    for (i = 0; i < src_cnt; i++)
+      b ^= ((const uint8_t*)src[i])[ofs];
+    dst[ofs] = b;
+  }
+}
+
+static uint32_t csum_scalar(const void* data, size_t len, uint32_t sum) {
+  const uint8_t* bytes = data;
+
+  while (len >= 2) {
+    sum += (bytes[0] << 8) | bytes[1];
+    bytes += 2;
+    len -= 2;
+  }
+  if (len > 0)
+    sum += bytes[0] << 8;
+  return sum;
+}
+
+/* CRC-32 lookup table for polynomial 0xedb88320. */
+static const uint32_t crc32_table[256] = {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
+    0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
+    0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5,
+    0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
+    0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599, 0xb8bda50f,
+    0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924, 0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,
+    0x76dc4190, 0x01db7106, 0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
+    0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
+    0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb,
+    0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9,
+    0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad,
+    0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a, 0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683,
+    0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7,
+    0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
+    0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
+    0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236, 0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f,
+    0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
+    0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21,
+    0x86d3d2d4, 0xf1d4e242, 0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45,
+    0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db,
+    0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
+    0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
+
+static uint32_t crc32_scalar(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* bytes = data;
+
+  while (len-- > 0)
+    crc = (crc >> 8) ^ crc32_table[(crc ^ *bytes++) & 0xff];
+  return crc;
+}
+
+#ifdef __i386__
+
+/* SSE implementations.  The kernel is compiled without -msse, so
+   these functions enable the extensions they use with the target
+   attribute; each asm statement is self-contained. */
+
+#define SSE2 __attribute__((target("sse2")))
+#define PCLMUL __attribute__((target("sse2,pclmul")))
+
+SSE2 static void xor_sse2(void* dst_, const void* const src[], size_t src_cnt, size_t size) {
+  uint8_t* dst = dst_;
+  size_t chunks = size / 64;
+  size_t i;
+
+  if (size < SIMD_MIN_SIZE) {
+    xor_scalar(dst, src, src_cnt, size);
+    return;
+  }
+
+  /* One pass per source.  A sector stays in the cache between
+     passes, so this costs little over XORing all sources at once. */
+  kernel_simd_begin();
+  for (i = 0; i < src_cnt; i++) {
+    uint8_t* d = dst;
+    const uint8_t* s = src[i];
+    size_t n = chunks;
+    asm volatile("1:\n\t"
+                 "movdqu (%0), %%xmm0\n\t"
+                 "movdqu 16(%0), %%xmm1\n\t"
+                 "movdqu 32(%0), %%xmm2\n\t"
+                 "movdqu 48(%0), %%xmm3\n\t"
+                 "movdqu (%1), %%xmm4\n\t"
+                 "movdqu 16(%1), %%xmm5\n\t"
+                 "movdqu 32(%1), %%xmm6\n\t"
+                 "movdqu 48(%1), %%xmm7\n\t"
+                 "pxor %%xmm4, %%xmm0\n\t"
+                 "pxor %%xmm5, %%xmm1\n\t"
+                 "pxor %%xmm6, %%xmm2\n\t"
+                 "pxor %%xmm7, %%xmm3\n\t"
+                 "movdqu %%xmm0, (%0)\n\t"
+                 "movdqu %%xmm1, 16(%0)\n\t"
+                 "movdqu %%xmm2, 32(%0)\n\t"
+                 "movdqu %%xmm3, 48(%0)\n\t"
+                 "addl $64, %0\n\t"
+                 "addl $64, %1\n\t"
+                 "decl %2\n\t"
+                 "jnz 1b"
+                 : "+r"(d), "+r"(s), "+r"(n)
+                 :
+                 : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory", "cc");
+  }
+  kernel_simd_end();
+
+  xor_range(dst, src, src_cnt, chunks * 64, size);
+}
+
+/* 32-byte blocks summed into 32-bit lanes before the lanes are added
+   up.  Each lane gains at most 2 * 0xffff per block, so this many
+   blocks cannot overflow one. */
+#define CSUM_CHUNK_BLOCKS 16384
+
+/* Sums the data as little-endian words, 16 at a time in four 32-bit
+   lanes of each of two registers, then byte-swaps the folded sum:
+   the one's complement sum of byte-swapped words is the byte-swapped
+   sum of the words [RFC 1071]. */
+SSE2 static uint32_t csum_sse2(const void* data, size_t len, uint32_t sum) {
+  const uint8_t* p = data;
+  uint32_t lanes[8] __attribute__((aligned(16)));
+  uint64_t acc = 0;
+  size_t blocks, i;
+
+  if (len < SIMD_MIN_SIZE)
+    return csum_scalar(data, len, sum);
+
+  kernel_simd_begin();
+  while (len >= 32) {
+    blocks = len / 32 < CSUM_CHUNK_BLOCKS ? len / 32 : CSUM_CHUNK_BLOCKS;
+    len -= blocks * 32;
+    asm volatile("pxor %%xmm0, %%xmm0\n\t"
+                 "pxor %%xmm1, %%xmm1\n\t"
+                 "pxor %%xmm7, %%xmm7\n"
+                 "1:\n\t"
+                 "movdqu (%0), %%xmm2\n\t"
+                 "movdqu 16(%0), %%xmm4\n\t"
+                 "movdqa %%xmm2, %%xmm3\n\t"
+                 "movdqa %%xmm4, %%xmm5\n\t"
+                 "punpcklwd %%xmm7, %%xmm2\n\t"
+                 "punpckhwd %%xmm7, %%xmm3\n\t"
+                 "punpcklwd %%xmm7, %%xmm4\n\t"
+                 "punpckhwd %%xmm7, %%xmm5\n\t"
+                 "paddd %%xmm2, %%xmm0\n\t"
+                 "paddd %%xmm3, %%xmm1\n\t"
+                 "paddd %%xmm4, %%xmm0\n\t"
+                 "paddd %%xmm5, %%xmm1\n\t"
+                 "addl $32, %0\n\t"
+                 "decl %1\n\t"
+                 "jnz 1b\n\t"
+                 "movdqa %%xmm0, (%2)\n\t"
+                 "movdqa %%xmm1, 16(%2)"
+                 : "+r"(p), "+r"(blocks)
+                 : "r"(lanes)
+                 : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm7", "memory", "cc");
+    for (i = 0; i < 8; i++)
+      acc += lanes[i];
+  }
+  kernel_simd_end();
+
+  while (acc >> 16)
+    acc = (acc & 0xffff) + (acc >> 16);
+  sum += ((acc & 0xff) << 8) | (acc >> 8);
+  return csum_scalar(p, len, sum);
+}
+
+/* Folding constants for the reflected CRC-32 polynomial, each pair
+   low quadword first: x^(4*128+32) and x^(4*128-32) mod P for
+   folding 512 bits at a time, x^(128+32) and x^(128-32) for 128
+   bits, x^64 for the final 64-to-32-bit step, and P and the Barrett
+   constant floor(x^64 / P), all bit-reflected.  See Gopal et al.,
+   "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+   Instruction" (Intel, 2009). */
+static const uint64_t crc_k1k2[2] __attribute__((aligned(16))) = {0x154442bd4ull, 0x1c6e41596ull};
+static const uint64_t crc_k3k4[2] __attribute__((aligned(16))) = {0x1751997d0ull, 0x0ccaa009eull};
+static const uint64_t crc_k5[2] __attribute__((aligned(16))) = {0x163cd6124ull, 0};
+static const uint64_t crc_mask32[2] __attribute__((aligned(16))) = {0xffffffffull, 0};
+static const uint64_t crc_poly_mu[2] __attribute__((aligned(16))) = {0x1db710641ull, 0x1f7011641ull};
+
+/* Folds the data into four 128-bit accumulators with carry-less
+   multiplies, 64 bytes per step, then folds those into one and
+   reduces it to 32 bits. */
+PCLMUL static uint32_t crc32_pclmul(uint32_t crc, const void* data, size_t len) {
+  const uint8_t* p = data;
+  size_t head, n;
+
+  if (len < SIMD_MIN_SIZE)
+    return crc32_scalar(crc, data, len);
+
+  /* The folding loop reads whole aligned 16-byte blocks, at least
+     four of them. */
+  head = -(uintptr_t)p & 15;
+  crc = crc32_scalar(crc, p, head);
+  p += head;
+  len -= head;
+  n = len & ~(size_t)15;
+  len -= n;
+  ASSERT(n >= 64);
+
+  kernel_simd_begin();
+  asm volatile(
+      /* Load the first 64 bytes and fold in the CRC so far. */
+      "movdqa (%0), %%xmm1\n\t"
+      "movdqa 16(%0), %%xmm2\n\t"
+      "movdqa 32(%0), %%xmm3\n\t"
+      "movdqa 48(%0), %%xmm4\n\t"
+      "movd %2, %%xmm0\n\t"
+      "pxor %%xmm0, %%xmm1\n\t"
+      "subl $64, %1\n\t"
+      "addl $64, %0\n\t"
+      "cmpl $64, %1\n\t"
+      "jb 2f\n\t"
+
+      /* Fold 64 bytes at a time. */
+      "movdqa %3, %%xmm0\n"
+      "1:\n\t"
+      "movdqa %%xmm1, %%xmm5\n\t"
+      "movdqa %%xmm2, %%xmm6\n\t"
+      "movdqa %%xmm3, %%xmm7\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm2\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm3\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm6\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm7\n\t"
+      "pxor %%xmm5, %%xmm1\n\t"
+      "pxor %%xmm6, %%xmm2\n\t"
+      "pxor %%xmm7, %%xmm3\n\t"
+      "movdqa %%xmm4, %%xmm5\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm4\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pxor %%xmm5, %%xmm4\n\t"
+      "pxor (%0), %%xmm1\n\t"
+      "pxor 16(%0), %%xmm2\n\t"
+      "pxor 32(%0), %%xmm3\n\t"
+      "pxor 48(%0), %%xmm4\n\t"
+      "subl $64, %1\n\t"
+      "addl $64, %0\n\t"
+      "cmpl $64, %1\n\t"
+      "jae 1b\n"
+
+      /* Fold the four accumulators into one. */
+      "2:\n\t"
+      "movdqa %4, %%xmm0\n\t"
+      "movdqa %%xmm1, %%xmm5\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pxor %%xmm5, %%xmm1\n\t"
+      "pxor %%xmm2, %%xmm1\n\t"
+      "movdqa %%xmm1, %%xmm5\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pxor %%xmm5, %%xmm1\n\t"
+      "pxor %%xmm3, %%xmm1\n\t"
+      "movdqa %%xmm1, %%xmm5\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pxor %%xmm5, %%xmm1\n\t"
+      "pxor %%xmm4, %%xmm1\n\t"
+
+      /* Fold in the remaining 16-byte blocks. */
+      "cmpl $16, %1\n\t"
+      "jb 4f\n"
+      "3:\n\t"
+      "movdqa %%xmm1, %%xmm5\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+      "pxor %%xmm5, %%xmm1\n\t"
+      "pxor (%0), %%xmm1\n\t"
+      "subl $16, %1\n\t"
+      "addl $16, %0\n\t"
+      "cmpl $16, %1\n\t"
+      "jae 3b\n"
+
+      /* Reduce 128 bits to 64, then to 32. */
+      "4:\n\t"
+      "pclmulqdq $0x01, %%xmm1, %%xmm0\n\t"
+      "psrldq $8, %%xmm1\n\t"
+      "pxor %%xmm0, %%xmm1\n\t"
+      "movdqa %%xmm1, %%xmm2\n\t"
+      "movdqa %5, %%xmm0\n\t"
+      "movdqa %6, %%xmm3\n\t"
+      "psrldq $4, %%xmm2\n\t"
+      "pand %%xmm3, %%xmm1\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pxor %%xmm2, %%xmm1\n\t"
+
+      /* Barrett reduction. */
+      "movdqa %7, %%xmm0\n\t"
+      "movdqa %%xmm1, %%xmm2\n\t"
+      "pand %%xmm3, %%xmm1\n\t"
+      "pclmulqdq $0x10, %%xmm0, %%xmm1\n\t"
+      "pand %%xmm3, %%xmm1\n\t"
+      "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+      "pxor %%xmm2, %%xmm1\n\t"
+      "psrldq $4, %%xmm1\n\t"
+      "movd %%xmm1, %2"
+      : "+r"(p), "+r"(n), "+r"(crc)
+      : "m"(crc_k1k2), "m"(crc_k3k4), "m"(crc_k5), "m"(crc_mask32), "m"(crc_poly_mu)
+      : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", "memory", "cc");
+  kernel_simd_end();
+
+  return crc32_scalar(crc, p, len);
+}
+
+#endif
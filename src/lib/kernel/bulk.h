@@ -0,0 +1,42 @@
+#ifndef __LIB_KERNEL_BULK_H
+#define __LIB_KERNEL_BULK_H
+
+/* Bulk data kernels: XOR parity, the Internet checksum and CRC-32.
+
+   Each has a portable scalar implementation and, on i386, a faster
+   one that processes 16 bytes per instruction in the SSE registers:
+   SSE2 for XOR and the checksum, and PCLMULQDQ carry-less multiplies
+   for the CRC.  bulk_init() picks the fastest the CPU supports, as
+   reported by CPUID.  Until then, and on CPUs without the needed
+   extensions, the scalar versions run.
+
+   The SSE versions run between kernel_simd_begin() and
+   kernel_simd_end() (see threads/fpu.h), so they may be called from
+   any context, but they keep interrupts off for the length of the
+   call.  Short buffers take the scalar path, where the cost of
+   borrowing the FPU outweighs the gain. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void bulk_init(void);
+bool bulk_select(bool simd);
+const char* bulk_impl(void);
+
+/* XORs the SRC_CNT buffers in SRC into DST.  All are SIZE bytes. */
+void bulk_xor(void* dst, const void* const src[], size_t src_cnt, size_t size);
+
+/* Adds the LEN bytes at DATA, as big-endian 16-bit words with a
+   final odd byte padded with zero, to the one's complement sum SUM.
+   Returns the new sum, unfolded.  The result need not equal a
+   straightforward 32-bit sum of the words, but it folds to the same
+   16-bit value. */
+uint32_t bulk_csum(const void* data, size_t len, uint32_t sum);
+
+/* Feeds the LEN bytes at DATA into CRC, a CRC-32 (IEEE 802.3,
+   reflected polynomial 0xedb88320) state, and returns the new state.
+   The caller does any initial and final inversion. */
+uint32_t bulk_crc32(uint32_t crc, const void* data, size_t len);
+
+#endif /* lib/kernel/bulk.h */
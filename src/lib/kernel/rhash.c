@@ -0,0 +1,272 @@
+/* Open-addressing hash table.
+
+   See rhash.h for basic information. */
+
+#include "rhash.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Smallest array the table allocates. */
+#define MIN_SLOTS 16
+
+/* Slots of the old array moved per insertion or deletion while the
+   table is growing.  Must be at least 2, so that the old array is
+   empty before the new one fills up. */
+#define MOVE_STEP 8
+
+/* Marks a slot of the old array whose element has been moved or
+   deleted.  Probes pass over it, so the elements after it stay
+   reachable. */
+static char moved_marker;
+#define MOVED ((void*)&moved_marker)
+
+static void* find_in(const struct rhash*, struct rhash_slot*, size_t slot_cnt, unsigned hash,
+                     const void* key, size_t* idx);
+static void place(struct rhash_slot*, size_t slot_cnt, unsigned hash, void* elem);
+static void move_some(struct rhash*, size_t cnt);
+static bool grow(struct rhash*);
+
+/* Initializes hash table H to compare elements with keys using EQ,
+   given auxiliary data AUX.  Allocates nothing until the first
+   insertion, so it cannot fail. */
+void rhash_init(struct rhash* h, rhash_eq_func* eq, void* aux) {
+  h->elem_cnt = 0;
+  h->slot_cnt = 0;
+  h->slots = NULL;
+  h->old = NULL;
+  h->old_cnt = 0;
+  h->moved = 0;
+  h->eq = eq;
+  h->aux = aux;
+}
+
+/* Destroys hash table H, leaving it empty.
+
+   If DESTRUCTOR is non-null, then it is first called for each
+   element in the table.  DESTRUCTOR may deallocate the element, but
+   must not modify H. */
+void rhash_destroy(struct rhash* h, rhash_action_func* destructor) {
+  if (destructor != NULL) {
+    struct rhash_iterator i;
+    void* elem;
+
+    rhash_first(&i, h);
+    while ((elem = rhash_next(&i)) != NULL)
+      destructor(elem, h->aux);
+  }
+  free(h->slots);
+  free(h->old);
+  rhash_init(h, h->eq, h->aux);
+}
+
+/* Returns the element in H with KEY, whose hash value is HASH, or a
+   null pointer if there is none. */
+void* rhash_find(const struct rhash* h, unsigned hash, const void* key) {
+  size_t idx;
+  void* elem = find_in(h, h->slots, h->slot_cnt, hash, key, &idx);
+  if (elem == NULL && h->old != NULL)
+    elem = find_in(h, h->old, h->old_cnt, hash, key, &idx);
+  return elem;
+}
+
+/* Inserts ELEM, whose key is KEY with hash value HASH, into H.
+   Returns false without inserting it if H already has an element
+   with KEY, or if H is full and memory to grow it is short. */
+bool rhash_insert(struct rhash* h, unsigned hash, const void* key, void* elem) {
+  ASSERT(elem != NULL && elem != MOVED);
+
+  if (rhash_find(h, hash, key) != NULL)
+    return false;
+
+  /* Grow at 3/4 full.  If that fails, carry on while a slot is free. */
+  if (h->elem_cnt >= h->slot_cnt / 4 * 3 && !grow(h) && h->elem_cnt == h->slot_cnt)
+    return false;
+
+  place(h->slots, h->slot_cnt, hash, elem);
+  h->elem_cnt++;
+  move_some(h, MOVE_STEP);
+  return true;
+}
+
+/* Removes the element with KEY, whose hash value is HASH, from H
+   and returns it, or returns a null pointer if there is none. */
+void* rhash_delete(struct rhash* h, unsigned hash, const void* key) {
+  size_t mask = h->slot_cnt - 1;
+  size_t idx;
+  void* elem;
+
+  elem = find_in(h, h->slots, h->slot_cnt, hash, key, &idx);
+  if (elem != NULL) {
+    /* Shift each following element that is away from its home
+       slot back by one. */
+    for (;;) {
+      size_t next = (idx + 1) & mask;
+      struct rhash_slot* s = &h->slots[next];
+      if (s->elem == NULL || (s->hash & mask) == next)
+        break;
+      h->slots[idx] = *s;
+      idx = next;
+    }
+    h->slots[idx].elem = NULL;
+  } else if (h->old != NULL) {
+    elem = find_in(h, h->old, h->old_cnt, hash, key, &idx);
+    if (elem != NULL)
+      h->old[idx].elem = MOVED;
+  }
+
+  if (elem != NULL) {
+    h->elem_cnt--;
+    move_some(h, MOVE_STEP);
+  }
+  return elem;
+}
+
+/* Initializes I for iterating hash table H.
+
+   Iteration idiom:
+
+      struct rhash_iterator i;
+      void* elem;
+
+      rhash_first (&i, h);
+      while ((elem = rhash_next (&i)) != NULL)
+        {
+          ...do something with elem...
+        }
+
+   Modifying hash table H during iteration, using any of the
+   functions rhash_destroy(), rhash_insert(), or rhash_delete(),
+   invalidates all iterators. */
+void rhash_first(struct rhash_iterator* i, struct rhash* h) {
+  ASSERT(i != NULL);
+  ASSERT(h != NULL);
+
+  i->rhash = h;
+  i->idx = 0;
+}
+
+/* Returns the next element in the table, or a null pointer once
+   every element has been returned.  Elements are returned in no
+   particular order. */
+void* rhash_next(struct rhash_iterator* i) {
+  struct rhash* h = i->rhash;
+
+  while (i->idx < h->slot_cnt + h->old_cnt) {
+    size_t idx = i->idx++;
+    void* elem = idx < h->slot_cnt ? h->slots[idx].elem : h->old[idx - h->slot_cnt].elem;
+    if (elem != NULL && elem != MOVED)
+      return elem;
+  }
+  return NULL;
+}
+
+/* Returns the number of elements in H. */
+size_t rhash_size(const struct rhash* h) { return h->elem_cnt; }
+
+/* Returns a hash of integer I.  Every bit of I affects the low bits
+   of the result, which are the ones that pick a slot, so keys that
+   differ only in high bits, such as page addresses, spread out. */
+unsigned rhash_int(uint32_t i) {
+  /* Finalizer of MurmurHash3. */
+  i ^= i >> 16;
+  i *= 0x85ebca6b;
+  i ^= i >> 13;
+  i *= 0xc2b2ae35;
+  i ^= i >> 16;
+  return i;
+}
+
+/* Searches the SLOT_CNT slots in SLOTS for the element of H with KEY,
+   whose hash value is HASH.  If found, stores its index in *IDX and
+   returns it; otherwise, returns a null pointer. */
+static void* find_in(const struct rhash* h, struct rhash_slot* slots, size_t slot_cnt, unsigned hash,
+                     const void* key, size_t* idx) {
+  size_t mask = slot_cnt - 1;
+  size_t i = hash & mask;
+
+  for (size_t dist = 0; dist < slot_cnt; dist++, i = (i + 1) & mask) {
+    struct rhash_slot* s = &slots[i];
+
+    /* An empty slot, or an element nearer its home than KEY would
+       be here, means KEY is absent. */
+    if (s->elem == NULL || ((i - s->hash) & mask) < dist)
+      return NULL;
+
+    if (s->hash == hash && s->elem != MOVED && h->eq(s->elem, key, h->aux)) {
+      *idx = i;
+      return s->elem;
+    }
+  }
+  return NULL;
+}
+
+/* Places ELEM, with hash value HASH, in the SLOT_CNT slots in SLOTS,
+   which must have a free slot. */
+static void place(struct rhash_slot* slots, size_t slot_cnt, unsigned hash, void* elem) {
+  size_t mask = slot_cnt - 1;
+  size_t i = hash & mask;
+  struct rhash_slot cur = {hash, elem};
+
+  for (size_t dist = 0;; dist++, i = (i + 1) & mask) {
+    struct rhash_slot* s = &slots[i];
+    size_t s_dist;
+
+    if (s->elem == NULL) {
+      *s = cur;
+      return;
+    }
+
+    /* Take the slot from an element that is closer to home. */
+    s_dist = (i - s->hash) & mask;
+    if (s_dist < dist) {
+      struct rhash_slot tmp = *s;
+      *s = cur;
+      cur = tmp;
+      dist = s_dist;
+    }
+  }
+}
+
+/* Moves up to CNT slots of H's old array into its current one, and
+   frees the old array once it has all been moved. */
+static void move_some(struct rhash* h, size_t cnt) {
+  if (h->old == NULL)
+    return;
+
+  for (; cnt > 0 && h->moved < h->old_cnt; cnt--) {
+    struct rhash_slot* s = &h->old[h->moved++];
+    if (s->elem != NULL && s->elem != MOVED) {
+      place(h->slots, h->slot_cnt, s->hash, s->elem);
+      s->elem = MOVED;
+    }
+  }
+
+  if (h->moved == h->old_cnt) {
+    free(h->old);
+    h->old = NULL;
+    h->old_cnt = 0;
+    h->moved = 0;
+  }
+}
+
+/* Doubles the size of H's array, or allocates its first one, and
+   starts moving its elements into the new one.  Finishes any move
+   already in progress first.  Returns false if memory is short. */
+static bool grow(struct rhash* h) {
+  size_t new_cnt = h->slot_cnt == 0 ? MIN_SLOTS : h->slot_cnt * 2;
+  struct rhash_slot* new_slots;
+
+  if (new_cnt <= h->slot_cnt)
+    return false;
+  new_slots = calloc(new_cnt, sizeof *new_slots);
+  if (new_slots == NULL)
+    return false;
+
+  move_some(h, h->old_cnt);
+  h->old = h->slots;
+  h->old_cnt = h->slot_cnt;
+  h->moved = 0;
+  h->slots = new_slots;
+  h->slot_cnt = new_cnt;
+  return true;
+}
@@ -0,0 +1,86 @@
+#ifndef __LIB_KERNEL_RHASH_H
+#define __LIB_KERNEL_RHASH_H
+
+/* Open-addressing hash table.
+
+   Unlike lib/kernel/hash.h, elements are not chained: the table is
+   a single array of slots, each holding an element pointer and the
+   element's hash value.  A lookup probes consecutive slots from the
+   one the hash selects, comparing stored hash values and calling the
+   equality function only when they match, so most lookups touch one
+   or two adjacent slots and no element memory.
+
+   Insertion uses Robin Hood hashing: an element that has probed
+   further from its home slot than the slot's occupant takes the slot
+   and the occupant moves on.  This keeps probe sequences short and
+   lets a search stop as soon as it reaches an element closer to home
+   than the key would be.  Deletion shifts the following elements
+   back instead of leaving tombstones.
+
+   The table doubles when it becomes 3/4 full.  Rather than rehashing
+   every element at once, each later insertion or deletion moves a
+   few slots' worth from the old array to the new one; lookups check
+   both arrays until the move finishes.
+
+   The table stores pointers and never owns or moves the elements,
+   so a pointer returned by rhash_find() stays valid until the caller
+   frees the element.  Keys are passed separately from elements, and
+   the caller supplies the hash value of each key, so a lookup needs
+   no dummy element. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Returns true if element ELEM has key KEY, given auxiliary data
+   AUX. */
+typedef bool rhash_eq_func(const void* elem, const void* key, void* aux);
+
+/* Performs some operation on element ELEM, given auxiliary data
+   AUX. */
+typedef void rhash_action_func(void* elem, void* aux);
+
+/* A slot.  ELEM is a null pointer if the slot is empty. */
+struct rhash_slot {
+  unsigned hash; /* Hash value of ELEM's key. */
+  void* elem;    /* Element. */
+};
+
+/* Hash table. */
+struct rhash {
+  size_t elem_cnt;          /* Number of elements in both arrays. */
+  size_t slot_cnt;          /* Number of slots, 0 or a power of 2. */
+  struct rhash_slot* slots; /* Array of `slot_cnt' slots. */
+  struct rhash_slot* old;   /* Array being moved into `slots', or null. */
+  size_t old_cnt;           /* Number of slots in `old'. */
+  size_t moved;             /* Slots of `old' already moved. */
+  rhash_eq_func* eq;        /* Equality function. */
+  void* aux;                /* Auxiliary data for `eq'. */
+};
+
+/* A hash table iterator. */
+struct rhash_iterator {
+  struct rhash* rhash; /* The hash table. */
+  size_t idx;          /* Next slot, counting `slots' then `old'. */
+};
+
+/* Basic life cycle. */
+void rhash_init(struct rhash*, rhash_eq_func*, void* aux);
+void rhash_destroy(struct rhash*, rhash_action_func*);
+
+/* Search, insertion, deletion. */
+void* rhash_find(const struct rhash*, unsigned hash, const void* key);
+bool rhash_insert(struct rhash*, unsigned hash, const void* key, void* elem);
+void* rhash_delete(struct rhash*, unsigned hash, const void* key);
+
+/* Iteration. */
+void rhash_first(struct rhash_iterator*, struct rhash*);
+void* rhash_next(struct rhash_iterator*);
+
+/* Information. */
+size_t rhash_size(const struct rhash*);
+
+/* Sample hash function. */
+unsigned rhash_int(uint32_t);
+
+#endif /* lib/kernel/rhash.h */
@@ -0,0 +1,47 @@
+#ifndef __LIB_POLL_H
+#define __LIB_POLL_H
+
+#include <stdint.h>
+
+/* Readiness events, for poll() and epoll. */
+#define POLLIN 0x001   /* Data may be read without blocking. */
+#define POLLOUT 0x004  /* Data may be written without blocking. */
+#define POLLERR 0x008  /* Error; for a pipe's write end, no reader remains. */
+#define POLLHUP 0x010  /* Hung up; for a pipe's read end, no writer remains. */
+#define POLLNVAL 0x020 /* Descriptor not open. */
+
+/* One descriptor watched by poll(). */
+struct pollfd {
+  int fd;        /* Descriptor, or negative to skip this entry. */
+  short events;  /* Events of interest. */
+  short revents; /* Events that occurred, set by poll(). */
+};
+
+/* The same events, as reported by epoll_wait(), plus modes for
+   epoll_ctl().  EPOLLERR and EPOLLHUP are always reported. */
+#define EPOLLIN POLLIN
+#define EPOLLOUT POLLOUT
+#define EPOLLERR POLLERR
+#define EPOLLHUP POLLHUP
+#define EPOLLONESHOT (1u << 30) /* Report once, then ignore until modified. */
+#define EPOLLET (1u << 31)      /* Report on changes only (edge-triggered). */
+
+/* epoll_ctl() operations. */
+#define EPOLL_CTL_ADD 1 /* Start watching a descriptor. */
+#define EPOLL_CTL_DEL 2 /* Stop watching it. */
+#define EPOLL_CTL_MOD 3 /* Change its events and data. */
+
+/* Caller's data, returned with each event. */
+typedef union epoll_data {
+  void* ptr;
+  int fd;
+  uint32_t u32;
+  uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+  uint32_t events;   /* Events of interest or that occurred. */
+  epoll_data_t data; /* Returned unchanged. */
+};
+
+#endif /* lib/poll.h */
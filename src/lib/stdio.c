@@ -569,6 +569,8 @@ void hex_dump(uintptr_t ofs, const void* buf_, size_t size, bool ascii) {
   while (size > 0) {
     size_t start, end, n;
     size_t i;
+    char line[96]; /* Offset, hex and ASCII columns, and new-line. */
+    char* p = line;
 
     /* Number of bytes on this line. */
     start = ofs % per_line;
@@ -577,25 +579,27 @@ void hex_dump(uintptr_t ofs, const void* buf_, size_t size, bool ascii) {
       end = start + size;
     n = end - start;
 
-    /* Print line. */
-    printf("%08llx  ", (unsigned long long)ROUND_DOWN(ofs, per_line));
+    /* Format the line, then print it all at once. */
+    p += snprintf(p, 11, "%08llx  ", (unsigned long long)ROUND_DOWN(ofs, per_line));
     for (i = 0; i < start; i++)
-      printf("   ");
+      p += snprintf(p, 4, "   ");
     for (; i < end; i++)
-      printf("%02hhx%c", buf[i - start], i == per_line / 2 - 1 ? '-' : ' ');
+      p += snprintf(p, 4, "%02hhx%c", buf[i - start], i == per_line / 2 - 1 ? '-' : ' ');
     if (ascii) {
       for (; i < per_line; i++)
-        printf("   ");
-      printf("|");
+        p += snprintf(p, 4, "   ");
+      *p++ = '|';
       for (i = 0; i < start; i++)
-        printf(" ");
+        *p++ = ' ';
       for (; i < end; i++)
-        printf("%c", isprint(buf[i - start]) ? buf[i - start] : '.');
+        *p++ = isprint(buf[i - start]) ? buf[i - start] : '.';
       for (; i < per_line; i++)
-        printf(" ");
-      printf("|");
+        *p++ = ' ';
+      *p++ = '|';
     }
-    printf("\n");
+    *p++ = '\n';
+    *p = '\0';
+    printf("%s", line);
 
     ofs += n;
     buf += n;
@@ -1,10 +1,92 @@
 #include <string.h>
 #include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
 // GCC erroneously emits a nonnull-compare error in the expansion of the ASSERT
 // macro in many places where it is used in this file, even though nothing is
 // marked as nonnull.
 #pragma GCC diagnostic ignored "-Wnonnull-compare"
 
+/* memcpy(), memmove() and memset() move whole words where they can.
+   On i386 they use the string instructions, which handle any
+   alignment, "rep movsl" and "rep stosl".  Elsewhere they use word
+   loops, which need DST and SRC to be equally aligned, and fall
+   back to bytes when they are not.  Blocks shorter than WORD_MIN bytes
+   are always done a byte at a time. */
+
+/* A machine word that may alias any other type. */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WORD_SIZE sizeof(word_t)
+#define WORD_MIN (4 * WORD_SIZE)
+
+/* Returns true if P is a multiple of WORD_SIZE. */
+static inline bool word_aligned(const void* p) { return ((uintptr_t)p & (WORD_SIZE - 1)) == 0; }
+
+/* Copies SIZE bytes from SRC to DST, lowest address first. */
+static void copy_up(unsigned char* dst, const unsigned char* src, size_t size) {
+  if (size >= WORD_MIN) {
+#ifdef __i386__
+    /* Align DST; the CPU copes with an unaligned SRC. */
+    while (!word_aligned(dst)) {
+      *dst++ = *src++;
+      size--;
+    }
+    size_t words = size / WORD_SIZE;
+    size %= WORD_SIZE;
+    asm volatile("rep movsl" : "+D"(dst), "+S"(src), "+c"(words) : : "memory");
+#else
+    if (((uintptr_t)dst ^ (uintptr_t)src) % WORD_SIZE == 0) {
+      while (!word_aligned(dst)) {
+        *dst++ = *src++;
+        size--;
+      }
+      for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+        *(word_t*)dst = *(const word_t*)src;
+        dst += WORD_SIZE;
+        src += WORD_SIZE;
+      }
+    }
+#endif
+  }
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+/* Copies SIZE bytes from SRC to DST, highest address first.  DST and
+   SRC point just past the end of the blocks. */
+static void copy_down(unsigned char* dst, const unsigned char* src, size_t size) {
+  if (size >= WORD_MIN) {
+#ifdef __i386__
+    while (!word_aligned(dst)) {
+      *--dst = *--src;
+      size--;
+    }
+    size_t words = size / WORD_SIZE;
+    size %= WORD_SIZE;
+    dst -= WORD_SIZE;
+    src -= WORD_SIZE;
+    asm volatile("std; rep movsl; cld" : "+D"(dst), "+S"(src), "+c"(words) : : "memory", "cc");
+    dst += WORD_SIZE;
+    src += WORD_SIZE;
+#else
+    if (((uintptr_t)dst ^ (uintptr_t)src) % WORD_SIZE == 0) {
+      while (!word_aligned(dst)) {
+        *--dst = *--src;
+        size--;
+      }
+      for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+        dst -= WORD_SIZE;
+        src -= WORD_SIZE;
+        *(word_t*)dst = *(const word_t*)src;
+      }
+    }
+#endif
+  }
+  while (size-- > 0)
+    *--dst = *--src;
+}
+
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
 void* memcpy(void* dst_, const void* src_, size_t size) {
@@ -14,8 +96,7 @@ void* memcpy(void* dst_, const void* src_, size_t size) {
   ASSERT(dst != NULL || size == 0);
   ASSERT(src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
+  copy_up(dst, src, size);
 
   return dst_;
 }
@@ -29,17 +110,12 @@ void* memmove(void* dst_, const void* src_, size_t size) {
   ASSERT(dst != NULL || size == 0);
   ASSERT(src != NULL || size == 0);
 
-  if (dst < src) {
-    while (size-- > 0)
-      *dst++ = *src++;
-  } else {
-    dst += size;
-    src += size;
-    while (size-- > 0)
-      *--dst = *--src;
-  }
+  if (dst < src)
+    copy_up(dst, src, size);
+  else
+    copy_down(dst + size, src + size, size);
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -251,6 +327,24 @@ void* memset(void* dst_, int value, size_t size) {
 
   ASSERT(dst != NULL || size == 0);
 
+  if (size >= WORD_MIN) {
+    word_t fill = (unsigned char)value * (~(word_t)0 / 0xff);
+
+    while (!word_aligned(dst)) {
+      *dst++ = value;
+      size--;
+    }
+#ifdef __i386__
+    size_t words = size / WORD_SIZE;
+    asm volatile("rep stosl" : "+D"(dst), "+c"(words) : "a"(fill) : "memory");
+#else
+    for (size_t words = size / WORD_SIZE; words > 0; words--) {
+      *(word_t*)dst = fill;
+      dst += WORD_SIZE;
+    }
+#endif
+    size %= WORD_SIZE;
+  }
   while (size-- > 0)
     *dst++ = value;
 
@@ -53,9 +53,54 @@ enum {
 
   /* Extended mmap with full signature. */
   SYS_MMAP2, /* mmap2(addr, length, prot, flags, fd, offset) */
+
+  /* VM statistics. */
+  SYS_VMSTAT, /* Read page-fault and eviction counters. */
+
+  /* Shared memory objects. */
+  SYS_SHM_OPEN,   /* Open or create a named shared memory object. */
+  SYS_SHM_UNLINK, /* Remove a shared memory object's name. */
+
+  /* Process identity. */
+  SYS_GET_PID, /* Gets PID of the current process. */
+
+  /* Positional and vectored I/O. */
+  SYS_PREAD,  /* Read from a file at an offset. */
+  SYS_PWRITE, /* Write to a file at an offset. */
+  SYS_READV,  /* Read into several buffers. */
+  SYS_WRITEV, /* Write from several buffers. */
+
+  /* In-kernel copy. */
+  SYS_COPY_FILE_RANGE, /* Copy data between two files. */
+  SYS_SPLICE,          /* Move data between a pipe and a file. */
+
+  /* Readiness. */
+  SYS_POLL,         /* Wait for events on several descriptors. */
+  SYS_EPOLL_CREATE, /* Create an epoll instance. */
+  SYS_EPOLL_CTL,    /* Change an epoll interest set. */
+  SYS_EPOLL_WAIT,   /* Wait for events from an epoll instance. */
+
+  /* Asynchronous I/O. */
+  SYS_IO_URING_SETUP, /* Create a submission/completion ring. */
+  SYS_IO_URING_ENTER, /* Submit to a ring and wait for completions. */
+
+  /* Tracing. */
+  SYS_SYSTRACE, /* Control system call tracing. */
+
+  /* More user-level synchronization. */
+  SYS_COND_INIT,      /* Initializes a condition variable */
+  SYS_COND_WAIT,      /* Waits on a condition variable */
+  SYS_COND_SIGNAL,    /* Wakes one waiter on a condition variable */
+  SYS_COND_BROADCAST, /* Wakes every waiter on a condition variable */
+  SYS_BARRIER_INIT,   /* Initializes a barrier */
+  SYS_BARRIER_WAIT,   /* Waits at a barrier */
+  SYS_RWLOCK_INIT,    /* Initializes a reader-writer lock */
+  SYS_RWLOCK_ACQUIRE, /* Acquires a reader-writer lock */
+  SYS_RWLOCK_RELEASE, /* Releases a reader-writer lock */
 };
 
 /* mmap flags for SYS_MMAP2. */
+#define MAP_SHARED 0x01    /* Changes are shared with other mappings. */
 #define MAP_PRIVATE 0x02   /* Changes are private (copy-on-write). */
 #define MAP_ANONYMOUS 0x20 /* Don't use a file (zero-filled pages). */
 
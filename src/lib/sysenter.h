@@ -0,0 +1,58 @@
+#ifndef __LIB_SYSENTER_H
+#define __LIB_SYSENTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Fast system call entry on i386, shared between the kernel and
+   user programs.
+
+   "int $0x30" goes through the IDT, pushes a full interrupt frame
+   in microcode, and returns with "iret", which together cost
+   hundreds of cycles before the kernel does any work.  SYSENTER
+   and SYSEXIT switch directly between fixed flat segments and
+   skip all of that.  The kernel sets up the SYSENTER MSRs when
+   sysenter_available() is true, and user programs use the same
+   test to pick the entry method, so both sides always agree.
+
+   Register convention for SYSENTER:
+
+     EAX     system call number; return value on exit.
+     EBX     first argument.
+     ESI     second argument.
+     EDI     third argument.
+     ECX     user stack pointer to return with.
+     EDX     user instruction pointer to return to.
+
+   ECX and EDX are clobbered.  All other registers are preserved.
+   System calls that take more than SYSENTER_MAX_ARGS arguments
+   must use "int $0x30", which remains available in every case. */
+
+/* Arguments that can be passed in registers. */
+#define SYSENTER_MAX_ARGS 3
+
+/* Returns true if the CPU implements SYSENTER and SYSEXIT.  The
+   Pentium Pro reports SEP in CPUID but does not implement the
+   instructions; see [IA32-v2b] "SYSENTER". */
+static inline bool sysenter_available(void) {
+#ifdef __i386__
+  uint32_t max, signature, ebx, ecx, features;
+  unsigned family, model, stepping;
+
+  asm("cpuid" : "=a"(max), "=b"(ebx), "=c"(ecx), "=d"(features) : "a"(0));
+  if (max < 1)
+    return false;
+  asm("cpuid" : "=a"(signature), "=b"(ebx), "=c"(ecx), "=d"(features) : "a"(1));
+  if (!(features & (1u << 11))) /* SEP. */
+    return false;
+
+  family = (signature >> 8) & 0xf;
+  model = (signature >> 4) & 0xf;
+  stepping = signature & 0xf;
+  return !(family == 6 && model < 3 && stepping < 3);
+#else
+  return false;
+#endif
+}
+
+#endif /* lib/sysenter.h */
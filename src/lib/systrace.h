@@ -0,0 +1,59 @@
+#ifndef __LIB_SYSTRACE_H
+#define __LIB_SYSTRACE_H
+
+#include <stdint.h>
+
+/* System call tracing, shared between the kernel and user programs
+   through the SYS_SYSTRACE system call.
+
+   While tracing is on, every system call made by a traced process that
+   returns to user space is counted, with its latency in cycles, in one
+   global statistics block indexed by system call number.  If event
+   logging is on as well, each such call is also appended to a ring of
+   the most recent SYSTRACE_RING_SIZE events, the oldest being
+   overwritten once it is full.  exit() does not return and is never
+   recorded.
+
+   Which processes are traced depends on the mode it was turned on with:
+   SYSTRACE_GLOBAL traces every process, SYSTRACE_CHILDREN only processes
+   the caller starts (with exec() or fork()) from then on, and their
+   descendants.  The caller itself is not traced in the latter mode,
+   which lets a tool trace a command without seeing its own calls.
+
+   When tracing is off, the cost per system call is one load and branch. */
+
+/* Number of system calls that statistics are kept for. */
+#define SYSTRACE_NR 64
+
+/* Number of events the log keeps. */
+#define SYSTRACE_RING_SIZE 256
+
+/* Operations for SYS_SYSTRACE.  The modes turn tracing on and may be
+   combined with SYSTRACE_LOG. */
+#define SYSTRACE_OFF 0      /* Turn tracing off. */
+#define SYSTRACE_GLOBAL 1   /* Trace every process. */
+#define SYSTRACE_CHILDREN 2 /* Trace processes the caller starts from now on. */
+#define SYSTRACE_RESET 3    /* Zero the statistics and empty the log. */
+#define SYSTRACE_STATS 4    /* Copy the statistics into the buffer. */
+#define SYSTRACE_EVENTS 5   /* Move up to SIZE logged events, oldest first, into the buffer. */
+#define SYSTRACE_LOG 0x100  /* With a mode: also log events. */
+
+/* Per-system call statistics. */
+struct systrace_stats {
+  uint64_t calls[SYSTRACE_NR];      /* Calls by number. */
+  uint64_t cycles[SYSTRACE_NR];     /* Total cycles by number. */
+  uint64_t max_cycles[SYSTRACE_NR]; /* Slowest call by number. */
+  uint64_t events_lost;             /* Events overwritten before they were read. */
+};
+
+/* One logged system call. */
+struct systrace_event {
+  int32_t pid;      /* Calling process. */
+  int32_t tid;      /* Calling thread. */
+  int32_t nr;       /* System call number. */
+  int32_t ret;      /* Return value. */
+  uint64_t args[3]; /* First three arguments, whether used or not. */
+  uint64_t cycles;  /* Time in the kernel. */
+};
+
+#endif /* lib/systrace.h */
@@ -0,0 +1,15 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One segment of a readv() or writev() vector. */
+struct iovec {
+  void* iov_base; /* Start of the segment. */
+  size_t iov_len; /* Length of the segment in bytes. */
+};
+
+/* Most segments accepted in one readv() or writev() call. */
+#define IOV_MAX 1024
+
+#endif /* lib/uio.h */
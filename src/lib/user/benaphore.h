@@ -0,0 +1,57 @@
+/* benaphore.h - Internal locking helpers shared by malloc.c and task.c.
+   This file is NOT part of the public API. */
+
+#ifndef LIB_USER_BENAPHORE_H
+#define LIB_USER_BENAPHORE_H
+
+#include <stdbool.h>
+#include <syscall.h>
+
+/* Benaphore: a counter in front of a semaphore, so that taking a free
+   lock or releasing one nobody waits for makes no system call. */
+struct mutex {
+  int users;  /* Threads holding or waiting for the lock. */
+  sema_t sem; /* Waiters sleep here. */
+};
+
+static inline bool mutex_init(struct mutex* m) {
+  m->users = 0;
+  return sema_init(&m->sem, 0);
+}
+
+static inline void mutex_acquire(struct mutex* m) {
+  if (__atomic_fetch_add(&m->users, 1, __ATOMIC_ACQUIRE) != 0)
+    sema_down(&m->sem);
+}
+
+static inline void mutex_release(struct mutex* m) {
+  if (__atomic_fetch_sub(&m->users, 1, __ATOMIC_RELEASE) != 1)
+    sema_up(&m->sem);
+}
+
+/* States of a one-time initialization.  A state variable starts out
+   INIT_NONE. */
+enum { INIT_NONE, INIT_BUSY, INIT_DONE, INIT_FAILED };
+
+/* Runs INIT once, the first time any thread calls this with STATE.
+   A thread that finds another already running INIT spins until it
+   finishes: there is no lock yet to sleep on.  Returns true if INIT
+   succeeded. */
+static inline bool init_once(int* state, bool (*init)(void)) {
+  int s = __atomic_load_n(state, __ATOMIC_ACQUIRE);
+  if (s == INIT_DONE)
+    return true;
+
+  int expected = INIT_NONE;
+  if (__atomic_compare_exchange_n(state, &expected, INIT_BUSY, false, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_ACQUIRE)) {
+    s = init() ? INIT_DONE : INIT_FAILED;
+    __atomic_store_n(state, s, __ATOMIC_RELEASE);
+    return s == INIT_DONE;
+  }
+  while ((s = __atomic_load_n(state, __ATOMIC_ACQUIRE)) == INIT_BUSY)
+    continue;
+  return s == INIT_DONE;
+}
+
+#endif /* LIB_USER_BENAPHORE_H */
@@ -22,8 +22,8 @@ int hprintf(int handle, const char* format, ...) {
 /* Writes string S to the console, followed by a new-line
    character. */
 int puts(const char* s) {
-  write(STDOUT_FILENO, s, strlen(s));
-  putchar('\n');
+  struct iovec iov[2] = {{(void*)s, strlen(s)}, {"\n", 1}};
+  writev(STDOUT_FILENO, iov, 2);
 
   return 0;
 }
@@ -37,7 +37,7 @@ int putchar(int c) {
 
 /* Auxiliary data for vhprintf_helper(). */
 struct vhprintf_aux {
-  char buf[64]; /* Character buffer. */
+  char buf[128]; /* Character buffer. */
   char* p;      /* Current position in buffer. */
   int char_cnt; /* Total characters written so far. */
   int handle;   /* Output file handle. */
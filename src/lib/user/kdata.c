@@ -0,0 +1,104 @@
+#include <kdata.h>
+#include <stdint.h>
+#include <syscall.h>
+
+/* The kernel data page, mapped read-only into every process.  See
+   lib/kdata.h for its layout and the reader protocol. */
+#define KDATA ((const struct kdata*)KDATA_BASE)
+
+/* Keeps the compiler from moving loads across the seqlock checks. */
+#define barrier() asm volatile("" : : : "memory")
+
+#ifdef __i386__
+/* Returns the CPU cycle counter. */
+static uint64_t rdtsc(void) {
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+#endif
+
+/* Returns the TID of the calling thread. */
+tid_t get_tid(void) {
+#ifdef __i386__
+  uint16_t gs;
+  int32_t tid;
+
+  asm("movw %%gs, %0" : "=r"(gs));
+  if (gs == KDATA_THREAD_SEL) {
+    asm volatile("movl %%gs:0, %0" : "=r"(tid));
+    if (tid != 0)
+      return tid;
+  }
+#endif
+  return sys_get_tid();
+}
+
+/* Returns the PID of the calling process. */
+pid_t get_pid(void) {
+#ifdef __i386__
+  uint16_t gs;
+  int32_t pid;
+
+  asm("movw %%gs, %0" : "=r"(gs));
+  if (gs == KDATA_THREAD_SEL) {
+    asm volatile("movl %%gs:4, %0" : "=r"(pid));
+    if (pid != 0)
+      return pid;
+  }
+#endif
+  return sys_get_pid();
+}
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t get_ticks(void) {
+  uint32_t seq;
+  int64_t ticks;
+
+  do {
+    seq = KDATA->seq;
+    barrier();
+    ticks = KDATA->ticks;
+    barrier();
+  } while ((seq & 1) || seq != KDATA->seq);
+  return ticks;
+}
+
+/* Returns the number of timer ticks per second. */
+int get_tick_freq(void) { return KDATA->timer_freq; }
+
+/* Returns the number of nanoseconds since the OS booted.  The
+   result has the timer's resolution, refined with the cycle
+   counter on i386 once the kernel has calibrated it.  Successive
+   calls never go backward. */
+int64_t get_time_ns(void) {
+  uint32_t seq;
+  int64_t ticks;
+  uint64_t tick_cycles, cycles_per_tick, now;
+  int64_t ns_per_tick, ns;
+
+  do {
+    seq = KDATA->seq;
+    barrier();
+    ticks = KDATA->ticks;
+    tick_cycles = KDATA->tick_cycles;
+    cycles_per_tick = KDATA->cycles_per_tick;
+#ifdef __i386__
+    now = rdtsc();
+#else
+    now = tick_cycles;
+#endif
+    barrier();
+  } while ((seq & 1) || seq != KDATA->seq);
+
+  ns_per_tick = 1000000000 / KDATA->timer_freq;
+  ns = ticks * ns_per_tick;
+  if (cycles_per_tick != 0 && now > tick_cycles) {
+    /* Never step past the next tick, which may simply be late. */
+    uint64_t delta = now - tick_cycles;
+    if (delta >= cycles_per_tick)
+      delta = cycles_per_tick - 1;
+    ns += delta * ns_per_tick / cycles_per_tick;
+  }
+  return ns;
+}
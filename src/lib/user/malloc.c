@@ -1,251 +1,705 @@
-/* User-space malloc implementation using mmap.
+/* User-space malloc.
  *
- * This implements a hybrid allocator:
- * - Large allocations (>= MMAP_THRESHOLD): Direct mmap/munmap per allocation
- * - Small allocations (< MMAP_THRESHOLD): Arena-based freelist within mmap'd pages
+ * Requests are served from one of three tiers, by size:
  *
- * This mirrors how glibc's malloc works on Unix systems.
+ * - Small (up to SMALL_MAX): NUM_CLASSES size classes, 16 bytes apart up
+ *   to 128 and then four per power of 2, so that past 128 bytes rounding
+ *   wastes less than a fifth of a block.  Each thread allocates from and frees to a
+ *   cache of free objects per class.  A cache that runs dry takes a batch
+ *   from the central free lists; one that grows too long gives a batch
+ *   back.  Centrally, free objects live in spans: runs of pages carved
+ *   into objects of a single class.
+ *
+ * - Large (up to LARGE_MAX): a run of whole pages from the page heap.
+ *
+ * - Huge: a mapping of its own, unmapped when freed.
+ *
+ * The page heap maps memory from the kernel in regions of REGION_PAGES,
+ * or more for a run that needs it, and hands out runs of pages from them
+ * for spans and large blocks alike.  Freed runs are coalesced with free
+ * neighbors in the same region.  A region that becomes entirely free is
+ * unmapped, except that one is kept in reserve.  realloc() grows a large
+ * block in place when the run after it is free.
+ *
+ * A page map, a two-level radix tree indexed by page number, leads from
+ * any address to the span that owns it.  That tells free() a block's
+ * class or size without a header in front of it.
+ *
+ * Locks are benaphores: an atomic counter hands the lock over without a
+ * system call unless another thread holds it, and only then does the
+ * newcomer sleep on a kernel semaphore.  A thread's cache is chosen by
+ * its TID, which on i386 is a load from its kernel data entry; threads
+ * whose TIDs collide share a cache, and its lock.  Lock order: cache
+ * lock, then heap lock.
  */
 
+#include <malloc.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <syscall.h>
-#include "../syscall-nr.h"
+#include "benaphore.h"
 
 /* Page size - must match kernel's PGSIZE */
-#define PGSIZE 4096
+#define PGBITS 12
+#define PGSIZE (1 << PGBITS)
 
-/* Threshold for using direct mmap vs arena allocation */
-#define MMAP_THRESHOLD PGSIZE
+/* Largest small object, and number of small size classes. */
+#define SMALL_MAX (32 * 1024)
+#define NUM_CLASSES 40
 
-/* Size of each arena (one page) */
-#define ARENA_SIZE PGSIZE
+/* Largest block served from the page heap. */
+#define LARGE_MAX (256 * 1024)
 
-/* Minimum block size (must hold free_block pointer) */
-#define MIN_BLOCK_SIZE 16
+/* Pages mapped from the kernel at a time for the page heap. */
+#define REGION_PAGES 256
 
-/* Alignment for all allocations (8 bytes for double, etc.) */
-#define MALLOC_ALIGNMENT 8
+/* Free run lists: list N - 1 holds runs of N pages, and the last list
+   holds every run of FREE_LISTS pages or more. */
+#define FREE_LISTS 64
 
-/* Round up to alignment boundary */
-#define ALIGN_UP(x, align) (((x) + (align)-1) & ~((align)-1))
+/* Number of thread caches. */
+#define NUM_CACHES 8
 
-/* Number of size classes: 16, 32, 64, 128, 256, 512, 1024, 2048 */
-#define NUM_SIZE_CLASSES 8
+/* Bytes mapped at a time for allocator metadata. */
+#define META_CHUNK (16 * PGSIZE)
 
-/* Magic numbers for validation */
-#define ARENA_MAGIC 0xA7E40001 /* "AREA" approximation in hex */
-#define MMAP_MAGIC 0x44A90001  /* "MMAP" approximation in hex */
+/* Page map: PAGEMAP_BITS of page number, split into a root index and
+   a leaf index.  Covers the low 4 GB of address space. */
+#define PAGEMAP_BITS 20
+#define PAGEMAP_LEAF_BITS 10
+#define PAGEMAP_ROOT_SIZE (1 << (PAGEMAP_BITS - PAGEMAP_LEAF_BITS))
+#define PAGEMAP_LEAF_SIZE (1 << PAGEMAP_LEAF_BITS)
 
-/* Size classes in bytes */
-static const size_t size_classes[NUM_SIZE_CLASSES] = {16, 32, 64, 128, 256, 512, 1024, 2048};
+/* Round up to alignment boundary */
+#define ALIGN_UP(x, align) (((x) + (align)-1) & ~((align)-1))
 
-/* Free block header (embedded in free blocks) */
-struct free_block {
-  struct free_block* next;
+/* Free object, linked through its first word. */
+struct object {
+  struct object* next;
 };
 
-/* Arena header (at start of each arena page) */
-struct arena {
-  uint32_t magic;               /* ARENA_MAGIC for validation */
-  int size_class;               /* Index into size_classes array */
-  size_t block_size;            /* Size of each block in this arena */
-  size_t blocks_per_arena;      /* Number of blocks in arena */
-  size_t free_count;            /* Number of free blocks */
-  struct free_block* free_list; /* Head of free list */
-  struct arena* next;           /* Next arena in global list */
+/* What a span is. */
+enum span_state {
+  SPAN_FREE,   /* Free run in the page heap. */
+  SPAN_SMALL,  /* Carved into small objects. */
+  SPAN_LARGE,  /* Handed out whole. */
+  SPAN_HUGE,   /* A mapping of its own. */
+  SPAN_REGION, /* Describes a region of the page heap. */
 };
 
-/* Header for large mmap allocations (stored before user data) */
-struct mmap_header {
-  uint32_t magic;    /* MMAP_MAGIC for validation */
-  size_t total_size; /* Total mmap size including header */
+/* A run of pages.  Small spans have every page in the page map; the
+   others just their first and last. */
+struct span {
+  uintptr_t page;           /* First page number. */
+  size_t pages;             /* Length in pages. */
+  uint8_t state;            /* enum span_state. */
+  uint8_t cls;              /* Size class, for SPAN_SMALL. */
+  unsigned used;            /* Objects handed out, for SPAN_SMALL. */
+  unsigned carved;          /* Objects carved so far, for SPAN_SMALL. */
+  struct object* objects;   /* Free objects given back, for SPAN_SMALL. */
+  struct span* region;      /* Region of the page heap the run is in. */
+  struct span *prev, *next; /* In a class list or a free run list. */
 };
 
-/* Per-size-class descriptor */
-struct size_class_desc {
-  struct arena* arena_list; /* List of arenas for this class */
+/* Per-thread cache of free small objects. */
+struct cache {
+  struct mutex mutex;
+  struct object* lists[NUM_CLASSES]; /* Free objects by class. */
+  unsigned counts[NUM_CLASSES];      /* Length of each list. */
+  size_t bytes;                      /* Bytes on all lists. */
+  uint64_t mallocs, frees, refills, flushes, in_place;
 };
 
-/* Global state */
-static struct size_class_desc descriptors[NUM_SIZE_CLASSES];
-static int malloc_initialized = 0;
-static lock_t malloc_lock;
+/* Size class tables. */
+static size_t class_size[NUM_CLASSES];     /* Object size. */
+static uint8_t class_pages[NUM_CLASSES];   /* Pages per span. */
+static uint16_t class_count[NUM_CLASSES];  /* Objects per span. */
+static uint8_t class_batch[NUM_CLASSES];   /* Objects moved to or from a cache at once. */
+static uint8_t class_by_16[1024 / 16 + 1]; /* Class of sizes up to 1024, by 16s. */
+static uint8_t class_by_128[SMALL_MAX / 128 + 1]; /* Class of larger sizes, by 128s. */
+
+static struct cache caches[NUM_CACHES];
+
+/* Central state, protected by heap_mutex. */
+static struct mutex heap_mutex;
+static struct span class_spans[NUM_CLASSES]; /* Small spans with free objects. */
+static struct span free_runs[FREE_LISTS];    /* Free runs, by length. */
+static struct span* spare_region;            /* Entirely free region kept mapped. */
+static struct span* free_spans;              /* Recycled span records. */
+static uint8_t* meta_next;                   /* Metadata bump allocator. */
+static uint8_t* meta_end;
+static struct span** pagemap[PAGEMAP_ROOT_SIZE];
+static struct malloc_stats heap_stats; /* Except the thread cache counters. */
+
+/* Initialization state. */
+static int init_state = INIT_NONE;
+
+/* ============================================================================
+ * LISTS
+ * ============================================================================ */
+
+static void list_init_head(struct span* head) { head->prev = head->next = head; }
+
+static bool list_is_empty(const struct span* head) { return head->next == head; }
+
+static void list_push(struct span* head, struct span* s) {
+  s->prev = head;
+  s->next = head->next;
+  head->next->prev = s;
+  head->next = s;
+}
 
-/* Round up to page boundary */
-static size_t round_up_page(size_t size) { return (size + PGSIZE - 1) & ~(PGSIZE - 1); }
+static void list_unlink(struct span* s) {
+  s->prev->next = s->next;
+  s->next->prev = s->prev;
+  s->prev = s->next = NULL;
+}
 
-/* Initialize malloc state */
-static void malloc_init(void) {
-  if (malloc_initialized)
-    return;
+/* ============================================================================
+ * INITIALIZATION
+ * ============================================================================ */
+
+/* Fills in the size class tables. */
+static void init_classes(void) {
+  int cls = 0;
+  for (size_t size = 16; size <= 128; size += 16)
+    class_size[cls++] = size;
+  for (size_t base = 128; base < SMALL_MAX; base *= 2)
+    for (int k = 1; k <= 4; k++)
+      class_size[cls++] = base + k * (base / 4);
+
+  for (cls = 0; cls < NUM_CLASSES; cls++) {
+    size_t size = class_size[cls];
+
+    /* Fewest pages that waste no more than an eighth of the span. */
+    size_t pages = (size + PGSIZE - 1) / PGSIZE;
+    while ((pages * PGSIZE) % size > pages * PGSIZE / 8)
+      pages++;
+    class_pages[cls] = pages;
+    class_count[cls] = pages * PGSIZE / size;
+
+    size_t batch = 16 * 1024 / size;
+    class_batch[cls] = batch < 1 ? 1 : batch > 32 ? 32 : batch;
+  }
 
-  for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
-    descriptors[i].arena_list = NULL;
+  cls = 0;
+  for (size_t i = 0; i < sizeof class_by_16; i++) {
+    while (class_size[cls] < i * 16)
+      cls++;
+    class_by_16[i] = cls;
   }
+  cls = 0;
+  for (size_t i = 0; i < sizeof class_by_128; i++) {
+    while (class_size[cls] < i * 128)
+      cls++;
+    class_by_128[i] = cls;
+  }
+}
 
-  lock_init(&malloc_lock);
-  malloc_initialized = 1;
+static bool init(void) {
+  init_classes();
+  for (int i = 0; i < NUM_CLASSES; i++)
+    list_init_head(&class_spans[i]);
+  for (int i = 0; i < FREE_LISTS; i++)
+    list_init_head(&free_runs[i]);
+
+  if (!mutex_init(&heap_mutex))
+    return false;
+  for (int i = 0; i < NUM_CACHES; i++)
+    if (!mutex_init(&caches[i].mutex))
+      return false;
+  return true;
 }
 
-/* Find size class index for a given size */
-static int find_size_class(size_t size) {
-  for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
-    if (size <= size_classes[i])
-      return i;
-  }
-  return -1; /* Too large for small allocation */
+/* Initializes the allocator on first use.  A thread that finds another
+   already at it waits for it to finish.  Returns false if
+   initialization failed. */
+static bool ensure_init(void) {
+  return init_once(&init_state, init);
 }
 
-/* Allocate a new arena for a size class */
-static struct arena* alloc_arena(int class_idx) {
-  /* Get a page via anonymous mmap */
-  void* page = mmap_anon(NULL, ARENA_SIZE);
-  if (page == (void*)MAP_FAILED)
-    return NULL;
+/* Returns the size class for SIZE, at most SMALL_MAX. */
+static int size_to_class(size_t size) {
+  return size <= 1024 ? class_by_16[(size + 15) >> 4] : class_by_128[(size + 127) >> 7];
+}
 
-  struct arena* arena = (struct arena*)page;
-  arena->magic = ARENA_MAGIC;
-  arena->size_class = class_idx;
-  arena->block_size = size_classes[class_idx];
-
-  /* Ensure blocks start at aligned address */
-  size_t header_size = ALIGN_UP(sizeof(struct arena), MALLOC_ALIGNMENT);
-  arena->blocks_per_arena = (ARENA_SIZE - header_size) / arena->block_size;
-  arena->free_count = arena->blocks_per_arena;
-  arena->next = NULL;
-
-  /* Initialize free list with all blocks */
-  arena->free_list = NULL;
-  uint8_t* block_start = (uint8_t*)arena + header_size;
-
-  for (size_t i = 0; i < arena->blocks_per_arena; i++) {
-    struct free_block* block = (struct free_block*)(block_start + i * arena->block_size);
-    block->next = arena->free_list;
-    arena->free_list = block;
+/* ============================================================================
+ * METADATA AND PAGE MAP (heap lock held)
+ * ============================================================================ */
+
+/* Returns SIZE bytes of zeroed metadata memory, which is never freed, or
+   a null pointer if memory is short. */
+static void* meta_alloc(size_t size) {
+  size = ALIGN_UP(size, 16);
+  if (meta_next == NULL || (size_t)(meta_end - meta_next) < size) {
+    void* chunk = mmap_anon(NULL, META_CHUNK);
+    if (chunk == (void*)MAP_FAILED)
+      return NULL;
+    heap_stats.maps++;
+    heap_stats.mapped += META_CHUNK;
+    meta_next = chunk;
+    meta_end = meta_next + META_CHUNK;
   }
+  void* p = meta_next;
+  meta_next += size;
+  return p;
+}
 
-  return arena;
+static struct span* span_alloc(void) {
+  struct span* s = free_spans;
+  if (s != NULL)
+    free_spans = s->next;
+  else if ((s = meta_alloc(sizeof *s)) == NULL)
+    return NULL;
+  memset(s, 0, sizeof *s);
+  return s;
+}
+
+static void span_free(struct span* s) {
+  s->state = SPAN_FREE;
+  s->next = free_spans;
+  free_spans = s;
 }
 
-/* Allocate from small allocation path */
-static void* malloc_small(size_t size) {
-  int class_idx = find_size_class(size);
-  if (class_idx < 0)
+/* Returns the span page PAGE is in, or a null pointer.  Safe without the
+   heap lock for pages of blocks in use, whose entries do not change. */
+static struct span* pagemap_get(uintptr_t page) {
+  if (page >> PAGEMAP_BITS)
     return NULL;
+  struct span** leaf = pagemap[page >> PAGEMAP_LEAF_BITS];
+  return leaf != NULL ? leaf[page & (PAGEMAP_LEAF_SIZE - 1)] : NULL;
+}
 
-  struct size_class_desc* desc = &descriptors[class_idx];
+/* Sets the entry for PAGE, which pagemap_ensure() has covered. */
+static void pagemap_set(uintptr_t page, struct span* s) {
+  pagemap[page >> PAGEMAP_LEAF_BITS][page & (PAGEMAP_LEAF_SIZE - 1)] = s;
+}
 
-  /* Find arena with free blocks */
-  struct arena* arena = desc->arena_list;
-  while (arena != NULL && arena->free_count == 0) {
-    arena = arena->next;
-  }
+/* Makes room in the page map for PAGES pages starting at PAGE.  Returns
+   false if they are out of its range or memory is short. */
+static bool pagemap_ensure(uintptr_t page, size_t pages) {
+  if ((page + pages) >> PAGEMAP_BITS)
+    return false;
+  for (uintptr_t i = page >> PAGEMAP_LEAF_BITS; i <= (page + pages - 1) >> PAGEMAP_LEAF_BITS; i++)
+    if (pagemap[i] == NULL && (pagemap[i] = meta_alloc(PAGEMAP_LEAF_SIZE * sizeof(void*))) == NULL)
+      return false;
+  return true;
+}
 
-  /* No free blocks - allocate new arena */
-  if (arena == NULL) {
-    arena = alloc_arena(class_idx);
-    if (arena == NULL)
-      return NULL;
-    arena->next = desc->arena_list;
-    desc->arena_list = arena;
-  }
+/* Points the page map entries for the first and last pages of S at it. */
+static void pagemap_set_ends(struct span* s) {
+  pagemap_set(s->page, s);
+  pagemap_set(s->page + s->pages - 1, s);
+}
 
-  /* Pop block from arena's free list */
-  struct free_block* block = arena->free_list;
-  arena->free_list = block->next;
-  arena->free_count--;
+static void* span_base(const struct span* s) { return (void*)(s->page << PGBITS); }
 
-  return (void*)block;
+/* ============================================================================
+ * PAGE HEAP (heap lock held)
+ * ============================================================================ */
+
+static struct span* free_list_for(size_t pages) {
+  return &free_runs[(pages < FREE_LISTS ? pages : FREE_LISTS) - 1];
 }
 
-/* Allocate via direct mmap for large allocations */
-static void* malloc_large(size_t size) {
-  /* Add header size and round up to page boundary */
-  size_t total_size = round_up_page(size + sizeof(struct mmap_header));
+/* Adds S to the free runs. */
+static void run_insert(struct span* s) {
+  s->state = SPAN_FREE;
+  list_push(free_list_for(s->pages), s);
+  pagemap_set_ends(s);
+  heap_stats.free_runs += s->pages * PGSIZE;
+}
 
-  void* ptr = mmap_anon(NULL, total_size);
-  if (ptr == (void*)MAP_FAILED)
+/* Takes S off the free runs. */
+static void run_remove(struct span* s) {
+  list_unlink(s);
+  heap_stats.free_runs -= s->pages * PGSIZE;
+  if (s->region == spare_region)
+    spare_region = NULL;
+}
+
+/* Returns the smallest free run of at least PAGES pages, or a null
+   pointer. */
+static struct span* run_find(size_t pages) {
+  for (size_t n = pages; n < FREE_LISTS; n++)
+    if (!list_is_empty(&free_runs[n - 1]))
+      return free_runs[n - 1].next;
+
+  struct span* head = &free_runs[FREE_LISTS - 1];
+  struct span* best = NULL;
+  for (struct span* s = head->next; s != head; s = s->next)
+    if (s->pages >= pages && (best == NULL || s->pages < best->pages))
+      best = s;
+  return best;
+}
+
+/* Maps a region with room for at least PAGES pages and returns it as a
+   free run, not on any list, or returns a null pointer. */
+static struct span* heap_grow(size_t pages) {
+  size_t n = pages > REGION_PAGES ? pages : REGION_PAGES;
+  void* base = mmap_anon(NULL, n * PGSIZE);
+  if (base == (void*)MAP_FAILED)
     return NULL;
 
-  struct mmap_header* header = (struct mmap_header*)ptr;
-  header->magic = MMAP_MAGIC;
-  header->total_size = total_size;
+  uintptr_t page = (uintptr_t)base >> PGBITS;
+  struct span* region = NULL;
+  struct span* run = NULL;
+  if (!pagemap_ensure(page, n) || (region = span_alloc()) == NULL ||
+      (run = span_alloc()) == NULL) {
+    if (region != NULL)
+      span_free(region);
+    munmap((mapid_t)(uintptr_t)base);
+    return NULL;
+  }
+  heap_stats.maps++;
+  heap_stats.mapped += n * PGSIZE;
+
+  region->state = SPAN_REGION;
+  region->page = run->page = page;
+  region->pages = run->pages = n;
+  run->region = region;
+  return run;
+}
+
+/* Returns a run of exactly PAGES pages, not on any list, or a null
+   pointer if memory is short. */
+static struct span* heap_alloc(size_t pages) {
+  struct span* s = run_find(pages);
+  if (s != NULL)
+    run_remove(s);
+  else if ((s = heap_grow(pages)) == NULL)
+    return NULL;
 
-  /* Return pointer after header */
-  return (void*)(header + 1);
+  if (s->pages > pages) {
+    struct span* rest = span_alloc();
+    if (rest == NULL) {
+      run_insert(s);
+      return NULL;
+    }
+    rest->page = s->page + pages;
+    rest->pages = s->pages - pages;
+    rest->region = s->region;
+    run_insert(rest);
+    s->pages = pages;
+  }
+  return s;
 }
 
-/* Get arena from block pointer (arena is at page-aligned address) */
-static struct arena* block_to_arena(void* ptr) {
-  return (struct arena*)((uintptr_t)ptr & ~(PGSIZE - 1));
+/* Returns the run S, not on any list, to the page heap, coalescing it
+   with free neighbors in its region, and unmaps the region if it is then
+   entirely free and another is already in reserve. */
+static void heap_free(struct span* s) {
+  struct span* region = s->region;
+
+  struct span* prev = pagemap_get(s->page - 1);
+  if (prev != NULL && prev->state == SPAN_FREE && prev->region == region &&
+      prev->page + prev->pages == s->page) {
+    run_remove(prev);
+    s->page = prev->page;
+    s->pages += prev->pages;
+    span_free(prev);
+  }
+  struct span* next = pagemap_get(s->page + s->pages);
+  if (next != NULL && next->state == SPAN_FREE && next->region == region &&
+      next->page == s->page + s->pages) {
+    run_remove(next);
+    s->pages += next->pages;
+    span_free(next);
+  }
+
+  if (s->pages == region->pages && spare_region != NULL) {
+    munmap((mapid_t)(uintptr_t)span_base(region));
+    heap_stats.unmaps++;
+    heap_stats.mapped -= region->pages * PGSIZE;
+    span_free(s);
+    span_free(region);
+    return;
+  }
+  run_insert(s);
+  if (s->pages == region->pages)
+    spare_region = region;
 }
 
-/* Check if pointer is a large mmap allocation */
-static int is_mmap_allocation(void* ptr) {
-  struct mmap_header* header = (struct mmap_header*)ptr - 1;
-  /* Check if header is page-aligned (mmap returns page-aligned) */
-  if (((uintptr_t)header & (PGSIZE - 1)) != 0)
-    return 0;
-  return header->magic == MMAP_MAGIC;
+/* ============================================================================
+ * CENTRAL FREE LISTS (heap lock held)
+ * ============================================================================ */
+
+static bool span_is_full(const struct span* s) {
+  return s->objects == NULL && s->carved == class_count[s->cls];
 }
 
-/* Main malloc function */
-void* malloc(size_t size) {
-  if (size == 0)
+/* Returns a new span for class CLS, on its class list, or a null
+   pointer. */
+static struct span* small_span_new(int cls) {
+  struct span* s = heap_alloc(class_pages[cls]);
+  if (s == NULL)
     return NULL;
 
-  if (!malloc_initialized)
-    malloc_init();
-
-  void* result;
+  s->state = SPAN_SMALL;
+  s->cls = cls;
+  s->used = s->carved = 0;
+  s->objects = NULL;
+  for (size_t i = 0; i < s->pages; i++)
+    pagemap_set(s->page + i, s);
+  list_push(&class_spans[cls], s);
+  heap_stats.small += s->pages * PGSIZE;
+  return s;
+}
 
-  lock_acquire(&malloc_lock);
+/* Takes up to WANT objects of class CLS and links them into a list at
+   *HEAD.  Returns the number taken, 0 if memory is short. */
+static unsigned central_take(int cls, unsigned want, struct object** head) {
+  unsigned n = 0;
+
+  *head = NULL;
+  while (n < want) {
+    struct span* s = class_spans[cls].next;
+    if (s == &class_spans[cls] && (s = small_span_new(cls)) == NULL)
+      break;
+
+    struct object* obj = s->objects;
+    if (obj != NULL)
+      s->objects = obj->next;
+    else
+      obj = (struct object*)((uint8_t*)span_base(s) + s->carved++ * class_size[cls]);
+    s->used++;
+    if (span_is_full(s))
+      list_unlink(s);
+
+    obj->next = *head;
+    *head = obj;
+    n++;
+  }
+  return n;
+}
 
-  if (size >= MMAP_THRESHOLD) {
-    result = malloc_large(size);
-  } else {
-    result = malloc_small(size);
+/* Gives the small object OBJ back to its span, and the span back to the
+   page heap if that leaves it unused. */
+static void central_put(struct object* obj) {
+  struct span* s = pagemap_get((uintptr_t)obj >> PGBITS);
+
+  if (span_is_full(s))
+    list_push(&class_spans[s->cls], s);
+  obj->next = s->objects;
+  s->objects = obj;
+  if (--s->used == 0) {
+    list_unlink(s);
+    heap_stats.small -= s->pages * PGSIZE;
+    heap_free(s);
   }
+}
 
-  lock_release(&malloc_lock);
+/* ============================================================================
+ * THREAD CACHES
+ * ============================================================================ */
+
+static struct cache* my_cache(void) { return &caches[(unsigned)get_tid() % NUM_CACHES]; }
+
+static void* small_alloc(size_t size) {
+  int cls = size_to_class(size);
+  struct cache* c = my_cache();
+
+  mutex_acquire(&c->mutex);
+  struct object* obj = c->lists[cls];
+  if (obj == NULL) {
+    mutex_acquire(&heap_mutex);
+    unsigned n = central_take(cls, class_batch[cls], &obj);
+    mutex_release(&heap_mutex);
+    c->counts[cls] += n;
+    c->bytes += n * class_size[cls];
+    c->refills++;
+  }
+  if (obj != NULL) {
+    c->lists[cls] = obj->next;
+    c->counts[cls]--;
+    c->bytes -= class_size[cls];
+    c->mallocs++;
+  }
+  mutex_release(&c->mutex);
+  return obj;
+}
 
-  return result;
+static void small_free(struct object* obj, int cls) {
+  struct cache* c = my_cache();
+
+  mutex_acquire(&c->mutex);
+  obj->next = c->lists[cls];
+  c->lists[cls] = obj;
+  c->counts[cls]++;
+  c->bytes += class_size[cls];
+  c->frees++;
+
+  /* Past twice a batch, give a batch back. */
+  if (c->counts[cls] > 2u * class_batch[cls]) {
+    mutex_acquire(&heap_mutex);
+    for (unsigned i = 0; i < class_batch[cls]; i++) {
+      obj = c->lists[cls];
+      c->lists[cls] = obj->next;
+      central_put(obj);
+    }
+    mutex_release(&heap_mutex);
+    c->counts[cls] -= class_batch[cls];
+    c->bytes -= class_batch[cls] * class_size[cls];
+    c->flushes++;
+  }
+  mutex_release(&c->mutex);
 }
 
-/* Main free function */
-void free(void* ptr) {
-  if (ptr == NULL)
-    return;
+/* ============================================================================
+ * LARGE AND HUGE BLOCKS
+ * ============================================================================ */
 
-  if (!malloc_initialized)
-    return; /* Can't free if never initialized */
+static size_t size_to_pages(size_t size) { return (size + PGSIZE - 1) / PGSIZE; }
 
-  lock_acquire(&malloc_lock);
+static void* large_alloc(size_t size) {
+  mutex_acquire(&heap_mutex);
+  struct span* s = heap_alloc(size_to_pages(size));
+  if (s != NULL) {
+    s->state = SPAN_LARGE;
+    pagemap_set_ends(s);
+    heap_stats.large += s->pages * PGSIZE;
+    heap_stats.mallocs++;
+  }
+  mutex_release(&heap_mutex);
+  return s != NULL ? span_base(s) : NULL;
+}
 
-  if (is_mmap_allocation(ptr)) {
-    /* Large allocation - munmap directly */
-    struct mmap_header* header = (struct mmap_header*)ptr - 1;
-    munmap((mapid_t)header);
+static void large_free(struct span* s) {
+  mutex_acquire(&heap_mutex);
+  heap_stats.large -= s->pages * PGSIZE;
+  heap_stats.frees++;
+  heap_free(s);
+  mutex_release(&heap_mutex);
+}
+
+/* Resizes large block S to PAGES pages without moving it, if that can be
+   done.  Returns true if successful. */
+static bool large_resize(struct span* s, size_t pages) {
+  bool success = false;
+
+  mutex_acquire(&heap_mutex);
+  if (pages < s->pages) {
+    /* Return the tail to the page heap. */
+    struct span* tail = span_alloc();
+    if (tail != NULL) {
+      tail->page = s->page + pages;
+      tail->pages = s->pages - pages;
+      tail->region = s->region;
+      heap_stats.large -= tail->pages * PGSIZE;
+      s->pages = pages;
+      pagemap_set_ends(s);
+      heap_free(tail);
+      success = true;
+    }
   } else {
-    /* Small allocation - return to arena free list */
-    struct arena* arena = block_to_arena(ptr);
-    if (arena->magic != ARENA_MAGIC) {
-      /* Invalid pointer - corruption or double-free, just ignore */
-      lock_release(&malloc_lock);
-      return;
+    /* Take the head of the free run that follows, if it is big enough. */
+    size_t extra = pages - s->pages;
+    struct span* next = pagemap_get(s->page + s->pages);
+    if (next != NULL && next->state == SPAN_FREE && next->region == s->region &&
+        next->page == s->page + s->pages && next->pages >= extra) {
+      run_remove(next);
+      if (next->pages > extra) {
+        next->page += extra;
+        next->pages -= extra;
+        run_insert(next);
+      } else {
+        span_free(next);
+      }
+      s->pages = pages;
+      pagemap_set_ends(s);
+      heap_stats.large += extra * PGSIZE;
+      success = true;
     }
+  }
+  mutex_release(&heap_mutex);
+  return success;
+}
+
+static void* huge_alloc(size_t size) {
+  size_t pages = size_to_pages(size);
+  void* base = mmap_anon(NULL, pages * PGSIZE);
+  if (base == (void*)MAP_FAILED)
+    return NULL;
 
-    struct free_block* block = (struct free_block*)ptr;
-    block->next = arena->free_list;
-    arena->free_list = block;
-    arena->free_count++;
+  mutex_acquire(&heap_mutex);
+  uintptr_t page = (uintptr_t)base >> PGBITS;
+  struct span* s = pagemap_ensure(page, 1) ? span_alloc() : NULL;
+  if (s != NULL) {
+    s->state = SPAN_HUGE;
+    s->page = page;
+    s->pages = pages;
+    pagemap_set(page, s);
+    heap_stats.maps++;
+    heap_stats.mapped += pages * PGSIZE;
+    heap_stats.huge += pages * PGSIZE;
+    heap_stats.mallocs++;
+  }
+  mutex_release(&heap_mutex);
 
-    /* If arena is completely free, we could munmap it.
-       For simplicity, we keep it allocated for future use. */
+  if (s == NULL) {
+    munmap((mapid_t)(uintptr_t)base);
+    return NULL;
   }
+  return base;
+}
 
-  lock_release(&malloc_lock);
+static void huge_free(struct span* s) {
+  void* base = span_base(s);
+
+  mutex_acquire(&heap_mutex);
+  pagemap_set(s->page, NULL);
+  heap_stats.unmaps++;
+  heap_stats.mapped -= s->pages * PGSIZE;
+  heap_stats.huge -= s->pages * PGSIZE;
+  heap_stats.frees++;
+  span_free(s);
+  mutex_release(&heap_mutex);
+  munmap((mapid_t)(uintptr_t)base);
+}
+
+/* ============================================================================
+ * PUBLIC INTERFACE
+ * ============================================================================ */
+
+/* Returns the span of block P, or a null pointer if P is not the start
+   of a block this allocator handed out. */
+static struct span* block_span(void* p) {
+  if (__atomic_load_n(&init_state, __ATOMIC_ACQUIRE) != INIT_DONE)
+    return NULL;
+  struct span* s = pagemap_get((uintptr_t)p >> PGBITS);
+  if (s == NULL)
+    return NULL;
+  if (s->state == SPAN_SMALL)
+    return s;
+  if ((s->state == SPAN_LARGE || s->state == SPAN_HUGE) && p == span_base(s))
+    return s;
+  return NULL;
+}
+
+void* malloc(size_t size) {
+  if (size == 0 || !ensure_init())
+    return NULL;
+
+  if (size <= SMALL_MAX)
+    return small_alloc(size);
+  else if (size <= LARGE_MAX)
+    return large_alloc(size);
+  else
+    return huge_alloc(size);
+}
+
+void free(void* ptr) {
+  struct span* s = block_span(ptr);
+  if (s == NULL)
+    return; /* Null, or not ours: ignore. */
+
+  if (s->state == SPAN_SMALL)
+    small_free(ptr, s->cls);
+  else if (s->state == SPAN_LARGE)
+    large_free(s);
+  else
+    huge_free(s);
 }
 
 /* Allocate zeroed memory */
@@ -263,6 +717,13 @@ void* calloc(size_t nmemb, size_t size) {
   return ptr;
 }
 
+size_t malloc_usable_size(void* p) {
+  struct span* s = block_span(p);
+  if (s == NULL)
+    return 0;
+  return s->state == SPAN_SMALL ? class_size[s->cls] : s->pages * PGSIZE;
+}
+
 /* Resize allocation */
 void* realloc(void* ptr, size_t size) {
   if (ptr == NULL)
@@ -273,18 +734,26 @@ void* realloc(void* ptr, size_t size) {
     return NULL;
   }
 
-  /* Get current allocation size */
-  size_t old_size;
-  if (is_mmap_allocation(ptr)) {
-    struct mmap_header* header = (struct mmap_header*)ptr - 1;
-    old_size = header->total_size - sizeof(struct mmap_header);
-  } else {
-    struct arena* arena = block_to_arena(ptr);
-    old_size = arena->block_size;
-  }
-
-  /* If new size fits in current allocation, return same pointer */
-  if (size <= old_size) {
+  struct span* s = block_span(ptr);
+  if (s == NULL)
+    return NULL;
+  size_t old_size = malloc_usable_size(ptr);
+
+  /* Stay put if the block is still the right tier and, for small
+     blocks, not more than twice the size needed. */
+  bool fits;
+  if (s->state == SPAN_SMALL)
+    fits = size <= old_size && size > old_size / 2;
+  else if (s->state == SPAN_LARGE)
+    fits = size > SMALL_MAX && size <= LARGE_MAX &&
+           (size_to_pages(size) == s->pages || large_resize(s, size_to_pages(size)));
+  else
+    fits = size > LARGE_MAX && size <= old_size;
+  if (fits) {
+    struct cache* c = my_cache();
+    mutex_acquire(&c->mutex);
+    c->in_place++;
+    mutex_release(&c->mutex);
     return ptr;
   }
 
@@ -297,3 +766,25 @@ void* realloc(void* ptr, size_t size) {
 
   return new_ptr;
 }
+
+void malloc_get_stats(struct malloc_stats* stats) {
+  memset(stats, 0, sizeof *stats);
+  if (!ensure_init())
+    return;
+
+  mutex_acquire(&heap_mutex);
+  *stats = heap_stats;
+  mutex_release(&heap_mutex);
+
+  for (int i = 0; i < NUM_CACHES; i++) {
+    struct cache* c = &caches[i];
+    mutex_acquire(&c->mutex);
+    stats->cached += c->bytes;
+    stats->mallocs += c->mallocs;
+    stats->frees += c->frees;
+    stats->refills += c->refills;
+    stats->flushes += c->flushes;
+    stats->in_place += c->in_place;
+    mutex_release(&c->mutex);
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef __LIB_USER_MALLOC_H
+#define __LIB_USER_MALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Allocator statistics, as returned by malloc_get_stats().  Byte
+   counts are current; event counts are totals since the program
+   started. */
+struct malloc_stats {
+  size_t mapped;     /* Bytes mapped from the kernel. */
+  size_t small;      /* Bytes in spans carved into small objects. */
+  size_t large;      /* Bytes in page runs handed out whole. */
+  size_t huge;       /* Bytes in allocations with a mapping of their own. */
+  size_t free_runs;  /* Bytes in free page runs. */
+  size_t cached;     /* Bytes of free small objects in thread caches. */
+  uint64_t mallocs;  /* Successful allocations, through any entry point. */
+  uint64_t frees;    /* Blocks freed. */
+  uint64_t refills;  /* Thread cache misses, each refilled with a batch. */
+  uint64_t flushes;  /* Batches returned from thread caches. */
+  uint64_t in_place; /* Reallocations that kept the block where it was. */
+  uint64_t maps;     /* mmap() calls. */
+  uint64_t unmaps;   /* munmap() calls. */
+};
+
+/* Fills STATS with the allocator's current statistics. */
+void malloc_get_stats(struct malloc_stats* stats);
+
+/* Returns the number of usable bytes in the block at P, which may be
+   more than were asked for, or 0 if P is NULL. */
+size_t malloc_usable_size(void* p);
+
+#endif /* lib/user/malloc.h */
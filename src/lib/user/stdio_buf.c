@@ -9,6 +9,27 @@
 /* Forward declaration */
 int fflush(FILE* stream);
 
+/* Picks a buffer size for FP.  A regular file opened only for reading
+   gets a buffer big enough for the rest of the file, in whole sectors,
+   up to STDIO_BUFSIZ_MAX, so a small file costs one small read and a
+   large one a few large reads.  A regular file being written gets the
+   largest buffer; the console and pipes get a page. */
+static int pick_bufsize(FILE* fp) {
+  int length = filesize(fp->fd);
+  if (length < 0)
+    return STDIO_BUFSIZ;
+  if ((fp->flags & (_IOREAD | _IOWRITE | _IORW)) != _IOREAD)
+    return STDIO_BUFSIZ_MAX;
+
+  int pos = tell(fp->fd);
+  int left = pos >= 0 && pos < length ? length - pos : 0;
+  if (left >= STDIO_BUFSIZ_MAX)
+    return STDIO_BUFSIZ_MAX;
+  if (left < STDIO_BLOCK_SIZE)
+    return STDIO_BLOCK_SIZE;
+  return (left + STDIO_BLOCK_SIZE - 1) / STDIO_BLOCK_SIZE * STDIO_BLOCK_SIZE;
+}
+
 /* Allocate a buffer for the stream if not already allocated. */
 static void ensure_buffer(FILE* fp) {
   /* Already have a buffer? */
@@ -20,14 +41,14 @@ static void ensure_buffer(FILE* fp) {
     fp->buf = fp->smallbuf;
     fp->bufsiz = 1;
   } else {
-    /* Buffered: allocate STDIO_BUFSIZ bytes */
-    fp->buf = malloc(STDIO_BUFSIZ);
+    int size = pick_bufsize(fp);
+    fp->buf = malloc(size);
     if (fp->buf == NULL) {
       /* Fallback to unbuffered if malloc fails */
       fp->buf = fp->smallbuf;
       fp->bufsiz = 1;
     } else {
-      fp->bufsiz = STDIO_BUFSIZ;
+      fp->bufsiz = size;
       fp->flags |= _IOMYBUF; /* We own this buffer, must free it */
     }
   }
@@ -110,9 +131,9 @@ int __flushbuf(int c, FILE* fp) {
 
 /* Flush output buffer to file. */
 int fflush(FILE* stream) {
-  /* NULL means flush all streams - not implemented */
+  /* NULL means flush all streams */
   if (stream == NULL)
-    return 0;
+    return __stdio_flush_all();
 
   /* Only flush writable streams */
   if (!(stream->flags & (_IOWRITE | _IORW)))
@@ -148,11 +169,41 @@ size_t fread(void* ptr, size_t size, size_t nmemb, FILE* stream) {
   size_t bytes_read = 0;
 
   while (bytes_read < total) {
+    size_t want = total - bytes_read;
+
     if (stream->cnt > 0) {
-      /* Copy from buffer */
-      *dest++ = *stream->ptr++;
-      stream->cnt--;
-      bytes_read++;
+      /* Copy what the buffer holds */
+      size_t n = (size_t)stream->cnt < want ? (size_t)stream->cnt : want;
+      memcpy(dest, stream->ptr, n);
+      dest += n;
+      stream->ptr += n;
+      stream->cnt -= n;
+      bytes_read += n;
+      continue;
+    }
+
+    if (stream->flags & _IOEOF)
+      break;
+    ensure_buffer(stream);
+
+    /* A request at least a buffer long is read straight into the caller's
+       memory, refilling the buffer in the same readv().  The console waits
+       for every byte asked for, so stdin reads only what was requested. */
+    if (want >= (size_t)stream->bufsiz && stream->bufsiz > 1) {
+      struct iovec iov[2] = {{dest, want}, {stream->buf, stream->bufsiz}};
+      int n = readv(stream->fd, iov, stream == stdin ? 1 : 2);
+      if (n <= 0) {
+        stream->flags |= n == 0 ? _IOEOF : _IOERR;
+        break;
+      }
+
+      size_t direct = (size_t)n < want ? (size_t)n : want;
+      dest += direct;
+      bytes_read += direct;
+      stream->ptr = stream->buf;
+      stream->cnt = n - direct;
+      if (direct < want)
+        break;
     } else {
       /* Buffer empty, refill */
       int c = __fillbuf(stream);
@@ -172,9 +223,63 @@ size_t fwrite(const void* ptr, size_t size, size_t nmemb, FILE* stream) {
   if (total == 0)
     return 0;
 
+  /* An unbuffered stream writes the data in one piece, not a byte at a
+     time. */
+  if ((stream->flags & (_IOWRITE | _IORW)) && (stream->flags & _IONBF)) {
+    int n = write(stream->fd, ptr, total);
+    if (n < 0 || (size_t)n < total) {
+      stream->flags |= _IOERR;
+      return n > 0 ? n / size : 0;
+    }
+    return nmemb;
+  }
+
+  /* Data that would overflow a fully buffered stream's buffer goes out
+     together with what is already buffered, in one writev(). */
+  if ((stream->flags & (_IOWRITE | _IORW)) && !(stream->flags & _IOLBF)) {
+    ensure_buffer(stream);
+    size_t buffered = stream->ptr - stream->buf;
+    if (stream->bufsiz > 1 && total >= (size_t)stream->bufsiz - buffered) {
+      struct iovec iov[2] = {{stream->buf, buffered}, {(void*)ptr, total}};
+      int n = writev(stream->fd, iov, 2);
+
+      stream->ptr = stream->buf;
+      stream->cnt = stream->bufsiz;
+      if (n < 0 || (size_t)n < buffered + total) {
+        stream->flags |= _IOERR;
+        return n > 0 && (size_t)n > buffered ? (n - buffered) / size : 0;
+      }
+      return nmemb;
+    }
+  }
+
   const unsigned char* src = (const unsigned char*)ptr;
   size_t bytes_written = 0;
 
+  /* A line buffered stream writes everything up to the last newline in
+     the data, after what is already buffered, in one writev() instead of
+     one write() per line.  The rest is buffered below. */
+  if ((stream->flags & _IOLBF) && (stream->flags & (_IOWRITE | _IORW))) {
+    size_t lines = total;
+    while (lines > 0 && src[lines - 1] != '\n')
+      lines--;
+    if (lines > 0) {
+      ensure_buffer(stream);
+      size_t buffered = stream->ptr - stream->buf;
+      struct iovec iov[2] = {{stream->buf, buffered}, {(void*)src, lines}};
+      int n = writev(stream->fd, iov, 2);
+
+      stream->ptr = stream->buf;
+      stream->cnt = stream->bufsiz;
+      if (n < 0 || (size_t)n < buffered + lines) {
+        stream->flags |= _IOERR;
+        return n > 0 && (size_t)n > buffered ? (n - buffered) / size : 0;
+      }
+      src += lines;
+      bytes_written = lines;
+    }
+  }
+
   while (bytes_written < total) {
     unsigned char c = *src++;
 
@@ -16,6 +16,9 @@ FILE* stdin = &__stdin_storage;
 FILE* stdout = &__stdout_storage;
 FILE* stderr = &__stderr_storage;
 
+/* Streams opened by fopen() and fdopen(), most recent first. */
+static FILE* open_files;
+
 /* Initialize the standard streams.
    Called from _start() before main(). */
 void __stdio_init(void) {
@@ -49,9 +52,14 @@ void __stdio_init(void) {
 
 /* Flush all open streams.
    Called implicitly on exit(). */
-void __stdio_exit(void) {
-  /* TODO: Call fflush() on stdout (and any other open streams)
-     Note: stderr is unbuffered so doesn't need flushing */
+void __stdio_exit(void) { __stdio_flush_all(); }
+
+int __stdio_flush_all(void) {
+  int result = fflush(stdout);
+  for (FILE* fp = open_files; fp != NULL; fp = fp->next)
+    if (fflush(fp) == EOF)
+      result = EOF;
+  return result;
 }
 
 /* Helper: parse mode string and return flags */
@@ -95,6 +103,8 @@ static FILE* alloc_file(int fd, int flags) {
   fp->cnt = 0;
   fp->bufsiz = 0;
   fp->ungetc_buf = -1;
+  fp->next = open_files;
+  open_files = fp;
 
   return fp;
 }
@@ -177,6 +187,11 @@ int fclose(FILE* stream) {
 
   /* Free the FILE struct if not a standard stream */
   if (stream != stdin && stream != stdout && stream != stderr) {
+    FILE** pp = &open_files;
+    while (*pp != NULL && *pp != stream)
+      pp = &(*pp)->next;
+    if (*pp != NULL)
+      *pp = stream->next;
     free(stream);
   }
 
@@ -7,8 +7,12 @@
 #include <stddef.h>
 #include <stdarg.h>
 
-/* Buffer size for stdio streams */
-#define STDIO_BUFSIZ 512
+/* Default buffer size for stdio streams: one page.  Regular files get a
+   buffer sized from the file instead (see ensure_buffer()), in whole
+   STDIO_BLOCK_SIZE units up to STDIO_BUFSIZ_MAX. */
+#define STDIO_BUFSIZ 4096
+#define STDIO_BUFSIZ_MAX 16384
+#define STDIO_BLOCK_SIZE 512 /* Filesystem sector size. */
 
 /* End-of-file return value */
 #ifndef EOF
@@ -48,6 +52,7 @@ struct __file {
   int flags;                 /* Mode and status flags (_IO* constants) */
   int ungetc_buf;            /* Pushed-back character from ungetc (-1 if none) */
   unsigned char smallbuf[1]; /* 1-byte buffer for unbuffered mode */
+  struct __file* next;       /* Next stream opened by fopen()/fdopen() */
 };
 
 /* Make FILE an alias for struct __file */
@@ -79,6 +84,10 @@ void __stdio_init(void);
    Called implicitly by exit(). */
 void __stdio_exit(void);
 
+/* Flush stdout and every stream opened by fopen() or fdopen().
+   Returns 0 on success, EOF if any flush failed. */
+int __stdio_flush_all(void);
+
 /* Internal printf engine (defined in lib/stdio.c).
    We use this for vfprintf implementation. */
 void __vprintf(const char* format, va_list args, void (*output)(char, void*), void* aux);
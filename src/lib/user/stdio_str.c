@@ -35,11 +35,10 @@ char* fgets(char* s, int n, FILE* stream) {
 /* Write a string to stream (without trailing newline).
    Returns non-negative on success, EOF on error. */
 int fputs(const char* s, FILE* stream) {
-  while (*s != '\0') {
-    if (fputc(*s, stream) == EOF)
-      return EOF;
-    s++;
-  }
+  /* fwrite() moves whole lines, or the whole string, at once */
+  size_t len = strlen(s);
+  if (fwrite(s, 1, len, stream) != len)
+    return EOF;
   return 0; /* Success */
 }
 
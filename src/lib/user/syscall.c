@@ -3,20 +3,49 @@
 #include <pthread.h>
 
 #ifdef ARCH_I386
+#include "../sysenter.h"
+
 /*
  * x86 syscall implementation.
- * Uses int $0x30 with arguments pushed on the stack.
+ * Uses SYSENTER with arguments in registers when the CPU supports it
+ * (see <sysenter.h>), otherwise int $0x30 with arguments pushed on the
+ * stack.  Calls with more than SYSENTER_MAX_ARGS arguments, and calls
+ * returning float, always use int $0x30.
  */
 
+/* Whether to use SYSENTER: 0 if not yet known, 1 if yes, -1 if no. */
+static int sysenter_state;
+
+/* Returns true if system calls should use SYSENTER. */
+static bool use_sysenter(void) {
+  if (sysenter_state == 0)
+    sysenter_state = sysenter_available() ? 1 : -1;
+  return sysenter_state > 0;
+}
+
+/* Invokes syscall NUMBER through SYSENTER, passing arguments ARG0,
+   ARG1, and ARG2 in registers, and returns the return value. */
+static int sysenter_call(int number, uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+  int retval;
+  asm volatile("movl %%esp, %%ecx; movl $1f, %%edx; sysenter; 1:"
+               : "=a"(retval)
+               : "a"(number), "b"(arg0), "S"(arg1), "D"(arg2)
+               : "ecx", "edx", "cc", "memory");
+  return retval;
+}
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                                                           \
   ({                                                                                               \
     int retval;                                                                                    \
-    asm volatile("pushl %[number]; int $0x30; addl $4, %%esp"                                      \
-                 : "=a"(retval)                                                                    \
-                 : [number] "i"(NUMBER)                                                            \
-                 : "memory");                                                                      \
+    if (use_sysenter())                                                                            \
+      retval = sysenter_call(NUMBER, 0, 0, 0);                                                     \
+    else                                                                                           \
+      asm volatile("pushl %[number]; int $0x30; addl $4, %%esp"                                    \
+                   : "=a"(retval)                                                                  \
+                   : [number] "i"(NUMBER)                                                          \
+                   : "memory");                                                                    \
     retval;                                                                                        \
   })
 
@@ -25,10 +54,13 @@
 #define syscall1(NUMBER, ARG0)                                                                     \
   ({                                                                                               \
     int retval;                                                                                    \
-    asm volatile("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp"                       \
-                 : "=a"(retval)                                                                    \
-                 : [number] "i"(NUMBER), [arg0] "g"(ARG0)                                          \
-                 : "memory");                                                                      \
+    if (use_sysenter())                                                                            \
+      retval = sysenter_call(NUMBER, (uint32_t)(ARG0), 0, 0);                                      \
+    else                                                                                           \
+      asm volatile("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp"                     \
+                   : "=a"(retval)                                                                  \
+                   : [number] "i"(NUMBER), [arg0] "g"(ARG0)                                        \
+                   : "memory");                                                                    \
     retval;                                                                                        \
   })
 
@@ -49,11 +81,14 @@
 #define syscall2(NUMBER, ARG0, ARG1)                                                               \
   ({                                                                                               \
     int retval;                                                                                    \
-    asm volatile("pushl %[arg1]; pushl %[arg0]; "                                                  \
-                 "pushl %[number]; int $0x30; addl $12, %%esp"                                     \
-                 : "=a"(retval)                                                                    \
-                 : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1)                        \
-                 : "memory");                                                                      \
+    if (use_sysenter())                                                                            \
+      retval = sysenter_call(NUMBER, (uint32_t)(ARG0), (uint32_t)(ARG1), 0);                       \
+    else                                                                                           \
+      asm volatile("pushl %[arg1]; pushl %[arg0]; "                                                \
+                   "pushl %[number]; int $0x30; addl $12, %%esp"                                   \
+                   : "=a"(retval)                                                                  \
+                   : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1)                      \
+                   : "memory");                                                                    \
     retval;                                                                                        \
   })
 
@@ -62,10 +97,27 @@
 #define syscall3(NUMBER, ARG0, ARG1, ARG2)                                                         \
   ({                                                                                               \
     int retval;                                                                                    \
-    asm volatile("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "                                   \
-                 "pushl %[number]; int $0x30; addl $16, %%esp"                                     \
+    if (use_sysenter())                                                                            \
+      retval = sysenter_call(NUMBER, (uint32_t)(ARG0), (uint32_t)(ARG1), (uint32_t)(ARG2));        \
+    else                                                                                           \
+      asm volatile("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "                                 \
+                   "pushl %[number]; int $0x30; addl $16, %%esp"                                   \
+                   : "=a"(retval)                                                                  \
+                   : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1), [arg2] "r"(ARG2)    \
+                   : "memory");                                                                    \
+    retval;                                                                                        \
+  })
+
+/* Invokes syscall NUMBER, passing 4 arguments, and returns the
+   return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                                   \
+  ({                                                                                               \
+    int retval;                                                                                    \
+    asm volatile("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "                    \
+                 "pushl %[number]; int $0x30; addl $20, %%esp"                                     \
                  : "=a"(retval)                                                                    \
-                 : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1), [arg2] "r"(ARG2)      \
+                 : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1), [arg2] "r"(ARG2),     \
+                   [arg3] "r"(ARG3)                                                                \
                  : "memory");                                                                      \
     retval;                                                                                        \
   })
@@ -147,6 +199,18 @@
     (int)_a0;                                                                                      \
   })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2, ARG3 */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                                   \
+  ({                                                                                               \
+    register long _num asm("a7") = (NUMBER);                                                       \
+    register long _a0 asm("a0") = (long)(ARG0);                                                    \
+    register long _a1 asm("a1") = (long)(ARG1);                                                    \
+    register long _a2 asm("a2") = (long)(ARG2);                                                    \
+    register long _a3 asm("a3") = (long)(ARG3);                                                    \
+    asm volatile("ecall" : "+r"(_a0) : "r"(_num), "r"(_a1), "r"(_a2), "r"(_a3) : "memory");        \
+    (int)_a0;                                                                                      \
+  })
+
 /* Invokes syscall NUMBER, passing 6 arguments */
 #define syscall6(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4, ARG5)                                       \
   ({                                                                                               \
@@ -206,6 +270,26 @@ unsigned tell(int fd) { return syscall1(SYS_TELL, fd); }
 
 void close(int fd) { syscall1(SYS_CLOSE, fd); }
 
+int pread(int fd, void* buffer, unsigned size, unsigned offset) {
+  return syscall4(SYS_PREAD, fd, buffer, size, offset);
+}
+
+int pwrite(int fd, const void* buffer, unsigned size, unsigned offset) {
+  return syscall4(SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int readv(int fd, const struct iovec* iov, int iovcnt) {
+  return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec* iov, int iovcnt) {
+  return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int copy_file_range(int fd_in, int fd_out, unsigned size) {
+  return syscall3(SYS_COPY_FILE_RANGE, fd_in, fd_out, size);
+}
+
 mapid_t mmap(int fd, void* addr) { return syscall2(SYS_MMAP, fd, addr); }
 
 void munmap(mapid_t mapid) { syscall1(SYS_MUNMAP, mapid); }
@@ -263,7 +347,61 @@ void sema_up(sema_t* sema) {
     exit(1);
 }
 
-tid_t get_tid(void) { return syscall0(SYS_GET_TID); }
+bool cond_init(cond_t* cond) { return syscall1(SYS_COND_INIT, cond); }
+
+void cond_wait(cond_t* cond, lock_t* lock) {
+  bool success = syscall2(SYS_COND_WAIT, cond, lock);
+  if (!success)
+    exit(1);
+}
+
+void cond_signal(cond_t* cond, lock_t* lock) {
+  bool success = syscall2(SYS_COND_SIGNAL, cond, lock);
+  if (!success)
+    exit(1);
+}
+
+void cond_broadcast(cond_t* cond, lock_t* lock) {
+  bool success = syscall2(SYS_COND_BROADCAST, cond, lock);
+  if (!success)
+    exit(1);
+}
+
+bool barrier_init(barrier_t* barrier, unsigned count) {
+  return syscall2(SYS_BARRIER_INIT, barrier, count);
+}
+
+bool barrier_wait(barrier_t* barrier) {
+  int result = syscall1(SYS_BARRIER_WAIT, barrier);
+  if (result < 0)
+    exit(1);
+  return result;
+}
+
+bool rwlock_init(rwlock_t* rwlock) { return syscall1(SYS_RWLOCK_INIT, rwlock); }
+
+/* Acquires RWLOCK, for reading if READER. */
+static void rwlock_acquire(rwlock_t* rwlock, bool reader) {
+  bool success = syscall2(SYS_RWLOCK_ACQUIRE, rwlock, (int)reader);
+  if (!success)
+    exit(1);
+}
+
+/* Releases RWLOCK, held for reading if READER. */
+static void rwlock_release(rwlock_t* rwlock, bool reader) {
+  bool success = syscall2(SYS_RWLOCK_RELEASE, rwlock, (int)reader);
+  if (!success)
+    exit(1);
+}
+
+void rwlock_acquire_read(rwlock_t* rwlock) { rwlock_acquire(rwlock, true); }
+void rwlock_acquire_write(rwlock_t* rwlock) { rwlock_acquire(rwlock, false); }
+void rwlock_release_read(rwlock_t* rwlock) { rwlock_release(rwlock, true); }
+void rwlock_release_write(rwlock_t* rwlock) { rwlock_release(rwlock, false); }
+
+tid_t sys_get_tid(void) { return syscall0(SYS_GET_TID); }
+
+pid_t sys_get_pid(void) { return syscall0(SYS_GET_PID); }
 
 pid_t fork(void) { return syscall0(SYS_FORK); }
 
@@ -277,4 +415,38 @@ int readlink(const char* path, char* buf, size_t bufsize) {
   return syscall3(SYS_READLINK, path, buf, bufsize);
 }
 
-int pipe(int pipefd[2]) { return syscall1(SYS_PIPE, pipefd); }
\ No newline at end of file
+int pipe(int pipefd[2]) { return syscall1(SYS_PIPE, pipefd); }
+
+int splice(int fd_in, int fd_out, unsigned size) {
+  return syscall3(SYS_SPLICE, fd_in, fd_out, size);
+}
+
+int poll(struct pollfd* fds, unsigned nfds, int timeout) {
+  return syscall3(SYS_POLL, fds, nfds, timeout);
+}
+
+int epoll_create(void) { return syscall0(SYS_EPOLL_CREATE); }
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+  return syscall4(SYS_EPOLL_CTL, epfd, op, fd, event);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout) {
+  return syscall4(SYS_EPOLL_WAIT, epfd, events, maxevents, timeout);
+}
+
+int io_uring_setup(unsigned entries, void* mem) {
+  return syscall2(SYS_IO_URING_SETUP, entries, mem);
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete) {
+  return syscall3(SYS_IO_URING_ENTER, fd, to_submit, min_complete);
+}
+
+int shm_open(const char* name, size_t size) { return syscall2(SYS_SHM_OPEN, name, size); }
+
+bool shm_unlink(const char* name) { return syscall1(SYS_SHM_UNLINK, name); }
+
+bool get_vmstat(int scope, struct vmstat* stats) { return syscall2(SYS_VMSTAT, scope, stats); }
+
+int systrace(int op, void* buf, unsigned size) { return syscall3(SYS_SYSTRACE, op, buf, size); }
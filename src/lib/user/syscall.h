@@ -2,10 +2,15 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <debug.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include "../poll.h"
 #include "../syscall-nr.h"
+#include "../systrace.h"
+#include "../uio.h"
+#include "../vmstat.h"
 
 /* Process identifier. */
 typedef int pid_t;
@@ -14,6 +19,9 @@ typedef int pid_t;
 /* Synchronization Types */
 typedef int lock_t;
 typedef int sema_t;
+typedef int cond_t;
+typedef int barrier_t;
+typedef int rwlock_t;
 
 /* Map region identifier. */
 typedef int mapid_t;
@@ -40,6 +48,21 @@ int write(int fd, const void* buffer, unsigned length);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
+
+/* Positional I/O: transfers at file offset OFFSET, leaving the file
+   position alone.  Regular files only. */
+int pread(int fd, void* buffer, unsigned length, unsigned offset);
+int pwrite(int fd, const void* buffer, unsigned length, unsigned offset);
+
+/* Vectored I/O: transfers the IOVCNT segments of IOV in order, as one
+   read() or write() would. */
+int readv(int fd, const struct iovec* iov, int iovcnt);
+int writev(int fd, const struct iovec* iov, int iovcnt);
+
+/* Copies up to SIZE bytes from FD_IN's file position to FD_OUT's inside
+   the kernel, advancing both.  Returns the number of bytes copied. */
+int copy_file_range(int fd_in, int fd_out, unsigned size);
+
 int practice(int i);
 double compute_e(int n);
 tid_t sys_pthread_create(stub_fun sfun, pthread_fun tfun, const void* arg);
@@ -51,7 +74,38 @@ void lock_release(lock_t* lock);
 bool sema_init(sema_t* sema, int val);
 void sema_down(sema_t* sema);
 void sema_up(sema_t* sema);
+
+/* Condition variables, used with a lock the caller holds, as in the
+   kernel.  cond_broadcast() wakes every waiter in one system call. */
+bool cond_init(cond_t* cond);
+void cond_wait(cond_t* cond, lock_t* lock);
+void cond_signal(cond_t* cond, lock_t* lock);
+void cond_broadcast(cond_t* cond, lock_t* lock);
+
+/* Barriers for COUNT threads.  barrier_wait() returns once COUNT threads
+   have called it, true in exactly one of them.  The barrier is then
+   ready for the next phase. */
+bool barrier_init(barrier_t* barrier, unsigned count);
+bool barrier_wait(barrier_t* barrier);
+
+/* Writer-preferring reader-writer locks. */
+bool rwlock_init(rwlock_t* rwlock);
+void rwlock_acquire_read(rwlock_t* rwlock);
+void rwlock_acquire_write(rwlock_t* rwlock);
+void rwlock_release_read(rwlock_t* rwlock);
+void rwlock_release_write(rwlock_t* rwlock);
+
+/* Thread identity and clock, read from the kernel data page when
+   possible (see lib/user/kdata.c). */
 tid_t get_tid(void);
+pid_t get_pid(void);
+int64_t get_ticks(void);
+int get_tick_freq(void);
+int64_t get_time_ns(void);
+
+/* Raw system calls behind get_tid() and get_pid(). */
+tid_t sys_get_tid(void);
+pid_t sys_get_pid(void);
 
 /* Project 3 and optionally project 4. */
 mapid_t mmap(int fd, void* addr);
@@ -63,6 +117,9 @@ void* mmap2(void* addr, size_t length, int prot, int flags, int fd, int offset);
 /* Convenience macro for anonymous mappings */
 #define mmap_anon(addr, len) mmap2((addr), (len), 0, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
 
+/* Convenience macro for anonymous memory shared with forked children */
+#define mmap_shared(addr, len) mmap2((addr), (len), 0, MAP_SHARED | MAP_ANONYMOUS, -1, 0)
+
 /* Project 4 only. */
 bool chdir(const char* dir);
 bool mkdir(const char* dir);
@@ -77,8 +134,46 @@ bool link(const char* oldpath, const char* newpath);
 bool symlink(const char* target, const char* linkpath);
 int readlink(const char* path, char* buf, size_t bufsize);
 
-/* Pipes. */
+/* Pipes.  splice() moves up to SIZE bytes from FD_IN to FD_OUT inside the
+   kernel, one of them a pipe and the other a file, advancing the file's
+   position.  Returns the number of bytes moved, 0 at end of input. */
 int pipe(int pipefd[2]);
+int splice(int fd_in, int fd_out, unsigned size);
+
+/* Readiness.  poll() waits up to TIMEOUT milliseconds (forever if
+   negative) for events on any of NFDS descriptors.  epoll_create()
+   returns a descriptor for an interest set kept in the kernel, changed
+   with epoll_ctl() and waited on with epoll_wait().  Both waits return
+   the number of descriptors with events. */
+int poll(struct pollfd* fds, unsigned nfds, int timeout);
+int epoll_create(void);
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+int epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout);
+
+/* Asynchronous I/O rings (see lib/io_uring.h, and lib/user/uring.h for
+   helpers).  io_uring_setup() lays out a ring with an SQ of ENTRIES
+   entries in the IORING_MEM_SIZE(ENTRIES) bytes at MEM and returns its
+   descriptor.  io_uring_enter() submits up to TO_SUBMIT queued entries,
+   then waits until MIN_COMPLETE completions are ready or nothing is in
+   flight, and returns the number submitted. */
+int io_uring_setup(unsigned entries, void* mem);
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete);
+
+/* Shared memory objects.  shm_open() returns a descriptor for the object
+   called NAME, creating it with SIZE bytes if it does not exist; map it
+   with mmap2(..., MAP_SHARED, fd, offset). */
+int shm_open(const char* name, size_t size);
+bool shm_unlink(const char* name);
+
+/* VM statistics: fills STATS with the VMSTAT_GLOBAL or VMSTAT_PROCESS
+   counters.  Returns false if SCOPE is invalid. */
+bool get_vmstat(int scope, struct vmstat* stats);
+
+/* System call tracing (see <systrace.h>).  OP is a SYSTRACE_* operation;
+   BUF receives a struct systrace_stats for SYSTRACE_STATS or up to SIZE
+   struct systrace_event for SYSTRACE_EVENTS.  Returns the number of
+   events read for SYSTRACE_EVENTS, otherwise 0, or -1 on error. */
+int systrace(int op, void* buf, unsigned size);
 
 pid_t fork(void);
 
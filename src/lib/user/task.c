@@ -0,0 +1,477 @@
+/* Work-stealing task runtime.
+ *
+ * Each thread in a session owns a worker: a bounded deque of tasks
+ * behind a benaphore (see benaphore.h).  The owner pushes and pops at the
+ * bottom; thieves take from the top, so they get the oldest and,
+ * under divide and conquer, the largest pieces of work.  A task that
+ * finds its deque full runs at once instead.
+ *
+ * A thread with nothing to run sleeps on one condition variable shared
+ * by the whole session.  QUEUED counts tasks sitting in deques and
+ * SLEEPERS counts threads about to sleep or asleep; a thread queueing a
+ * task or finishing the last task of a group signals the condition only
+ * when SLEEPERS is nonzero, so the common case makes no system call.
+ * Both sides update their own counter before reading the other's, with
+ * sequentially consistent atomics, so a wakeup is never lost.
+ *
+ * A thread waiting for a group runs its own tasks first, newest first,
+ * which under divide and conquer are the group's.  It steals other
+ * threads' tasks only while its nesting of waits is shallow, to bound
+ * its stack, and otherwise sleeps until the group is done.
+ */
+
+#include <task.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "benaphore.h"
+
+/* Tasks a deque holds; more are run at once.  A power of 2. */
+#define DEQUE_SIZE 128
+
+/* Deepest nesting of task_group_wait() at which a thread still steals. */
+#define STEAL_DEPTH_MAX 4
+
+/* parallel_sort() leaves ranges this short to the sequential sort. */
+#define SORT_LEAF 512
+
+/* Grain per worker that parallel_for() aims for when given none. */
+#define FOR_CHUNKS_PER_WORKER 8
+
+struct task {
+  task_func* fn;
+  void* aux;
+  size_t lo, hi;
+  struct task_group* group; /* Told when the task finishes. */
+};
+
+struct worker {
+  struct mutex mutex;             /* Guards the deque. */
+  struct task deque[DEQUE_SIZE];  /* Ring of tasks. */
+  unsigned top;                   /* Oldest task, the next to be stolen. */
+  unsigned bottom;                /* One past the newest task. */
+  tid_t tid;                      /* Thread that owns this worker, or 0. */
+  unsigned seed;                  /* Picks steal victims. */
+  int depth;                      /* Nesting of task_group_wait(). */
+};
+
+static struct worker workers[TASK_WORKERS_MAX];
+static int num_workers = TASK_WORKERS_DEFAULT; /* For the next session. */
+static int active;                             /* Workers in this session. */
+static bool session_over;                      /* Helpers should return. */
+
+static lock_t session_lock; /* One session at a time. */
+static lock_t idle_lock;    /* With IDLE_COND. */
+static cond_t idle_cond;    /* Sleepers wait here for work or progress. */
+static int queued;          /* Tasks in all deques. */
+static int sleepers;        /* Threads sleeping on IDLE_COND. */
+
+static struct task_stats stats;
+
+/* Initialization state. */
+static int init_state = INIT_NONE;
+
+/* ============================================================================
+ * INITIALIZATION
+ * ============================================================================ */
+
+static bool init(void) {
+  if (!lock_init(&session_lock) || !lock_init(&idle_lock) || !cond_init(&idle_cond))
+    return false;
+  for (int i = 0; i < TASK_WORKERS_MAX; i++)
+    if (!mutex_init(&workers[i].mutex))
+      return false;
+  return true;
+}
+
+/* Initializes the runtime on first use.  A thread that finds another
+   already at it waits for it to finish.  Returns false if
+   initialization failed, in which case every task runs inline. */
+static bool ensure_init(void) {
+  return init_once(&init_state, init);
+}
+
+void task_set_workers(int n) {
+  num_workers = n < 1 ? 1 : n > TASK_WORKERS_MAX ? TASK_WORKERS_MAX : n;
+}
+
+int task_get_workers(void) { return num_workers; }
+
+void task_get_stats(struct task_stats* s) {
+  s->sessions = __atomic_load_n(&stats.sessions, __ATOMIC_RELAXED);
+  s->spawned = __atomic_load_n(&stats.spawned, __ATOMIC_RELAXED);
+  s->inlined = __atomic_load_n(&stats.inlined, __ATOMIC_RELAXED);
+  s->stolen = __atomic_load_n(&stats.stolen, __ATOMIC_RELAXED);
+}
+
+/* ============================================================================
+ * DEQUES
+ * ============================================================================ */
+
+/* Returns the calling thread's worker, or NULL if it is not in the
+   current session. */
+static struct worker* self(void) {
+  int n = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+  if (n == 0)
+    return NULL;
+
+  tid_t tid = get_tid();
+  for (int i = 0; i < n; i++)
+    if (__atomic_load_n(&workers[i].tid, __ATOMIC_RELAXED) == tid)
+      return &workers[i];
+  return NULL;
+}
+
+/* Wakes one sleeper, if there are any. */
+static void wake_one(void) {
+  if (__atomic_load_n(&sleepers, __ATOMIC_SEQ_CST) > 0) {
+    lock_acquire(&idle_lock);
+    cond_signal(&idle_cond, &idle_lock);
+    lock_release(&idle_lock);
+  }
+}
+
+/* Wakes every sleeper, if there are any. */
+static void wake_all(void) {
+  if (__atomic_load_n(&sleepers, __ATOMIC_SEQ_CST) > 0) {
+    lock_acquire(&idle_lock);
+    cond_broadcast(&idle_cond, &idle_lock);
+    lock_release(&idle_lock);
+  }
+}
+
+/* Returns true if W's deque is empty, without locking it, so the answer
+   may already be out of date. */
+static bool is_empty(struct worker* w) {
+  return __atomic_load_n(&w->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&w->top, __ATOMIC_RELAXED);
+}
+
+/* Pushes T onto W's deque.  Returns false if the deque is full. */
+static bool push(struct worker* w, const struct task* t) {
+  mutex_acquire(&w->mutex);
+  if (w->bottom - w->top == DEQUE_SIZE) {
+    mutex_release(&w->mutex);
+    return false;
+  }
+  w->deque[w->bottom % DEQUE_SIZE] = *t;
+  __atomic_store_n(&w->bottom, w->bottom + 1, __ATOMIC_RELAXED);
+  mutex_release(&w->mutex);
+
+  __atomic_add_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+  wake_one();
+  return true;
+}
+
+/* Pops the newest task on W's deque into *T.  Returns false if the
+   deque is empty. */
+static bool pop(struct worker* w, struct task* t) {
+  if (is_empty(w))
+    return false;
+
+  mutex_acquire(&w->mutex);
+  bool found = w->bottom != w->top;
+  if (found) {
+    *t = w->deque[(w->bottom - 1) % DEQUE_SIZE];
+    __atomic_store_n(&w->bottom, w->bottom - 1, __ATOMIC_RELAXED);
+  }
+  mutex_release(&w->mutex);
+
+  if (found)
+    __atomic_sub_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+  return found;
+}
+
+/* Takes the oldest task on VICTIM's deque into *T.  Returns false if
+   the deque is empty. */
+static bool steal(struct worker* victim, struct task* t) {
+  if (is_empty(victim))
+    return false;
+
+  mutex_acquire(&victim->mutex);
+  bool found = victim->bottom != victim->top;
+  if (found) {
+    *t = victim->deque[victim->top % DEQUE_SIZE];
+    __atomic_store_n(&victim->top, victim->top + 1, __ATOMIC_RELAXED);
+  }
+  mutex_release(&victim->mutex);
+
+  if (found) {
+    __atomic_sub_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&stats.stolen, 1, __ATOMIC_RELAXED);
+  }
+  return found;
+}
+
+/* Tries every other worker once, starting at a random one. */
+static bool steal_any(struct worker* me, struct task* t) {
+  int n = __atomic_load_n(&active, __ATOMIC_ACQUIRE);
+
+  me->seed = me->seed * 1103515245 + 12345;
+  int start = (me->seed >> 16) % n;
+  for (int i = 0; i < n; i++) {
+    struct worker* victim = &workers[(start + i) % n];
+    if (victim != me && steal(victim, t))
+      return true;
+  }
+  return false;
+}
+
+static void run_task(const struct task* t) {
+  t->fn(t->aux, t->lo, t->hi);
+  if (__atomic_sub_fetch(&t->group->pending, 1, __ATOMIC_SEQ_CST) == 0)
+    wake_all();
+}
+
+/* Sleeps until DONE() returns true for ARG or, if ANY_WORK, a task is
+   queued. */
+static void sleep_until(bool (*done)(void*), void* arg, bool any_work) {
+  lock_acquire(&idle_lock);
+  __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+  while (!(any_work && __atomic_load_n(&queued, __ATOMIC_SEQ_CST) > 0) && !done(arg))
+    cond_wait(&idle_cond, &idle_lock);
+  __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+  lock_release(&idle_lock);
+}
+
+/* ============================================================================
+ * SESSIONS AND GROUPS
+ * ============================================================================ */
+
+static bool is_session_over(void* aux UNUSED) {
+  return __atomic_load_n(&session_over, __ATOMIC_SEQ_CST);
+}
+
+static bool is_group_done(void* group) {
+  return __atomic_load_n(&((struct task_group*)group)->pending, __ATOMIC_SEQ_CST) == 0;
+}
+
+/* Helper thread: runs tasks until the session ends. */
+static void helper(void* worker) {
+  struct worker* me = worker;
+  struct task t;
+
+  __atomic_store_n(&me->tid, get_tid(), __ATOMIC_RELAXED);
+  while (!is_session_over(NULL)) {
+    if (pop(me, &t) || steal_any(me, &t))
+      run_task(&t);
+    else
+      sleep_until(is_session_over, NULL, true);
+  }
+}
+
+/* Resets worker I for a session, owned by thread TID. */
+static void worker_reset(int i, tid_t tid) {
+  struct worker* w = &workers[i];
+  w->top = w->bottom = 0;
+  w->tid = tid;
+  w->seed = i + 1;
+  w->depth = 0;
+}
+
+void task_run(task_func* fn, void* aux, size_t lo, size_t hi) {
+  if (self() != NULL || num_workers == 1 || !ensure_init()) {
+    fn(aux, lo, hi);
+    return;
+  }
+
+  lock_acquire(&session_lock);
+  __atomic_store_n(&session_over, false, __ATOMIC_SEQ_CST);
+  worker_reset(0, get_tid());
+  __atomic_store_n(&active, 1, __ATOMIC_RELEASE);
+
+  /* Both the helper and this thread record the helper's tid, so that
+     it is known before either the helper runs or others steal from it. */
+  tid_t tids[TASK_WORKERS_MAX];
+  int n;
+  for (n = 1; n < num_workers; n++) {
+    worker_reset(n, 0);
+    tids[n] = pthread_create(helper, &workers[n]);
+    if (tids[n] == TID_ERROR)
+      break;
+    __atomic_store_n(&workers[n].tid, tids[n], __ATOMIC_RELAXED);
+    __atomic_store_n(&active, n + 1, __ATOMIC_RELEASE);
+  }
+  __atomic_add_fetch(&stats.sessions, 1, __ATOMIC_RELAXED);
+
+  fn(aux, lo, hi);
+
+  __atomic_store_n(&session_over, true, __ATOMIC_SEQ_CST);
+  wake_all();
+  for (int i = 1; i < n; i++)
+    pthread_join(tids[i]);
+
+  __atomic_store_n(&active, 0, __ATOMIC_RELEASE);
+  workers[0].tid = 0;
+  lock_release(&session_lock);
+}
+
+void task_group_init(struct task_group* g) { g->pending = 0; }
+
+void task_spawn(struct task_group* g, task_func* fn, void* aux, size_t lo, size_t hi) {
+  struct task t = {fn, aux, lo, hi, g};
+  struct worker* me = self();
+
+  __atomic_add_fetch(&g->pending, 1, __ATOMIC_SEQ_CST);
+  if (me != NULL && push(me, &t)) {
+    __atomic_add_fetch(&stats.spawned, 1, __ATOMIC_RELAXED);
+  } else {
+    __atomic_add_fetch(&stats.inlined, 1, __ATOMIC_RELAXED);
+    run_task(&t);
+  }
+}
+
+void task_group_wait(struct task_group* g) {
+  struct worker* me = self();
+  struct task t;
+
+  if (me == NULL) {
+    /* Every task ran inline. */
+    while (!is_group_done(g))
+      continue;
+    return;
+  }
+
+  me->depth++;
+  bool may_steal = me->depth <= STEAL_DEPTH_MAX;
+  while (!is_group_done(g)) {
+    if (pop(me, &t) || (may_steal && steal_any(me, &t)))
+      run_task(&t);
+    else
+      sleep_until(is_group_done, g, may_steal);
+  }
+  me->depth--;
+}
+
+/* ============================================================================
+ * PARALLEL FOR
+ * ============================================================================ */
+
+struct for_args {
+  task_func* body;
+  void* aux;
+  size_t grain;
+};
+
+/* Runs the loop over [LO, HI), a grain at a time.  Whenever the
+   calling thread's deque is empty, which means any task it queued has
+   been stolen, splits off the upper half of what is left for others. */
+static void for_range(void* args_, size_t lo, size_t hi) {
+  struct for_args* args = args_;
+  struct worker* me = self();
+  struct task_group g;
+
+  task_group_init(&g);
+  while (lo < hi) {
+    while (me != NULL && hi - lo > args->grain && is_empty(me)) {
+      size_t mid = lo + (hi - lo) / 2;
+      task_spawn(&g, for_range, args, mid, hi);
+      hi = mid;
+    }
+
+    size_t end = hi - lo > args->grain ? lo + args->grain : hi;
+    args->body(args->aux, lo, end);
+    lo = end;
+  }
+  task_group_wait(&g);
+}
+
+void parallel_for(size_t lo, size_t hi, size_t grain, task_func* body, void* aux) {
+  if (lo >= hi)
+    return;
+  if (grain == 0) {
+    grain = (hi - lo) / (num_workers * FOR_CHUNKS_PER_WORKER);
+    if (grain == 0)
+      grain = 1;
+  }
+
+  struct for_args args = {body, aux, grain};
+  task_run(for_range, &args, lo, hi);
+}
+
+/* ============================================================================
+ * PARALLEL SORT
+ * ============================================================================ */
+
+struct sort_args {
+  unsigned char* array;
+  size_t size;
+  int (*compare)(const void*, const void*);
+};
+
+static unsigned char* elem(const struct sort_args* s, size_t i) { return s->array + i * s->size; }
+
+static void swap(const struct sort_args* s, size_t a, size_t b) {
+  unsigned char* pa = elem(s, a);
+  unsigned char* pb = elem(s, b);
+  for (size_t i = 0; i < s->size; i++) {
+    unsigned char t = pa[i];
+    pa[i] = pb[i];
+    pb[i] = t;
+  }
+}
+
+static int compare(const struct sort_args* s, size_t a, size_t b) {
+  return s->compare(elem(s, a), elem(s, b));
+}
+
+/* Partitions [LO, HI), which has at least 3 elements, around the
+   median of its first, middle and last elements.  Returns the pivot's
+   final index P: elements before it are no greater, and elements after
+   it no less. */
+static size_t partition(const struct sort_args* s, size_t lo, size_t hi) {
+  size_t mid = lo + (hi - lo) / 2;
+  size_t last = hi - 1;
+
+  /* Leave the smallest of the three at LO, as a sentinel for the
+     downward scan, and the median at LAST. */
+  if (compare(s, mid, lo) < 0)
+    swap(s, mid, lo);
+  if (compare(s, last, lo) < 0)
+    swap(s, last, lo);
+  if (compare(s, mid, last) < 0)
+    swap(s, mid, last);
+
+  size_t i = lo, j = last;
+  for (;;) {
+    while (compare(s, i, last) < 0)
+      i++;
+    do
+      j--;
+    while (compare(s, last, j) < 0);
+    if (i >= j)
+      break;
+    swap(s, i, j);
+    i++;
+  }
+  swap(s, i, last);
+  return i;
+}
+
+/* Sorts [LO, HI).  Spawns the smaller side of each partition and keeps
+   the larger, so a task that waits and then runs its own spawns nests
+   no deeper than the log of the range's length. */
+static void sort_range(void* args_, size_t lo, size_t hi) {
+  struct sort_args* s = args_;
+  struct task_group g;
+
+  task_group_init(&g);
+  while (hi - lo > SORT_LEAF) {
+    size_t p = partition(s, lo, hi);
+    if (p - lo < hi - (p + 1)) {
+      task_spawn(&g, sort_range, s, lo, p);
+      lo = p + 1;
+    } else {
+      task_spawn(&g, sort_range, s, p + 1, hi);
+      hi = p;
+    }
+  }
+  qsort(elem(s, lo), hi - lo, s->size, s->compare);
+  task_group_wait(&g);
+}
+
+void parallel_sort(void* array, size_t cnt, size_t size,
+                   int (*compare)(const void*, const void*)) {
+  struct sort_args args = {array, size, compare};
+  task_run(sort_range, &args, 0, cnt);
+}
@@ -0,0 +1,75 @@
+#ifndef __LIB_USER_TASK_H
+#define __LIB_USER_TASK_H
+
+#include <stddef.h>
+
+/* Work-stealing task runtime.
+
+   task_run() starts a session: the calling thread and up to
+   task_get_workers() - 1 helper threads, each with a deque of tasks.
+   A thread pushes the tasks it spawns onto its own deque and pops the
+   newest one when it runs out of work; an idle thread steals the
+   oldest task from another thread's deque.  Helpers are ordinary
+   pthreads, created for the session and joined when it ends, so no
+   thread outlives the call.
+
+   parallel_for() and parallel_sort() start a session of their own,
+   or join the current one when called from inside it.
+
+   Task bodies in helper threads run on a one-page pthread stack, so
+   they should not recurse deeply or keep large objects on the stack. */
+
+/* A task: runs over the range [LO, HI) with AUX. */
+typedef void task_func(void* aux, size_t lo, size_t hi);
+
+/* Tasks spawned together, to be waited for together. */
+struct task_group {
+  int pending; /* Spawned tasks that have not finished. */
+};
+
+/* Runtime statistics, totals since the program started. */
+struct task_stats {
+  unsigned sessions; /* Calls to task_run() that started helpers. */
+  unsigned spawned;  /* Tasks pushed onto a deque. */
+  unsigned inlined;  /* Tasks run at once, because no deque had room. */
+  unsigned stolen;   /* Tasks taken from another thread's deque. */
+};
+
+/* Sets the number of threads, the caller included, that later
+   sessions use.  The default is TASK_WORKERS_DEFAULT; N is clamped to
+   [1, TASK_WORKERS_MAX]. */
+#define TASK_WORKERS_DEFAULT 4
+#define TASK_WORKERS_MAX 8
+void task_set_workers(int n);
+int task_get_workers(void);
+
+/* Runs FN(AUX, LO, HI) in a session and returns when it has finished.
+   FN must wait for every group it spawns into.  Called from inside a
+   session, just calls FN. */
+void task_run(task_func* fn, void* aux, size_t lo, size_t hi);
+
+void task_group_init(struct task_group*);
+
+/* Spawns FN(AUX, LO, HI) into GROUP.  Outside a session, runs it
+   before returning. */
+void task_spawn(struct task_group*, task_func* fn, void* aux, size_t lo, size_t hi);
+
+/* Waits until every task spawned into GROUP has finished, running
+   queued tasks in the meantime. */
+void task_group_wait(struct task_group*);
+
+/* Calls BODY(AUX, lo, hi) on subranges that together cover [LO, HI),
+   in parallel.  Ranges are split in half while the splitting thread
+   has nothing queued, down to GRAIN iterations; a GRAIN of 0 picks one
+   from the range and the number of workers. */
+void parallel_for(size_t lo, size_t hi, size_t grain, task_func* body, void* aux);
+
+/* Sorts ARRAY, which has CNT elements of SIZE bytes each, into the
+   order given by COMPARE, in parallel.  Not stable. */
+void parallel_sort(void* array, size_t cnt, size_t size,
+                   int (*compare)(const void*, const void*));
+
+/* Fills STATS with the runtime's statistics. */
+void task_get_stats(struct task_stats* stats);
+
+#endif /* lib/user/task.h */
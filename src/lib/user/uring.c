@@ -0,0 +1,92 @@
+#include <uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Index accesses shared with the kernel's worker threads.  The acquire
+   load of an index the kernel advances comes before reading the entries
+   it covers; the release store of one we advance comes after writing
+   them. */
+#define LOAD_INDEX(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define STORE_INDEX(P, V) __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+
+int io_uring_queue_init_mem(unsigned entries, struct io_uring* ring, void* mem, size_t size) {
+  if (entries == 0 || size < IORING_MEM_SIZE(entries))
+    return -1;
+
+  int fd = io_uring_setup(entries, mem);
+  if (fd < 0)
+    return -1;
+
+  ring->fd = fd;
+  ring->rings = mem;
+  ring->sqes = (struct io_uring_sqe*)((uint8_t*)mem + IORING_SQES_OFFSET);
+  ring->cqes = (struct io_uring_cqe*)((uint8_t*)mem + IORING_CQES_OFFSET(entries));
+  ring->sq_mask = ring->rings->sq_entries - 1;
+  ring->cq_mask = ring->rings->cq_entries - 1;
+  ring->sq_queued = 0;
+  ring->mem = NULL;
+  return 0;
+}
+
+int io_uring_queue_init(unsigned entries, struct io_uring* ring) {
+  void* mem = malloc(IORING_MEM_SIZE(entries));
+  if (mem == NULL)
+    return -1;
+  if (io_uring_queue_init_mem(entries, ring, mem, IORING_MEM_SIZE(entries)) < 0) {
+    free(mem);
+    return -1;
+  }
+  ring->mem = mem;
+  return 0;
+}
+
+void io_uring_queue_exit(struct io_uring* ring) {
+  /* Closing waits for operations in progress, so the memory is free. */
+  close(ring->fd);
+  free(ring->mem);
+}
+
+struct io_uring_sqe* io_uring_get_sqe(struct io_uring* ring) {
+  unsigned head = LOAD_INDEX(&ring->rings->sq_head);
+  if (ring->sq_queued - head > ring->sq_mask)
+    return NULL;
+
+  struct io_uring_sqe* sqe = &ring->sqes[ring->sq_queued++ & ring->sq_mask];
+  memset(sqe, 0, sizeof *sqe);
+  return sqe;
+}
+
+int io_uring_submit_and_wait(struct io_uring* ring, unsigned wait_nr) {
+  /* Entries the kernel left unconsumed last time are submitted again. */
+  STORE_INDEX(&ring->rings->sq_tail, ring->sq_queued);
+  unsigned to_submit = ring->sq_queued - LOAD_INDEX(&ring->rings->sq_head);
+  return io_uring_enter(ring->fd, to_submit, wait_nr);
+}
+
+int io_uring_submit(struct io_uring* ring) { return io_uring_submit_and_wait(ring, 0); }
+
+int io_uring_peek_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr) {
+  unsigned head = ring->rings->cq_head;
+  if (head == LOAD_INDEX(&ring->rings->cq_tail))
+    return -1;
+  *cqe_ptr = &ring->cqes[head & ring->cq_mask];
+  return 0;
+}
+
+int io_uring_wait_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr) {
+  while (io_uring_peek_cqe(ring, cqe_ptr) < 0) {
+    unsigned tail = LOAD_INDEX(&ring->rings->cq_tail);
+    if (io_uring_submit_and_wait(ring, 1) < 0)
+      return -1;
+
+    /* Returning without a new completion means nothing was in flight. */
+    if (LOAD_INDEX(&ring->rings->cq_tail) == tail)
+      return io_uring_peek_cqe(ring, cqe_ptr);
+  }
+  return 0;
+}
+
+void io_uring_cqe_seen(struct io_uring* ring, struct io_uring_cqe* cqe UNUSED) {
+  STORE_INDEX(&ring->rings->cq_head, ring->rings->cq_head + 1);
+}
@@ -0,0 +1,110 @@
+#ifndef __LIB_USER_URING_H
+#define __LIB_USER_URING_H
+
+#include <io_uring.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Helpers for asynchronous I/O rings, in the style of liburing.
+
+   Typical use: get an SQ entry with io_uring_get_sqe(), fill it with one
+   of the io_uring_prep_*() functions and io_uring_sqe_set_data(), repeat
+   for as many operations as wanted, then io_uring_submit() them with a
+   single system call.  Collect results with io_uring_wait_cqe() or
+   io_uring_peek_cqe(), marking each one consumed with
+   io_uring_cqe_seen().
+
+   A ring is used by one thread at a time. */
+
+struct io_uring {
+  int fd;                       /* Ring descriptor. */
+  struct io_uring_rings* rings; /* Header shared with the kernel. */
+  struct io_uring_sqe* sqes;    /* SQ entries. */
+  struct io_uring_cqe* cqes;    /* CQ entries. */
+  unsigned sq_mask;             /* SQ size minus 1. */
+  unsigned cq_mask;             /* CQ size minus 1. */
+  unsigned sq_queued;           /* Tail of entries handed out, not yet submitted. */
+  void* mem;                    /* Ring memory, if allocated by io_uring_queue_init(). */
+};
+
+/* Sets up RING with an SQ of ENTRIES entries (a power of 2) in memory
+   from malloc().  Returns 0 on success, -1 on failure. */
+int io_uring_queue_init(unsigned entries, struct io_uring* ring);
+
+/* Like io_uring_queue_init(), but in the SIZE bytes at MEM, which must be
+   8-byte aligned and at least IORING_MEM_SIZE(ENTRIES) bytes. */
+int io_uring_queue_init_mem(unsigned entries, struct io_uring* ring, void* mem, size_t size);
+
+/* Closes RING and frees its memory if io_uring_queue_init() allocated it.
+   Operations still in flight run to completion. */
+void io_uring_queue_exit(struct io_uring* ring);
+
+/* Returns a free SQ entry, zeroed, or NULL if the SQ is full. */
+struct io_uring_sqe* io_uring_get_sqe(struct io_uring* ring);
+
+/* Submits every entry obtained since the last submission.  Returns the
+   number the kernel consumed, or -1. */
+int io_uring_submit(struct io_uring* ring);
+
+/* Like io_uring_submit(), then waits until WAIT_NR completions are ready
+   or nothing is left in flight. */
+int io_uring_submit_and_wait(struct io_uring* ring, unsigned wait_nr);
+
+/* Stores the oldest completion in *CQE_PTR and returns 0, or returns -1
+   if none is ready. */
+int io_uring_peek_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr);
+
+/* Like io_uring_peek_cqe(), but first waits for a completion, submitting
+   any queued entries.  Returns -1 only if nothing is in flight. */
+int io_uring_wait_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr);
+
+/* Marks the completion returned by the last peek or wait consumed. */
+void io_uring_cqe_seen(struct io_uring* ring, struct io_uring_cqe* cqe);
+
+/* Fills SQE for an operation.  OFFSET IORING_OFF_CURRENT reads or writes
+   at the descriptor's position, as read() and write() do. */
+static inline void io_uring_prep_rw(struct io_uring_sqe* sqe, int op, int fd, const void* addr,
+                                    unsigned len, uint64_t offset) {
+  sqe->opcode = op;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)addr;
+  sqe->len = len;
+  sqe->off = offset;
+}
+
+static inline void io_uring_prep_nop(struct io_uring_sqe* sqe) {
+  io_uring_prep_rw(sqe, IORING_OP_NOP, -1, NULL, 0, 0);
+}
+
+static inline void io_uring_prep_read(struct io_uring_sqe* sqe, int fd, void* buf, unsigned len,
+                                      uint64_t offset) {
+  io_uring_prep_rw(sqe, IORING_OP_READ, fd, buf, len, offset);
+}
+
+static inline void io_uring_prep_write(struct io_uring_sqe* sqe, int fd, const void* buf,
+                                       unsigned len, uint64_t offset) {
+  io_uring_prep_rw(sqe, IORING_OP_WRITE, fd, buf, len, offset);
+}
+
+static inline void io_uring_prep_open(struct io_uring_sqe* sqe, const char* path) {
+  io_uring_prep_rw(sqe, IORING_OP_OPEN, -1, path, 0, 0);
+}
+
+static inline void io_uring_prep_close(struct io_uring_sqe* sqe, int fd) {
+  io_uring_prep_rw(sqe, IORING_OP_CLOSE, fd, NULL, 0, 0);
+}
+
+static inline void io_uring_prep_fsync(struct io_uring_sqe* sqe, int fd) {
+  io_uring_prep_rw(sqe, IORING_OP_FSYNC, fd, NULL, 0, 0);
+}
+
+static inline void io_uring_sqe_set_data64(struct io_uring_sqe* sqe, uint64_t data) {
+  sqe->user_data = data;
+}
+
+static inline uint64_t io_uring_cqe_get_data64(const struct io_uring_cqe* cqe) {
+  return cqe->user_data;
+}
+
+#endif /* lib/user/uring.h */
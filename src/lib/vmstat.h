@@ -0,0 +1,56 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Virtual memory event counters, shared between the kernel and user
+   programs through the SYS_VMSTAT system call.
+
+   The kernel keeps one global copy and one copy per process.  Fault
+   counters are charged to the faulting process; eviction counters are
+   charged to the process that owned the evicted page.  Clock-hand scan
+   counters are global only (a scan does not belong to any one process)
+   and read as zero in per-process snapshots. */
+
+/* Page fault classes, by how the fault was resolved. */
+enum vmstat_fault {
+  VMSTAT_FAULT_ZERO,    /* Zero-filled page (BSS, anonymous mmap). */
+  VMSTAT_FAULT_FILE,    /* Read from an executable or mapped file. */
+  VMSTAT_FAULT_SWAP,    /* Read back from swap. */
+  VMSTAT_FAULT_COW,     /* Private copy of a copy-on-write page. */
+  VMSTAT_FAULT_STACK,   /* Stack growth. */
+  VMSTAT_FAULT_SHARED,  /* Mapped a shared page already in memory. */
+  VMSTAT_FAULT_INVALID, /* Not resolved; the process is killed. */
+  VMSTAT_FAULT_CNT
+};
+
+/* Eviction outcomes, by what happened to the victim's contents. */
+enum vmstat_evict {
+  VMSTAT_EVICT_CLEAN, /* Dropped; reloadable from file or zero-fill. */
+  VMSTAT_EVICT_SWAP,  /* Written to a swap slot. */
+  VMSTAT_EVICT_FILE,  /* Written back to its mapped file. */
+  VMSTAT_EVICT_CNT
+};
+
+/* Fault latency histogram: bucket B counts faults that took
+   [2**B, 2**(B+1)) cycles, with the last bucket open-ended. */
+#define VMSTAT_HIST_BUCKETS 32
+
+/* Scope argument to SYS_VMSTAT. */
+#define VMSTAT_GLOBAL 0  /* System-wide counters. */
+#define VMSTAT_PROCESS 1 /* Counters for the calling process. */
+
+struct vmstat {
+  uint64_t faults[VMSTAT_FAULT_CNT];           /* Fault count by class. */
+  uint64_t fault_cycles[VMSTAT_FAULT_CNT];     /* Total cycles by class. */
+  uint64_t fault_max_cycles[VMSTAT_FAULT_CNT]; /* Slowest fault by class. */
+  uint32_t fault_hist[VMSTAT_FAULT_CNT][VMSTAT_HIST_BUCKETS];
+
+  uint64_t evictions[VMSTAT_EVICT_CNT]; /* Evictions by outcome. */
+
+  uint64_t clock_scans;     /* Calls into the clock eviction loop. */
+  uint64_t clock_steps;     /* Frames examined across all scans. */
+  uint64_t clock_max_steps; /* Longest single scan. */
+};
+
+#endif /* lib/vmstat.h */
@@ -5,10 +5,20 @@
 
 #include "net/buf/pbuf.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 #include <string.h>
 #include <debug.h>
 
+/* Object caches: bare pbufs for PBUF_REF, and full-frame buffers
+   (header space plus PBUF_MAX_SIZE payload) for PBUF_RAM.  A full
+   frame is too big for malloc()'s block sizes and would otherwise
+   take a page of its own; the cache fits two per page.  Larger
+   PBUF_RAM requests still go to malloc(). */
+#define PBUF_POOL_SIZE (sizeof(struct pbuf) + PBUF_HEADER_SPACE + PBUF_MAX_SIZE)
+static struct slab_cache pbuf_ref_cache;
+static struct slab_cache pbuf_pool_cache;
+
 /* Statistics */
 static uint32_t pbufs_allocated;
 static uint32_t pbufs_freed;
@@ -24,6 +34,8 @@ static const uint16_t layer_header_size[] = {
 void pbuf_init(void) {
   pbufs_allocated = 0;
   pbufs_freed = 0;
+  slab_cache_init(&pbuf_ref_cache, "pbuf", sizeof(struct pbuf), NULL, NULL);
+  slab_cache_init(&pbuf_pool_cache, "pbuf_pool", PBUF_POOL_SIZE, NULL, NULL);
 }
 
 struct pbuf* pbuf_alloc(int layer, uint16_t size, enum pbuf_type type) {
@@ -33,10 +45,15 @@ struct pbuf* pbuf_alloc(int layer, uint16_t size, enum pbuf_type type) {
   ASSERT(layer >= PBUF_TRANSPORT && layer <= PBUF_RAW);
   header_space = layer_header_size[layer];
 
+  uint8_t flags = 0;
   if (type == PBUF_RAM) {
     /* Allocate pbuf + header space + payload in one block */
     size_t total = sizeof(struct pbuf) + header_space + size;
-    p = malloc(total);
+    if (total <= PBUF_POOL_SIZE) {
+      p = slab_alloc(&pbuf_pool_cache);
+      flags = PBUF_FLAG_POOL;
+    } else
+      p = malloc(total);
     if (p == NULL)
       return NULL;
 
@@ -45,7 +62,7 @@ struct pbuf* pbuf_alloc(int layer, uint16_t size, enum pbuf_type type) {
     p->len = size;
   } else {
     /* PBUF_REF: just allocate the structure */
-    p = malloc(sizeof(struct pbuf));
+    p = slab_alloc(&pbuf_ref_cache);
     if (p == NULL)
       return NULL;
 
@@ -57,7 +74,7 @@ struct pbuf* pbuf_alloc(int layer, uint16_t size, enum pbuf_type type) {
   p->tot_len = size;
   p->type = type;
   p->ref = 1;
-  p->flags = 0;
+  p->flags = flags;
   p->_pad = 0;
 
   pbufs_allocated++;
@@ -83,10 +100,13 @@ struct pbuf* pbuf_free(struct pbuf* p) {
 
   /* Free based on type */
   if (p->type == PBUF_RAM) {
-    free(p);
+    if (p->flags & PBUF_FLAG_POOL)
+      slab_free(&pbuf_pool_cache, p);
+    else
+      free(p);
   } else {
     /* PBUF_REF: don't free external data */
-    free(p);
+    slab_free(&pbuf_ref_cache, p);
   }
 
   pbufs_freed++;
@@ -34,6 +34,9 @@ enum pbuf_type {
   PBUF_REF  /* Data is external reference */
 };
 
+/* Pbuf flags */
+#define PBUF_FLAG_POOL 0x01 /* Allocated from the full-frame slab cache */
+
 /**
  * @brief Packet buffer structure.
  */
@@ -44,7 +47,7 @@ struct pbuf {
   uint16_t len;      /* Length of this buffer's data */
   uint8_t type;      /* PBUF_RAM or PBUF_REF */
   uint8_t ref;       /* Reference count */
-  uint8_t flags;     /* Reserved for future use */
+  uint8_t flags;     /* PBUF_FLAG_* bits */
   uint8_t _pad;      /* Padding for alignment */
 
   /* For PBUF_RAM: actual data follows this structure */
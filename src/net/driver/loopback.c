@@ -6,12 +6,16 @@
 #include "net/driver/loopback.h"
 #include "net/driver/netdev.h"
 #include "net/util/byteorder.h"
+#include <random.h>
 #include <stdio.h>
 
 /* Loopback IP: 127.0.0.1 */
 #define LOOPBACK_IP htonl(0x7F000001)
 #define LOOPBACK_MASK htonl(0xFF000000)
 
+/* Packets dropped per thousand sent, for testing loss recovery. */
+static unsigned loss_per_mille;
+
 static int loopback_init_dev(struct netdev* dev);
 static int loopback_transmit(struct netdev* dev, struct pbuf* p);
 
@@ -37,12 +41,19 @@ static int loopback_transmit(struct netdev* dev, struct pbuf* p) {
    * The packet is already in the format it would be received.
    */
 
+  if (loss_per_mille > 0 && random_ulong() % 1000 < loss_per_mille) {
+    pbuf_free(p);
+    return -1;
+  }
+
   /* Don't free the pbuf - pass ownership to receive queue */
   netdev_input(dev, p);
 
   return 0;
 }
 
+void loopback_set_loss(unsigned per_mille) { loss_per_mille = per_mille; }
+
 void loopback_init(void) {
   struct netdev* dev;
 
@@ -16,4 +16,12 @@
  */
 void loopback_init(void);
 
+/**
+ * @brief Set the loopback device's simulated packet loss.
+ * @param per_mille Packets to drop, per thousand sent (0 for none).
+ *
+ * Dropped packets count as transmit errors.
+ */
+void loopback_set_loss(unsigned per_mille);
+
 #endif /* NET_DRIVER_LOOPBACK_H */
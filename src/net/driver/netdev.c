@@ -5,7 +5,9 @@
 
 #include "net/driver/netdev.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/interrupt.h"
+#include "threads/waitq.h"
 #include <string.h>
 #include <stdio.h>
 #include <debug.h>
@@ -15,9 +17,16 @@ static struct list netdev_list;
 static struct lock netdev_list_lock;
 static bool netdev_initialized = false;
 
+/* Receive queue entries of all devices. */
+static struct slab_cache rx_entry_cache;
+
+/* Woken whenever any device queues a packet, or a null pointer. */
+static struct waiter* rx_waiter;
+
 void netdev_init(void) {
   list_init(&netdev_list);
   lock_init(&netdev_list_lock);
+  slab_cache_init(&rx_entry_cache, "netdev_rx_entry", sizeof(struct netdev_rx_entry), NULL, NULL);
   netdev_initialized = true;
 }
 
@@ -145,6 +154,7 @@ struct netdev* netdev_get_loopback(void) {
 }
 
 int netdev_transmit(struct netdev* dev, struct pbuf* p) {
+  uint16_t len;
   int err;
 
   ASSERT(dev != NULL);
@@ -160,10 +170,12 @@ int netdev_transmit(struct netdev* dev, struct pbuf* p) {
     return -1; /* No transmit function */
   }
 
+  /* The driver owns P from here, and may already have freed it. */
+  len = p->tot_len;
   err = dev->ops->transmit(dev, p);
   if (err == 0) {
     dev->tx_packets++;
-    dev->tx_bytes += p->tot_len;
+    dev->tx_bytes += len;
   } else {
     dev->tx_errors++;
   }
@@ -177,7 +189,7 @@ void netdev_input(struct netdev* dev, struct pbuf* p) {
   ASSERT(dev != NULL);
   ASSERT(p != NULL);
 
-  entry = malloc(sizeof(struct netdev_rx_entry));
+  entry = slab_alloc(&rx_entry_cache);
   if (entry == NULL) {
     dev->rx_dropped++;
     pbuf_free(p);
@@ -195,8 +207,12 @@ void netdev_input(struct netdev* dev, struct pbuf* p) {
 
   /* Signal that a packet is available */
   sema_up(&dev->rx_sem);
+  if (rx_waiter != NULL)
+    waiter_wake(rx_waiter);
 }
 
+void netdev_set_rx_waiter(struct waiter* w) { rx_waiter = w; }
+
 struct pbuf* netdev_receive(struct netdev* dev) {
   struct netdev_rx_entry* entry;
   struct pbuf* p;
@@ -213,7 +229,7 @@ struct pbuf* netdev_receive(struct netdev* dev) {
   lock_release(&dev->rx_lock);
 
   p = entry->p;
-  free(entry);
+  slab_free(&rx_entry_cache, entry);
   return p;
 }
 
@@ -19,6 +19,8 @@
 #include "threads/synch.h"
 #include "net/buf/pbuf.h"
 
+struct waiter;
+
 /* Maximum Transmission Unit (standard Ethernet) */
 #define NETDEV_MTU 1500
 
@@ -174,6 +176,14 @@ void netdev_input(struct netdev* dev, struct pbuf* p);
  */
 struct pbuf* netdev_receive(struct netdev* dev);
 
+/**
+ * @brief Register a waiter to wake on every received packet.
+ * @param w Waiter, or NULL for none.
+ *
+ * Lets the network thread sleep until any device has input.
+ */
+void netdev_set_rx_waiter(struct waiter* w);
+
 /**
  * @brief Configure device IP settings.
  * @param dev Device to configure.
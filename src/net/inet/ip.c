@@ -112,8 +112,7 @@ void ip_input(struct netdev* dev, struct pbuf* p) {
       break;
 
     case IP_PROTO_TCP:
-      /* TCP not yet implemented - drop or send ICMP */
-      pbuf_free(p);
+      tcp_input(dev, p, src_addr, dst_addr);
       break;
 
     case IP_PROTO_UDP:
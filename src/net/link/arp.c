@@ -12,6 +12,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <debug.h>
+#include <rhash.h>
 
 /* Pending packet entry */
 struct arp_pending_pkt {
@@ -31,22 +32,28 @@ struct arp_entry {
   struct list pending;  /* Packets waiting for resolution */
 };
 
-/* ARP cache */
+/* ARP cache, indexed by IP address.  The index holds exactly the
+   entries that are not ARP_STATE_EMPTY, so lookups on the transmit
+   path do not scan the whole cache. */
 static struct arp_entry arp_cache[ARP_CACHE_SIZE];
+static struct rhash arp_index;
 static struct lock arp_lock;
 static bool arp_initialized = false;
 
 /* Forward declarations */
 static void arp_send_request(struct netdev* dev, uint32_t ip_addr);
 static void arp_send_reply(struct netdev* dev, uint32_t target_ip, const uint8_t* target_mac);
+static bool arp_entry_eq(const void* entry, const void* key, void* aux);
 static struct arp_entry* arp_find_entry(uint32_t ip_addr);
-static struct arp_entry* arp_alloc_entry(void);
+static struct arp_entry* arp_alloc_entry(uint32_t ip_addr);
+static void arp_free_entry(struct arp_entry* entry);
 static void arp_send_pending(struct arp_entry* entry, struct netdev* dev);
 
 void arp_init(void) {
   int i;
 
   lock_init(&arp_lock);
+  rhash_init(&arp_index, arp_entry_eq, NULL);
 
   for (i = 0; i < ARP_CACHE_SIZE; i++) {
     arp_cache[i].state = ARP_STATE_EMPTY;
@@ -94,9 +101,8 @@ void arp_input(struct netdev* dev, struct pbuf* p) {
     arp_send_pending(entry, dev);
   } else if (arp->target_ip == dev->ip_addr) {
     /* New entry for someone asking about us */
-    entry = arp_alloc_entry();
+    entry = arp_alloc_entry(arp->sender_ip);
     if (entry != NULL) {
-      entry->ip_addr = arp->sender_ip;
       memcpy(entry->mac_addr, arp->sender_mac, 6);
       entry->state = ARP_STATE_VALID;
       entry->expire_time = timer_ticks() + ARP_CACHE_TIMEOUT;
@@ -143,9 +149,8 @@ bool arp_resolve(struct netdev* dev, uint32_t ip_addr, uint8_t* mac_out) {
     found = true;
   } else if (entry == NULL || entry->state == ARP_STATE_EMPTY) {
     /* Need to send ARP request */
-    entry = arp_alloc_entry();
+    entry = arp_alloc_entry(ip_addr);
     if (entry != NULL) {
-      entry->ip_addr = ip_addr;
       entry->state = ARP_STATE_PENDING;
       entry->retry_count = 0;
       entry->retry_time = timer_ticks() + 100; /* Retry in 1 second */
@@ -218,13 +223,11 @@ void arp_cache_update(uint32_t ip_addr, const uint8_t* mac) {
 
   entry = arp_find_entry(ip_addr);
   if (entry == NULL) {
-    entry = arp_alloc_entry();
+    entry = arp_alloc_entry(ip_addr);
     if (entry == NULL) {
       lock_release(&arp_lock);
       return;
     }
-    entry->ip_addr = ip_addr;
-    list_init(&entry->pending);
   }
 
   memcpy(entry->mac_addr, mac, 6);
@@ -282,16 +285,8 @@ void arp_timer(void) {
       continue;
 
     /* Check for expiration */
-    if (now >= e->expire_time) {
-      /* Free pending packets */
-      while (!list_empty(&e->pending)) {
-        struct arp_pending_pkt* pkt;
-        pkt = list_entry(list_pop_front(&e->pending), struct arp_pending_pkt, elem);
-        pbuf_free(pkt->p);
-        free(pkt);
-      }
-      e->state = ARP_STATE_EMPTY;
-    }
+    if (now >= e->expire_time)
+      arp_free_entry(e);
   }
 
   lock_release(&arp_lock);
@@ -347,51 +342,50 @@ static void arp_send_reply(struct netdev* dev, uint32_t target_ip, const uint8_t
   ethernet_output(dev, p, target_mac, ETH_TYPE_ARP);
 }
 
-static struct arp_entry* arp_find_entry(uint32_t ip_addr) {
-  int i;
+static bool arp_entry_eq(const void* entry, const void* key, void* aux UNUSED) {
+  return ((const struct arp_entry*)entry)->ip_addr == *(const uint32_t*)key;
+}
 
-  for (i = 0; i < ARP_CACHE_SIZE; i++) {
-    if (arp_cache[i].state != ARP_STATE_EMPTY && arp_cache[i].ip_addr == ip_addr) {
-      return &arp_cache[i];
-    }
-  }
-  return NULL;
+static struct arp_entry* arp_find_entry(uint32_t ip_addr) {
+  return rhash_find(&arp_index, rhash_int(ip_addr), &ip_addr);
 }
 
-static struct arp_entry* arp_alloc_entry(void) {
+/* Takes an empty entry, or else the oldest one, for IP_ADDR and adds
+   it to the index.  The caller must set its state. */
+static struct arp_entry* arp_alloc_entry(uint32_t ip_addr) {
+  struct arp_entry* e = NULL;
   int i;
-  int64_t oldest_time = INT64_MAX;
-  int oldest_idx = -1;
 
   /* Find empty or oldest entry */
   for (i = 0; i < ARP_CACHE_SIZE; i++) {
     if (arp_cache[i].state == ARP_STATE_EMPTY) {
-      list_init(&arp_cache[i].pending);
-      return &arp_cache[i];
-    }
-    if (arp_cache[i].expire_time < oldest_time) {
-      oldest_time = arp_cache[i].expire_time;
-      oldest_idx = i;
+      e = &arp_cache[i];
+      break;
     }
+    if (e == NULL || arp_cache[i].expire_time < e->expire_time)
+      e = &arp_cache[i];
   }
 
   /* Reuse oldest entry */
-  if (oldest_idx >= 0) {
-    struct arp_entry* e = &arp_cache[oldest_idx];
-
-    /* Free pending packets */
-    while (!list_empty(&e->pending)) {
-      struct arp_pending_pkt* pkt;
-      pkt = list_entry(list_pop_front(&e->pending), struct arp_pending_pkt, elem);
-      pbuf_free(pkt->p);
-      free(pkt);
-    }
+  if (e->state != ARP_STATE_EMPTY)
+    arp_free_entry(e);
 
-    list_init(&e->pending);
-    return e;
-  }
+  e->ip_addr = ip_addr;
+  if (!rhash_insert(&arp_index, rhash_int(ip_addr), &ip_addr, e))
+    return NULL;
+  return e;
+}
 
-  return NULL;
+/* Drops ENTRY's pending packets and removes it from the cache. */
+static void arp_free_entry(struct arp_entry* entry) {
+  while (!list_empty(&entry->pending)) {
+    struct arp_pending_pkt* pkt;
+    pkt = list_entry(list_pop_front(&entry->pending), struct arp_pending_pkt, elem);
+    pbuf_free(pkt->p);
+    free(pkt);
+  }
+  rhash_delete(&arp_index, rhash_int(entry->ip_addr), &entry->ip_addr);
+  entry->state = ARP_STATE_EMPTY;
 }
 
 static void arp_send_pending(struct arp_entry* entry, struct netdev* dev) {
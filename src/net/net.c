@@ -6,6 +6,7 @@
 #include "net/net.h"
 #include "threads/thread.h"
 #include "threads/synch.h"
+#include "threads/waitq.h"
 #include "devices/timer.h"
 #include <stdio.h>
 #include <string.h>
@@ -35,7 +36,7 @@ void net_init(void) {
   ip_init();
   icmp_init();
 
-  /* Initialize transport layer (scaffolds) */
+  /* Initialize transport layer */
   udp_init();
   tcp_init();
 
@@ -153,14 +154,21 @@ void net_ping_test(const char* dest_ip) {
 
 /*
  * Network input thread.
- * Polls all devices for received packets and processes them.
+ * Polls all devices for received packets and processes them, and
+ * runs the TCP timers once per timer tick.
  */
 static void net_input_thread(void* aux UNUSED) {
   struct netdev *lo, *eth;
+  struct waiter rx_waiter;
+  int64_t last_tick;
 
   lo = netdev_get_loopback();
   eth = netdev_find_by_name("eth0");
 
+  waiter_init(&rx_waiter);
+  netdev_set_rx_waiter(&rx_waiter);
+  last_tick = timer_ticks();
+
   while (net_running) {
     struct pbuf* p = NULL;
     bool processed = false;
@@ -189,9 +197,16 @@ static void net_input_thread(void* aux UNUSED) {
       }
     }
 
-    /* If no packets processed, sleep briefly */
+    if (timer_ticks() != last_tick) {
+      last_tick = timer_ticks();
+      tcp_timer();
+    }
+
+    /* If no packets processed, sleep until one arrives or the next
+       tick, whichever is first.  Devices that must be polled are
+       polled once per tick. */
     if (!processed) {
-      timer_msleep(10);
+      waiter_wait(&rx_waiter, 1);
     }
   }
 }
@@ -2,45 +2,95 @@
  * @file net/transport/tcp.c
  * @brief TCP protocol implementation.
  *
- * SCAFFOLD - IMPLEMENT ME!
+ * tcp_input() validates a segment, finds its PCB and processes it
+ * as RFC 793 section 3.9 ("SEGMENT ARRIVES") lays out, with one
+ * handler each for LISTEN, SYN_SENT and the synchronized states.
+ * tcp_output() sends whatever the send buffer, the peer's window
+ * and the congestion window allow, and is called whenever one of
+ * them changes.  tcp_timer() runs the retransmission, delayed ACK
+ * and TIME_WAIT timers.
  *
- * This is the most complex part of the network stack.
- * Take your time and implement in phases.
- *
- * PHASE 6A - STATE MACHINE:
- * - tcp_input(): Route to appropriate state handler
- * - Handle SYN (passive open), SYN+ACK (active open)
- * - Handle FIN (connection close)
- * - Handle RST (connection abort)
- *
- * PHASE 6B - DATA TRANSFER:
- * - Send buffer: queue data, track what's sent/acked
- * - Receive buffer: handle out-of-order, deliver in order
- * - Window management
- *
- * PHASE 6C - TIMERS:
- * - RTT measurement and RTO calculation
- * - Retransmission on timeout
- * - TIME_WAIT timer
- *
- * PHASE 6D - CONGESTION CONTROL:
- * - Slow start (exponential increase)
- * - Congestion avoidance (linear increase)
- * - Fast retransmit (3 dup ACKs)
- * - Fast recovery
+ * Sequence numbers index the send and receive rings directly: the
+ * byte with sequence number SEQ lives at offset SEQ mod the ring's
+ * size.  That holds for every byte a ring can contain at once, so
+ * neither ring needs a head pointer.
  */
 
 #include "net/transport/tcp.h"
 #include "net/inet/ip.h"
+#include "net/inet/route.h"
 #include "net/util/checksum.h"
 #include "net/util/byteorder.h"
+#include "devices/timer.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include <random.h>
 #include <string.h>
 #include <stdio.h>
 #include <debug.h>
 
-/* Global list of TCP PCBs */
+/* Sequence number comparisons, modulo 2**32. */
+#define SEQ_LT(a, b) ((int32_t)((a) - (b)) < 0)
+#define SEQ_LEQ(a, b) ((int32_t)((a) - (b)) <= 0)
+#define SEQ_GT(a, b) ((int32_t)((a) - (b)) > 0)
+#define SEQ_GEQ(a, b) ((int32_t)((a) - (b)) >= 0)
+
+/* PCB flags. */
+#define TF_ACK_NOW 0x01     /* Send an ACK without delay. */
+#define TF_FIN_QUEUED 0x02  /* Application closed; FIN follows snd_end. */
+#define TF_FIN_RCVD 0x04    /* Peer's FIN received; rcv_nxt counts it. */
+#define TF_FIN_EARLY 0x08   /* Peer's FIN at fin_seq waits for a gap to fill. */
+#define TF_WSCALE 0x10      /* Both sides sent the window scale option. */
+#define TF_RECOVERY 0x20    /* In fast recovery. */
+#define TF_TIMING 0x40      /* Timing the segment at rtt_seq. */
+#define TF_QUEUED 0x80      /* On parent's accept queue. */
+#define TF_USER_CLOSED 0x100 /* Application will read no more. */
+
+/* Timers, in timer ticks. */
+#define TCP_RTO_INIT TIMER_FREQ       /* 1 s [RFC 6298]. */
+#define TCP_RTO_MIN (TIMER_FREQ / 5)  /* 200 ms, as most stacks use. */
+#define TCP_RTO_MAX (60 * TIMER_FREQ) /* 60 s. */
+#define TCP_DELACK (TIMER_FREQ / 25 > 0 ? TIMER_FREQ / 25 : 1) /* 40 ms. */
+#define TCP_MSL (30 * TIMER_FREQ)     /* Maximum segment lifetime. */
+
+#define TCP_MAX_RTX 12      /* Data timeouts before giving up. */
+#define TCP_SYN_MAX_RTX 6   /* SYN timeouts before giving up. */
+#define TCP_DUPACK_THRESH 3 /* Duplicate ACKs that signal a loss. */
+#define TCP_DEFAULT_MSS 536 /* MSS when the peer sends none [RFC 879]. */
+#define TCP_MAX_OOSEQ 16    /* Out-of-order ranges kept per connection. */
+#define TCP_CC_MAX 4        /* Congestion control algorithms. */
+
+/* cwnd never usefully exceeds what the send buffer can have in
+   flight, and a larger one only delays the response to a loss. */
+#define TCP_CWND_MAX (2 * TCP_SND_BUF_SIZE)
+
+/* Options. */
+#define TCP_OPT_END 0
+#define TCP_OPT_NOP 1
+#define TCP_OPT_MSS 2
+#define TCP_OPT_WSCALE 3
+#define TCP_MAX_WSCALE 14
+#define TCP_SYN_OPT_LEN 8 /* MSS, then NOP and window scale. */
+
+/* A range of out-of-order data in the receive buffer. */
+struct tcp_ooseg {
+  uint32_t start, end;   /* Sequence numbers, END exclusive. */
+  struct list_elem elem; /* In pcb->ooseq. */
+};
+
+/* A received segment, with the header fields in host byte order. */
+struct tcp_seg {
+  uint32_t seq;
+  uint32_t ack;
+  uint8_t flags;
+  uint16_t wnd;        /* Unscaled. */
+  const uint8_t* data;
+  uint32_t len;        /* Bytes of data. */
+  uint16_t mss;        /* MSS option, or 0. */
+  int wscale;          /* Window scale option, or -1. */
+};
+
+/* Global list of TCP PCBs.  tcp_lock protects it and every PCB. */
 static struct list tcp_pcb_list;
 static struct lock tcp_lock;
 static bool tcp_initialized = false;
@@ -48,250 +98,1420 @@ static bool tcp_initialized = false;
 /* Next ephemeral port */
 static uint16_t tcp_next_port = 49152;
 
+/* Registered congestion control algorithms.  The first is the
+   default. */
+static const struct tcp_cc_ops* cc_algos[TCP_CC_MAX] = {&tcp_newreno};
+static int cc_cnt = 1;
+
 /* TCP state names for debugging */
 static const char* state_names[] = {"CLOSED",      "LISTEN",     "SYN_SENT",   "SYN_RCVD",
                                     "ESTABLISHED", "FIN_WAIT_1", "FIN_WAIT_2", "CLOSE_WAIT",
                                     "CLOSING",     "LAST_ACK",   "TIME_WAIT"};
 
+static void tcp_output(struct tcp_pcb* pcb);
+static void pcb_closed(struct tcp_pcb* pcb, int error);
+static void abort_locked(struct tcp_pcb* pcb);
+
 const char* tcp_state_name(enum tcp_state state) {
   if (state <= TCP_TIME_WAIT)
     return state_names[state];
   return "UNKNOWN";
 }
 
+static uint32_t min32(uint32_t a, uint32_t b) { return a < b ? a : b; }
+static uint32_t max32(uint32_t a, uint32_t b) { return a > b ? a : b; }
+
 void tcp_init(void) {
   list_init(&tcp_pcb_list);
   lock_init(&tcp_lock);
   tcp_initialized = true;
-  printf("tcp: initialized (SCAFFOLD - implement me!)\n");
-}
-
-void tcp_input(struct netdev* dev UNUSED, struct pbuf* p, uint32_t src_ip UNUSED,
-               uint32_t dst_ip UNUSED) {
-  /*
-   * TODO: Implement TCP input processing
-   *
-   * This is the main entry point for received TCP segments.
-   * It should:
-   *
-   * 1. Validate segment:
-   *    - Check length >= TCP_HEADER_LEN
-   *    - Verify checksum (with pseudo-header)
-   *    - Extract header fields
-   *
-   * 2. Find matching PCB:
-   *    - Look up by (local_ip, local_port, remote_ip, remote_port)
-   *    - Also check LISTEN sockets (just local_port)
-   *
-   * 3. Process based on current state:
-   *
-   *    CLOSED:
-   *      - Send RST (unless incoming is RST)
-   *
-   *    LISTEN:
-   *      - If SYN: create new PCB, send SYN+ACK, go to SYN_RCVD
-   *
-   *    SYN_SENT:
-   *      - If SYN+ACK: send ACK, go to ESTABLISHED
-   *      - If SYN: send SYN+ACK, go to SYN_RCVD (simultaneous open)
-   *
-   *    SYN_RCVD:
-   *      - If ACK: go to ESTABLISHED, add to parent's accept queue
-   *
-   *    ESTABLISHED:
-   *      - If FIN: send ACK, go to CLOSE_WAIT
-   *      - If data: process, send ACK, add to receive buffer
-   *      - If ACK: update send window, free acked data
-   *
-   *    FIN_WAIT_1:
-   *      - If FIN+ACK: send ACK, go to TIME_WAIT
-   *      - If FIN: send ACK, go to CLOSING
-   *      - If ACK: go to FIN_WAIT_2
-   *
-   *    FIN_WAIT_2:
-   *      - If FIN: send ACK, go to TIME_WAIT
-   *
-   *    CLOSE_WAIT:
-   *      - Wait for close() from application
-   *
-   *    CLOSING:
-   *      - If ACK: go to TIME_WAIT
-   *
-   *    LAST_ACK:
-   *      - If ACK: go to CLOSED
-   *
-   *    TIME_WAIT:
-   *      - If FIN: resend ACK
-   *      - After 2*MSL: go to CLOSED
-   */
-
-  printf("tcp: received segment (not implemented)\n");
-  pbuf_free(p);
+  printf("tcp: initialized\n");
 }
 
-struct tcp_pcb* tcp_new(void) {
-  /*
-   * TODO: Allocate and initialize a new TCP PCB
-   *
-   * Initialize all fields to appropriate defaults:
-   * - State: CLOSED
-   * - Addresses/ports: 0
-   * - Sequence numbers: 0 (will be set on connect/accept)
-   * - Windows: reasonable defaults (e.g., 65535)
-   * - Congestion: cwnd = 1 MSS, ssthresh = 65535
-   * - Synchronization primitives
-   */
-
-  printf("tcp: new PCB (not implemented)\n");
-  return NULL;
+/* ---------------------------------------------------------------- */
+/* Buffers                                                          */
+/* ---------------------------------------------------------------- */
+
+/* Copies LEN bytes from SRC into ring BUF of SIZE bytes, starting
+   at the position of sequence number SEQ. */
+static void ring_write(uint8_t* buf, size_t size, uint32_t seq, const uint8_t* src, size_t len) {
+  size_t ofs = seq & (size - 1);
+  size_t first = len < size - ofs ? len : size - ofs;
+
+  memcpy(buf + ofs, src, first);
+  memcpy(buf, src + first, len - first);
 }
 
-void tcp_free(struct tcp_pcb* pcb) {
+/* Copies LEN bytes from ring BUF of SIZE bytes, starting at the
+   position of sequence number SEQ, to DST. */
+static void ring_read(const uint8_t* buf, size_t size, uint32_t seq, uint8_t* dst, size_t len) {
+  size_t ofs = seq & (size - 1);
+  size_t first = len < size - ofs ? len : size - ofs;
+
+  memcpy(dst, buf + ofs, first);
+  memcpy(dst + first, buf, len - first);
+}
+
+/* Returns the free space in PCB's receive buffer past rcv_nxt, which
+   is also the receive window. */
+static uint32_t rcv_space(const struct tcp_pcb* pcb) {
+  return pcb->rcv_user + TCP_RCV_BUF_SIZE - pcb->rcv_nxt;
+}
+
+/* Returns the bytes in PCB's receive buffer that the application
+   may read. */
+static uint32_t rcv_avail(const struct tcp_pcb* pcb) {
+  uint32_t end = pcb->rcv_nxt - ((pcb->flags & TF_FIN_RCVD) ? 1 : 0);
+  return end - pcb->rcv_user;
+}
+
+/* Returns the bytes queued in PCB's send buffer but not yet sent. */
+static uint32_t snd_unsent(const struct tcp_pcb* pcb) {
+  return SEQ_LT(pcb->snd_nxt, pcb->snd_end) ? pcb->snd_end - pcb->snd_nxt : 0;
+}
+
+/* Frees PCB's buffers and out-of-order ranges. */
+static void free_buffers(struct tcp_pcb* pcb) {
+  while (!list_empty(&pcb->ooseq))
+    free(list_entry(list_pop_front(&pcb->ooseq), struct tcp_ooseg, elem));
+  free(pcb->send_buf);
+  free(pcb->recv_buf);
+  pcb->send_buf = NULL;
+  pcb->recv_buf = NULL;
+}
+
+/* Records that sequence numbers START up to END are in PCB's receive
+   buffer, beyond a gap at rcv_nxt.  The ranges stay sorted and are
+   merged where they touch.  Past TCP_MAX_OOSEQ ranges the new one is
+   forgotten; the peer sends it again. */
+static void ooseq_insert(struct tcp_pcb* pcb, uint32_t start, uint32_t end) {
+  struct tcp_ooseg* seg;
+  struct list_elem* e;
+
+  for (e = list_begin(&pcb->ooseq); e != list_end(&pcb->ooseq); e = list_next(e)) {
+    seg = list_entry(e, struct tcp_ooseg, elem);
+    if (SEQ_LT(end, seg->start))
+      break;
+    if (SEQ_LEQ(start, seg->end)) {
+      if (SEQ_LT(start, seg->start))
+        seg->start = start;
+      if (SEQ_GT(end, seg->end))
+        seg->end = end;
+
+      /* Absorb the ranges that SEG now reaches. */
+      while (list_next(e) != list_end(&pcb->ooseq)) {
+        struct tcp_ooseg* next = list_entry(list_next(e), struct tcp_ooseg, elem);
+        if (SEQ_LT(seg->end, next->start))
+          break;
+        if (SEQ_GT(next->end, seg->end))
+          seg->end = next->end;
+        list_remove(&next->elem);
+        free(next);
+      }
+      return;
+    }
+  }
+
+  if (list_size(&pcb->ooseq) >= TCP_MAX_OOSEQ)
+    return;
+  seg = malloc(sizeof *seg);
+  if (seg == NULL)
+    return;
+  seg->start = start;
+  seg->end = end;
+  list_insert(e, &seg->elem);
+}
+
+/* Advances rcv_nxt over the out-of-order ranges that now follow it
+   without a gap. */
+static void ooseq_advance(struct tcp_pcb* pcb) {
+  while (!list_empty(&pcb->ooseq)) {
+    struct tcp_ooseg* seg = list_entry(list_front(&pcb->ooseq), struct tcp_ooseg, elem);
+    if (SEQ_GT(seg->start, pcb->rcv_nxt))
+      break;
+    if (SEQ_GT(seg->end, pcb->rcv_nxt))
+      pcb->rcv_nxt = seg->end;
+    list_remove(&seg->elem);
+    free(seg);
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/* PCB management                                                   */
+/* ---------------------------------------------------------------- */
+
+/* Allocates a closed PCB with one reference, for the application,
+   and adds it to the PCB list. */
+static struct tcp_pcb* pcb_alloc(void) {
+  struct tcp_pcb* pcb = calloc(1, sizeof *pcb);
+  if (pcb == NULL)
+    return NULL;
+
+  pcb->state = TCP_CLOSED;
+  pcb->cc = cc_algos[0];
+  list_init(&pcb->ooseq);
+  list_init(&pcb->accept_queue);
+  cond_init(&pcb->connect_cond);
+  cond_init(&pcb->accept_cond);
+  cond_init(&pcb->send_cond);
+  cond_init(&pcb->recv_cond);
+  pcb->refcount = 1;
+  list_push_back(&tcp_pcb_list, &pcb->elem);
+  return pcb;
+}
+
+/* Drops a reference to PCB, freeing it with the last. */
+static void pcb_unref(struct tcp_pcb* pcb) {
+  ASSERT(pcb->refcount > 0);
+  if (--pcb->refcount > 0)
+    return;
+
+  list_remove(&pcb->elem);
+  free_buffers(pcb);
+  free(pcb);
+}
+
+/* Returns the largest segment PCB's route carries. */
+static uint16_t local_mss(const struct tcp_pcb* pcb) {
+  struct route_result route;
+
+  if (route_lookup(pcb->remote_ip, &route) != 0 || route.dev->mtu <= IP_HEADER_LEN + TCP_HEADER_LEN)
+    return TCP_DEFAULT_MSS;
+  return route.dev->mtu - IP_HEADER_LEN - TCP_HEADER_LEN;
+}
+
+/* Prepares PCB, whose addresses are set, to open a connection:
+   allocates its buffers and picks its initial sequence number.
+   Takes the reference that an open connection holds.  Returns
+   false if memory is short. */
+static bool pcb_open(struct tcp_pcb* pcb) {
+  pcb->send_buf = malloc(TCP_SND_BUF_SIZE);
+  pcb->recv_buf = malloc(TCP_RCV_BUF_SIZE);
+  if (pcb->send_buf == NULL || pcb->recv_buf == NULL) {
+    free_buffers(pcb);
+    return false;
+  }
+
+  pcb->iss = random_ulong();
+  pcb->snd_una = pcb->snd_nxt = pcb->snd_max = pcb->iss;
+  pcb->snd_end = pcb->iss + 1;
+  pcb->recover = pcb->iss;
+  pcb->mss = min32(TCP_DEFAULT_MSS, local_mss(pcb));
+  pcb->rto = TCP_RTO_INIT;
+  pcb->srtt = pcb->rttvar = 0;
+  pcb->rcv_wscale = 0;
+  while ((TCP_RCV_BUF_SIZE >> pcb->rcv_wscale) > 0xffff)
+    pcb->rcv_wscale++;
+  pcb->refcount++;
+  return true;
+}
+
+/* Finds the PCB for a segment from REMOTE_IP:REMOTE_PORT to
+   LOCAL_IP:LOCAL_PORT: the connection if there is one, else a
+   listener on the port. */
+static struct tcp_pcb* pcb_lookup(uint32_t local_ip, uint16_t local_port, uint32_t remote_ip,
+                                  uint16_t remote_port) {
+  struct tcp_pcb* listener = NULL;
+  struct list_elem* e;
+
+  for (e = list_begin(&tcp_pcb_list); e != list_end(&tcp_pcb_list); e = list_next(e)) {
+    struct tcp_pcb* pcb = list_entry(e, struct tcp_pcb, elem);
+    if (pcb->local_port != local_port || pcb->state == TCP_CLOSED)
+      continue;
+    if (pcb->state == TCP_LISTEN) {
+      if (pcb->local_ip == 0 || pcb->local_ip == local_ip)
+        listener = pcb;
+    } else if (pcb->remote_port == remote_port && pcb->remote_ip == remote_ip &&
+               pcb->local_ip == local_ip)
+      return pcb;
+  }
+  return listener;
+}
+
+/* Returns true if a PCB other than one in TIME_WAIT is bound to
+   PORT.  With REMOTE_IP nonzero, only a connection to
+   REMOTE_IP:REMOTE_PORT counts, in any state. */
+static bool port_in_use(uint16_t port, uint32_t remote_ip, uint16_t remote_port) {
+  struct list_elem* e;
+
+  for (e = list_begin(&tcp_pcb_list); e != list_end(&tcp_pcb_list); e = list_next(e)) {
+    struct tcp_pcb* pcb = list_entry(e, struct tcp_pcb, elem);
+    if (pcb->local_port != port)
+      continue;
+    if (remote_ip == 0 ? pcb->state != TCP_TIME_WAIT
+                       : pcb->remote_ip == remote_ip && pcb->remote_port == remote_port)
+      return true;
+  }
+  return false;
+}
+
+/* Returns an unused ephemeral port, or 0 if all are taken. */
+static uint16_t ephemeral_port(void) {
+  int i;
+
+  for (i = 0; i < 65536 - 49152; i++) {
+    uint16_t port = tcp_next_port++;
+    if (tcp_next_port == 0) /* Wrap around */
+      tcp_next_port = 49152;
+    if (!port_in_use(port, 0, 0))
+      return port;
+  }
+  return 0;
+}
+
+/* Wakes every thread waiting on PCB. */
+static void wake_all(struct tcp_pcb* pcb) {
+  cond_broadcast(&pcb->connect_cond, &tcp_lock);
+  cond_broadcast(&pcb->accept_cond, &tcp_lock);
+  cond_broadcast(&pcb->send_cond, &tcp_lock);
+  cond_broadcast(&pcb->recv_cond, &tcp_lock);
+}
+
+/* Moves PCB to CLOSED, recording ERROR if nonzero, and drops the
+   reference of the open connection.  PCB may be freed. */
+static void pcb_closed(struct tcp_pcb* pcb, int error) {
+  bool was_open = pcb->state != TCP_CLOSED && pcb->state != TCP_LISTEN;
+  bool orphan = false;
+
+  if (error != 0 && pcb->error == 0)
+    pcb->error = error;
+  pcb->state = TCP_CLOSED;
+  pcb->rtx_timer = pcb->ack_timer = pcb->tw_timer = 0;
+  wake_all(pcb);
+
+  /* Nobody will accept a connection that died before it was
+     established, so drop the listener's reference too. */
+  if (pcb->parent != NULL && !(pcb->flags & TF_QUEUED)) {
+    pcb->parent->pending--;
+    pcb->parent = NULL;
+    orphan = true;
+  }
+
+  if (was_open)
+    pcb_unref(pcb);
+  if (orphan)
+    pcb_unref(pcb);
+}
+
+/* Enters TIME_WAIT.  The buffers are no longer needed. */
+static void enter_time_wait(struct tcp_pcb* pcb) {
+  pcb->state = TCP_TIME_WAIT;
+  pcb->rtx_timer = 0;
+  pcb->tw_timer = timer_ticks() + 2 * TCP_MSL;
+  pcb->flags |= TF_ACK_NOW;
+  free_buffers(pcb);
+}
+
+/* ---------------------------------------------------------------- */
+/* Output                                                           */
+/* ---------------------------------------------------------------- */
+
+/* Allocates a segment with OPT_LEN bytes of options and LEN bytes
+   of data, and fills in its header except for the checksum. */
+static struct pbuf* seg_alloc(uint16_t src_port, uint16_t dst_port, uint32_t seq, uint32_t ack,
+                              uint8_t flags, uint16_t wnd, size_t opt_len, size_t len) {
+  struct tcp_hdr* th;
+  struct pbuf* p;
+
+  p = pbuf_alloc(PBUF_TRANSPORT, TCP_HEADER_LEN + opt_len + len, PBUF_RAM);
+  if (p == NULL)
+    return NULL;
+
+  th = p->payload;
+  th->src_port = htons(src_port);
+  th->dst_port = htons(dst_port);
+  th->seq_num = htonl(seq);
+  th->ack_num = htonl(ack);
+  th->data_offset = ((TCP_HEADER_LEN + opt_len) / 4) << 4;
+  th->flags = flags;
+  th->window = htons(wnd);
+  th->checksum = 0;
+  th->urgent_ptr = 0;
+  return p;
+}
+
+/* Checksums the segment in P and hands it to IP. */
+static void xmit(struct pbuf* p, uint32_t src_ip, uint32_t dst_ip) {
+  struct tcp_hdr* th = p->payload;
+  uint32_t sum;
+
+  sum = checksum_pseudo_header(src_ip, dst_ip, IP_PROTO_TCP, p->len);
+  sum = checksum_partial(p->payload, p->len, sum);
+  th->checksum = checksum_finish(sum);
+
+  ip_output(NULL, p, src_ip, dst_ip, IP_PROTO_TCP, 0);
+}
+
+/* Sends a RST from LOCAL_IP:LOCAL_PORT to REMOTE_IP:REMOTE_PORT. */
+static void send_reset(uint32_t local_ip, uint16_t local_port, uint32_t remote_ip,
+                       uint16_t remote_port, uint32_t seq, uint32_t ack, uint8_t flags) {
+  struct pbuf* p = seg_alloc(local_port, remote_port, seq, ack, TCP_FLAG_RST | flags, 0, 0, 0);
+  if (p != NULL)
+    xmit(p, local_ip, remote_ip);
+}
+
+/* Answers SEG, which no connection wants, with a RST
+   [RFC 793 3.4, "Reset Generation"]. */
+static void reset_segment(const struct tcp_seg* seg, uint32_t local_ip, uint16_t local_port,
+                          uint32_t remote_ip, uint16_t remote_port) {
+  if (seg->flags & TCP_FLAG_RST)
+    return;
+  if (seg->flags & TCP_FLAG_ACK)
+    send_reset(local_ip, local_port, remote_ip, remote_port, seg->ack, 0, 0);
+  else {
+    uint32_t len = seg->len + !!(seg->flags & TCP_FLAG_SYN) + !!(seg->flags & TCP_FLAG_FIN);
+    send_reset(local_ip, local_port, remote_ip, remote_port, 0, seg->seq + len, TCP_FLAG_ACK);
+  }
+}
+
+/* Sends a segment on PCB with sequence number SEQ, FLAGS, and LEN
+   bytes of data from the send buffer.  A SYN carries the MSS and,
+   where allowed, window scale options. */
+static void send_segment(struct tcp_pcb* pcb, uint32_t seq, uint32_t len, uint8_t flags) {
+  uint8_t opts[TCP_SYN_OPT_LEN];
+  size_t opt_len = 0;
+  unsigned shift = 0;
+  uint32_t wnd;
+  struct pbuf* p;
+
+  if (flags & TCP_FLAG_SYN) {
+    uint16_t mss = local_mss(pcb);
+    opts[0] = TCP_OPT_MSS;
+    opts[1] = 4;
+    opts[2] = mss >> 8;
+    opts[3] = mss & 0xff;
+    opt_len = 4;
+
+    /* Offer scaling in our SYN, and accept it in our SYN+ACK only
+       if the peer offered it [RFC 7323 2.2]. */
+    if (!(flags & TCP_FLAG_ACK) || (pcb->flags & TF_WSCALE)) {
+      opts[4] = TCP_OPT_NOP;
+      opts[5] = TCP_OPT_WSCALE;
+      opts[6] = 3;
+      opts[7] = pcb->rcv_wscale;
+      opt_len = 8;
+    }
+  } else
+    shift = pcb->rcv_wscale;
+
+  /* The window in a SYN is never scaled. */
+  wnd = rcv_space(pcb) >> shift;
+  if (wnd > 0xffff)
+    wnd = 0xffff;
+
+  p = seg_alloc(pcb->local_port, pcb->remote_port, seq, pcb->rcv_nxt, flags, wnd, opt_len, len);
+  if (p == NULL)
+    return; /* As if lost; the timers recover. */
+  memcpy((uint8_t*)p->payload + TCP_HEADER_LEN, opts, opt_len);
+  if (len > 0)
+    ring_read(pcb->send_buf, TCP_SND_BUF_SIZE, seq,
+              (uint8_t*)p->payload + TCP_HEADER_LEN + opt_len, len);
+
+  if (flags & TCP_FLAG_ACK) {
+    pcb->flags &= ~TF_ACK_NOW;
+    pcb->ack_pending = 0;
+    pcb->ack_timer = 0;
+    pcb->rcv_adv = pcb->rcv_nxt + (wnd << shift);
+  }
+  pcb->stats.segs_out++;
+  if (SEQ_LT(seq, pcb->snd_max) && (len > 0 || (flags & (TCP_FLAG_SYN | TCP_FLAG_FIN))))
+    pcb->stats.retransmits++;
+
+  xmit(p, pcb->local_ip, pcb->remote_ip);
+}
+
+/* Sends the SYN, or the SYN+ACK in SYN_RCVD, and starts the
+   retransmission timer. */
+static void send_syn(struct tcp_pcb* pcb) {
+  uint8_t flags = TCP_FLAG_SYN | (pcb->state == TCP_SYN_RCVD ? TCP_FLAG_ACK : 0);
+
+  send_segment(pcb, pcb->iss, 0, flags);
+  pcb->snd_nxt = pcb->snd_max = pcb->iss + 1;
+  pcb->rtx_timer = timer_ticks() + pcb->rto;
+}
+
+/* Sends again the first unacknowledged segment. */
+static void retransmit_first(struct tcp_pcb* pcb) {
+  uint32_t len = 0;
+  uint8_t flags = TCP_FLAG_ACK;
+
+  if (SEQ_LT(pcb->snd_una, pcb->snd_end))
+    len = min32(pcb->mss, pcb->snd_end - pcb->snd_una);
+  if ((pcb->flags & TF_FIN_QUEUED) && pcb->snd_una + len == pcb->snd_end &&
+      SEQ_GT(pcb->snd_max, pcb->snd_end))
+    flags |= TCP_FLAG_FIN;
+  if (len == 0 && !(flags & TCP_FLAG_FIN))
+    return;
+
+  send_segment(pcb, pcb->snd_una, len, flags);
+  pcb->rtx_timer = timer_ticks() + pcb->rto;
+}
+
+/* Sends as much queued data, and the FIN, as the send window and
+   the congestion window allow, or else an ACK if one is due. */
+static void tcp_output(struct tcp_pcb* pcb) {
+  int64_t now = timer_ticks();
+  bool sent = false;
+
+  if (pcb->state < TCP_SYN_RCVD)
+    return;
+
+  if (pcb->state >= TCP_ESTABLISHED && pcb->state != TCP_TIME_WAIT) {
+    for (;;) {
+      uint32_t wnd = min32(pcb->snd_wnd, pcb->cwnd);
+      uint32_t flight = pcb->snd_nxt - pcb->snd_una;
+      uint32_t unsent = snd_unsent(pcb);
+      uint32_t len = flight < wnd ? min32(min32(unsent, pcb->mss), wnd - flight) : 0;
+      uint8_t flags = TCP_FLAG_ACK;
+
+      /* The FIN follows the last byte, window or not. */
+      if ((pcb->flags & TF_FIN_QUEUED) && len == unsent && pcb->snd_nxt + len == pcb->snd_end)
+        flags |= TCP_FLAG_FIN;
+      if (len == 0 && !(flags & TCP_FLAG_FIN))
+        break;
+      if (len > 0 && len == unsent)
+        flags |= TCP_FLAG_PSH;
+
+      /* Time one new segment per round trip, never a retransmission
+         [RFC 6298 3, Karn's algorithm]. */
+      if (!(pcb->flags & TF_TIMING) && pcb->snd_nxt == pcb->snd_max) {
+        pcb->flags |= TF_TIMING;
+        pcb->rtt_seq = pcb->snd_nxt;
+        pcb->rtt_start = now;
+      }
+
+      send_segment(pcb, pcb->snd_nxt, len, flags);
+      pcb->snd_nxt += len + ((flags & TCP_FLAG_FIN) ? 1 : 0);
+      if (SEQ_GT(pcb->snd_nxt, pcb->snd_max))
+        pcb->snd_max = pcb->snd_nxt;
+      if (pcb->rtx_timer == 0)
+        pcb->rtx_timer = now + pcb->rto;
+      sent = true;
+    }
+
+    /* Data waits behind a zero window with nothing in flight to
+       bring an update: the timer probes it. */
+    if (snd_unsent(pcb) > 0 && pcb->snd_wnd == 0 && pcb->snd_una == pcb->snd_max &&
+        pcb->rtx_timer == 0)
+      pcb->rtx_timer = now + pcb->rto;
+  }
+
+  if (!sent && (pcb->flags & TF_ACK_NOW) && pcb->state != TCP_SYN_RCVD)
+    send_segment(pcb, pcb->snd_nxt, 0, TCP_FLAG_ACK);
+}
+
+/* ---------------------------------------------------------------- */
+/* Timers                                                           */
+/* ---------------------------------------------------------------- */
+
+/* Updates PCB's RTT estimate with a measurement of M ticks and
+   recomputes the RTO [RFC 6298 2].  SRTT is kept times 8 and RTTVAR
+   times 4, as in Jacobson's original code. */
+static void rtt_update(struct tcp_pcb* pcb, int64_t m) {
+  /* A round trip under a tick still took some time. */
+  if (m < 1)
+    m = 1;
+
+  if (pcb->srtt == 0) {
+    pcb->srtt = m << 3;
+    pcb->rttvar = m << 1;
+  } else {
+    int64_t delta = m - (pcb->srtt >> 3);
+    pcb->srtt += delta;
+    if (delta < 0)
+      delta = -delta;
+    pcb->rttvar += delta - (pcb->rttvar >> 2);
+  }
+
+  /* RTO = SRTT + max(G, 4 * RTTVAR), with G one tick. */
+  pcb->rto = (pcb->srtt >> 3) + (pcb->rttvar > 1 ? pcb->rttvar : 1);
+  if (pcb->rto < TCP_RTO_MIN)
+    pcb->rto = TCP_RTO_MIN;
+  if (pcb->rto > TCP_RTO_MAX)
+    pcb->rto = TCP_RTO_MAX;
+}
+
+/* Doubles PCB's RTO, up to the maximum [RFC 6298 5.5]. */
+static void rto_backoff(struct tcp_pcb* pcb) {
+  pcb->rto = pcb->rto * 2 < TCP_RTO_MAX ? pcb->rto * 2 : TCP_RTO_MAX;
+}
+
+/* Handles expiry of PCB's retransmission timer.  PCB may be freed. */
+static void rtx_expired(struct tcp_pcb* pcb) {
+  int64_t now = timer_ticks();
+
+  pcb->rtx_timer = 0;
+  pcb->flags &= ~TF_TIMING;
+
+  if (pcb->state == TCP_SYN_SENT || pcb->state == TCP_SYN_RCVD) {
+    if (++pcb->nrtx > TCP_SYN_MAX_RTX) {
+      pcb_closed(pcb, TCP_ERR_TIMEOUT);
+      return;
+    }
+    pcb->stats.timeouts++;
+    rto_backoff(pcb);
+    send_syn(pcb);
+    return;
+  }
+
+  /* Persist timer: push one byte past a zero window, so that the
+     ACK it draws reports when the window opens. */
+  if (pcb->snd_wnd == 0 && snd_unsent(pcb) + (pcb->snd_max - pcb->snd_una) > 0 &&
+      pcb->snd_max - pcb->snd_una <= 1 && SEQ_LT(pcb->snd_una, pcb->snd_end)) {
+    rto_backoff(pcb);
+    send_segment(pcb, pcb->snd_una, 1, TCP_FLAG_ACK);
+    pcb->snd_nxt = pcb->snd_una + 1;
+    if (SEQ_GT(pcb->snd_nxt, pcb->snd_max))
+      pcb->snd_max = pcb->snd_nxt;
+    pcb->rtx_timer = now + pcb->rto;
+    return;
+  }
+
+  if (pcb->snd_una == pcb->snd_max)
+    return;
+
+  if (++pcb->nrtx > TCP_MAX_RTX) {
+    send_reset(pcb->local_ip, pcb->local_port, pcb->remote_ip, pcb->remote_port, pcb->snd_nxt,
+               0, 0);
+    pcb_closed(pcb, TCP_ERR_TIMEOUT);
+    return;
+  }
+
+  /* Everything in flight is presumed lost: fall back to slow start
+     from one segment and send it all again [RFC 5681 3.1], and let
+     no duplicate ACKs for it start fast recovery [RFC 6582 4.2]. */
+  pcb->stats.timeouts++;
+  pcb->ssthresh = pcb->cc->ssthresh(pcb);
+  pcb->cwnd = pcb->mss;
+  pcb->flags &= ~TF_RECOVERY;
+  pcb->recover = pcb->snd_max;
+  pcb->dupacks = 0;
+  rto_backoff(pcb);
+  pcb->snd_nxt = pcb->snd_una;
+  tcp_output(pcb);
+}
+
+void tcp_timer(void) {
+  struct list_elem *e, *next;
+  int64_t now;
+
+  if (!tcp_initialized)
+    return;
+
+  lock_acquire(&tcp_lock);
+  now = timer_ticks();
+  for (e = list_begin(&tcp_pcb_list); e != list_end(&tcp_pcb_list); e = next) {
+    struct tcp_pcb* pcb = list_entry(e, struct tcp_pcb, elem);
+    next = list_next(e);
+
+    if (pcb->tw_timer != 0 && now >= pcb->tw_timer) {
+      pcb_closed(pcb, 0);
+      continue;
+    }
+    if (pcb->ack_timer != 0 && now >= pcb->ack_timer) {
+      pcb->ack_timer = 0;
+      pcb->flags |= TF_ACK_NOW;
+      tcp_output(pcb);
+    }
+    if (pcb->rtx_timer != 0 && now >= pcb->rtx_timer)
+      rtx_expired(pcb);
+  }
+  lock_release(&tcp_lock);
+}
+
+/* ---------------------------------------------------------------- */
+/* Input                                                            */
+/* ---------------------------------------------------------------- */
+
+/* Parses the LEN bytes of options at OPT into SEG. */
+static void parse_options(const uint8_t* opt, size_t len, struct tcp_seg* seg) {
+  seg->mss = 0;
+  seg->wscale = -1;
+
+  while (len > 0 && opt[0] != TCP_OPT_END) {
+    if (opt[0] == TCP_OPT_NOP) {
+      opt++;
+      len--;
+      continue;
+    }
+    if (len < 2 || opt[1] < 2 || opt[1] > len)
+      break;
+    if (opt[0] == TCP_OPT_MSS && opt[1] == 4)
+      seg->mss = (opt[2] << 8) | opt[3];
+    else if (opt[0] == TCP_OPT_WSCALE && opt[1] == 3)
+      seg->wscale = opt[2] < TCP_MAX_WSCALE ? opt[2] : TCP_MAX_WSCALE;
+    len -= opt[1];
+    opt += opt[1];
+  }
+}
+
+/* Takes the peer's side of the connection from SYN segment SEG. */
+static void syn_input(struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  pcb->irs = seg->seq;
+  pcb->rcv_nxt = pcb->rcv_user = seg->seq + 1;
+  pcb->mss = min32(seg->mss != 0 ? seg->mss : TCP_DEFAULT_MSS, local_mss(pcb));
+
+  if (seg->wscale >= 0) {
+    pcb->flags |= TF_WSCALE;
+    pcb->snd_wscale = seg->wscale;
+  } else {
+    pcb->snd_wscale = 0;
+    pcb->rcv_wscale = 0;
+  }
+}
+
+/* Enters ESTABLISHED and starts congestion control. */
+static void established(struct tcp_pcb* pcb) {
+  pcb->state = TCP_ESTABLISHED;
+  pcb->nrtx = 0;
+
+  /* Initial window [RFC 5681 3.1]. */
+  if (pcb->mss > 2190)
+    pcb->cwnd = 2 * pcb->mss;
+  else if (pcb->mss > 1095)
+    pcb->cwnd = 3 * pcb->mss;
+  else
+    pcb->cwnd = 4 * pcb->mss;
+  pcb->ssthresh = UINT32_MAX;
+  memset(pcb->cc_priv, 0, sizeof pcb->cc_priv);
+  if (pcb->cc->init != NULL)
+    pcb->cc->init(pcb);
+
+  cond_broadcast(&pcb->connect_cond, &tcp_lock);
+}
+
+/* Handles a duplicate ACK: counts it and, at the third, retransmits
+   the segment it asks for and enters fast recovery, unless the loss
+   it reports was already dealt with [RFC 6582 3.2]. */
+static void dupack_input(struct tcp_pcb* pcb) {
+  if (pcb->flags & TF_RECOVERY) {
+    /* Each duplicate means a segment left the network. */
+    pcb->cwnd += pcb->mss;
+    return;
+  }
+  if (++pcb->dupacks != TCP_DUPACK_THRESH || SEQ_LT(pcb->snd_una, pcb->recover))
+    return;
+
+  pcb->stats.fast_retransmits++;
+  pcb->ssthresh = pcb->cc->ssthresh(pcb);
+  pcb->recover = pcb->snd_max;
+  pcb->flags = (pcb->flags | TF_RECOVERY) & ~TF_TIMING;
+  retransmit_first(pcb);
+  pcb->cwnd = pcb->ssthresh + TCP_DUPACK_THRESH * pcb->mss;
+}
+
+/* Handles an ACK of ACKED new bytes, up to ACK. */
+static void new_ack_input(struct tcp_pcb* pcb, uint32_t ack, uint32_t acked) {
+  pcb->snd_una = ack;
+  if (SEQ_LT(pcb->snd_nxt, ack))
+    pcb->snd_nxt = ack;
+  pcb->nrtx = 0;
+
+  if ((pcb->flags & TF_TIMING) && SEQ_GT(ack, pcb->rtt_seq)) {
+    pcb->flags &= ~TF_TIMING;
+    rtt_update(pcb, timer_elapsed(pcb->rtt_start));
+  }
+
+  /* Restart the timer for the data still in flight [RFC 6298 5.3]. */
+  pcb->rtx_timer = pcb->snd_una == pcb->snd_max ? 0 : timer_ticks() + pcb->rto;
+
+  if (pcb->flags & TF_RECOVERY) {
+    if (SEQ_GEQ(ack, pcb->recover)) {
+      /* Full acknowledgment: deflate the window and leave recovery
+         [RFC 6582 3.2, step 3]. */
+      uint32_t flight = pcb->snd_max - pcb->snd_una;
+      pcb->cwnd = min32(pcb->ssthresh, max32(flight, pcb->mss) + pcb->mss);
+      pcb->flags &= ~TF_RECOVERY;
+      pcb->dupacks = 0;
+    } else {
+      /* Partial acknowledgment: the segment after it was lost too.
+         Deflate by what was acknowledged, keeping room for the
+         retransmission [RFC 6582 3.2, step 4]. */
+      retransmit_first(pcb);
+      pcb->cwnd = pcb->cwnd > acked ? pcb->cwnd - acked : 0;
+      if (acked >= pcb->mss || pcb->cwnd < pcb->mss)
+        pcb->cwnd += pcb->mss;
+    }
+  } else {
+    pcb->dupacks = 0;
+    pcb->cc->cong_avoid(pcb, acked);
+    if (pcb->cwnd > TCP_CWND_MAX)
+      pcb->cwnd = TCP_CWND_MAX;
+  }
+
+  cond_broadcast(&pcb->send_cond, &tcp_lock);
+}
+
+/* Processes the ACK field of SEG.  Returns false if the segment
+   should be dropped. */
+static bool ack_input(struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  uint32_t wnd = (uint32_t)seg->wnd << pcb->snd_wscale;
+  uint32_t old_wnd = pcb->snd_wnd;
+  bool wnd_changed = false;
+
+  if (SEQ_GT(seg->ack, pcb->snd_max)) {
+    /* Acknowledges something not yet sent. */
+    pcb->flags |= TF_ACK_NOW;
+    return false;
+  }
+  if (SEQ_LT(seg->ack, pcb->snd_una))
+    return true; /* Old duplicate. */
+
+  /* Update the send window from the newest segment [RFC 793 3.9]. */
+  if (SEQ_LT(pcb->snd_wl1, seg->seq) ||
+      (pcb->snd_wl1 == seg->seq && SEQ_LEQ(pcb->snd_wl2, seg->ack))) {
+    wnd_changed = pcb->snd_wnd != wnd;
+    pcb->snd_wnd = wnd;
+    pcb->snd_wl1 = seg->seq;
+    pcb->snd_wl2 = seg->ack;
+  }
+
+  if (seg->ack != pcb->snd_una)
+    new_ack_input(pcb, seg->ack, seg->ack - pcb->snd_una);
+  else if (seg->len == 0 && !(seg->flags & (TCP_FLAG_SYN | TCP_FLAG_FIN)) && !wnd_changed &&
+           pcb->snd_max != pcb->snd_una && wnd != 0)
+    dupack_input(pcb); /* Duplicate by RFC 5681's definition, less
+                          the answers to zero window probes. */
+
+  /* The window reopened with a probe's byte refused: send it again
+     ahead of the data that follows it. */
+  if (old_wnd == 0 && pcb->snd_wnd != 0 && pcb->snd_nxt - pcb->snd_una == 1)
+    pcb->snd_nxt = pcb->snd_una;
+  return true;
+}
+
+/* Stores the data of SEG in the receive buffer. */
+static void data_input(struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  uint32_t seq = seg->seq + ((seg->flags & TCP_FLAG_SYN) ? 1 : 0);
+  uint32_t limit = pcb->rcv_user + TCP_RCV_BUF_SIZE;
+  const uint8_t* data = seg->data;
+  uint32_t len = seg->len;
+
+  /* Trim what was received before and what does not fit. */
+  if (SEQ_LT(seq, pcb->rcv_nxt)) {
+    uint32_t skip = pcb->rcv_nxt - seq;
+    if (skip >= len) {
+      pcb->flags |= TF_ACK_NOW;
+      return;
+    }
+    data += skip;
+    len -= skip;
+    seq = pcb->rcv_nxt;
+  }
+  if (SEQ_GT(seq + len, limit))
+    len = SEQ_LT(seq, limit) ? limit - seq : 0;
+  if (len == 0) {
+    pcb->flags |= TF_ACK_NOW;
+    return;
+  }
+
+  ring_write(pcb->recv_buf, TCP_RCV_BUF_SIZE, seq, data, len);
+
+  if (seq != pcb->rcv_nxt) {
+    /* A gap: keep the data and tell the sender at once, with a
+       duplicate ACK [RFC 5681 4.2]. */
+    ooseq_insert(pcb, seq, seq + len);
+    pcb->flags |= TF_ACK_NOW;
+    return;
+  }
+
+  /* In order.  ACK at least every second full segment, and at once
+     if this filled a gap [RFC 5681 4.2]. */
+  pcb->rcv_nxt += len;
+  if (!list_empty(&pcb->ooseq)) {
+    ooseq_advance(pcb);
+    pcb->flags |= TF_ACK_NOW;
+  } else if (++pcb->ack_pending >= 2)
+    pcb->flags |= TF_ACK_NOW;
+  else if (pcb->ack_timer == 0)
+    pcb->ack_timer = timer_ticks() + TCP_DELACK;
+
+  if (pcb->flags & TF_USER_CLOSED)
+    pcb->rcv_user = pcb->rcv_nxt;
+  cond_broadcast(&pcb->recv_cond, &tcp_lock);
+}
+
+/* Takes the peer's FIN, which rcv_nxt has reached.  PCB may be
+   freed. */
+static void fin_input(struct tcp_pcb* pcb) {
+  pcb->flags = (pcb->flags | TF_FIN_RCVD | TF_ACK_NOW) & ~TF_FIN_EARLY;
+  pcb->rcv_nxt++;
+  cond_broadcast(&pcb->recv_cond, &tcp_lock);
+
+  switch (pcb->state) {
+    case TCP_ESTABLISHED:
+      pcb->state = TCP_CLOSE_WAIT;
+      break;
+    case TCP_FIN_WAIT_1:
+      /* Our FIN is not yet acknowledged, or we would be in
+         FIN_WAIT_2. */
+      pcb->state = TCP_CLOSING;
+      break;
+    case TCP_FIN_WAIT_2:
+      pcb->tw_timer = 0;
+      enter_time_wait(pcb);
+      break;
+    default:
+      break;
+  }
+}
+
+/* Processes SEG on listener LPCB: a SYN opens a new connection in
+   SYN_RCVD, counted against the backlog until accepted. */
+static void listen_input(struct tcp_pcb* lpcb, const struct tcp_seg* seg, uint32_t local_ip,
+                         uint16_t local_port, uint32_t remote_ip, uint16_t remote_port) {
+  struct tcp_pcb* pcb;
+
+  if (seg->flags & TCP_FLAG_RST)
+    return;
+  if (seg->flags & TCP_FLAG_ACK) {
+    reset_segment(seg, local_ip, local_port, remote_ip, remote_port);
+    return;
+  }
+  if (!(seg->flags & TCP_FLAG_SYN) || lpcb->pending >= lpcb->backlog)
+    return; /* A dropped SYN is sent again. */
+
+  pcb = pcb_alloc();
   if (pcb == NULL)
     return;
+  pcb->local_ip = local_ip;
+  pcb->local_port = local_port;
+  pcb->remote_ip = remote_ip;
+  pcb->remote_port = remote_port;
+  pcb->cc = lpcb->cc;
+  if (!pcb_open(pcb)) {
+    pcb_unref(pcb);
+    return;
+  }
+
+  /* The application's reference belongs to the listener until the
+     connection is accepted. */
+  pcb->parent = lpcb;
+  lpcb->pending++;
+
+  syn_input(pcb, seg);
+  pcb->snd_wnd = seg->wnd;
+  pcb->snd_wl1 = seg->seq;
+  pcb->state = TCP_SYN_RCVD;
+  send_syn(pcb);
+}
+
+/* Processes SEG in SYN_SENT. */
+static void syn_sent_input(struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  bool ack_ok = false;
+
+  if (seg->flags & TCP_FLAG_ACK) {
+    if (SEQ_LEQ(seg->ack, pcb->iss) || SEQ_GT(seg->ack, pcb->snd_max)) {
+      reset_segment(seg, pcb->local_ip, pcb->local_port, pcb->remote_ip, pcb->remote_port);
+      return;
+    }
+    ack_ok = true;
+  }
+  if (seg->flags & TCP_FLAG_RST) {
+    if (ack_ok)
+      pcb_closed(pcb, TCP_ERR_REFUSED);
+    return;
+  }
+  if (!(seg->flags & TCP_FLAG_SYN))
+    return;
+
+  syn_input(pcb, seg);
+  pcb->snd_wnd = seg->wnd;
+  pcb->snd_wl1 = seg->seq;
+  pcb->snd_wl2 = seg->ack;
+
+  if (ack_ok) {
+    pcb->snd_una = seg->ack;
+    pcb->rtx_timer = 0;
+    if (pcb->nrtx == 0)
+      rtt_update(pcb, timer_elapsed(pcb->rtt_start));
+    established(pcb);
+    pcb->flags |= TF_ACK_NOW;
+    tcp_output(pcb);
+  } else {
+    /* Simultaneous open. */
+    pcb->state = TCP_SYN_RCVD;
+    send_syn(pcb);
+  }
+}
+
+/* Returns true if SEG overlaps PCB's receive window
+   [RFC 793 3.3, "Segment Receive Test"]. */
+static bool seq_acceptable(const struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  uint32_t len = seg->len + !!(seg->flags & TCP_FLAG_SYN) + !!(seg->flags & TCP_FLAG_FIN);
+  uint32_t wnd = rcv_space(pcb);
+  uint32_t last = seg->seq + len - 1;
+
+  if (wnd == 0)
+    return len == 0 && seg->seq == pcb->rcv_nxt;
+  if (SEQ_GEQ(seg->seq, pcb->rcv_nxt) && SEQ_LT(seg->seq, pcb->rcv_nxt + wnd))
+    return true;
+  return len > 0 && SEQ_GEQ(last, pcb->rcv_nxt) && SEQ_LT(last, pcb->rcv_nxt + wnd);
+}
+
+/* Processes SEG in SYN_RCVD or a synchronized state.  PCB may be
+   freed. */
+static void synced_input(struct tcp_pcb* pcb, const struct tcp_seg* seg) {
+  uint32_t fin_seq;
+
+  /* First, check the sequence number. */
+  if (!seq_acceptable(pcb, seg)) {
+    if (seg->flags & TCP_FLAG_RST)
+      return;
+    if (pcb->state == TCP_SYN_RCVD)
+      send_syn(pcb);
+    else {
+      /* Also answers a retransmitted FIN in TIME_WAIT, which
+         restarts the wait [RFC 793 3.9]. */
+      if (pcb->state == TCP_TIME_WAIT && (seg->flags & TCP_FLAG_FIN))
+        pcb->tw_timer = timer_ticks() + 2 * TCP_MSL;
+      pcb->flags |= TF_ACK_NOW;
+      tcp_output(pcb);
+    }
+    return;
+  }
+
+  /* Second, the RST bit. */
+  if (seg->flags & TCP_FLAG_RST) {
+    if (pcb->state == TCP_SYN_RCVD)
+      pcb_closed(pcb, pcb->parent != NULL ? 0 : TCP_ERR_REFUSED);
+    else
+      pcb_closed(pcb, TCP_ERR_RESET);
+    return;
+  }
+
+  /* Fourth, a SYN in the window is an error. */
+  if (seg->flags & TCP_FLAG_SYN) {
+    send_reset(pcb->local_ip, pcb->local_port, pcb->remote_ip, pcb->remote_port, pcb->snd_nxt,
+               0, 0);
+    pcb_closed(pcb, TCP_ERR_RESET);
+    return;
+  }
+
+  /* Fifth, the ACK field. */
+  if (!(seg->flags & TCP_FLAG_ACK))
+    return;
+  if (pcb->state == TCP_SYN_RCVD) {
+    if (SEQ_LEQ(seg->ack, pcb->snd_una) || SEQ_GT(seg->ack, pcb->snd_max)) {
+      reset_segment(seg, pcb->local_ip, pcb->local_port, pcb->remote_ip, pcb->remote_port);
+      return;
+    }
+    established(pcb);
+    if (pcb->parent != NULL) {
+      pcb->flags |= TF_QUEUED;
+      list_push_back(&pcb->parent->accept_queue, &pcb->accept_elem);
+      cond_signal(&pcb->parent->accept_cond, &tcp_lock);
+    }
+  }
+  if (!ack_input(pcb, seg)) {
+    tcp_output(pcb);
+    return;
+  }
+  if ((pcb->flags & TF_FIN_QUEUED) && pcb->snd_una == pcb->snd_end + 1) {
+    /* Our FIN is acknowledged. */
+    if (pcb->state == TCP_FIN_WAIT_1) {
+      /* An orphan waits for the peer's FIN no longer than it
+         would in TIME_WAIT. */
+      pcb->state = TCP_FIN_WAIT_2;
+      pcb->tw_timer = timer_ticks() + 2 * TCP_MSL;
+    } else if (pcb->state == TCP_CLOSING)
+      enter_time_wait(pcb);
+    else if (pcb->state == TCP_LAST_ACK) {
+      pcb_closed(pcb, 0);
+      return;
+    }
+  }
+
+  /* Seventh, the segment text.  (Sixth, URG, is not supported.) */
+  if (seg->len > 0 && !(pcb->flags & TF_FIN_RCVD) &&
+      (pcb->state == TCP_ESTABLISHED || pcb->state == TCP_FIN_WAIT_1 ||
+       pcb->state == TCP_FIN_WAIT_2))
+    data_input(pcb, seg);
+
+  /* Eighth, the FIN bit.  A FIN beyond a gap waits for the gap to
+     fill. */
+  fin_seq = seg->seq + ((seg->flags & TCP_FLAG_SYN) ? 1 : 0) + seg->len;
+  if ((seg->flags & TCP_FLAG_FIN) && pcb->state != TCP_TIME_WAIT) {
+    if (pcb->flags & TF_FIN_RCVD)
+      pcb->flags |= TF_ACK_NOW;
+    else if (SEQ_GT(fin_seq, pcb->rcv_nxt) && SEQ_LEQ(fin_seq, pcb->rcv_user + TCP_RCV_BUF_SIZE)) {
+      pcb->flags |= TF_FIN_EARLY;
+      pcb->fin_seq = fin_seq;
+    } else if (fin_seq == pcb->rcv_nxt)
+      fin_input(pcb);
+  }
+  if ((pcb->flags & TF_FIN_EARLY) && pcb->rcv_nxt == pcb->fin_seq)
+    fin_input(pcb);
 
-  printf("tcp: free PCB (not implemented)\n");
-  (void)pcb;
+  tcp_output(pcb);
+}
+
+void tcp_input(struct netdev* dev UNUSED, struct pbuf* p, uint32_t src_ip, uint32_t dst_ip) {
+  struct tcp_hdr* th;
+  struct tcp_seg seg;
+  struct tcp_pcb* pcb;
+  uint16_t src_port, dst_port;
+  size_t hlen;
+  uint32_t sum;
+
+  /* 1. Validate the header and checksum. */
+  if (p->len < TCP_HEADER_LEN) {
+    pbuf_free(p);
+    return;
+  }
+  th = p->payload;
+  hlen = TCP_DATA_OFFSET(th);
+  if (hlen < TCP_HEADER_LEN || hlen > p->len) {
+    pbuf_free(p);
+    return;
+  }
+  sum = checksum_pseudo_header(src_ip, dst_ip, IP_PROTO_TCP, p->len);
+  sum = checksum_partial(p->payload, p->len, sum);
+  if (checksum_finish(sum) != 0) {
+    pbuf_free(p);
+    return;
+  }
+
+  /* 2. Extract the fields. */
+  src_port = ntohs(th->src_port);
+  dst_port = ntohs(th->dst_port);
+  seg.seq = ntohl(th->seq_num);
+  seg.ack = ntohl(th->ack_num);
+  seg.flags = th->flags;
+  seg.wnd = ntohs(th->window);
+  seg.data = (const uint8_t*)p->payload + hlen;
+  seg.len = p->len - hlen;
+  parse_options((const uint8_t*)(th + 1), hlen - TCP_HEADER_LEN, &seg);
+
+  /* 3. Hand it to its connection. */
+  lock_acquire(&tcp_lock);
+  pcb = pcb_lookup(dst_ip, dst_port, src_ip, src_port);
+  if (pcb == NULL)
+    reset_segment(&seg, dst_ip, dst_port, src_ip, src_port);
+  else {
+    pcb->stats.segs_in++;
+    if (pcb->state == TCP_LISTEN)
+      listen_input(pcb, &seg, dst_ip, dst_port, src_ip, src_port);
+    else if (pcb->state == TCP_SYN_SENT)
+      syn_sent_input(pcb, &seg);
+    else
+      synced_input(pcb, &seg);
+  }
+  lock_release(&tcp_lock);
+
+  pbuf_free(p);
+}
+
+/* ---------------------------------------------------------------- */
+/* Application interface                                            */
+/* ---------------------------------------------------------------- */
+
+struct tcp_pcb* tcp_new(void) {
+  struct tcp_pcb* pcb;
+
+  lock_acquire(&tcp_lock);
+  pcb = pcb_alloc();
+  lock_release(&tcp_lock);
+  return pcb;
+}
+
+void tcp_free(struct tcp_pcb* pcb) {
+  if (pcb != NULL)
+    tcp_abort(pcb);
 }
 
 int tcp_bind(struct tcp_pcb* pcb, uint32_t ip, uint16_t port) {
-  /*
-   * TODO: Bind to local address/port
-   *
-   * - If port == 0, allocate ephemeral port
-   * - Check port not already in use
-   * - Update PCB
-   */
+  int result = -1;
+
+  if (pcb == NULL)
+    return -1;
 
-  printf("tcp: bind (not implemented)\n");
-  (void)pcb;
-  (void)ip;
-  (void)port;
-  return -1;
+  lock_acquire(&tcp_lock);
+  if (pcb->state == TCP_CLOSED && pcb->local_port == 0) {
+    /* If port == 0, allocate ephemeral port */
+    if (port == 0)
+      port = ephemeral_port();
+    else if (port_in_use(port, 0, 0))
+      port = 0;
+    if (port != 0) {
+      pcb->local_ip = ip;
+      pcb->local_port = port;
+      result = 0;
+    }
+  }
+  lock_release(&tcp_lock);
+  return result;
 }
 
 int tcp_listen(struct tcp_pcb* pcb, int backlog) {
-  /*
-   * TODO: Put socket in LISTEN state
-   *
-   * - PCB must be bound
-   * - Initialize accept queue
-   * - Set state to LISTEN
-   */
+  int result = -1;
+
+  if (pcb == NULL)
+    return -1;
 
-  printf("tcp: listen (not implemented)\n");
-  (void)pcb;
-  (void)backlog;
-  return -1;
+  lock_acquire(&tcp_lock);
+  if (pcb->state == TCP_CLOSED && pcb->local_port != 0) {
+    pcb->backlog = backlog > 0 ? backlog : 1;
+    pcb->pending = 0;
+    pcb->state = TCP_LISTEN;
+    result = 0;
+  }
+  lock_release(&tcp_lock);
+  return result;
 }
 
 struct tcp_pcb* tcp_accept(struct tcp_pcb* pcb) {
-  /*
-   * TODO: Accept incoming connection (blocking)
-   *
-   * - Wait on accept_cond until accept_queue not empty
-   * - Dequeue and return new PCB
-   */
+  struct tcp_pcb* conn = NULL;
 
-  printf("tcp: accept (not implemented)\n");
-  (void)pcb;
-  return NULL;
+  if (pcb == NULL)
+    return NULL;
+
+  lock_acquire(&tcp_lock);
+  while (pcb->state == TCP_LISTEN && list_empty(&pcb->accept_queue))
+    cond_wait(&pcb->accept_cond, &tcp_lock);
+  if (!list_empty(&pcb->accept_queue)) {
+    conn = list_entry(list_pop_front(&pcb->accept_queue), struct tcp_pcb, accept_elem);
+    conn->flags &= ~TF_QUEUED;
+    conn->parent = NULL;
+    pcb->pending--;
+  }
+  lock_release(&tcp_lock);
+  return conn;
 }
 
 int tcp_connect(struct tcp_pcb* pcb, uint32_t ip, uint16_t port) {
-  /*
-   * TODO: Active open (blocking)
-   *
-   * 1. If not bound, bind to ephemeral port
-   * 2. Generate ISS (Initial Send Sequence number)
-   * 3. Send SYN segment
-   * 4. Set state to SYN_SENT
-   * 5. Wait on connect_cond for ESTABLISHED or error
-   *
-   * Return 0 on success, negative on error.
-   */
-
-  printf("tcp: connect (not implemented)\n");
-  (void)pcb;
-  (void)ip;
-  (void)port;
-  return -1;
+  struct route_result route;
+  int result = -1;
+
+  if (pcb == NULL)
+    return -1;
+
+  lock_acquire(&tcp_lock);
+  if (pcb->state != TCP_CLOSED || pcb->error != 0 || pcb->send_buf != NULL)
+    goto done;
+
+  /* Pick a local address and port, unless bound. */
+  if (pcb->local_port == 0 && (pcb->local_port = ephemeral_port()) == 0)
+    goto done;
+  if (pcb->local_ip == 0) {
+    if (route_lookup(ip, &route) != 0)
+      goto done;
+    pcb->local_ip = route.dev->ip_addr;
+  }
+  if (port_in_use(pcb->local_port, ip, port))
+    goto done;
+
+  pcb->remote_ip = ip;
+  pcb->remote_port = port;
+  if (!pcb_open(pcb))
+    goto done;
+
+  pcb->state = TCP_SYN_SENT;
+  pcb->rtt_start = timer_ticks();
+  send_syn(pcb);
+
+  while (pcb->state == TCP_SYN_SENT || pcb->state == TCP_SYN_RCVD)
+    cond_wait(&pcb->connect_cond, &tcp_lock);
+  if (pcb->state != TCP_CLOSED)
+    result = 0;
+
+done:
+  lock_release(&tcp_lock);
+  return result;
 }
 
 int tcp_send(struct tcp_pcb* pcb, const void* data, size_t len) {
-  /*
-   * TODO: Send data on connection (may block)
-   *
-   * 1. Check state is ESTABLISHED
-   * 2. Add data to send buffer
-   * 3. Transmit what the window allows
-   * 4. If buffer full, wait on send_cond
-   *
-   * Return bytes sent, or negative on error.
-   */
-
-  printf("tcp: send (not implemented)\n");
-  (void)pcb;
-  (void)data;
-  (void)len;
-  return -1;
+  const uint8_t* src = data;
+  size_t done = 0;
+
+  if (pcb == NULL)
+    return -1;
+
+  lock_acquire(&tcp_lock);
+  while (done < len) {
+    uint32_t space, chunk;
+
+    if ((pcb->state != TCP_ESTABLISHED && pcb->state != TCP_CLOSE_WAIT) ||
+        (pcb->flags & TF_FIN_QUEUED)) {
+      lock_release(&tcp_lock);
+      return -1;
+    }
+
+    space = TCP_SND_BUF_SIZE - (pcb->snd_end - pcb->snd_una);
+    if (space == 0) {
+      cond_wait(&pcb->send_cond, &tcp_lock);
+      continue;
+    }
+
+    chunk = min32(space, len - done);
+    ring_write(pcb->send_buf, TCP_SND_BUF_SIZE, pcb->snd_end, src + done, chunk);
+    pcb->snd_end += chunk;
+    done += chunk;
+    tcp_output(pcb);
+  }
+  lock_release(&tcp_lock);
+  return len;
 }
 
 int tcp_recv(struct tcp_pcb* pcb, void* buf, size_t len) {
-  /*
-   * TODO: Receive data from connection (blocking)
-   *
-   * 1. Wait on recv_cond until data available or FIN received
-   * 2. Copy data from receive buffer
-   * 3. Update receive window
-   * 4. Return bytes read (0 on EOF/FIN)
-   */
-
-  printf("tcp: recv (not implemented)\n");
-  (void)pcb;
-  (void)buf;
-  (void)len;
-  return -1;
+  uint32_t avail;
+  int result;
+
+  if (pcb == NULL || buf == NULL)
+    return -1;
+
+  lock_acquire(&tcp_lock);
+  while ((avail = rcv_avail(pcb)) == 0 && !(pcb->flags & TF_FIN_RCVD) &&
+         pcb->state != TCP_CLOSED)
+    cond_wait(&pcb->recv_cond, &tcp_lock);
+
+  if (avail > 0) {
+    result = min32(avail, len);
+    ring_read(pcb->recv_buf, TCP_RCV_BUF_SIZE, pcb->rcv_user, buf, result);
+    pcb->rcv_user += result;
+
+    /* Tell the peer once the window has grown by a good part of the
+       buffer or two segments, whichever is less; smaller updates
+       would only invite small segments [RFC 1122 4.2.3.3]. */
+    if ((pcb->state == TCP_ESTABLISHED || pcb->state == TCP_FIN_WAIT_1 ||
+         pcb->state == TCP_FIN_WAIT_2) &&
+        pcb->rcv_user + TCP_RCV_BUF_SIZE - pcb->rcv_adv >=
+            min32(TCP_RCV_BUF_SIZE / 2, 2 * pcb->mss)) {
+      pcb->flags |= TF_ACK_NOW;
+      tcp_output(pcb);
+    }
+  } else
+    result = (pcb->flags & TF_FIN_RCVD) ? 0 : -1;
+  lock_release(&tcp_lock);
+  return result;
+}
+
+/* Closes listener PCB and aborts the connections it has not handed
+   out. */
+static void close_listener(struct tcp_pcb* pcb) {
+  struct list_elem *e, *next;
+
+  for (e = list_begin(&tcp_pcb_list); e != list_end(&tcp_pcb_list); e = next) {
+    struct tcp_pcb* child = list_entry(e, struct tcp_pcb, elem);
+    next = list_next(e);
+    if (child->parent != pcb)
+      continue;
+
+    if (child->flags & TF_QUEUED)
+      list_remove(&child->accept_elem);
+    child->flags &= ~TF_QUEUED;
+    child->parent = NULL;
+    child->refcount++;
+    abort_locked(child);
+    pcb_unref(child); /* The reference taken just above. */
+    pcb_unref(child); /* The listener's. */
+  }
+  pcb->pending = 0;
+  pcb->state = TCP_CLOSED;
+  cond_broadcast(&pcb->accept_cond, &tcp_lock);
+}
+
+/* Aborts PCB's connection, sending a RST if the peer knows of it. */
+static void abort_locked(struct tcp_pcb* pcb) {
+  if (pcb->state == TCP_LISTEN) {
+    close_listener(pcb);
+    return;
+  }
+  if (pcb->state >= TCP_SYN_RCVD && pcb->state != TCP_TIME_WAIT)
+    send_reset(pcb->local_ip, pcb->local_port, pcb->remote_ip, pcb->remote_port, pcb->snd_nxt,
+               0, 0);
+  if (pcb->state != TCP_CLOSED)
+    pcb_closed(pcb, 0);
 }
 
 int tcp_close(struct tcp_pcb* pcb) {
-  /*
-   * TODO: Close connection
-   *
-   * From ESTABLISHED or CLOSE_WAIT:
-   * - Send FIN
-   * - Wait for ACK
-   * - Eventually free PCB
-   *
-   * State transitions:
-   * ESTABLISHED -> FIN_WAIT_1 -> FIN_WAIT_2 -> TIME_WAIT -> CLOSED
-   * CLOSE_WAIT -> LAST_ACK -> CLOSED
-   */
-
-  printf("tcp: close (not implemented)\n");
-  (void)pcb;
-  return -1;
+  if (pcb == NULL)
+    return -1;
+
+  lock_acquire(&tcp_lock);
+  if ((pcb->state == TCP_ESTABLISHED || pcb->state == TCP_CLOSE_WAIT) && rcv_avail(pcb) == 0) {
+    /* Send a FIN after the queued data. */
+    pcb->state = pcb->state == TCP_ESTABLISHED ? TCP_FIN_WAIT_1 : TCP_LAST_ACK;
+    pcb->flags |= TF_FIN_QUEUED | TF_USER_CLOSED;
+    tcp_output(pcb);
+  } else if (pcb->state < TCP_FIN_WAIT_1 || pcb->state == TCP_CLOSE_WAIT) {
+    /* Not yet established, or data would go unread: reset
+       [RFC 2525 2.17]. */
+    abort_locked(pcb);
+  }
+  pcb_unref(pcb);
+  lock_release(&tcp_lock);
+  return 0;
 }
 
 void tcp_abort(struct tcp_pcb* pcb) {
-  /*
-   * TODO: Abort connection
-   *
-   * - Send RST
-   * - Free PCB immediately
-   */
+  if (pcb == NULL)
+    return;
 
-  printf("tcp: abort (not implemented)\n");
-  (void)pcb;
+  lock_acquire(&tcp_lock);
+  abort_locked(pcb);
+  pcb_unref(pcb);
+  lock_release(&tcp_lock);
 }
 
-void tcp_timer(void) {
-  /*
-   * TODO: TCP timer processing
-   *
-   * Called periodically to handle:
-   * - Retransmission timeouts
-   * - TIME_WAIT expiration
-   * - Keepalive (optional)
-   */
+/* ---------------------------------------------------------------- */
+/* Congestion control                                               */
+/* ---------------------------------------------------------------- */
+
+int tcp_cc_register(const struct tcp_cc_ops* ops) {
+  int result = -1;
+
+  ASSERT(ops->cong_avoid != NULL && ops->ssthresh != NULL);
+
+  lock_acquire(&tcp_lock);
+  if (cc_cnt < TCP_CC_MAX) {
+    cc_algos[cc_cnt++] = ops;
+    result = 0;
+  }
+  lock_release(&tcp_lock);
+  return result;
 }
+
+int tcp_set_cc(struct tcp_pcb* pcb, const char* name) {
+  int result = -1;
+  int i;
+
+  if (pcb == NULL)
+    return -1;
+
+  lock_acquire(&tcp_lock);
+  for (i = 0; i < cc_cnt; i++)
+    if (!strcmp(cc_algos[i]->name, name) &&
+        (pcb->state == TCP_CLOSED || pcb->state == TCP_LISTEN)) {
+      pcb->cc = cc_algos[i];
+      result = 0;
+    }
+  lock_release(&tcp_lock);
+  return result;
+}
+
+/* Slow start adds up to one MSS per ACK; congestion avoidance adds
+   one MSS per window of bytes acknowledged, counted in cc_priv[0]
+   [RFC 5681 3.1]. */
+static void newreno_cong_avoid(struct tcp_pcb* pcb, uint32_t acked) {
+  if (pcb->cwnd < pcb->ssthresh) {
+    pcb->cwnd += min32(acked, pcb->mss);
+    return;
+  }
+  pcb->cc_priv[0] += acked;
+  if (pcb->cc_priv[0] >= pcb->cwnd) {
+    pcb->cc_priv[0] -= pcb->cwnd;
+    pcb->cwnd += pcb->mss;
+  }
+}
+
+/* Half the data in flight, but at least two segments
+   [RFC 5681 3.1, equation 4]. */
+static uint32_t newreno_ssthresh(struct tcp_pcb* pcb) {
+  return max32((pcb->snd_max - pcb->snd_una) / 2, 2 * pcb->mss);
+}
+
+const struct tcp_cc_ops tcp_newreno = {.name = "newreno",
+                                       .init = NULL,
+                                       .cong_avoid = newreno_cong_avoid,
+                                       .ssthresh = newreno_ssthresh};
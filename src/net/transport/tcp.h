@@ -2,40 +2,36 @@
  * @file net/transport/tcp.h
  * @brief TCP protocol (Transmission Control Protocol).
  *
- * SCAFFOLD FOR YOUR IMPLEMENTATION
- * ================================
+ * TCP provides reliable, ordered, connection-oriented byte streams
+ * (RFC 793).
  *
- * TCP provides reliable, ordered, connection-oriented byte streams.
- * This is the most complex protocol in the stack.
+ * Each connection owns a send buffer and a receive buffer, both
+ * rings indexed directly by sequence number.  The send buffer holds
+ * every byte from SND.UNA to the end of the application's last
+ * write, so a retransmission is cut from it again like any other
+ * segment.  The receive buffer holds every byte from the
+ * application's read position onward; a segment that arrives out
+ * of order is copied to its place at once and its range remembered
+ * until the gap before it fills.
  *
- * YOUR TASKS (in recommended order):
+ * Also implemented:
+ * - MSS and window scale options (RFC 7323)
+ * - RTT estimation and retransmission timeout (RFC 6298), with
+ *   Karn's algorithm and exponential backoff
+ * - Slow start and congestion avoidance (RFC 5681), and NewReno
+ *   fast retransmit and fast recovery (RFC 6582), behind the
+ *   struct tcp_cc_ops interface so that other algorithms can be
+ *   plugged in
+ * - Delayed ACKs, receiver window updates and zero-window probes
+ * - The TIME_WAIT state
  *
- * Phase 6A - State Machine:
- * 1. Implement the 11-state TCP FSM
- * 2. Handle connection establishment (3-way handshake)
- * 3. Handle connection termination (4-way close)
+ * Not implemented: SACK, timestamps, urgent data and keepalives.
  *
- * Phase 6B - Data Transfer:
- * 4. Implement sliding window protocol
- * 5. Handle out-of-order segments
- * 6. Implement retransmission buffer
- *
- * Phase 6C - Timers:
- * 7. Implement RTT estimation (Jacobson/Karels)
- * 8. Implement retransmission timeout (RTO)
- * 9. Implement TIME_WAIT timer
- *
- * Phase 6D - Congestion Control:
- * 10. Implement slow start
- * 11. Implement congestion avoidance
- * 12. Implement fast retransmit/recovery
- *
- * KEY DATA STRUCTURES:
- * - TCP PCB (Protocol Control Block): Per-connection state
- * - Send buffer: Data waiting to be sent/acknowledged
- * - Receive buffer: Data received but not read by application
- *
- * REFERENCE: RFC 793 (TCP), RFC 6298 (RTO), RFC 5681 (Congestion Control)
+ * All TCP state is protected by a single lock.  The API functions
+ * block, but only ever on that lock and the PCB's condition
+ * variables, so they may be called from any kernel thread.
+ * Segments are processed by the network input thread, which also
+ * calls tcp_timer() once per timer tick.
  */
 
 #ifndef NET_TRANSPORT_TCP_H
@@ -77,6 +73,12 @@ struct tcp_hdr {
 /* Macro to get data offset in bytes */
 #define TCP_DATA_OFFSET(hdr) (((hdr)->data_offset >> 4) * 4)
 
+/* Buffer sizes per connection.  Both must be powers of 2.  A
+   receive buffer over 65535 bytes is advertised with the window
+   scale option. */
+#define TCP_SND_BUF_SIZE 65536
+#define TCP_RCV_BUF_SIZE 65536
+
 /**
  * @brief TCP connection states.
  *
@@ -120,14 +122,62 @@ enum tcp_state {
  */
 const char* tcp_state_name(enum tcp_state state);
 
+/* Why a connection failed. */
+#define TCP_ERR_RESET 1   /* Peer sent RST. */
+#define TCP_ERR_REFUSED 2 /* Peer answered our SYN with RST. */
+#define TCP_ERR_TIMEOUT 3 /* Retransmissions went unanswered. */
+
+struct tcp_pcb;
+
+/**
+ * @brief Congestion control algorithm.
+ *
+ * The core detects loss, runs fast retransmit and recovery and the
+ * retransmission timer; the algorithm decides how fast the
+ * congestion window grows and how far it falls.  Hooks run with
+ * the TCP lock held and may keep private state in pcb->cc_priv,
+ * which is zeroed before init() is called.
+ */
+struct tcp_cc_ops {
+  const char* name;
+
+  /* Sets up a newly established connection.  cwnd and ssthresh
+     already hold the RFC 5681 initial values.  Optional. */
+  void (*init)(struct tcp_pcb* pcb);
+
+  /* Grows cwnd for an ACK that acknowledged ACKED new bytes,
+     outside fast recovery. */
+  void (*cong_avoid)(struct tcp_pcb* pcb, uint32_t acked);
+
+  /* Returns the slow start threshold to use after a loss, detected
+     either by duplicate ACKs or by a retransmission timeout. */
+  uint32_t (*ssthresh)(struct tcp_pcb* pcb);
+};
+
+/* Words of per-connection state for the congestion control
+   algorithm. */
+#define TCP_CC_PRIV_WORDS 16
+
+/**
+ * @brief Per-connection counters.
+ */
+struct tcp_stats {
+  uint32_t segs_out;         /* Segments sent, including retransmissions. */
+  uint32_t segs_in;          /* Segments received. */
+  uint32_t retransmits;      /* Segments sent more than once. */
+  uint32_t fast_retransmits; /* Fast recoveries entered. */
+  uint32_t timeouts;         /* Retransmission timer expirations. */
+};
+
 /**
  * @brief TCP Protocol Control Block.
  *
  * This structure maintains all state for a single TCP connection.
- * It's the most important data structure in TCP.
+ * All members are protected by the TCP lock.
  */
 struct tcp_pcb {
-  /* Connection identification (socket pair) */
+  /* Connection identification (socket pair).  Addresses are in
+     network byte order, ports in host byte order. */
   uint32_t local_ip;
   uint16_t local_port;
   uint32_t remote_ip;
@@ -135,6 +185,8 @@ struct tcp_pcb {
 
   /* State machine */
   enum tcp_state state;
+  unsigned flags; /* TF_* flags, private to tcp.c. */
+  int error;      /* TCP_ERR_* once the connection failed, else 0. */
 
   /*
    * Send Sequence Space (RFC 793):
@@ -148,12 +200,16 @@ struct tcp_pcb {
    * 3 - Sequence numbers allowed for new data
    * 4 - Future sequence numbers not allowed
    */
-  uint32_t snd_una; /* Send unacknowledged */
-  uint32_t snd_nxt; /* Send next */
-  uint32_t snd_wnd; /* Send window (from receiver) */
-  uint32_t snd_wl1; /* Segment seq for last window update */
-  uint32_t snd_wl2; /* Segment ack for last window update */
-  uint32_t iss;     /* Initial send sequence number */
+  uint32_t snd_una;   /* Send unacknowledged */
+  uint32_t snd_nxt;   /* Send next */
+  uint32_t snd_max;   /* Highest sequence number sent, plus 1 */
+  uint32_t snd_end;   /* End of data queued by the application */
+  uint32_t snd_wnd;   /* Send window (from receiver), scaled */
+  uint32_t snd_wl1;   /* Segment seq for last window update */
+  uint32_t snd_wl2;   /* Segment ack for last window update */
+  uint32_t iss;       /* Initial send sequence number */
+  uint16_t mss;       /* Largest segment to send */
+  uint8_t snd_wscale; /* Peer's window scale shift */
 
   /*
    * Receive Sequence Space (RFC 793):
@@ -166,36 +222,57 @@ struct tcp_pcb {
    * 2 - Sequence numbers allowed for new reception
    * 3 - Future sequence numbers not yet allowed
    */
-  uint32_t rcv_nxt; /* Receive next */
-  uint32_t rcv_wnd; /* Receive window (our buffer) */
-  uint32_t irs;     /* Initial receive sequence number */
-
-  /* Buffers - YOU IMPLEMENT THESE */
-  void* send_buf; /* Send buffer (retransmission) */
-  void* recv_buf; /* Receive buffer (reordering) */
-
-  /* Timer state - YOU IMPLEMENT THESE */
-  int64_t rto;    /* Retransmission timeout (ticks) */
-  int64_t srtt;   /* Smoothed RTT (scaled) */
-  int64_t rttvar; /* RTT variance (scaled) */
-
-  /* Congestion control - YOU IMPLEMENT THESE */
+  uint32_t rcv_nxt;   /* Receive next */
+  uint32_t rcv_adv;   /* Right edge of the window last advertised */
+  uint32_t rcv_user;  /* Next byte the application reads */
+  uint32_t irs;       /* Initial receive sequence number */
+  uint32_t fin_seq;   /* Sequence number of a FIN received early */
+  uint8_t rcv_wscale; /* Our window scale shift */
+  uint8_t ack_pending; /* Segments received but not yet ACKed */
+
+  /* Buffers, allocated when the connection is opened. */
+  uint8_t* send_buf; /* TCP_SND_BUF_SIZE bytes */
+  uint8_t* recv_buf; /* TCP_RCV_BUF_SIZE bytes */
+  struct list ooseq; /* Out-of-order ranges in recv_buf, by seq */
+
+  /* Timer deadlines, in timer ticks, or 0 if not running. */
+  int64_t rtx_timer; /* Retransmission (or persist) timer */
+  int64_t ack_timer; /* Delayed ACK */
+  int64_t tw_timer;  /* 2*MSL wait in TIME_WAIT */
+  int nrtx;          /* Consecutive retransmission timeouts */
+
+  /* RTT estimation (RFC 6298), in timer ticks. */
+  int64_t rto;       /* Retransmission timeout */
+  int64_t srtt;      /* Smoothed RTT, times 8 */
+  int64_t rttvar;    /* RTT variance, times 4 */
+  int64_t rtt_start; /* When the timed segment was sent, or 0 */
+  uint32_t rtt_seq;  /* Sequence number of the timed segment */
+
+  /* Congestion control */
   uint32_t cwnd;     /* Congestion window */
   uint32_t ssthresh; /* Slow start threshold */
+  uint32_t recover;  /* snd_max when fast recovery began */
+  unsigned dupacks;  /* Consecutive duplicate ACKs */
+  const struct tcp_cc_ops* cc;
+  uint32_t cc_priv[TCP_CC_PRIV_WORDS];
+
+  struct tcp_stats stats;
 
   /* For LISTEN sockets */
-  struct list accept_queue; /* Completed connections */
-  int backlog;              /* Max pending connections */
-  struct tcp_pcb* parent;   /* Parent listening socket */
+  struct list accept_queue;    /* Completed connections */
+  int backlog;                 /* Max pending connections */
+  int pending;                 /* Connections not yet accepted */
+  struct tcp_pcb* parent;      /* Listener, until accepted */
+  struct list_elem accept_elem; /* In parent's accept_queue */
 
-  /* Synchronization */
-  struct lock lock;
+  /* Synchronization, all on the TCP lock */
   struct condition connect_cond;
   struct condition accept_cond;
   struct condition send_cond;
   struct condition recv_cond;
 
-  /* Reference counting */
+  /* Reference counting: one for the application, one while a
+     connection is open */
   int refcount;
 
   struct list_elem elem; /* In global PCB list */
@@ -212,8 +289,6 @@ void tcp_init(void);
  * @param p Packet buffer with TCP segment.
  * @param src_ip Source IP address.
  * @param dst_ip Destination IP address.
- *
- * TODO: Implement this function
  */
 void tcp_input(struct netdev* dev, struct pbuf* p, uint32_t src_ip, uint32_t dst_ip);
 
@@ -226,52 +301,93 @@ struct tcp_pcb* tcp_new(void);
 /**
  * @brief Free a TCP PCB.
  * @param pcb PCB to free.
+ *
+ * Aborts the connection, as tcp_abort(), if one is open.
  */
 void tcp_free(struct tcp_pcb* pcb);
 
 /**
  * @brief Bind TCP PCB to local address/port.
+ * @return 0 on success, -1 if the port is in use.
+ *
+ * Port 0 picks an unused ephemeral port.
  */
 int tcp_bind(struct tcp_pcb* pcb, uint32_t ip, uint16_t port);
 
 /**
  * @brief Put PCB in LISTEN state.
+ * @return 0 on success, -1 if the PCB is not bound and closed.
  */
 int tcp_listen(struct tcp_pcb* pcb, int backlog);
 
 /**
  * @brief Accept incoming connection (blocking).
+ * @return New PCB, or NULL if the listener was closed.
  */
 struct tcp_pcb* tcp_accept(struct tcp_pcb* pcb);
 
 /**
- * @brief Initiate connection to remote host.
+ * @brief Initiate connection to remote host (blocking).
+ * @return 0 once established, -1 if refused or timed out.
  */
 int tcp_connect(struct tcp_pcb* pcb, uint32_t ip, uint16_t port);
 
 /**
  * @brief Send data on established connection.
+ * @return LEN once all of it is queued, or -1 if the connection
+ *         cannot send.
+ *
+ * Blocks while the send buffer is full.
  */
 int tcp_send(struct tcp_pcb* pcb, const void* data, size_t len);
 
 /**
  * @brief Receive data from connection (blocking).
+ * @return Bytes received, 0 at end of stream, or -1 if the
+ *         connection was reset.
  */
 int tcp_recv(struct tcp_pcb* pcb, void* buf, size_t len);
 
 /**
  * @brief Close connection.
+ * @return 0.
+ *
+ * Sends a FIN after any queued data and returns at once; the stack
+ * finishes the close and frees the PCB, which the caller must no
+ * longer use.  Unread received data makes it an abort instead.
  */
 int tcp_close(struct tcp_pcb* pcb);
 
 /**
  * @brief Abort connection (send RST).
+ *
+ * Frees the PCB, which the caller must no longer use.
  */
 void tcp_abort(struct tcp_pcb* pcb);
 
 /**
- * @brief TCP timer callback (called periodically).
+ * @brief TCP timer callback, called once per timer tick.
  */
 void tcp_timer(void);
 
+/**
+ * @brief Register a congestion control algorithm.
+ * @return 0 on success, -1 if the table is full.
+ */
+int tcp_cc_register(const struct tcp_cc_ops* ops);
+
+/**
+ * @brief Select PCB's congestion control algorithm by name.
+ * @return 0 on success, -1 if no such algorithm is registered or
+ *         the PCB is already connected.
+ *
+ * Connections accepted on a listener inherit its algorithm.
+ */
+int tcp_set_cc(struct tcp_pcb* pcb, const char* name);
+
+/**
+ * @brief NewReno (RFC 5681, RFC 6582), the default algorithm.
+ */
+extern const struct tcp_cc_ops tcp_newreno;
+
 #endif /* NET_TRANSPORT_TCP_H */
@@ -4,24 +4,12 @@
  */
 
 #include "net/util/checksum.h"
+#include <bulk.h>
 #include "net/util/byteorder.h"
 
 uint32_t checksum_partial(const void* data, size_t len, uint32_t sum) {
-  const uint8_t* bytes = data;
-
-  /* Sum 16-bit words */
-  while (len >= 2) {
-    sum += (bytes[0] << 8) | bytes[1];
-    bytes += 2;
-    len -= 2;
-  }
-
-  /* Handle odd byte */
-  if (len > 0) {
-    sum += bytes[0] << 8;
-  }
-
-  return sum;
+  /* Sum 16-bit words, with SSE2 where available */
+  return bulk_csum(data, len, sum);
 }
 
 uint16_t checksum_finish(uint32_t sum) {
@@ -19,7 +19,8 @@
  * @param sum Initial/accumulated sum (pass 0 to start fresh).
  * @return Accumulated checksum (not yet folded or complemented).
  *
- * Call multiple times to checksum non-contiguous data, then
+ * The result folds to the same value as a plain sum of the words but
+ * may differ from it before folding.  Call multiple times to checksum non-contiguous data, then
  * call checksum_finish() on the final sum.
  */
 uint32_t checksum_partial(const void* data, size_t len, uint32_t sum);
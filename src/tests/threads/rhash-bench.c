@@ -0,0 +1,199 @@
+/* Compares the chained hash table in lib/kernel/hash.c with the
+   open-addressing one in lib/kernel/rhash.c on the workload of a
+   supplemental page table: keys are page-aligned user addresses,
+   inserted, looked up (hits and misses), then deleted.  Checks that
+   both tables give the right answers and reports the cycles each
+   operation takes on average. */
+
+#include <hash.h>
+#include <rhash.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "arch/common/cpu.h"
+
+#define PAGE_CNT 2048
+#define BASE_ADDR 0x08048000
+
+struct page {
+  struct hash_elem hash_elem; /* For the chained table. */
+  void* upage;                /* Key. */
+};
+
+/* PAGE_CNT pages, allocated by the test so they take no room in the
+   kernel image. */
+static struct page* pages;
+
+/* Returns the address of the I'th page.  Pages come in runs of 16,
+   as code, data and stack regions would, with gaps between runs. */
+static void* page_addr(int i) { return (void*)(BASE_ADDR + (uintptr_t)(i / 16 * 64 + i % 16) * PGSIZE); }
+
+/* Returns an address near the I'th page that is never a key. */
+static void* missing_addr(int i) { return (uint8_t*)page_addr(i) + 32 * PGSIZE; }
+
+static unsigned chain_hash(const struct hash_elem* e, void* aux UNUSED) {
+  struct page* p = hash_entry(e, struct page, hash_elem);
+  return hash_bytes(&p->upage, sizeof p->upage);
+}
+
+static bool chain_less(const struct hash_elem* a, const struct hash_elem* b, void* aux UNUSED) {
+  return hash_entry(a, struct page, hash_elem)->upage < hash_entry(b, struct page, hash_elem)->upage;
+}
+
+static struct page* chain_find(struct hash* h, void* upage) {
+  struct page key;
+  struct hash_elem* e;
+
+  key.upage = upage;
+  e = hash_find(h, &key.hash_elem);
+  return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
+}
+
+static unsigned open_hash(const void* upage) { return rhash_int(pg_no(upage)); }
+
+static bool open_eq(const void* p, const void* key, void* aux UNUSED) {
+  return ((const struct page*)p)->upage == key;
+}
+
+/* Checks that the table answers correctly while it is growing, when
+   elements are split between the old and new arrays: after each
+   insertion that leaves a move in progress, every key inserted so
+   far is found or, if deleted, missed.  Right after each grow starts,
+   a few of the oldest keys, which are still in the old array, are
+   deleted. */
+static void check_migration(void) {
+  bool* live = malloc(PAGE_CNT * sizeof *live);
+  struct rhash h;
+  int i, j, checks = 0, deletes = 0;
+
+  if (live == NULL)
+    fail("out of memory");
+  rhash_init(&h, open_eq, NULL);
+  for (i = 0; i < PAGE_CNT; i++) {
+    bool was_growing = h.old != NULL;
+
+    if (!rhash_insert(&h, open_hash(pages[i].upage), pages[i].upage, &pages[i]))
+      fail("rhash: inserting page %d failed", i);
+    live[i] = true;
+    if (h.old == NULL)
+      continue;
+
+    if (!was_growing) {
+      /* Each deletion moves more slots, so stop after a few. */
+      int cnt = 0;
+      for (j = 0; j < i && h.old != NULL && cnt < 8; j += 3) {
+        if (!live[j])
+          continue;
+        if (rhash_delete(&h, open_hash(pages[j].upage), pages[j].upage) != &pages[j])
+          fail("rhash: page %d missing on delete during a move", j);
+        if (rhash_delete(&h, open_hash(pages[j].upage), pages[j].upage) != NULL)
+          fail("rhash: page %d deleted twice during a move", j);
+        live[j] = false;
+        cnt++;
+      }
+      deletes += cnt;
+    }
+
+    for (j = 0; j <= i; j++) {
+      void* miss = missing_addr(j);
+      void* want = live[j] ? &pages[j] : NULL;
+      if (rhash_find(&h, open_hash(pages[j].upage), pages[j].upage) != want ||
+          rhash_find(&h, open_hash(miss), miss) != NULL)
+        fail("rhash: wrong result for page %d during a move", j);
+    }
+    checks++;
+  }
+  if (checks == 0 || deletes == 0)
+    fail("rhash: no lookups or deletions happened during a move");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (live[i] && rhash_delete(&h, open_hash(pages[i].upage), pages[i].upage) != &pages[i])
+      fail("rhash: page %d missing on delete", i);
+  if (rhash_size(&h) != 0)
+    fail("rhash: %zu elements left after deleting every page", rhash_size(&h));
+  rhash_destroy(&h, NULL);
+  free(live);
+}
+
+static void report(const char* op, uint64_t chain, uint64_t open) {
+  msg("%-6s hash %5llu cycles, rhash %5llu cycles", op, (unsigned long long)(chain / PAGE_CNT),
+      (unsigned long long)(open / PAGE_CNT));
+}
+
+void test_rhash_bench(void) {
+  struct hash chain;
+  struct rhash open;
+  uint64_t start, chain_ins, chain_find_t, chain_del, open_ins, open_find_t, open_del;
+  int i;
+
+  pages = malloc(PAGE_CNT * sizeof *pages);
+  if (pages == NULL)
+    fail("out of memory");
+  for (i = 0; i < PAGE_CNT; i++)
+    pages[i].upage = page_addr(i);
+  check_migration();
+
+  hash_init(&chain, chain_hash, chain_less, NULL);
+  rhash_init(&open, open_eq, NULL);
+
+  /* Insert. */
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (hash_insert(&chain, &pages[i].hash_elem) != NULL)
+      fail("hash: page %d inserted twice", i);
+  chain_ins = cpu_cycles() - start;
+
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (!rhash_insert(&open, open_hash(pages[i].upage), pages[i].upage, &pages[i]))
+      fail("rhash: inserting page %d failed", i);
+  open_ins = cpu_cycles() - start;
+
+  if (rhash_insert(&open, open_hash(pages[0].upage), pages[0].upage, &pages[0]))
+    fail("rhash: duplicate insertion succeeded");
+  if (hash_size(&chain) != PAGE_CNT || rhash_size(&open) != PAGE_CNT)
+    fail("sizes %zu and %zu, expected %d", hash_size(&chain), rhash_size(&open), PAGE_CNT);
+
+  /* Find every key and miss as often. */
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (chain_find(&chain, page_addr(i)) != &pages[i] || chain_find(&chain, missing_addr(i)) != NULL)
+      fail("hash: wrong result for page %d", i);
+  chain_find_t = cpu_cycles() - start;
+
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++) {
+    void* hit = page_addr(i);
+    void* miss = missing_addr(i);
+    if (rhash_find(&open, open_hash(hit), hit) != &pages[i] ||
+        rhash_find(&open, open_hash(miss), miss) != NULL)
+      fail("rhash: wrong result for page %d", i);
+  }
+  open_find_t = cpu_cycles() - start;
+
+  /* Delete. */
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (hash_delete(&chain, &pages[i].hash_elem) == NULL)
+      fail("hash: page %d missing on delete", i);
+  chain_del = cpu_cycles() - start;
+
+  start = cpu_cycles();
+  for (i = 0; i < PAGE_CNT; i++)
+    if (rhash_delete(&open, open_hash(pages[i].upage), pages[i].upage) != &pages[i])
+      fail("rhash: page %d missing on delete", i);
+  open_del = cpu_cycles() - start;
+
+  if (hash_size(&chain) != 0 || rhash_size(&open) != 0)
+    fail("tables not empty after deleting every page");
+
+  report("insert", chain_ins, open_ins);
+  report("find", chain_find_t, open_find_t);
+  report("delete", chain_del, open_del);
+
+  hash_destroy(&chain, NULL);
+  rhash_destroy(&open, NULL);
+  free(pages);
+  pass();
+}
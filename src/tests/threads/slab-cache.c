@@ -0,0 +1,74 @@
+/* Allocates and frees objects from a slab cache with a
+   constructor and checks that objects do not overlap, that the
+   constructor runs once per object rather than once per
+   allocation, and that freed objects come back constructed. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+
+#define OBJ_CNT 300
+#define OBJ_MAGIC 0x0b1ec7
+
+struct obj {
+  unsigned magic; /* OBJ_MAGIC once constructed. */
+  int owner;      /* Index of the allocation using this object. */
+  char pad[40];
+};
+
+static int ctor_cnt;
+
+static void obj_ctor(void* obj_, void* aux) {
+  struct obj* obj = obj_;
+  obj->magic = *(unsigned*)aux;
+  obj->owner = -1;
+  ctor_cnt++;
+}
+
+static struct slab_cache cache;
+static struct obj* objs[OBJ_CNT];
+
+void test_slab_cache(void) {
+  static unsigned magic = OBJ_MAGIC;
+  int i, round;
+
+  slab_cache_init(&cache, "slab-cache test", sizeof(struct obj), obj_ctor, &magic);
+
+  for (round = 0; round < 2; round++) {
+    for (i = 0; i < OBJ_CNT; i++) {
+      objs[i] = slab_alloc(&cache);
+      if (objs[i] == NULL)
+        fail("round %d: allocation %d failed", round, i);
+      if (objs[i]->magic != OBJ_MAGIC || objs[i]->owner != -1)
+        fail("round %d: object %d not in constructed state", round, i);
+      objs[i]->owner = i;
+    }
+
+    /* A fresh cache constructs whole slabs, and no more than needed. */
+    if (round == 0 && (ctor_cnt < OBJ_CNT || ctor_cnt >= OBJ_CNT + (int)cache.objs_per_slab))
+      fail("constructor ran %d times for %d objects", ctor_cnt, OBJ_CNT);
+
+    /* Every object must still belong to the allocation that got it. */
+    for (i = 0; i < OBJ_CNT; i++)
+      if (objs[i]->owner != i)
+        fail("round %d: object %d overwritten by %d", round, i, objs[i]->owner);
+
+    /* Return objects in constructed state, in an order that leaves
+       slabs partially used for a while. */
+    for (i = 0; i < OBJ_CNT; i += 2) {
+      objs[i]->owner = -1;
+      slab_free(&cache, objs[i]);
+    }
+    for (i = 1; i < OBJ_CNT; i += 2) {
+      objs[i]->owner = -1;
+      slab_free(&cache, objs[i]);
+    }
+    msg("round %d: %d objects allocated and freed", round, OBJ_CNT);
+  }
+
+  /* Reused objects are not constructed again. */
+  if (ctor_cnt % cache.objs_per_slab != 0)
+    fail("constructor ran %d times, not a whole number of slabs", ctor_cnt);
+  pass();
+}
@@ -0,0 +1,118 @@
+/* Sends a bulk stream over a TCP connection on the loopback device
+   and checks that every byte arrives, in order, followed by the
+   end of the stream.  Runs once on a clean link and once with the
+   loopback device dropping 1% of packets, and reports the
+   throughput and retransmissions of each run. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+#include "net/driver/loopback.h"
+#include "net/inet/ip.h"
+#include "net/transport/tcp.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define PORT 5001
+#define CHUNK 4096
+
+struct receiver {
+  struct tcp_pcb* listener;
+  size_t size;              /* Bytes to expect. */
+  struct semaphore received; /* Upped when all SIZE bytes arrived. */
+  struct semaphore done;     /* Upped after the end of the stream. */
+};
+
+static uint8_t chunk[CHUNK];
+
+/* Returns the byte at offset I of the stream.  251 is prime, so a
+   misplaced chunk never matches. */
+static uint8_t pattern(size_t i) { return i % 251; }
+
+static void receive_thread(void* r_) {
+  struct receiver* r = r_;
+  struct tcp_pcb* conn;
+  size_t total = 0;
+  int n, i;
+
+  conn = tcp_accept(r->listener);
+  if (conn == NULL)
+    fail("accept failed");
+
+  while (total < r->size) {
+    n = tcp_recv(conn, chunk, sizeof chunk);
+    if (n <= 0)
+      fail("recv returned %d after %zu bytes", n, total);
+    for (i = 0; i < n; i++)
+      if (chunk[i] != pattern(total + i))
+        fail("byte %zu is %d, expected %d", total + i, chunk[i], pattern(total + i));
+    total += n;
+  }
+  sema_up(&r->received);
+
+  n = tcp_recv(conn, chunk, sizeof chunk);
+  if (n != 0)
+    fail("recv returned %d at the end of the stream", n);
+  tcp_close(conn);
+  sema_up(&r->done);
+}
+
+/* Sends SIZE bytes to the listener through a link that drops LOSS
+   packets per thousand, and reports the results as NAME. */
+static void run(struct tcp_pcb* listener, const char* name, size_t size, unsigned loss) {
+  static uint8_t data[CHUNK];
+  struct receiver r;
+  struct tcp_pcb* conn;
+  struct tcp_stats stats;
+  int64_t start, ticks;
+  size_t sent, i;
+
+  r.listener = listener;
+  r.size = size;
+  sema_init(&r.received, 0);
+  sema_init(&r.done, 0);
+  thread_create("receiver", PRI_DEFAULT, receive_thread, &r);
+
+  loopback_set_loss(loss);
+  conn = tcp_new();
+  if (conn == NULL || tcp_connect(conn, ip_addr_from_str("127.0.0.1"), PORT) != 0)
+    fail("%s: connect failed", name);
+
+  start = timer_ticks();
+  for (sent = 0; sent < size; sent += CHUNK) {
+    for (i = 0; i < CHUNK; i++)
+      data[i] = pattern(sent + i);
+    if (tcp_send(conn, data, CHUNK) != CHUNK)
+      fail("%s: send failed after %zu bytes", name, sent);
+  }
+  sema_down(&r.received);
+  ticks = timer_elapsed(start);
+  if (ticks < 1)
+    ticks = 1;
+
+  /* The connection is gone once closed. */
+  stats = conn->stats;
+  tcp_close(conn);
+  sema_down(&r.done);
+  loopback_set_loss(0);
+
+  msg("%-5s %zu KB in %lld ms, %lld KB/s, %u retransmits (%u fast, %u timeouts)", name,
+      size / 1024, (long long)ticks * 1000 / TIMER_FREQ,
+      (long long)size * TIMER_FREQ / ticks / 1024, stats.retransmits, stats.fast_retransmits,
+      stats.timeouts);
+}
+
+void test_tcp_bench(void) {
+  struct tcp_pcb* listener;
+
+  listener = tcp_new();
+  if (listener == NULL || tcp_bind(listener, 0, PORT) != 0 || tcp_listen(listener, 1) != 0)
+    fail("cannot listen on port %d", PORT);
+
+  run(listener, "clean", 2 * 1024 * 1024, 0);
+  run(listener, "lossy", 512 * 1024, 10);
+
+  tcp_close(listener);
+  pass();
+}
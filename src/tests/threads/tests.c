@@ -52,7 +52,14 @@ static const struct test threads_tests[] = {
     {"smfs-hierarchy-32", test_smfs_hierarchy_32},
     {"smfs-hierarchy-64", test_smfs_hierarchy_64},
     {"smfs-hierarchy-256", test_smfs_hierarchy_256},
-    {"fair-vruntime", test_fair_vruntime}};
+    {"fair-vruntime", test_fair_vruntime},
+    {"slab-cache", test_slab_cache},
+    {"rhash-bench", test_rhash_bench},
+    {"bulk-bench", test_bulk_bench},
+#ifdef ARCH_I386
+    {"tcp-bench", test_tcp_bench},
+#endif
+};
 
 /* Runs the threads test named NAME. */
 void run_threads_test(const char* name) {
@@ -54,5 +54,11 @@ extern test_func test_smfs_hierarchy_32;
 extern test_func test_smfs_hierarchy_64;
 extern test_func test_smfs_hierarchy_256;
 extern test_func test_fair_vruntime;
+extern test_func test_slab_cache;
+extern test_func test_rhash_bench;
+extern test_func test_bulk_bench;
+#ifdef ARCH_I386
+extern test_func test_tcp_bench;
+#endif
 
 #endif /* tests/threads/tests.h */
@@ -0,0 +1,25 @@
+/* Copies "sample.txt" into a new file with copy_file_range(), in two
+   pieces, and checks the copy and both file positions. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  int size = sizeof sample - 1;
+  int in_fd, out_fd;
+
+  CHECK((in_fd = open("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK(create("copy.txt", 0), "create \"copy.txt\"");
+  CHECK((out_fd = open("copy.txt")) > 1, "open \"copy.txt\"");
+
+  CHECK(copy_file_range(in_fd, out_fd, 100) == 100, "copy 100 bytes");
+  CHECK(copy_file_range(in_fd, out_fd, 4096) == size - 100, "copy the rest");
+  CHECK(copy_file_range(in_fd, out_fd, 4096) == 0, "copy at end of file");
+  CHECK((int)tell(in_fd) == size && (int)tell(out_fd) == size, "positions advanced");
+  CHECK(copy_file_range(out_fd, out_fd, 10) == -1, "overlapping copy fails");
+
+  seek(out_fd, 0);
+  check_file_handle(out_fd, "copy.txt", sample, size);
+}
@@ -0,0 +1,53 @@
+/* Watches many pipes with one epoll instance while a child writes to a
+   few of them, and checks that exactly those are reported. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PIPES 64
+
+static int fds[PIPES][2];
+
+void test_main(void) {
+  static const int targets[] = {5, 17, 42};
+  struct epoll_event ev, out[8];
+  bool seen[PIPES] = {false};
+  int ep, seen_cnt = 0;
+
+  CHECK((ep = epoll_create()) > 2, "epoll_create()");
+  for (int i = 0; i < PIPES; i++) {
+    if (pipe(fds[i]) != 0)
+      fail("pipe %d failed", i);
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, fds[i][0], &ev) != 0)
+      fail("epoll_ctl %d failed", i);
+  }
+  msg("watching %d pipes", PIPES);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    for (int i = 0; i < 3; i++)
+      write(fds[targets[i]][1], "x", 1);
+    exit(0);
+  }
+
+  /* Drain each pipe as it is reported so it is not reported again. */
+  while (seen_cnt < 3) {
+    int n = epoll_wait(ep, out, 8, -1);
+    if (n <= 0)
+      fail("epoll_wait returned %d", n);
+    for (int i = 0; i < n; i++) {
+      uint32_t p = out[i].data.u32;
+      char c;
+      if (p >= PIPES || seen[p] || read(fds[p][0], &c, 1) != 1)
+        fail("unexpected event for pipe %u", p);
+      seen[p] = true;
+      seen_cnt++;
+    }
+  }
+  wait(pid);
+  CHECK(seen[5] && seen[17] && seen[42], "pipes 5, 17 and 42 reported");
+  CHECK(epoll_wait(ep, out, 8, 0) == 0, "nothing else ready");
+}
@@ -0,0 +1,68 @@
+/* Checks level-triggered, edge-triggered, and one-shot epoll reporting
+   on a pipe, and hangup and removal. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Returns the number of events epoll_wait() reports without waiting. */
+static int ready(int ep, struct epoll_event* out) { return epoll_wait(ep, out, 4, 0); }
+
+static void set_events(int ep, int fd, int op, uint32_t events) {
+  struct epoll_event ev;
+  ev.events = events;
+  ev.data.u32 = 7;
+  CHECK(epoll_ctl(ep, op, fd, &ev) == 0, "epoll_ctl(%s)", op == EPOLL_CTL_ADD ? "add" : "mod");
+}
+
+void test_main(void) {
+  struct epoll_event out[4];
+  int fds[2];
+  char buf[4];
+  int ep;
+
+  CHECK((ep = epoll_create()) > 2, "epoll_create()");
+  CHECK(pipe(fds) == 0, "pipe()");
+  set_events(ep, fds[0], EPOLL_CTL_ADD, EPOLLIN);
+  CHECK(epoll_ctl(ep, EPOLL_CTL_ADD, fds[0], &out[0]) == -1, "second add fails");
+  CHECK(ready(ep, out) == 0, "nothing ready");
+
+  /* Level-triggered: reported until drained. */
+  write(fds[1], "ab", 2);
+  CHECK(ready(ep, out) == 1 && out[0].events == EPOLLIN && out[0].data.u32 == 7, "level ready");
+  CHECK(ready(ep, out) == 1, "level ready again");
+  read(fds[0], buf, 2);
+  CHECK(ready(ep, out) == 0, "level idle after drain");
+
+  /* Edge-triggered: reported once per arrival. */
+  set_events(ep, fds[0], EPOLL_CTL_MOD, EPOLLIN | EPOLLET);
+  write(fds[1], "c", 1);
+  CHECK(ready(ep, out) == 1, "edge ready");
+  CHECK(ready(ep, out) == 0, "edge not repeated");
+  write(fds[1], "d", 1);
+  CHECK(ready(ep, out) == 1, "edge ready on new data");
+  read(fds[0], buf, 2);
+
+  /* One-shot: reported once until modified. */
+  set_events(ep, fds[0], EPOLL_CTL_MOD, EPOLLIN | EPOLLONESHOT);
+  write(fds[1], "e", 1);
+  CHECK(ready(ep, out) == 1, "one-shot ready");
+  write(fds[1], "f", 1);
+  CHECK(ready(ep, out) == 0, "one-shot disabled");
+  set_events(ep, fds[0], EPOLL_CTL_MOD, EPOLLIN | EPOLLONESHOT);
+  CHECK(ready(ep, out) == 1, "one-shot rearmed");
+  read(fds[0], buf, 2);
+
+  /* Hangup is reported without being asked for. */
+  close(fds[1]);
+  set_events(ep, fds[0], EPOLL_CTL_MOD, EPOLLIN);
+  CHECK(ready(ep, out) == 1 && out[0].events == EPOLLHUP, "hangup reported");
+  CHECK(epoll_ctl(ep, EPOLL_CTL_DEL, fds[0], NULL) == 0, "epoll_ctl(del)");
+  CHECK(ready(ep, out) == 0, "nothing ready after removal");
+
+  /* Closing a watched descriptor removes it. */
+  set_events(ep, fds[0], EPOLL_CTL_ADD, EPOLLIN);
+  close(fds[0]);
+  CHECK(ready(ep, out) == 0, "nothing ready after close");
+  close(ep);
+}
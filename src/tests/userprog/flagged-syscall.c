@@ -0,0 +1,37 @@
+/* Makes system calls with extra EFLAGS bits set as the kernel is
+   entered, for the tests of how the entry paths treat the
+   caller's flags. */
+
+#include "tests/userprog/flagged-syscall.h"
+#include <sysenter.h>
+
+/* Invokes system call NUMBER with arguments ARG0, ARG1 and ARG2,
+   with FLAGS set in EFLAGS by the instruction just before the one
+   that enters the kernel, so that a trap flag takes effect only
+   once the call has entered the kernel.  Uses SYSENTER if the CPU
+   has it, otherwise "int $0x30". */
+int flagged_syscall(uint32_t flags, int number, uint32_t arg0, uint32_t arg1, uint32_t arg2) {
+  int retval;
+  uint32_t edx;
+
+  if (sysenter_available())
+    asm volatile("pushfl; orl %%ecx, (%%esp); movl %%esp, %%ecx; addl $4, %%ecx; "
+                 "movl $1f, %%edx; popfl; sysenter; 1:"
+                 : "=a"(retval), "+c"(flags), "=d"(edx)
+                 : "a"(number), "b"(arg0), "S"(arg1), "D"(arg2)
+                 : "memory", "cc");
+  else
+    asm volatile("pushl %%edi; pushl %%esi; pushl %%ebx; pushl %%eax; "
+                 "pushfl; orl %%ecx, (%%esp); popfl; int $0x30; addl $16, %%esp"
+                 : "=a"(retval)
+                 : "a"(number), "b"(arg0), "S"(arg1), "D"(arg2), "c"(flags)
+                 : "memory", "cc");
+  return retval;
+}
+
+/* Returns the current EFLAGS. */
+uint32_t get_flags(void) {
+  uint32_t flags;
+  asm volatile("pushfl; popl %0" : "=r"(flags));
+  return flags;
+}
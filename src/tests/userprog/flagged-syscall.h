@@ -0,0 +1,9 @@
+#ifndef TESTS_USERPROG_FLAGGED_SYSCALL_H
+#define TESTS_USERPROG_FLAGGED_SYSCALL_H
+
+#include <stdint.h>
+
+int flagged_syscall(uint32_t flags, int number, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+uint32_t get_flags(void);
+
+#endif /* tests/userprog/flagged-syscall.h */
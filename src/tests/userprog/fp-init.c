@@ -10,7 +10,7 @@ void test_main(void) {
   test_name = "fp-init";
   uint8_t fpu[FPU_SIZE];
   uint8_t init_fpu[FPU_SIZE];
-  asm("fsave (%0); fninit; fsave (%1)" : : "g"(&fpu), "g"(&init_fpu));
+  asm volatile("fsave %0; fninit; fsave %1" : "=m"(fpu), "=m"(init_fpu));
   compare_bytes(&fpu, &init_fpu, FPU_SIZE, 0, test_name);
   msg("Success!");
   exit(162);
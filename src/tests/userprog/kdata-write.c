@@ -0,0 +1,11 @@
+/* Writes to the kernel data page, which is mapped read-only.
+   This should terminate the process with a -1 exit code. */
+
+#include <kdata.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  ((volatile struct kdata*)KDATA_BASE)->ticks = 0;
+  fail("should have exited with -1");
+}
@@ -0,0 +1,53 @@
+/* Reads the thread identity and clock from the kernel data page
+   and checks them against the equivalent system calls, in the
+   main thread, a second thread, and a forked child. */
+
+#include <pthread.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static pid_t parent_pid;
+static tid_t thread_tid;
+static pid_t thread_pid;
+
+static void thread_function(void* arg UNUSED) {
+  thread_tid = get_tid();
+  thread_pid = get_pid();
+}
+
+void test_main(void) {
+  tid_t tid = get_tid();
+  int64_t start, ticks, ns, prev_ns;
+
+  parent_pid = get_pid();
+  CHECK(tid == sys_get_tid(), "get_tid() matches the system call");
+  CHECK(parent_pid == sys_get_pid(), "get_pid() matches the system call");
+  CHECK(tid == parent_pid, "main thread's TID is the PID");
+  CHECK(get_tick_freq() > 0, "timer frequency is positive");
+
+  /* Spin until the timer ticks, checking that time never goes back. */
+  start = get_ticks();
+  prev_ns = get_time_ns();
+  do {
+    ticks = get_ticks();
+    ns = get_time_ns();
+    if (ticks < start || ns < prev_ns)
+      fail("clock went backward");
+    prev_ns = ns;
+  } while (ticks == start);
+  msg("clock advances monotonically");
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    pid_t child_pid = get_pid();
+    exit(child_pid != parent_pid && child_pid == sys_get_pid() && get_tid() == sys_get_tid() ? 0
+                                                                                            : 1);
+  }
+  CHECK(pid > 0 && wait(pid) == 0, "child sees its own PID");
+
+  tid_t child_tid = pthread_check_create(thread_function, NULL);
+  pthread_check_join(child_tid);
+  CHECK(thread_tid == child_tid && thread_pid == parent_pid,
+        "thread sees its own TID and the process's PID");
+}
@@ -0,0 +1,65 @@
+/* Threads step through several phases separated by a barrier.  After
+   each barrier_wait(), every thread must see the work that all the
+   others did in that phase, and exactly one thread per phase must be
+   told it arrived last. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_THREADS 8
+#define NUM_PHASES 10
+
+// Global variables
+barrier_t barrier;
+lock_t lock;
+int slots[NUM_THREADS];
+int errors;
+int last_arrivals;
+
+void thread_function(void* arg_);
+
+/* Writes its slot for each phase and checks everyone else's */
+void thread_function(void* arg_) {
+  int id = (int)arg_;
+
+  for (int phase = 1; phase <= NUM_PHASES; phase++) {
+    slots[id] = phase;
+    bool last = barrier_wait(&barrier);
+
+    int bad = 0;
+    for (int i = 0; i < NUM_THREADS; i++)
+      if (slots[i] != phase)
+        bad++;
+
+    lock_acquire(&lock);
+    errors += bad;
+    last_arrivals += last;
+    lock_release(&lock);
+
+    /* Nobody starts the next phase until everyone has checked this one */
+    barrier_wait(&barrier);
+  }
+}
+
+void test_main(void) {
+  tid_t tids[NUM_THREADS];
+
+  msg("Main starting");
+  lock_check_init(&lock);
+  if (barrier_init(&barrier, 0))
+    fail("barrier_init accepted a count of 0");
+  if (!barrier_init(&barrier, NUM_THREADS))
+    fail("barrier_init failed");
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    tids[i] = pthread_check_create(thread_function, (void*)i);
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+
+  msg("%d threads finished %d phases", NUM_THREADS, NUM_PHASES);
+  msg("stale slots seen: %d", errors);
+  msg("last arrivals: %d", last_arrivals);
+  msg("Main finishing");
+}
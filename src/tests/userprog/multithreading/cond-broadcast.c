@@ -0,0 +1,59 @@
+/* Threads wait on a condition variable until main sets a flag and
+   broadcasts once; every one of them must wake up. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_THREADS 8
+
+// Global variables
+lock_t lock;
+cond_t go_cond;
+cond_t main_cond;
+bool go;
+int waiting;
+int woken;
+
+void thread_function(void* arg_);
+
+/* Reports in, waits for the go flag, then reports again */
+void thread_function(void* arg_ UNUSED) {
+  lock_acquire(&lock);
+  waiting++;
+  cond_signal(&main_cond, &lock);
+  while (!go)
+    cond_wait(&go_cond, &lock);
+  woken++;
+  cond_signal(&main_cond, &lock);
+  lock_release(&lock);
+}
+
+void test_main(void) {
+  tid_t tids[NUM_THREADS];
+
+  msg("Main starting");
+  lock_check_init(&lock);
+  if (!cond_init(&go_cond) || !cond_init(&main_cond))
+    fail("cond_init failed");
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    tids[i] = pthread_check_create(thread_function, NULL);
+
+  lock_acquire(&lock);
+  while (waiting < NUM_THREADS)
+    cond_wait(&main_cond, &lock);
+  msg("All threads waiting");
+
+  go = true;
+  cond_broadcast(&go_cond, &lock);
+  while (woken < NUM_THREADS)
+    cond_wait(&main_cond, &lock);
+  lock_release(&lock);
+  msg("Broadcast woke %d threads", woken);
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+  msg("Main finishing");
+}
@@ -0,0 +1,41 @@
+/* Creates and joins many short-lived threads a few at a time, so most
+   of them run on kernel threads parked by earlier ones.  Each thread
+   must see its own tid and argument, and tids must never repeat. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <pthread.h>
+#include <syscall.h>
+
+#define NUM_THREADS 1000
+#define BATCH 4
+
+// Global variables
+tid_t seen_tid[NUM_THREADS];
+
+void thread_function(void* arg_);
+
+/* Records the tid this thread sees in its own slot */
+void thread_function(void* arg_) {
+  tid_t* slot = (tid_t*)arg_;
+  *slot = get_tid();
+}
+
+void test_main(void) {
+  tid_t tids[NUM_THREADS];
+  int bad_tid = 0, reused_tid = 0;
+
+  for (int i = 0; i < NUM_THREADS; i += BATCH) {
+    for (int j = i; j < i + BATCH; j++)
+      tids[j] = pthread_check_create(thread_function, &seen_tid[j]);
+    for (int j = i; j < i + BATCH; j++)
+      pthread_check_join(tids[j]);
+  }
+
+  for (int i = 0; i < NUM_THREADS; i++) {
+    bad_tid += seen_tid[i] != tids[i];
+    reused_tid += i > 0 && tids[i] <= tids[i - 1];
+  }
+  msg("Ran %d threads", NUM_THREADS);
+  msg("%d saw the wrong tid, %d got a reused tid", bad_tid, reused_tid);
+}
@@ -0,0 +1,40 @@
+/* Keeps more threads alive at once than the old limit of 127 per
+   process, then joins them all. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <pthread.h>
+
+#define NUM_THREADS 160
+
+// Global variables
+sema_t all_created;
+int ran[NUM_THREADS];
+
+void thread_function(void* arg_);
+
+/* Waits until every thread exists, then marks itself as having run */
+void thread_function(void* arg_) {
+  int* slot = (int*)arg_;
+  sema_down(&all_created);
+  (*slot)++;
+}
+
+void test_main(void) {
+  tid_t tids[NUM_THREADS];
+
+  sema_check_init(&all_created, 0);
+  for (int i = 0; i < NUM_THREADS; i++)
+    tids[i] = pthread_check_create(thread_function, &ran[i]);
+  msg("Created %d threads", NUM_THREADS);
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    sema_up(&all_created);
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+
+  int done = 0;
+  for (int i = 0; i < NUM_THREADS; i++)
+    done += ran[i] == 1;
+  msg("Joined %d threads, %d ran once", NUM_THREADS, done);
+}
@@ -0,0 +1,85 @@
+/* Readers share a reader-writer lock while writers get it alone.
+   Writers keep two counters equal; readers must never see them
+   differ. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_WRITERS 4
+#define NUM_READERS 4
+#define ITERATIONS 200
+
+// Global variables
+rwlock_t rwlock;
+sema_t reading;
+sema_t done_reading;
+int a, b;
+int mismatches;
+
+void holder_function(void* arg_);
+void writer_function(void* arg_);
+void reader_function(void* arg_);
+
+/* Holds a read lock until main, also reading, tells it to stop */
+void holder_function(void* arg_ UNUSED) {
+  rwlock_acquire_read(&rwlock);
+  sema_up(&reading);
+  sema_down(&done_reading);
+  rwlock_release_read(&rwlock);
+}
+
+/* Bumps both counters under the write lock */
+void writer_function(void* arg_ UNUSED) {
+  for (int i = 0; i < ITERATIONS; i++) {
+    rwlock_acquire_write(&rwlock);
+    int x = a;
+    for (volatile int spin = 0; spin < 100; spin++)
+      continue;
+    a = x + 1;
+    b = b + 1;
+    rwlock_release_write(&rwlock);
+  }
+}
+
+/* Checks that the counters match under the read lock */
+void reader_function(void* arg_ UNUSED) {
+  for (int i = 0; i < ITERATIONS; i++) {
+    rwlock_acquire_read(&rwlock);
+    if (a != b)
+      mismatches++;
+    rwlock_release_read(&rwlock);
+  }
+}
+
+void test_main(void) {
+  tid_t tids[NUM_WRITERS + NUM_READERS];
+
+  msg("Main starting");
+  if (!rwlock_init(&rwlock))
+    fail("rwlock_init failed");
+  sema_check_init(&reading, 0);
+  sema_check_init(&done_reading, 0);
+
+  /* Two readers at once */
+  tid_t holder = pthread_check_create(holder_function, NULL);
+  sema_down(&reading);
+  rwlock_acquire_read(&rwlock);
+  msg("Two readers hold the lock");
+  rwlock_release_read(&rwlock);
+  sema_up(&done_reading);
+  pthread_check_join(holder);
+
+  /* Writers exclude readers and each other */
+  for (int i = 0; i < NUM_WRITERS; i++)
+    tids[i] = pthread_check_create(writer_function, NULL);
+  for (int i = 0; i < NUM_READERS; i++)
+    tids[NUM_WRITERS + i] = pthread_check_create(reader_function, NULL);
+  for (int i = 0; i < NUM_WRITERS + NUM_READERS; i++)
+    pthread_check_join(tids[i]);
+
+  msg("a = %d, b = %d", a, b);
+  msg("mismatches: %d", mismatches);
+  msg("Main finishing");
+}
@@ -0,0 +1,30 @@
+/* Creates far more locks and semaphores than the old fixed tables
+   held, then uses each of them. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+
+#define NUM_SYNCH 1000
+
+// Global variables
+lock_t locks[NUM_SYNCH];
+sema_t semaphores[NUM_SYNCH];
+
+void test_main(void) {
+  for (int i = 0; i < NUM_SYNCH; i++) {
+    lock_check_init(&locks[i]);
+    sema_check_init(&semaphores[i], 1);
+  }
+  msg("Created %d locks and %d semaphores", NUM_SYNCH, NUM_SYNCH);
+
+  for (int i = 0; i < NUM_SYNCH; i++) {
+    lock_acquire(&locks[i]);
+    sema_down(&semaphores[i]);
+  }
+  for (int i = 0; i < NUM_SYNCH; i++) {
+    sema_up(&semaphores[i]);
+    lock_release(&locks[i]);
+  }
+  msg("Acquired and released all of them");
+}
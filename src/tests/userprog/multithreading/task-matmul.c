@@ -0,0 +1,36 @@
+/* Multiplies two 32x32 matrices with parallel_for() over the rows of
+   the result, once with each number of workers from 1 to 4, and checks
+   the product every time. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/threads/matmul_data.h"
+#include <string.h>
+#include <task.h>
+
+// Global variables
+short results_data[ARRAY_SIZE];
+
+void matmul_rows(void* aux, size_t lo, size_t hi);
+
+/* Computes rows [LO, HI) of C += A x B */
+void matmul_rows(void* aux UNUSED, size_t lo, size_t hi) {
+  for (size_t j = lo; j < hi; j++)
+    for (size_t k = 0; k < DIM_SIZE; k++)
+      for (size_t i = 0; i < DIM_SIZE; i++)
+        results_data[i + j * DIM_SIZE] +=
+            input1_data[j * DIM_SIZE + k] * input2_data[k * DIM_SIZE + i];
+}
+
+void test_main(void) {
+  for (int workers = 1; workers <= 4; workers++) {
+    memset(results_data, 0, sizeof results_data);
+    task_set_workers(workers);
+    parallel_for(0, DIM_SIZE, 1, matmul_rows, NULL);
+
+    if (verifyDouble(ARRAY_SIZE, results_data, verify_data) == 0)
+      msg("%d workers: Matrix results match expected values.", workers);
+    else
+      msg("%d workers: Matrix results do not match expected values!", workers);
+  }
+}
@@ -0,0 +1,46 @@
+/* Sorts 32768 pseudo-random ints with parallel_sort() and compares the
+   result against qsort() of the same data.  Sorting already sorted and
+   reverse-sorted input must work too. */
+
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <stdlib.h>
+#include <string.h>
+#include <task.h>
+
+#define CNT 32768
+
+// Global variables
+int data[CNT];
+int expected[CNT];
+
+static int compare_ints(const void* a_, const void* b_) {
+  const int* a = a_;
+  const int* b = b_;
+  return *a < *b ? -1 : *a > *b;
+}
+
+/* Sorts DATA in parallel and checks it against EXPECTED. */
+static void check_sort(const char* what) {
+  parallel_sort(data, CNT, sizeof *data, compare_ints);
+  if (memcmp(data, expected, sizeof data))
+    fail("%s input sorted incorrectly", what);
+  msg("sorted %s input", what);
+}
+
+void test_main(void) {
+  struct arc4 arc4;
+
+  arc4_init(&arc4, "foobar", 6);
+  arc4_crypt(&arc4, data, sizeof data);
+  memcpy(expected, data, sizeof data);
+  qsort(expected, CNT, sizeof *expected, compare_ints);
+
+  check_sort("random");
+  check_sort("sorted");
+
+  for (int i = 0; i < CNT; i++)
+    data[i] = expected[CNT - 1 - i];
+  check_sort("reversed");
+}
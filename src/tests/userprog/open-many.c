@@ -0,0 +1,35 @@
+/* Opens more file descriptors than fit in the initial table, then
+   checks that each open() returns the lowest free descriptor and that
+   a descriptor from the grown table still works. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/sample.inc"
+
+#define FD_CNT 1000
+
+void test_main(void) {
+  char c;
+  int i, fd;
+
+  for (i = 0; i < FD_CNT; i++) {
+    fd = open("sample.txt");
+    if (fd != 3 + i)
+      fail("open #%d returned %d, expected %d", i, fd, 3 + i);
+  }
+  msg("open \"sample.txt\" %d times", FD_CNT);
+
+  close(500);
+  close(100);
+  CHECK(open("sample.txt") == 100, "reopen returns 100");
+  CHECK(open("sample.txt") == 500, "reopen returns 500");
+
+  fd = 3 + FD_CNT - 1;
+  CHECK(read(fd, &c, 1) == 1, "read fd %d", fd);
+  if (c != sample[0])
+    fail("read '%c', expected '%c'", c, sample[0]);
+
+  for (i = 0; i < FD_CNT; i++)
+    close(3 + i);
+}
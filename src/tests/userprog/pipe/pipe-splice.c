@@ -0,0 +1,46 @@
+/* Test that splice() moves data from a file through a pipe into another
+   file, and reports end of input once the write end is closed. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE 10000
+
+static char data[DATA_SIZE];
+static char copy[DATA_SIZE];
+
+void test_main(void) {
+  int pipefd[2];
+  int in_fd, out_fd;
+  int n, total;
+
+  for (int i = 0; i < DATA_SIZE; i++)
+    data[i] = 'a' + i % 26;
+  CHECK(create("splice-in", DATA_SIZE), "create \"splice-in\"");
+  CHECK((in_fd = open("splice-in")) > 1, "open \"splice-in\"");
+  CHECK(write(in_fd, data, DATA_SIZE) == DATA_SIZE, "write \"splice-in\"");
+  seek(in_fd, 0);
+  CHECK(create("splice-out", 0), "create \"splice-out\"");
+  CHECK((out_fd = open("splice-out")) > 1, "open \"splice-out\"");
+
+  CHECK(pipe(pipefd) == 0, "pipe()");
+  CHECK(splice(in_fd, pipefd[1], DATA_SIZE) == DATA_SIZE, "splice file into pipe");
+  CHECK(tell(in_fd) == DATA_SIZE, "input position advanced");
+  close(pipefd[1]);
+
+  total = 0;
+  while ((n = splice(pipefd[0], out_fd, DATA_SIZE)) > 0)
+    total += n;
+  CHECK(n == 0, "splice reached end of pipe");
+  CHECK(total == DATA_SIZE, "spliced %d bytes into file", total);
+
+  seek(out_fd, 0);
+  CHECK(read(out_fd, copy, DATA_SIZE) == DATA_SIZE, "read \"splice-out\"");
+  CHECK(memcmp(data, copy, DATA_SIZE) == 0, "data integrity verified");
+
+  close(pipefd[0]);
+  close(in_fd);
+  close(out_fd);
+}
@@ -0,0 +1,41 @@
+/* Polls both ends of a pipe: before and after data arrives, while
+   blocked waiting for a child to write, and after the writer closes. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  struct pollfd pfd[2];
+  int fds[2];
+  char c;
+
+  CHECK(pipe(fds) == 0, "pipe()");
+  pfd[0].fd = fds[0];
+  pfd[0].events = POLLIN;
+  pfd[1].fd = fds[1];
+  pfd[1].events = POLLOUT;
+  CHECK(poll(pfd, 2, 0) == 1 && pfd[0].revents == 0 && pfd[1].revents == POLLOUT,
+        "only write end ready");
+  CHECK(poll(pfd, 1, 30) == 0, "read end times out");
+
+  write(fds[1], "a", 1);
+  CHECK(poll(pfd, 1, 0) == 1 && pfd[0].revents == POLLIN, "read end ready");
+  read(fds[0], &c, 1);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    write(fds[1], "b", 1);
+    exit(0);
+  }
+  int ready = poll(pfd, 1, -1);
+  wait(pid);
+  CHECK(ready == 1 && pfd[0].revents == POLLIN, "woken by child's write");
+  CHECK(read(fds[0], &c, 1) == 1 && c == 'b', "read child's byte");
+
+  close(fds[1]);
+  CHECK(poll(pfd, 1, -1) == 1 && pfd[0].revents == POLLHUP, "hangup once writer closes");
+
+  pfd[0].fd = fds[1];
+  CHECK(poll(pfd, 1, 0) == 1 && pfd[0].revents == POLLNVAL, "closed descriptor is invalid");
+}
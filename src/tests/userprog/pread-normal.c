@@ -0,0 +1,23 @@
+/* Reads "sample.txt" with pread() at several offsets, which must
+   return the data at each offset and leave the file position alone. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  char buf[32];
+  int fd;
+
+  CHECK((fd = open("sample.txt")) > 1, "open \"sample.txt\"");
+
+  CHECK(pread(fd, buf, sizeof buf, 100) == sizeof buf, "pread 32 bytes at offset 100");
+  compare_bytes(buf, sample + 100, sizeof buf, 100, "sample.txt");
+  CHECK(pread(fd, buf, 10, 0) == 10, "pread 10 bytes at offset 0");
+  compare_bytes(buf, sample, 10, 0, "sample.txt");
+  CHECK(tell(fd) == 0, "file position unchanged");
+
+  CHECK(pread(fd, buf, sizeof buf, sizeof sample - 11) == 10, "pread past end is short");
+  CHECK(pread(0, buf, 1, 0) == -1, "pread from stdin fails");
+}
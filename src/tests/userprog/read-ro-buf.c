@@ -0,0 +1,16 @@
+/* Passes a buffer in the program's read-only code segment to the
+   read system call.  The kernel must notice before the file
+   system writes to it, and terminate the process with -1 exit
+   code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  int handle;
+
+  CHECK((handle = open("sample.txt")) > 1, "open \"sample.txt\"");
+  read(handle, (char*)test_main, 16);
+  fail("should have exited with -1");
+}
@@ -0,0 +1,20 @@
+/* Reads "sample.txt" with readv() into three buffers, which must be
+   filled in order and advance the file position by the total. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  char a[7], b[50], c[100];
+  struct iovec iov[] = {{a, sizeof a}, {b, 0}, {b, sizeof b}, {c, sizeof c}};
+  int fd;
+
+  CHECK((fd = open("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK(readv(fd, iov, 4) == sizeof a + sizeof b + sizeof c, "readv 3 segments");
+  compare_bytes(a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes(b, sample + sizeof a, sizeof b, sizeof a, "sample.txt");
+  compare_bytes(c, sample + sizeof a + sizeof b, sizeof c, sizeof a + sizeof b, "sample.txt");
+  CHECK(tell(fd) == sizeof a + sizeof b + sizeof c, "file position advanced");
+}
@@ -0,0 +1,67 @@
+/* Test buffered I/O on a file several buffers long, and line
+   buffered writes that carry several lines at once. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE 40000
+
+static char big[FILE_SIZE];
+
+/* Returns the byte at offset I of the test file. */
+static char pattern(int i) { return 'a' + (i * 7 + i / 251) % 26; }
+
+void test_main(void) {
+  FILE* fp;
+  char buf[64];
+  int i;
+
+  /* Write the file a character at a time */
+  fp = fopen("big.txt", "w");
+  CHECK(fp != NULL, "fopen big.txt for write");
+  for (i = 0; i < FILE_SIZE; i++)
+    if (fputc(pattern(i), fp) == EOF)
+      break;
+  CHECK(i == FILE_SIZE, "fputc %d bytes", FILE_SIZE);
+  fclose(fp);
+
+  fp = fopen("big.txt", "r");
+  CHECK(filesize(fileno(fp)) == FILE_SIZE, "file is %d bytes", FILE_SIZE);
+  for (i = 0; i < FILE_SIZE; i++)
+    if (fgetc(fp) != pattern(i))
+      break;
+  CHECK(i == FILE_SIZE && fgetc(fp) == EOF, "fgetc reads back every byte");
+  fclose(fp);
+
+  /* A small read leaves data buffered; a large one bypasses the buffer */
+  fp = fopen("big.txt", "r");
+  size_t first = fread(big, 1, 100, fp);
+  size_t rest = fread(big + 100, 1, FILE_SIZE, fp);
+  CHECK(first == 100 && rest == FILE_SIZE - 100, "fread returns whole file");
+  for (i = 0; i < FILE_SIZE; i++)
+    if (big[i] != pattern(i))
+      break;
+  CHECK(i == FILE_SIZE && feof(fp), "fread data matches");
+  fclose(fp);
+
+  /* One line buffered write holding two full lines and a partial one */
+  fp = fopen("lines.txt", "w");
+  setvbuf(fp, NULL, _IOLBF, 0);
+  fputs("one\ntwo\nthr", fp);
+  FILE* fp2 = fopen("lines.txt", "r");
+  size_t n = fread(buf, 1, sizeof buf, fp2);
+  CHECK(n == 8 && !memcmp(buf, "one\ntwo\n", 8), "complete lines written at once");
+  fclose(fp2);
+
+  fputs("ee\n", fp);
+  fclose(fp);
+  fp = fopen("lines.txt", "r");
+  n = fread(buf, 1, sizeof buf, fp);
+  CHECK(n == 14 && !memcmp(buf, "one\ntwo\nthree\n", 14), "partial line written with the next");
+  fclose(fp);
+
+  msg("bigfile tests passed");
+}
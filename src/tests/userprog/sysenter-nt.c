@@ -0,0 +1,44 @@
+/* Makes system calls with the nested task flag set.  The kernel
+   must not return with NT still set in its own flags, since an
+   iret would then try to return to a previous task, but the
+   caller's NT must survive the call. */
+
+#include <syscall.h>
+#include <stdio.h>
+#include <syscall-nr.h>
+#include "arch/i386/flags.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/flagged-syscall.h"
+
+static const char message[] = "(sysenter-nt) write with NT set\n";
+
+/* Clears NT and returns true if it was set. */
+static bool clear_nt(void) {
+  bool was_set = (get_flags() & FLAG_NT) != 0;
+  asm volatile("pushfl; andl %0, (%%esp); popfl" : : "i"(~FLAG_NT) : "cc");
+  return was_set;
+}
+
+void test_main(void) {
+  int size = sizeof message - 1;
+  pid_t pid;
+  bool was_set;
+
+  CHECK(flagged_syscall(FLAG_NT, SYS_WRITE, STDOUT_FILENO, (uint32_t)message, size) == size,
+        "write returned %d", size);
+  CHECK(clear_nt(), "NT still set");
+
+  /* fork() returns to the child through a frame of its own. */
+  pid = flagged_syscall(FLAG_NT, SYS_FORK, 0, 0, 0);
+  if (pid == 0) {
+    if (!clear_nt())
+      exit(1);
+    exit(81);
+  }
+  was_set = clear_nt();
+  if (pid < 0)
+    fail("fork returned %d", pid);
+  CHECK(wait(pid) == 81, "wait for child");
+  CHECK(was_set, "NT still set in parent");
+}
@@ -0,0 +1,18 @@
+/* Makes a system call with the trap flag set.  The call must
+   complete without the single-step trap being taken in the
+   kernel, and then the trap, which this kernel treats like any
+   other user exception, must kill the process. */
+
+#include <stdio.h>
+#include <syscall-nr.h>
+#include "arch/i386/flags.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/flagged-syscall.h"
+
+static const char message[] = "(sysenter-tf) write with TF set\n";
+
+void test_main(void) {
+  flagged_syscall(FLAG_TF, SYS_WRITE, STDOUT_FILENO, (uint32_t)message, sizeof message - 1);
+  fail("should have exited with -1");
+}
@@ -0,0 +1,60 @@
+/* Traces system calls globally and then for children only, and checks
+   the per-call statistics and the event log. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct systrace_stats stats;
+static struct systrace_event events[SYSTRACE_RING_SIZE];
+
+/* Reads the statistics and returns the number of practice() calls. */
+static uint64_t practice_calls(void) {
+  if (systrace(SYSTRACE_STATS, &stats, 0) != 0)
+    fail("systrace(SYSTRACE_STATS) failed");
+  return stats.calls[SYS_PRACTICE];
+}
+
+void test_main(void) {
+  CHECK(systrace(SYSTRACE_RESET, NULL, 0) == 0, "reset");
+  CHECK(systrace(SYSTRACE_GLOBAL | SYSTRACE_LOG, NULL, 0) == 0, "trace everything");
+  for (int i = 0; i < 3; i++)
+    practice(41);
+  uint64_t calls = practice_calls();
+  CHECK(calls == 3, "3 practice calls counted");
+  CHECK(stats.max_cycles[SYS_PRACTICE] > 0 &&
+            stats.cycles[SYS_PRACTICE] >= stats.max_cycles[SYS_PRACTICE],
+        "latency recorded");
+
+  int n = systrace(SYSTRACE_EVENTS, events, SYSTRACE_RING_SIZE);
+  int found = 0;
+  for (int i = 0; i < n; i++)
+    if (events[i].nr == SYS_PRACTICE && events[i].args[0] == 41 && events[i].ret == 42 &&
+        events[i].pid == get_pid() && events[i].tid == get_tid())
+      found++;
+  CHECK(found == 3, "3 practice events logged");
+
+  /* The first event after draining is the draining call itself. */
+  int m = systrace(SYSTRACE_EVENTS, events, SYSTRACE_RING_SIZE);
+  CHECK(m >= 1 && events[0].nr == SYS_SYSTRACE && events[0].ret == n, "draining is logged");
+
+  CHECK(systrace(SYSTRACE_OFF, NULL, 0) == 0, "tracing off");
+  CHECK(systrace(SYSTRACE_RESET, NULL, 0) == 0, "reset");
+  practice(41);
+  calls = practice_calls();
+  CHECK(calls == 0, "nothing counted while off");
+
+  CHECK(systrace(SYSTRACE_CHILDREN, NULL, 0) == 0, "trace children");
+  practice(41);
+  pid_t pid = fork();
+  if (pid == 0) {
+    practice(1);
+    exit(0);
+  }
+  int status = wait(pid);
+  calls = practice_calls();
+  CHECK(status == 0, "wait for child");
+  CHECK(calls == 1, "only the child's call counted");
+  CHECK(systrace(SYSTRACE_OFF, NULL, 0) == 0, "tracing off");
+  CHECK(systrace(42, NULL, 0) == -1, "bad operation rejected");
+}
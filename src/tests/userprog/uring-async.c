@@ -0,0 +1,49 @@
+/* Checks that io_uring operations run asynchronously: a read of an
+   empty pipe completes only once data is written, after the submitting
+   call has returned.  Also checks that a forked child cannot submit to
+   its parent's ring, and that exiting stops the ring's workers. */
+
+#include <string.h>
+#include <syscall.h>
+#include <uring.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ENTRIES 4
+
+static uint64_t ring_mem[IORING_MEM_SIZE(ENTRIES) / sizeof(uint64_t)];
+
+void test_main(void) {
+  struct io_uring ring;
+  struct io_uring_cqe* cqe;
+  char buf[16];
+  int fds[2];
+
+  CHECK(pipe(fds) == 0, "pipe()");
+  CHECK(io_uring_queue_init_mem(ENTRIES, &ring, ring_mem, sizeof ring_mem) == 0,
+        "io_uring_queue_init_mem");
+
+  io_uring_prep_read(io_uring_get_sqe(&ring), fds[0], buf, sizeof buf, IORING_OFF_CURRENT);
+  CHECK(io_uring_submit(&ring) == 1, "submit read of empty pipe");
+  CHECK(io_uring_peek_cqe(&ring, &cqe) == -1, "read not complete");
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    msg("child submit returns %d", io_uring_enter(ring.fd, 0, 0));
+    exit(0);
+  }
+  wait(pid);
+
+  write(fds[1], "hello", 5);
+  CHECK(io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res == 5, "read completes with 5 bytes");
+  io_uring_cqe_seen(&ring, cqe);
+  CHECK(!memcmp(buf, "hello", 5), "read \"hello\"");
+
+  close(fds[1]);
+  io_uring_prep_read(io_uring_get_sqe(&ring), fds[0], buf, sizeof buf, IORING_OFF_CURRENT);
+  io_uring_submit(&ring);
+  CHECK(io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res == 0, "end of file after writer closes");
+  io_uring_cqe_seen(&ring, cqe);
+
+  /* The ring is left open, with its worker parked, for exit to stop. */
+}
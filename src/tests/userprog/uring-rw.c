@@ -0,0 +1,103 @@
+/* Writes, syncs, reads back, opens and closes a file through an
+   io_uring, several operations per submission, and checks each
+   completion. */
+
+#include <string.h>
+#include <syscall.h>
+#include <uring.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ENTRIES 8
+#define BLOCKS 4
+#define BLOCK_SIZE 512
+
+static uint64_t ring_mem[IORING_MEM_SIZE(ENTRIES) / sizeof(uint64_t)];
+static char out[BLOCKS][BLOCK_SIZE];
+static char in[BLOCKS][BLOCK_SIZE];
+
+/* Waits for CNT completions, checking that each has a distinct user_data
+   below CNT and result EXPECT. */
+static void reap(struct io_uring* ring, int cnt, int expect, const char* what) {
+  bool seen[ENTRIES] = {false};
+  for (int i = 0; i < cnt; i++) {
+    struct io_uring_cqe* cqe;
+    if (io_uring_wait_cqe(ring, &cqe) < 0)
+      fail("%s: no completion", what);
+    uint64_t id = io_uring_cqe_get_data64(cqe);
+    if (id >= (uint64_t)cnt || seen[id] || cqe->res != expect)
+      fail("%s: bad completion %d: result %d", what, (int)id, cqe->res);
+    seen[id] = true;
+    io_uring_cqe_seen(ring, cqe);
+  }
+  msg("%s complete", what);
+}
+
+/* Queues one operation tagged with ID. */
+static struct io_uring_sqe* queue(struct io_uring* ring, uint64_t id) {
+  struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+  if (sqe == NULL)
+    fail("submission queue full");
+  io_uring_sqe_set_data64(sqe, id);
+  return sqe;
+}
+
+void test_main(void) {
+  struct io_uring ring;
+  struct io_uring_cqe* cqe;
+  int fd;
+
+  CHECK(create("ring.dat", 0), "create \"ring.dat\"");
+  CHECK((fd = open("ring.dat")) > 1, "open \"ring.dat\"");
+  CHECK(io_uring_queue_init_mem(ENTRIES, &ring, ring_mem, sizeof ring_mem) == 0,
+        "io_uring_queue_init_mem");
+
+  for (int i = 0; i < BLOCKS; i++) {
+    memset(out[i], 'a' + i, BLOCK_SIZE);
+    io_uring_prep_write(queue(&ring, i), fd, out[i], BLOCK_SIZE, i * BLOCK_SIZE);
+  }
+  CHECK(io_uring_submit(&ring) == BLOCKS, "submit %d writes", BLOCKS);
+  reap(&ring, BLOCKS, BLOCK_SIZE, "writes");
+
+  io_uring_prep_fsync(queue(&ring, 0), fd);
+  io_uring_prep_nop(queue(&ring, 1));
+  CHECK(io_uring_submit_and_wait(&ring, 2) == 2, "submit fsync and nop");
+  reap(&ring, 2, 0, "fsync and nop");
+
+  for (int i = 0; i < BLOCKS; i++)
+    io_uring_prep_read(queue(&ring, i), fd, in[i], BLOCK_SIZE, i * BLOCK_SIZE);
+  CHECK(io_uring_submit(&ring) == BLOCKS, "submit %d reads", BLOCKS);
+  reap(&ring, BLOCKS, BLOCK_SIZE, "reads");
+  CHECK(memcmp(in, out, sizeof in) == 0, "read back what was written");
+
+  /* Reads at the descriptor's position advance it, like read(). */
+  io_uring_prep_read(queue(&ring, 0), fd, in[0], BLOCK_SIZE, IORING_OFF_CURRENT);
+  io_uring_submit(&ring);
+  CHECK(io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res == BLOCK_SIZE, "read at position");
+  io_uring_cqe_seen(&ring, cqe);
+  CHECK(tell(fd) == BLOCK_SIZE, "position advanced");
+
+  io_uring_prep_open(queue(&ring, 0), "ring.dat");
+  io_uring_submit(&ring);
+  CHECK(io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res > fd, "open through ring");
+  int fd2 = cqe->res;
+  io_uring_cqe_seen(&ring, cqe);
+  CHECK(filesize(fd2) == BLOCKS * BLOCK_SIZE, "opened file has the data");
+
+  io_uring_prep_close(queue(&ring, 0), fd2);
+  io_uring_prep_close(queue(&ring, 1), ring.fd);
+  io_uring_prep_read(queue(&ring, 2), 1000, in[0], 1, 0);
+  io_uring_submit_and_wait(&ring, 3);
+  int res[3] = {1, 1, 1};
+  while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+    res[cqe->user_data] = cqe->res;
+    io_uring_cqe_seen(&ring, cqe);
+  }
+  CHECK(res[0] == 0, "close through ring");
+  CHECK(res[1] == -1, "closing the ring through itself fails");
+  CHECK(res[2] == -1, "read from bad descriptor fails");
+  CHECK(filesize(fd2) == -1, "descriptor closed");
+
+  io_uring_queue_exit(&ring);
+  close(fd);
+}
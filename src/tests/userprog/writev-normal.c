@@ -0,0 +1,26 @@
+/* Writes a file with writev(), overwrites part of it with pwrite(),
+   and checks the result. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void test_main(void) {
+  size_t size = sizeof sample - 1;
+  struct iovec iov[] = {{sample, 20}, {sample + 20, size - 20}};
+  char expected[sizeof sample];
+  int fd;
+
+  CHECK(create("test.txt", size), "create \"test.txt\"");
+  CHECK((fd = open("test.txt")) > 1, "open \"test.txt\"");
+  CHECK(writev(fd, iov, 2) == (int)size, "writev 2 segments");
+  CHECK(pwrite(fd, "XYZ", 3, 5) == 3, "pwrite 3 bytes at offset 5");
+  CHECK(tell(fd) == size, "file position after writev only");
+
+  memcpy(expected, sample, size);
+  memcpy(expected + 5, "XYZ", 3);
+  seek(fd, 0);
+  check_file_handle(fd, "test.txt", expected, size);
+}
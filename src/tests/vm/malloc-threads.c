@@ -0,0 +1,110 @@
+/* Allocates and frees blocks of many sizes from several threads at
+   once, checking that no two live blocks overlap, then checks in-place
+   realloc() growth and the allocator statistics. */
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREADS 4
+#define ROUNDS 2000
+#define SLOTS 64
+
+/* Returns a pseudo-random number from *STATE. */
+static unsigned next_random(unsigned* state) {
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+
+/* Returns a block size: mostly small, sometimes large. */
+static size_t random_size(unsigned* state) {
+  unsigned r = next_random(state);
+  if (r % 16 == 0)
+    return 32 * 1024 + r % (96 * 1024);
+  return 1 + r % (r % 4 == 0 ? 8192 : 512);
+}
+
+static void check_block(const unsigned char* p, size_t size, unsigned char tag) {
+  for (size_t i = 0; i < size; i += 61)
+    if (p[i] != tag)
+      fail("block %p of %zu bytes overwritten at %zu", p, size, i);
+}
+
+static void worker(void* arg) {
+  unsigned id = (unsigned)(uintptr_t)arg;
+  unsigned state = id + 1;
+  unsigned char* blocks[SLOTS] = {NULL};
+  size_t sizes[SLOTS];
+  unsigned char tags[SLOTS];
+
+  for (int round = 0; round < ROUNDS; round++) {
+    int slot = next_random(&state) % SLOTS;
+    if (blocks[slot] != NULL) {
+      check_block(blocks[slot], sizes[slot], tags[slot]);
+      if (next_random(&state) % 4 == 0) {
+        /* Resize, which must keep the contents. */
+        size_t size = random_size(&state);
+        unsigned char* p = realloc(blocks[slot], size);
+        if (p == NULL)
+          fail("realloc to %zu failed", size);
+        check_block(p, size < sizes[slot] ? size : sizes[slot], tags[slot]);
+        memset(p, tags[slot], size);
+        blocks[slot] = p;
+        sizes[slot] = size;
+        continue;
+      }
+      free(blocks[slot]);
+    }
+    sizes[slot] = random_size(&state);
+    tags[slot] = id * SLOTS + slot;
+    blocks[slot] = malloc(sizes[slot]);
+    if (blocks[slot] == NULL)
+      fail("malloc of %zu failed", sizes[slot]);
+    memset(blocks[slot], tags[slot], sizes[slot]);
+  }
+
+  for (int slot = 0; slot < SLOTS; slot++)
+    if (blocks[slot] != NULL) {
+      check_block(blocks[slot], sizes[slot], tags[slot]);
+      free(blocks[slot]);
+    }
+}
+
+void test_main(void) {
+  struct malloc_stats stats;
+
+  /* A large block in a fresh heap has free pages after it. */
+  char* p = malloc(40 * 1024);
+  memset(p, 'a', 40 * 1024);
+  char* q = realloc(p, 60 * 1024);
+  CHECK(q == p && q[40 * 1024 - 1] == 'a', "large block grows in place");
+  free(q);
+
+  char* small = malloc(100);
+  char* grown = realloc(small, 110);
+  CHECK(grown == small && malloc_usable_size(grown) >= 110, "small block grows within its class");
+  free(grown);
+
+  tid_t tids[THREADS];
+  for (int i = 0; i < THREADS; i++)
+    tids[i] = pthread_check_create(worker, (void*)(uintptr_t)i);
+  for (int i = 0; i < THREADS; i++)
+    pthread_check_join(tids[i]);
+  msg("%d threads done", THREADS);
+
+  malloc_get_stats(&stats);
+  CHECK(stats.mallocs == stats.frees, "every block freed");
+  CHECK(stats.large == 0 && stats.huge == 0, "no large or huge blocks left");
+  CHECK(stats.in_place >= 2, "in-place reallocations counted");
+  CHECK(stats.refills > 0 && stats.cached > 0, "thread caches used");
+
+  size_t maps = stats.maps;
+  void* huge = malloc(1024 * 1024);
+  CHECK(huge != NULL, "huge block");
+  free(huge);
+  malloc_get_stats(&stats);
+  CHECK(stats.maps == maps + 1 && stats.unmaps > 0, "huge block mapped and unmapped");
+}
@@ -0,0 +1,46 @@
+/* Maps anonymous MAP_SHARED memory, forks, and checks that the
+   child's stores are visible to the parent and that a private
+   mapping made alongside it stays private. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SHARED_PAGES 4
+
+void test_main(void) {
+  int i;
+
+  char* shared = mmap_shared(NULL, SHARED_PAGES * PAGE_SIZE);
+  CHECK(shared != (char*)-1, "mmap shared region");
+  char* private = mmap_anon(NULL, PAGE_SIZE);
+  CHECK(private != (char*)-1, "mmap private region");
+
+  /* Fault in the first page before fork, leave the rest untouched. */
+  shared[0] = 'p';
+  private[0] = 'p';
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (shared[0] != 'p')
+      exit(1);
+    for (i = 0; i < SHARED_PAGES; i++)
+      shared[i * PAGE_SIZE] = 'c' + i;
+    private[0] = 'c';
+    exit(0);
+  }
+  if (pid < 0)
+    fail("fork returned %d", pid);
+  CHECK(wait(pid) == 0, "wait for child");
+
+  for (i = 0; i < SHARED_PAGES; i++)
+    if (shared[i * PAGE_SIZE] != 'c' + i)
+      fail("shared page %d holds '%c'", i, shared[i * PAGE_SIZE]);
+  msg("child's stores visible in parent");
+  CHECK(private[0] == 'p', "private page unchanged");
+
+  munmap((mapid_t)shared);
+  msg("munmap shared region");
+}
@@ -0,0 +1,45 @@
+/* Creates a named shared memory object, maps it at two offsets,
+   and checks that a child that opens the object by name sees and
+   updates the same pages.  Then unlinks the name. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+void test_main(void) {
+  int fd;
+
+  CHECK((fd = shm_open("shm-test", 2 * PAGE_SIZE)) > 1, "shm_open \"shm-test\"");
+  char* whole = mmap2(NULL, 2 * PAGE_SIZE, 0, MAP_SHARED, fd, 0);
+  CHECK(whole != (char*)-1, "mmap whole object");
+  char* second = mmap2(NULL, PAGE_SIZE, 0, MAP_SHARED, fd, PAGE_SIZE);
+  CHECK(second != (char*)-1, "mmap second page");
+  CHECK(mmap2(NULL, PAGE_SIZE, 0, MAP_SHARED, fd, 2 * PAGE_SIZE) == (void*)-1,
+        "mmap past end fails");
+
+  strlcpy(whole + PAGE_SIZE, "parent", PAGE_SIZE);
+  CHECK(!strcmp(second, "parent"), "aliased mappings agree");
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    /* Reach the object by name rather than through inherited mappings. */
+    int cfd = shm_open("shm-test", 0);
+    char* p = mmap2(NULL, 2 * PAGE_SIZE, 0, MAP_SHARED, cfd, 0);
+    if (cfd < 0 || p == (char*)-1 || strcmp(p + PAGE_SIZE, "parent"))
+      exit(1);
+    strlcpy(p + PAGE_SIZE, "child", PAGE_SIZE);
+    exit(0);
+  }
+  if (pid < 0)
+    fail("fork returned %d", pid);
+  CHECK(wait(pid) == 0, "wait for child");
+  CHECK(!strcmp(second, "child"), "child's store visible");
+
+  CHECK(shm_unlink("shm-test"), "shm_unlink \"shm-test\"");
+  CHECK(shm_open("shm-test", 0) == -1, "name is gone");
+  CHECK(!strcmp(whole + PAGE_SIZE, "child"), "mapping survives unlink");
+  close(fd);
+}
@@ -0,0 +1,63 @@
+/* Checks that SYS_VMSTAT counts page faults by class: zero-fill
+   faults on an anonymous mapping, stack-growth faults, and
+   copy-on-write faults in a forked child. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ANON_PAGES 8
+
+/* Written by the child after fork() to force a COW fault. */
+static int shared_value = 1;
+
+/* Grows the stack by several pages. */
+static int NO_INLINE grow_stack(void) {
+  volatile char big[4 * PAGE_SIZE];
+  for (size_t i = 0; i < sizeof big; i += PAGE_SIZE)
+    big[i] = (char)i;
+  return big[0];
+}
+
+void test_main(void) {
+  struct vmstat before, after, global;
+  int i;
+
+  CHECK(get_vmstat(VMSTAT_PROCESS, &before), "get_vmstat (process)");
+
+  /* Touch every page of a fresh anonymous mapping. */
+  char* anon = mmap_anon(NULL, ANON_PAGES * PAGE_SIZE);
+  CHECK(anon != (char*)-1, "mmap anonymous region");
+  for (i = 0; i < ANON_PAGES; i++)
+    anon[i * PAGE_SIZE] = 'x';
+
+  grow_stack();
+
+  CHECK(get_vmstat(VMSTAT_PROCESS, &after), "get_vmstat (process) again");
+  CHECK(after.faults[VMSTAT_FAULT_ZERO] - before.faults[VMSTAT_FAULT_ZERO] >= ANON_PAGES,
+        "zero-fill faults counted");
+  CHECK(after.faults[VMSTAT_FAULT_STACK] > before.faults[VMSTAT_FAULT_STACK],
+        "stack-growth faults counted");
+  CHECK(after.fault_cycles[VMSTAT_FAULT_ZERO] > 0, "fault latency recorded");
+
+  CHECK(get_vmstat(VMSTAT_GLOBAL, &global), "get_vmstat (global)");
+  CHECK(global.faults[VMSTAT_FAULT_ZERO] >= after.faults[VMSTAT_FAULT_ZERO],
+        "global counters include this process");
+
+  CHECK(!get_vmstat(42, &global), "get_vmstat rejects bad scope");
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    struct vmstat child;
+    shared_value = 2;
+    if (!get_vmstat(VMSTAT_PROCESS, &child) || child.faults[VMSTAT_FAULT_COW] == 0)
+      exit(1);
+    exit(0);
+  }
+  if (pid < 0)
+    fail("fork returned %d", pid);
+  CHECK(wait(pid) == 0, "child saw copy-on-write fault");
+  CHECK(shared_value == 1, "parent copy unchanged");
+}
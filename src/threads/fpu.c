@@ -0,0 +1,335 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+#ifdef ARCH_RISCV64
+#include "arch/riscv64/csr.h"
+#endif
+
+/* Lazy FPU context switching.  See fpu.h for the overview. */
+
+#ifdef ARCH_RISCV64
+/* f0...f31, then fcsr. */
+#define FPU_SAVE_SIZE (33 * 8)
+#define FPU_ALIGN 8
+#else
+/* An FXSAVE image.  The 108 bytes FNSAVE stores also fit. */
+#define FPU_SAVE_SIZE 512
+#define FPU_ALIGN 16
+#endif
+
+/* Thread whose registers the FPU holds, or a null pointer if the
+   FPU holds nothing worth saving. */
+static struct thread* fpu_owner;
+
+/* True if the FPU's registers may differ from fpu_owner's save
+   area. */
+static bool owner_dirty;
+
+/* Save areas.  Slab objects are not aligned enough for FXSAVE, so
+   each is allocated with room to align it; see fpu_area(). */
+static struct slab_cache fpu_cache;
+
+/* Registers of a freshly initialized FPU, copied into each new
+   thread's save area. */
+static uint8_t fpu_initial[FPU_SAVE_SIZE] __attribute__((aligned(FPU_ALIGN)));
+
+/* True between kernel_simd_begin() and kernel_simd_end(), and the
+   interrupt level to return to at the end. */
+static bool simd_active;
+static enum intr_level simd_old_level;
+
+static void hw_init(void);
+static void hw_enable(void);
+static void hw_disable(void);
+static void hw_save(void* area);
+static void hw_restore(const void* area);
+static void release_owner(void);
+
+/* Returns T's save area. */
+static void* fpu_area(struct thread* t) { return (void*)ROUND_UP((uintptr_t)t->fpu, FPU_ALIGN); }
+
+/* Initializes the FPU and gives the running thread a save area.
+   Must be called after slab_init() and, on i386, intr_init(), and
+   before any other thread is created. */
+void fpu_init(void) {
+  hw_init();
+  hw_enable();
+  hw_save(fpu_initial);
+
+  slab_cache_init(&fpu_cache, "fpu", FPU_SAVE_SIZE + FPU_ALIGN - 1, NULL, NULL);
+  if (!fpu_thread_init(thread_current()))
+    PANIC("no memory for FPU state");
+
+  fpu_owner = NULL;
+  hw_disable();
+}
+
+/* Gives new thread T a save area in the initial FPU state.
+   Returns false if memory is short. */
+bool fpu_thread_init(struct thread* t) {
+  t->fpu = slab_alloc(&fpu_cache);
+  if (t->fpu == NULL)
+    return false;
+  memcpy(fpu_area(t), fpu_initial, FPU_SAVE_SIZE);
+  return true;
+}
+
+/* Frees the save area of T, which must be the running thread and
+   about to exit. */
+void fpu_thread_exit(struct thread* t) {
+  enum intr_level old_level;
+
+  ASSERT(t == thread_current());
+
+  old_level = intr_disable();
+  if (fpu_owner == t)
+    fpu_owner = NULL;
+  hw_disable();
+  intr_set_level(old_level);
+
+  slab_free(&fpu_cache, t->fpu);
+  t->fpu = NULL;
+}
+
+/* Enables the FPU if the running thread owns it and disables it
+   otherwise.  Called with interrupts off on every thread switch. */
+void fpu_activate(void) {
+  if (thread_current() == fpu_owner)
+    hw_enable();
+  else
+    hw_disable();
+}
+
+/* Makes the running thread the FPU's owner, saving the previous
+   owner's registers if needed, and enables the FPU.  Called from
+   the trap that a disabled FPU raises. */
+void fpu_claim(void) {
+  struct thread* cur = thread_current();
+  enum intr_level old_level;
+
+  ASSERT(cur->fpu != NULL);
+
+  old_level = intr_disable();
+  hw_enable();
+  if (fpu_owner != cur) {
+    if (fpu_owner != NULL && owner_dirty)
+      hw_save(fpu_area(fpu_owner));
+    hw_restore(fpu_area(cur));
+    fpu_owner = cur;
+#ifdef ARCH_RISCV64
+    /* hw_restore() left sstatus.FS Clean. */
+    owner_dirty = false;
+#else
+    /* CR0.TS gives no dirty bit, so assume the owner writes. */
+    owner_dirty = true;
+#endif
+  }
+  intr_set_level(old_level);
+}
+
+/* Puts T, which must be the running thread, back in the initial
+   FPU state, for reuse by a new pthread. */
+void fpu_reset(struct thread* t) {
+  enum intr_level old_level;
+
+  ASSERT(t == thread_current());
+
+  old_level = intr_disable();
+  if (fpu_owner == t)
+    fpu_owner = NULL;
+  memcpy(fpu_area(t), fpu_initial, FPU_SAVE_SIZE);
+  fpu_activate();
+  intr_set_level(old_level);
+}
+
+/* Copies the FPU state of SRC to DST, for fork(). */
+void fpu_copy(struct thread* dst, struct thread* src) {
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+
+  /* SRC's area must be up to date.  SRC's next FPU instruction loads
+     it again. */
+  release_owner();
+  memcpy(fpu_area(dst), fpu_area(src), FPU_SAVE_SIZE);
+  fpu_activate();
+  intr_set_level(old_level);
+}
+
+/* Starts a region in which kernel code may use the FPU and SSE
+   registers freely.  Saves the registers of the FPU's owner, which
+   reloads them on its next FPU instruction, enables the FPU and
+   turns interrupts off until kernel_simd_end().  Regions do not
+   nest. */
+void kernel_simd_begin(void) {
+  enum intr_level old_level = intr_disable();
+
+  ASSERT(!simd_active);
+  release_owner();
+  hw_enable();
+  simd_active = true;
+  simd_old_level = old_level;
+}
+
+/* Ends the region started by kernel_simd_begin().  The registers
+   hold nothing worth keeping, so the FPU is simply disabled. */
+void kernel_simd_end(void) {
+  ASSERT(simd_active);
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  simd_active = false;
+  hw_disable();
+  intr_set_level(simd_old_level);
+}
+
+/* Writes the FPU's registers back to its owner's save area, if they
+   may differ, and leaves the FPU disabled with no owner.  Interrupts
+   must be off. */
+static void release_owner(void) {
+  hw_disable();
+  if (fpu_owner != NULL && owner_dirty) {
+    hw_enable();
+    hw_save(fpu_area(fpu_owner));
+    hw_disable();
+  }
+  fpu_owner = NULL;
+}
+
+#ifdef ARCH_RISCV64
+
+/* Clears the FPU registers.  fpu_initial is still all zeros, which
+   is +0.0 in every register and round-to-nearest with no flags in
+   fcsr. */
+static void hw_init(void) {
+  hw_enable();
+  hw_restore(fpu_initial);
+}
+
+/* Sets sstatus.FS to Clean if it is Off. */
+static void hw_enable(void) {
+  if ((csr_read(sstatus) & SSTATUS_FS) == SSTATUS_FS_OFF)
+    csr_set(sstatus, SSTATUS_FS_CLEAN);
+}
+
+/* Sets sstatus.FS to Off, noting first whether the owner wrote its
+   registers since they were loaded. */
+static void hw_disable(void) {
+  if ((csr_read(sstatus) & SSTATUS_FS) == SSTATUS_FS_DIRTY)
+    owner_dirty = true;
+  csr_clear(sstatus, SSTATUS_FS);
+}
+
+#define FREG(OP, N) OP " f" #N ", " #N "*8(%0)\n\t"
+#define FREGS(OP)                                                                                  \
+  FREG(OP, 0) FREG(OP, 1) FREG(OP, 2) FREG(OP, 3) FREG(OP, 4) FREG(OP, 5) FREG(OP, 6) FREG(OP, 7)  \
+  FREG(OP, 8) FREG(OP, 9) FREG(OP, 10) FREG(OP, 11) FREG(OP, 12) FREG(OP, 13) FREG(OP, 14)         \
+  FREG(OP, 15) FREG(OP, 16) FREG(OP, 17) FREG(OP, 18) FREG(OP, 19) FREG(OP, 20) FREG(OP, 21)       \
+  FREG(OP, 22) FREG(OP, 23) FREG(OP, 24) FREG(OP, 25) FREG(OP, 26) FREG(OP, 27) FREG(OP, 28)       \
+  FREG(OP, 29) FREG(OP, 30) FREG(OP, 31)
+
+static void hw_save(void* area) {
+  asm volatile(FREGS("fsd") "frcsr t0\n\t"
+                            "sd t0, 256(%0)"
+               :
+               : "r"(area)
+               : "t0", "memory");
+}
+
+/* Loading the registers sets sstatus.FS Dirty, so this sets it back
+   to Clean: they now match AREA. */
+static void hw_restore(const void* area) {
+  asm volatile(FREGS("fld") "ld t0, 256(%0)\n\t"
+                            "fscsr t0"
+               :
+               : "r"(area)
+               : "t0", "memory");
+  csr_clear(sstatus, SSTATUS_FS);
+  csr_set(sstatus, SSTATUS_FS_CLEAN);
+}
+
+#else /* i386 */
+
+#define CR0_MP 0x00000002 /* WAIT traps too while TS is set. */
+#define CR0_EM 0x00000004 /* Emulate: every FPU instruction traps. */
+#define CR0_TS 0x00000008 /* Task switched: FPU instructions trap. */
+#define CR0_NE 0x00000020 /* Report x87 errors as #MF. */
+
+#define CR4_OSFXSR 0x00000200     /* FXSAVE saves SSE state; SSE enabled. */
+#define CR4_OSXMMEXCPT 0x00000400 /* Report SSE errors as #XF. */
+
+#define CPUID_FXSR (1u << 24)
+#define CPUID_SSE (1u << 25)
+
+/* True if the CPU has FXSAVE and FXRSTOR, which unlike FNSAVE and
+   FRSTOR also cover the SSE registers. */
+static bool has_fxsr;
+
+/* True if CR0.TS is clear. */
+static bool hw_enabled;
+
+static void fpu_fault(struct intr_frame* f UNUSED) { fpu_claim(); }
+
+/* Turns on the FPU, and SSE where the CPU has it, and registers the
+   #NM handler. */
+static void hw_init(void) {
+  uint32_t eax, ebx, ecx, edx, cr0, cr4;
+
+  asm("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+  has_fxsr = (edx & CPUID_FXSR) != 0;
+  if (has_fxsr) {
+    asm volatile("movl %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_OSFXSR;
+    if (edx & CPUID_SSE)
+      cr4 |= CR4_OSXMMEXCPT;
+    asm volatile("movl %0, %%cr4" : : "r"(cr4));
+  }
+
+  asm volatile("movl %%cr0, %0" : "=r"(cr0));
+  cr0 = (cr0 & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE;
+  asm volatile("movl %0, %%cr0" : : "r"(cr0));
+  hw_enabled = true;
+  asm volatile("fninit");
+
+  intr_register_int(7, 0, INTR_OFF, fpu_fault, "#NM Device Not Available Exception");
+}
+
+/* Clears CR0.TS. */
+static void hw_enable(void) {
+  if (!hw_enabled) {
+    asm volatile("clts");
+    hw_enabled = true;
+  }
+}
+
+/* Sets CR0.TS. */
+static void hw_disable(void) {
+  if (hw_enabled) {
+    uint32_t cr0;
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    asm volatile("movl %0, %%cr0" : : "r"(cr0 | CR0_TS));
+    hw_enabled = false;
+  }
+}
+
+/* FNSAVE also reinitializes the FPU, which is harmless here: the
+   registers are saved because they are about to be replaced. */
+static void hw_save(void* area) {
+  if (has_fxsr)
+    asm volatile("fxsave (%0)" : : "r"(area) : "memory");
+  else
+    asm volatile("fnsave (%0)" : : "r"(area) : "memory");
+}
+
+static void hw_restore(const void* area) {
+  if (has_fxsr)
+    asm volatile("fxrstor (%0)" : : "r"(area) : "memory");
+  else
+    asm volatile("frstor (%0)" : : "r"(area) : "memory");
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* Per-thread floating-point state, switched lazily.
+
+   Every thread has a save area for its x87/SSE registers (i386) or
+   its F/D registers and fcsr (riscv64), allocated with the thread.
+   A context switch does not touch the FPU.  Instead, the FPU stays
+   loaded with the registers of its "owner", the last thread to use
+   it, and is disabled for every other thread: CR0.TS on i386,
+   sstatus.FS = Off on riscv64.  The first FPU instruction a
+   non-owner executes traps (#NM, or an illegal instruction), and
+   the trap saves the owner's registers, loads the new thread's and
+   makes it the owner.  Threads that never use the FPU never trap
+   and never cause a save.
+
+   On riscv64 the owner's registers are only saved if sstatus.FS
+   showed them dirty when it last lost the CPU.
+
+   Kernel code that uses the FPU is normally treated like user code:
+   it works on the state of the thread it runs in.  Kernel code that
+   only wants the registers for a moment, such as the SSE loops in
+   lib/kernel/bulk.c, instead brackets its use with
+   kernel_simd_begin() and kernel_simd_end().  These write the owner's
+   registers back to its save area and run the region with interrupts
+   off, so the region may clobber any register, cannot be preempted,
+   and may be entered from any context, including an interrupt
+   handler.  Keep such regions short.  Outside them, interrupt
+   handlers must not use the FPU. */
+
+void fpu_init(void);
+
+bool fpu_thread_init(struct thread*);
+void fpu_thread_exit(struct thread*);
+void fpu_activate(void);
+void fpu_claim(void);
+
+void fpu_reset(struct thread*);
+void fpu_copy(struct thread* dst, struct thread* src);
+
+void kernel_simd_begin(void);
+void kernel_simd_end(void);
+
+#endif /* threads/fpu.h */
@@ -21,6 +21,7 @@
  */
 
 #include "threads/init.h"
+#include <bulk.h>
 #include <console.h>
 #include <debug.h>
 #include <inttypes.h>
@@ -40,10 +41,12 @@
 #include "devices/rtc.h"
 #include "devices/e1000.h"
 #include "net/net.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
@@ -53,8 +56,11 @@
 #include "userprog/exception.h"
 #include "userprog/filedesc.h"
 #include "userprog/gdt.h"
+#include "userprog/kdata.h"
+#include "userprog/poll.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/uring.h"
 #include "tests/userprog/kernel/tests.h"
 #endif
 #include "vm/vm.h"
@@ -165,6 +171,7 @@ int main(void) {
   /* Initialize memory system. */
   palloc_init(user_page_limit);
   malloc_init();
+  slab_init();
   paging_init();
 
   /* Segmentation. */
@@ -175,12 +182,15 @@ int main(void) {
 
   /* Initialize interrupt handlers. */
   intr_init();
+  fpu_init();
+  bulk_init();
   timer_init();
   kbd_init();
   input_init();
 #ifdef USERPROG
   exception_init();
   syscall_init();
+  kdata_init();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -210,6 +220,8 @@ int main(void) {
 #ifdef USERPROG
   /* Initialize the global open file description table */
   ofd_init();
+  poll_init();
+  uring_init();
   /* Give main thread a minimal PCB so it can launch the first process */
   userprog_init();
 #endif
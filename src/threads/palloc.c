@@ -2,13 +2,14 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,13 +24,47 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is managed as a buddy system.  Free memory is kept as
+   blocks of 2**ORDER pages, aligned to their size relative to the
+   pool base, on one free list per order.  An allocation takes a
+   block from the smallest order that fits, splitting larger blocks
+   in half as needed, and returns any pages beyond the request to
+   the free lists.  Freeing a block merges it with its "buddy", the
+   other half of the block it was split from, for as long as that
+   buddy is free too.  A single page therefore comes straight off
+   the order-0 list in the common case, and finding any contiguous
+   run takes at most one step per order.
+
+   A free block's list element lives in the first page of the
+   block, which is otherwise unused.  The pool also keeps one byte
+   per page, ORDER_MAP, that marks the first page of each free
+   block with the block's order so that a buddy can be checked in
+   constant time, and a bitmap of allocated pages for sanity
+   checks.
+
+   The pools are protected by disabling interrupts rather than by
+   a lock, because thread_switch_tail() frees a dying thread's page
+   from inside the scheduler, where it must not block.  Each
+   operation takes at most a few steps per order. */
+
+/* Largest block order: 2**20 pages is 4 GB. */
+#define PALLOC_MAX_ORDER 20
+
+/* ORDER_MAP entry for the first page of a free block of order K. */
+#define FREE_HEAD(K) (0x80 | (K))
+
+/* ORDER_MAP entry for any other page. */
+#define NOT_HEAD 0
 
 /* A memory pool. */
 struct pool {
-  struct lock lock;        /* Mutual exclusion. */
-  struct bitmap* used_map; /* Bitmap of free pages. */
+  struct bitmap* used_map; /* Bitmap of allocated pages. */
+  uint8_t* order_map;      /* FREE_HEAD(order) or NOT_HEAD, per page. */
+  size_t page_cnt;         /* Number of pages in pool. */
   uint8_t* base;           /* Base of pool. */
+  struct list free_lists[PALLOC_MAX_ORDER + 1]; /* Free blocks by order. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -37,6 +72,8 @@ static struct pool kernel_pool, user_pool;
 
 static void init_pool(struct pool*, void* base, size_t page_cnt, const char* name);
 static bool page_from_pool(const struct pool*, void* page);
+static size_t buddy_alloc(struct pool*, size_t page_cnt);
+static void buddy_free_range(struct pool*, size_t page_idx, size_t page_cnt);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -81,15 +118,20 @@ void palloc_init(size_t user_page_limit) {
    FLAGS, in which case the kernel panics. */
 void* palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
   struct pool* pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
   void* pages;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire(&pool->lock);
-  page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-  lock_release(&pool->lock);
+  old_level = intr_disable();
+  page_idx = buddy_alloc(pool, page_cnt);
+  if (page_idx != BITMAP_ERROR) {
+    ASSERT(bitmap_none(pool->used_map, page_idx, page_cnt));
+    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+  }
+  intr_set_level(old_level);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -98,7 +140,8 @@ void* palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
 
   if (pages != NULL) {
     if (flags & PAL_ZERO)
-      memset(pages, 0, PGSIZE * page_cnt);
+      for (size_t i = 0; i < page_cnt; i++)
+        clear_page((uint8_t*)pages + PGSIZE * i);
   } else {
     if (flags & PAL_ASSERT)
       PANIC("palloc_get: out of pages");
@@ -119,6 +162,7 @@ void* palloc_get_page(enum palloc_flags flags) { return palloc_get_multiple(flag
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void palloc_free_multiple(void* pages, size_t page_cnt) {
   struct pool* pool;
+  enum intr_level old_level;
   size_t page_idx;
 
   ASSERT(pg_ofs(pages) == 0);
@@ -138,8 +182,11 @@ void palloc_free_multiple(void* pages, size_t page_cnt) {
   memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  old_level = intr_disable();
   ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+  buddy_free_range(pool, page_idx, page_cnt);
+  intr_set_level(old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,20 +195,29 @@ void palloc_free_page(void* page) { palloc_free_multiple(page, 1); }
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void init_pool(struct pool* p, void* base, size_t page_cnt, const char* name) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
+  /* We'll put the pool's used_map and order_map at its base.
+     Calculate the space needed for them and subtract it from
+     the pool's size.  Sizing both for the original PAGE_CNT
+     slightly overestimates, which is harmless. */
   size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
+  size_t om_pages = DIV_ROUND_UP(page_cnt, PGSIZE);
+  if (bm_pages + om_pages > page_cnt)
     PANIC("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  page_cnt -= bm_pages + om_pages;
 
   printf("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init(&p->lock);
   p->used_map = bitmap_create_in_buf(page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->order_map = (uint8_t*)base + bm_pages * PGSIZE;
+  memset(p->order_map, NOT_HEAD, page_cnt);
+  p->page_cnt = page_cnt;
+  p->base = (uint8_t*)base + (bm_pages + om_pages) * PGSIZE;
+  for (int order = 0; order <= PALLOC_MAX_ORDER; order++)
+    list_init(&p->free_lists[order]);
+
+  /* Hand the whole pool to the buddy system as free blocks. */
+  buddy_free_range(p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -169,7 +225,103 @@ static void init_pool(struct pool* p, void* base, size_t page_cnt, const char* n
 static bool page_from_pool(const struct pool* pool, void* page) {
   size_t page_no = pg_no(page);
   size_t start_page = pg_no(pool->base);
-  size_t end_page = start_page + bitmap_size(pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the list element stored in the first page of the free
+   block starting at PAGE_IDX in POOL. */
+static struct list_elem* block_elem(struct pool* pool, size_t page_idx) {
+  return (struct list_elem*)(pool->base + page_idx * PGSIZE);
+}
+
+/* Returns the index of the page holding free-list element E. */
+static size_t elem_page_idx(struct pool* pool, struct list_elem* e) {
+  return ((uint8_t*)e - pool->base) / PGSIZE;
+}
+
+/* Puts the block of 2**ORDER pages at PAGE_IDX on POOL's free
+   list for ORDER.  Must be called with interrupts off. */
+static void push_block(struct pool* pool, size_t page_idx, int order) {
+  pool->order_map[page_idx] = FREE_HEAD(order);
+  list_push_front(&pool->free_lists[order], block_elem(pool, page_idx));
+}
+
+/* Takes the free block at PAGE_IDX off its free list.  Must be
+   called with interrupts off. */
+static void pull_block(struct pool* pool, size_t page_idx) {
+  pool->order_map[page_idx] = NOT_HEAD;
+  list_remove(block_elem(pool, page_idx));
+}
+
+/* Returns the smallest order whose blocks hold PAGE_CNT pages. */
+static int order_for(size_t page_cnt) {
+  int order = 0;
+  while (((size_t)1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy for as long as the buddy is a free block of the same
+   order.  Must be called with interrupts off. */
+static void buddy_free_block(struct pool* pool, size_t page_idx, int order) {
+  while (order < PALLOC_MAX_ORDER) {
+    size_t buddy = page_idx ^ ((size_t)1 << order);
+    if (buddy >= pool->page_cnt || pool->order_map[buddy] != FREE_HEAD(order))
+      break;
+    pull_block(pool, buddy);
+    if (buddy < page_idx)
+      page_idx = buddy;
+    order++;
+  }
+  push_block(pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX, which need not
+   form a single block, by splitting them into the largest aligned
+   blocks that fit.  Must be called with interrupts off. */
+static void buddy_free_range(struct pool* pool, size_t page_idx, size_t page_cnt) {
+  while (page_cnt > 0) {
+    int order = 0;
+    while (order < PALLOC_MAX_ORDER && (page_idx & ((size_t)1 << order)) == 0 &&
+           ((size_t)2 << order) <= page_cnt)
+      order++;
+    buddy_free_block(pool, page_idx, order);
+    page_idx += (size_t)1 << order;
+    page_cnt -= (size_t)1 << order;
+  }
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if no free block is large
+   enough.  Must be called with interrupts off. */
+static size_t buddy_alloc(struct pool* pool, size_t page_cnt) {
+  int want = order_for(page_cnt);
+  int order;
+  size_t page_idx;
+
+  if (want > PALLOC_MAX_ORDER)
+    return BITMAP_ERROR;
+
+  /* Find the smallest free block that is big enough. */
+  for (order = want; order <= PALLOC_MAX_ORDER; order++)
+    if (!list_empty(&pool->free_lists[order]))
+      break;
+  if (order > PALLOC_MAX_ORDER)
+    return BITMAP_ERROR;
+
+  page_idx = elem_page_idx(pool, list_front(&pool->free_lists[order]));
+  pull_block(pool, page_idx);
+
+  /* Split it, returning upper halves to the free lists. */
+  while (order > want) {
+    order--;
+    push_block(pool, page_idx + ((size_t)1 << order), order);
+  }
+
+  /* Return pages beyond PAGE_CNT, if it is not a power of 2. */
+  buddy_free_range(pool, page_idx + page_cnt, ((size_t)1 << want) - page_cnt);
+  return page_idx;
+}
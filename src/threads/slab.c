@@ -0,0 +1,306 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab cache implementation.
+
+   Each slab is one page.  The page starts with a struct slab,
+   followed by an array of 16-bit indexes that chains the free
+   objects together, followed by the objects themselves.  Keeping
+   the free chain outside the objects is what lets freed objects
+   stay constructed.
+
+     +------------+-----------------+-------+-------+-----+-------+
+     | struct slab| next[0..n-1]    | obj 0 | obj 1 | ... | obj n-1
+     +------------+-----------------+-------+-------+-----+-------+
+
+   An object's slab is found by rounding its address down to a
+   page boundary, as malloc() does for arenas. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x5ab1ca4e
+
+/* End of a slab's free chain. */
+#define SLAB_NONE UINT16_MAX
+
+/* Object alignment. */
+#define SLAB_ALIGN 8
+
+/* Slab header. */
+struct slab {
+  unsigned magic;           /* Always set to SLAB_MAGIC. */
+  struct slab_cache* cache; /* Owning cache. */
+  size_t in_use;            /* Objects not on the free chain. */
+  uint16_t free_idx;        /* First free object, or SLAB_NONE. */
+  struct list_elem elem;    /* Element in cache's partial list. */
+  uint16_t next[];          /* Free chain: index of next free object. */
+};
+
+/* All caches, for statistics. */
+static struct list cache_list;
+static struct lock cache_list_lock;
+
+/* Initializes the slab allocator. */
+void slab_init(void) {
+  list_init(&cache_list);
+  lock_init(&cache_list_lock);
+}
+
+/* Initializes CACHE to hand out objects of OBJ_SIZE bytes, named
+   NAME in statistics.  If CTOR is nonnull, it is called as
+   CTOR(OBJ, AUX) on each object when its slab is created. */
+void slab_cache_init(struct slab_cache* cache, const char* name, size_t obj_size,
+                     slab_ctor_func* ctor, void* aux) {
+  size_t n;
+
+  ASSERT(cache != NULL);
+  ASSERT(obj_size > 0);
+
+  /* Fit as many objects and their free-chain slots as possible
+     after the header, then give back slots lost to alignment. */
+  obj_size = ROUND_UP(obj_size, SLAB_ALIGN);
+  n = (PGSIZE - sizeof(struct slab)) / (obj_size + sizeof(uint16_t));
+  while (n > 0 &&
+         ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), SLAB_ALIGN) + n * obj_size > PGSIZE)
+    n--;
+  ASSERT(n > 0 && n < SLAB_NONE);
+
+  cache->name = name;
+  cache->obj_size = obj_size;
+  cache->obj_ofs = ROUND_UP(sizeof(struct slab) + n * sizeof(uint16_t), SLAB_ALIGN);
+  cache->objs_per_slab = n;
+  cache->ctor = ctor;
+  cache->aux = aux;
+  lock_init(&cache->lock);
+  list_init(&cache->partial);
+  cache->empty = NULL;
+  cache->slab_cnt = 0;
+  cache->mag_cnt = 0;
+  cache->allocs = 0;
+  cache->frees = 0;
+  cache->mag_hits = 0;
+
+  lock_acquire(&cache_list_lock);
+  list_push_back(&cache_list, &cache->elem);
+  lock_release(&cache_list_lock);
+}
+
+/* Returns object IDX of slab S. */
+static void* slab_obj(struct slab* s, size_t idx) {
+  return (uint8_t*)s + s->cache->obj_ofs + idx * s->cache->obj_size;
+}
+
+/* Returns the slab that OBJ is inside. */
+static struct slab* obj_to_slab(void* obj) {
+  struct slab* s = pg_round_down(obj);
+
+  /* Check that the slab is valid and OBJ is aligned within it. */
+  ASSERT(s != NULL);
+  ASSERT(s->magic == SLAB_MAGIC);
+  ASSERT(pg_ofs(obj) >= s->cache->obj_ofs);
+  ASSERT((pg_ofs(obj) - s->cache->obj_ofs) % s->cache->obj_size == 0);
+
+  return s;
+}
+
+/* Returns true if slab A has more objects in use than slab B. */
+static bool slab_more_used(const struct list_elem* a_, const struct list_elem* b_,
+                           void* aux UNUSED) {
+  const struct slab* a = list_entry(a_, struct slab, elem);
+  const struct slab* b = list_entry(b_, struct slab, elem);
+  return a->in_use > b->in_use;
+}
+
+/* Allocates a new slab for CACHE and constructs its objects.
+   Returns a null pointer if no page is available.
+   CACHE's lock must be held. */
+static struct slab* slab_create(struct slab_cache* cache) {
+  struct slab* s = palloc_get_page(0);
+  size_t i;
+
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->in_use = 0;
+  s->free_idx = 0;
+  for (i = 0; i < cache->objs_per_slab; i++) {
+    s->next[i] = i + 1 < cache->objs_per_slab ? i + 1 : SLAB_NONE;
+    if (cache->ctor != NULL)
+      cache->ctor(slab_obj(s, i), cache->aux);
+  }
+  cache->slab_cnt++;
+  return s;
+}
+
+/* Takes a free object from CACHE's slabs.  If none is free and
+   GROW is true, creates a new slab; otherwise returns a null
+   pointer.  CACHE's lock must be held. */
+static void* cache_take_locked(struct slab_cache* cache, bool grow) {
+  struct slab* s;
+  void* obj;
+
+  if (!list_empty(&cache->partial))
+    s = list_entry(list_front(&cache->partial), struct slab, elem);
+  else {
+    if (cache->empty != NULL) {
+      s = cache->empty;
+      cache->empty = NULL;
+    } else if (grow) {
+      s = slab_create(cache);
+      if (s == NULL)
+        return NULL;
+    } else
+      return NULL;
+
+    /* With one object in use, it is the least used partial slab. */
+    list_push_back(&cache->partial, &s->elem);
+  }
+
+  /* The front slab only gets fuller, so the list stays sorted. */
+  obj = slab_obj(s, s->free_idx);
+  s->free_idx = s->next[s->free_idx];
+  s->in_use++;
+  if (s->free_idx == SLAB_NONE)
+    list_remove(&s->elem);
+  return obj;
+}
+
+/* Returns OBJ to its slab in CACHE, releasing the slab's page if
+   it becomes unused and an empty slab is already held in reserve.
+   CACHE's lock must be held. */
+static void cache_put_locked(struct slab_cache* cache, void* obj) {
+  struct slab* s = obj_to_slab(obj);
+  size_t idx = (pg_ofs(obj) - cache->obj_ofs) / cache->obj_size;
+
+  ASSERT(s->cache == cache);
+  ASSERT(s->in_use > 0);
+
+  if (s->free_idx != SLAB_NONE)
+    list_remove(&s->elem);
+  s->next[idx] = s->free_idx;
+  s->free_idx = idx;
+  s->in_use--;
+
+  if (s->in_use > 0)
+    list_insert_ordered(&cache->partial, &s->elem, slab_more_used, NULL);
+  else if (cache->empty == NULL)
+    cache->empty = s;
+  else {
+    s->magic = 0;
+    palloc_free_page(s);
+    cache->slab_cnt--;
+  }
+}
+
+/* Obtains and returns a new object from CACHE.
+   Returns a null pointer if memory is not available. */
+void* slab_alloc(struct slab_cache* cache) {
+  void* batch[SLAB_MAGAZINE_SIZE / 2];
+  size_t batch_cnt = 0;
+  enum intr_level old_level;
+  void* obj;
+
+  ASSERT(!intr_context());
+
+  /* Fast path: pop the magazine. */
+  old_level = intr_disable();
+  if (cache->mag_cnt > 0) {
+    obj = cache->mag[--cache->mag_cnt];
+    cache->allocs++;
+    cache->mag_hits++;
+    intr_set_level(old_level);
+    return obj;
+  }
+  intr_set_level(old_level);
+
+  /* Slow path: take one object from the slabs, plus up to half a
+     magazine from existing slabs so the next allocations are fast. */
+  lock_acquire(&cache->lock);
+  obj = cache_take_locked(cache, true);
+  if (obj != NULL) {
+    void* extra;
+    while (batch_cnt < SLAB_MAGAZINE_SIZE / 2 &&
+           (extra = cache_take_locked(cache, false)) != NULL)
+      batch[batch_cnt++] = extra;
+
+    old_level = intr_disable();
+    while (batch_cnt > 0 && cache->mag_cnt < SLAB_MAGAZINE_SIZE)
+      cache->mag[cache->mag_cnt++] = batch[--batch_cnt];
+    cache->allocs++;
+    intr_set_level(old_level);
+
+    /* Other threads may have refilled the magazine meanwhile. */
+    while (batch_cnt > 0)
+      cache_put_locked(cache, batch[--batch_cnt]);
+  }
+  lock_release(&cache->lock);
+  return obj;
+}
+
+/* Frees OBJ, which must have been allocated from CACHE with
+   slab_alloc() and, if CACHE has a constructor, must be in its
+   constructed state. */
+void slab_free(struct slab_cache* cache, void* obj) {
+  void* batch[SLAB_MAGAZINE_SIZE / 2];
+  size_t batch_cnt;
+  enum intr_level old_level;
+
+  if (obj == NULL)
+    return;
+
+  ASSERT(!intr_context());
+  ASSERT(obj_to_slab(obj)->cache == cache);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     its constructed state must be preserved. */
+  if (cache->ctor == NULL)
+    memset(obj, 0xcc, cache->obj_size);
+#endif
+
+  /* Fast path: push onto the magazine. */
+  old_level = intr_disable();
+  if (cache->mag_cnt < SLAB_MAGAZINE_SIZE) {
+    cache->mag[cache->mag_cnt++] = obj;
+    cache->frees++;
+    intr_set_level(old_level);
+    return;
+  }
+  intr_set_level(old_level);
+
+  /* Slow path: move the older half of the magazine back to the
+     slabs, keeping OBJ, the most recently used, in the magazine. */
+  lock_acquire(&cache->lock);
+  old_level = intr_disable();
+  batch_cnt = cache->mag_cnt < SLAB_MAGAZINE_SIZE / 2 ? cache->mag_cnt : SLAB_MAGAZINE_SIZE / 2;
+  memcpy(batch, cache->mag, batch_cnt * sizeof *batch);
+  memmove(cache->mag, cache->mag + batch_cnt, (cache->mag_cnt - batch_cnt) * sizeof *batch);
+  cache->mag_cnt -= batch_cnt;
+  cache->mag[cache->mag_cnt++] = obj;
+  cache->frees++;
+  intr_set_level(old_level);
+
+  while (batch_cnt > 0)
+    cache_put_locked(cache, batch[--batch_cnt]);
+  lock_release(&cache->lock);
+}
+
+/* Prints usage of each cache that has been used. */
+void slab_print_stats(void) {
+  struct list_elem* e;
+
+  for (e = list_begin(&cache_list); e != list_end(&cache_list); e = list_next(e)) {
+    struct slab_cache* c = list_entry(e, struct slab_cache, elem);
+    if (c->allocs == 0)
+      continue;
+    printf("Slab: %s: %llu in use, %zu slabs of %zu, %llu allocs, %llu magazine hits\n", c->name,
+           c->allocs - c->frees, c->slab_cnt, c->objs_per_slab, c->allocs, c->mag_hits);
+  }
+}
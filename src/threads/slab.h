@@ -0,0 +1,75 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* Object caches for fixed-size kernel structures.
+
+   A slab cache hands out objects of one size.  Its backing store
+   is a set of "slabs", single pages from the page allocator that
+   are carved into equal objects.  Compared to malloc(), a cache
+   wastes no space rounding up to a power of 2, keeps objects of
+   one type together, and can keep objects in a constructed state
+   between uses: if a constructor is given, it runs once for each
+   object when its slab is created, and freed objects must be
+   returned in that same state (for example, with any embedded
+   lock released).
+
+   Each cache has a magazine, a small stack of recently freed
+   objects that is accessed with interrupts disabled rather than
+   under the cache lock.  Most allocations and frees only touch
+   the magazine.  When it runs empty or full, half a magazine's
+   worth of objects moves to or from the slabs under the lock.
+   The kernel runs on one CPU, so one magazine per cache plays
+   the role of a per-CPU magazine.
+
+   Slabs with both free and used objects sit on the cache's
+   partial list, fullest first, so new objects are packed into as
+   few pages as possible and lightly used slabs drain and are
+   returned to the page allocator.  One empty slab is kept to
+   absorb alloc/free bursts at a slab boundary.
+
+   Like malloc(), the cache functions may sleep and must not be
+   called from an interrupt handler. */
+
+/* Constructor: initializes OBJ, with auxiliary data AUX. */
+typedef void slab_ctor_func(void* obj, void* aux);
+
+/* Objects held in a cache's magazine. */
+#define SLAB_MAGAZINE_SIZE 16
+
+/* An object cache.  Treat as opaque outside slab.c. */
+struct slab_cache {
+  const char* name;      /* Name, for statistics. */
+  size_t obj_size;       /* Object size, rounded up for alignment. */
+  size_t obj_ofs;        /* Offset of the first object in a slab. */
+  size_t objs_per_slab;  /* Objects in each slab. */
+  slab_ctor_func* ctor;  /* Constructor, or NULL. */
+  void* aux;             /* Constructor argument. */
+  struct list_elem elem; /* Element in the list of all caches. */
+
+  /* Slab layer, protected by LOCK. */
+  struct lock lock;
+  struct list partial; /* Partially used slabs, most used first. */
+  struct slab* empty;  /* One unused slab kept in reserve, or NULL. */
+  size_t slab_cnt;     /* Slabs owned, including EMPTY. */
+
+  /* Magazine layer, protected by disabling interrupts. */
+  size_t mag_cnt;                 /* Objects in MAG. */
+  void* mag[SLAB_MAGAZINE_SIZE];  /* Free, constructed objects. */
+  uint64_t allocs;                /* Objects handed out. */
+  uint64_t frees;                 /* Objects given back. */
+  uint64_t mag_hits;              /* Allocations served from MAG. */
+};
+
+void slab_init(void);
+void slab_cache_init(struct slab_cache*, const char* name, size_t obj_size, slab_ctor_func*,
+                     void* aux);
+void* slab_alloc(struct slab_cache*) __attribute__((malloc));
+void slab_free(struct slab_cache*, void*);
+void slab_print_stats(void);
+
+#endif /* threads/slab.h */
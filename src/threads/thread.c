@@ -62,6 +62,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/fixed-point.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/switch.h"
@@ -72,6 +73,7 @@
 #include "threads/intr-stubs.h"
 #endif
 #ifdef USERPROG
+#include "userprog/kdata.h"
 #include "userprog/process.h"
 #endif
 
@@ -400,6 +402,13 @@ tid_t thread_create(const char* name, int priority, thread_func* function, void*
 
   /* Initialize thread. */
   init_thread(t, name, priority);
+  if (!fpu_thread_init(t)) {
+    enum intr_level old_level = intr_disable();
+    list_remove(&t->allelem);
+    intr_set_level(old_level);
+    palloc_free_page(t);
+    return TID_ERROR;
+  }
   tid = t->tid = allocate_tid();
 
   /* Set up stack frames for new thread bootstrap.
@@ -555,6 +564,11 @@ tid_t thread_tid(void) { return thread_current()->tid; }
 void thread_exit(void) {
   ASSERT(!intr_context());
 
+#ifdef USERPROG
+  kdata_thread_detach(thread_current());
+#endif
+  fpu_thread_exit(thread_current());
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_switch_tail(). */
@@ -901,6 +915,7 @@ static void init_thread(struct thread* t, const char* name, int priority) {
   t->pcb = NULL;
   /* pcb_elem will be added to pcb->threads when pcb_init() is called */
   t->cwd = NULL;
+  t->kdata_slot = 0;
 #endif
   t->magic = THREAD_MAGIC;
   t->wake_up_tick = 0;
@@ -1150,6 +1165,10 @@ void thread_switch_tail(struct thread* prev) {
   process_activate();
 #endif
 
+  /* Leave the FPU enabled only for the thread whose registers it
+     holds. */
+  fpu_activate();
+
   /* If the thread we switched from is dying, destroy its struct
      thread.  This must happen late so that thread_exit() doesn't
      pull out the rug under itself.  (We don't free
@@ -1194,6 +1213,8 @@ static tid_t allocate_tid(void) {
   return tid;
 }
 
+tid_t thread_allocate_tid(void) { return allocate_tid(); }
+
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof(struct thread, stack);
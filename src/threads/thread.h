@@ -214,6 +214,14 @@ struct thread {
   int nice;       /* Nice value: -20 (high priority) to +20 (low priority). */
   int recent_cpu; /* Recent CPU usage (17.14 fixed-point format). */
 
+  /* ═══════════════════════════════════════════════════════════════════════
+   * FPU STATE
+   * ─────────────────────────────────────────────────────────────────────────
+   * Owned by fpu.c.  Registers are saved here only when another thread
+   * takes over the FPU, not on every switch.
+   * ═══════════════════════════════════════════════════════════════════════*/
+  void* fpu; /* FPU save area (slab object; see fpu_area()). */
+
 #ifdef USERPROG
   /* ═══════════════════════════════════════════════════════════════════════
    * USER PROGRAM SUPPORT
@@ -227,6 +235,7 @@ struct thread {
   void* syscall_esp;                /* User ESP saved on syscall entry (for page fault handler). */
   struct pthread_status* my_status; /* Status struct for pthread join synchronization. */
   struct dir* cwd;                  /* Current working directory (per-thread in PintOS). */
+  size_t kdata_slot;                /* Entry in the kernel data page's thread table, or 0. */
 #endif
 
 #ifdef FILESYS
@@ -306,6 +315,10 @@ typedef void thread_func(void* aux);
 tid_t thread_create(const char* name, int priority, thread_func*, void*);
 void thread_exit(void) NO_RETURN;
 
+/* Returns a tid no thread has had, for a pooled user thread taking on a
+   new identity (userprog/process.c). */
+tid_t thread_allocate_tid(void);
+
 /* Blocking and unblocking. */
 void thread_block(void);
 void thread_unblock(struct thread*);
@@ -0,0 +1,73 @@
+#include "threads/waitq.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+void wait_queue_init(struct wait_queue* wq) { list_init(&wq->entries); }
+
+void wait_entry_init(struct wait_entry* entry, wait_func* func, void* aux) {
+  entry->wq = NULL;
+  entry->func = func;
+  entry->aux = aux;
+}
+
+void wait_queue_add(struct wait_queue* wq, struct wait_entry* entry) {
+  enum intr_level old_level = intr_disable();
+  ASSERT(entry->wq == NULL);
+  entry->wq = wq;
+  list_push_back(&wq->entries, &entry->elem);
+  intr_set_level(old_level);
+}
+
+void wait_queue_remove(struct wait_entry* entry) {
+  enum intr_level old_level = intr_disable();
+  if (entry->wq != NULL) {
+    list_remove(&entry->elem);
+    entry->wq = NULL;
+  }
+  intr_set_level(old_level);
+}
+
+void wait_queue_wake(struct wait_queue* wq, unsigned events) {
+  enum intr_level old_level = intr_disable();
+  for (struct list_elem* e = list_begin(&wq->entries); e != list_end(&wq->entries);) {
+    /* FUNC may not remove its own entry, but read ahead anyway. */
+    struct wait_entry* entry = list_entry(e, struct wait_entry, elem);
+    e = list_next(e);
+    entry->func(entry, events);
+  }
+  intr_set_level(old_level);
+}
+
+void waiter_init(struct waiter* w) {
+  w->thread = thread_current();
+  w->woken = false;
+  w->sleeping = false;
+}
+
+bool waiter_wait(struct waiter* w, int64_t ticks) {
+  ASSERT(w->thread == thread_current());
+  ASSERT(!intr_context());
+
+  enum intr_level old_level = intr_disable();
+  if (!w->woken && ticks != 0) {
+    w->sleeping = true;
+    timer_block(ticks);
+    w->sleeping = false;
+  }
+  bool woken = w->woken;
+  w->woken = false;
+  intr_set_level(old_level);
+  return woken;
+}
+
+void waiter_wake(struct waiter* w) {
+  enum intr_level old_level = intr_disable();
+  w->woken = true;
+  if (w->sleeping) {
+    w->sleeping = false;
+    timer_wake(w->thread);
+  }
+  intr_set_level(old_level);
+}
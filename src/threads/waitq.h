@@ -0,0 +1,73 @@
+#ifndef THREADS_WAITQ_H
+#define THREADS_WAITQ_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Wait queues and waiters, for waiting on several objects at once.
+
+   An object that others may wait on embeds a wait queue and wakes
+   it, with a mask of the events that occurred, whenever its state
+   changes.  Each wait entry on the queue names a function to call.
+   Unlike a condition variable, a thread can have entries on any
+   number of queues while it sleeps, which is what poll() and
+   epoll need.
+
+   Wake functions run with interrupts disabled, possibly from an
+   interrupt handler, so they must not sleep.  Typically they
+   record the event and call waiter_wake().
+
+   A waiter is the sleeping side: a thread blocks in waiter_wait()
+   until some wake function calls waiter_wake() or a timeout
+   passes.  A wake that arrives before the thread blocks is not
+   lost; the next waiter_wait() returns at once.
+
+   Queues and entries are protected by disabling interrupts. */
+
+struct wait_entry;
+
+/* Called with interrupts off when ENTRY's queue is woken with EVENTS. */
+typedef void wait_func(struct wait_entry* entry, unsigned events);
+
+struct wait_queue {
+  struct list entries; /* Entries waiting, in order added. */
+};
+
+struct wait_entry {
+  struct list_elem elem;  /* Element in wq->entries. */
+  struct wait_queue* wq;  /* Queue this entry is on, or NULL. */
+  wait_func* func;        /* Called on wakeup. */
+  void* aux;              /* For FUNC's use. */
+};
+
+void wait_queue_init(struct wait_queue*);
+void wait_entry_init(struct wait_entry*, wait_func*, void* aux);
+
+/* Adds ENTRY, which must not be on a queue, to WQ. */
+void wait_queue_add(struct wait_queue* wq, struct wait_entry* entry);
+
+/* Removes ENTRY from its queue, if it is on one. */
+void wait_queue_remove(struct wait_entry* entry);
+
+/* Calls every entry on WQ with EVENTS.  Safe in interrupt context. */
+void wait_queue_wake(struct wait_queue* wq, unsigned events);
+
+struct waiter {
+  struct thread* thread; /* Thread that waits. */
+  bool woken;            /* Woken since the last waiter_wait()? */
+  bool sleeping;         /* Blocked in waiter_wait()? */
+};
+
+void waiter_init(struct waiter*);
+
+/* Blocks until waiter_wake() or, if TICKS is not negative, until TICKS
+   timer ticks pass.  Returns true if woken, false on timeout. */
+bool waiter_wait(struct waiter*, int64_t ticks);
+
+/* Wakes the waiter's thread.  Safe in interrupt context. */
+void waiter_wake(struct waiter*);
+
+#endif /* threads/waitq.h */
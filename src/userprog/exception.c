@@ -25,7 +25,7 @@
  * ║    │    4    │ #OF Overflow (INTO)                                   │   ║
  * ║    │    5    │ #BR BOUND Range Exceeded                              │   ║
  * ║    │    6    │ #UD Invalid Opcode                                    │   ║
- * ║    │    7    │ #NM Device Not Available (no FPU)                     │   ║
+ * ║    │    7    │ #NM Device Not Available (threads/fpu.c)              │   ║
  * ║    │   11    │ #NP Segment Not Present                               │   ║
  * ║    │   12    │ #SS Stack Fault                                       │   ║
  * ║    │   13    │ #GP General Protection (catch-all)                    │   ║
@@ -116,7 +116,6 @@ void exception_init(void) {
   intr_register_int(0, 0, INTR_ON, kill, "#DE Divide Error");
   intr_register_int(1, 0, INTR_ON, kill, "#DB Debug Exception");
   intr_register_int(6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-  intr_register_int(7, 0, INTR_ON, kill, "#NM Device Not Available Exception");
   intr_register_int(11, 0, INTR_ON, kill, "#NP Segment Not Present");
   intr_register_int(12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
   intr_register_int(13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -133,6 +132,28 @@ void exception_init(void) {
 /* Prints exception statistics. */
 void exception_print_stats(void) { printf("Exception: %lld page faults\n", page_fault_cnt); }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * EXCEPTION TABLE
+ * ─────────────────────────────────────────────────────────────────────────────
+ * Collected by the linker script between _start_ex_table and _end_ex_table.
+ * There are only a handful of entries, so a linear search is fine.
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* One entry, as emitted by EXCEPTION_TABLE_ENTRY. */
+struct exception_table_entry {
+  uintptr_t insn;  /* Instruction that may fault on a user address. */
+  uintptr_t fixup; /* Where to resume if it does. */
+};
+
+extern const struct exception_table_entry _start_ex_table[], _end_ex_table[];
+
+uintptr_t exception_fixup(uintptr_t pc) {
+  for (const struct exception_table_entry* e = _start_ex_table; e < _end_ex_table; e++)
+    if (e->insn == pc)
+      return e->fixup;
+  return 0;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * EXCEPTION HANDLERS (x86-specific)
  * ═══════════════════════════════════════════════════════════════════════════*/
@@ -251,6 +272,13 @@ static void page_fault(struct intr_frame* f) {
      Check if this is kernel code accessing user memory (syscall context).
      In this case, we should kill the user process, not panic the kernel. */
   if (!user && is_user_vaddr(fault_addr)) {
+    /* A uaccess primitive reports the failure to its caller. */
+    uintptr_t fixup = exception_fixup((uintptr_t)f->eip);
+    if (fixup != 0) {
+      f->eip = (void (*)(void))fixup;
+      return;
+    }
+
     /* Kernel code tried to access invalid user memory (bad syscall pointer).
        Kill the user process with exit code -1. */
     f->eax = -1;
@@ -317,6 +345,13 @@ void riscv_page_fault(struct intr_frame* f) {
   /* VM couldn't handle the fault (or VM disabled).
      Check if this is kernel code accessing user memory (syscall context). */
   if (!user && is_user_vaddr(fault_addr)) {
+    /* A uaccess primitive reports the failure to its caller. */
+    uintptr_t fixup = exception_fixup(f->sepc);
+    if (fixup != 0) {
+      f->sepc = fixup;
+      return;
+    }
+
     /* Kernel code tried to access invalid user memory (bad syscall pointer).
        Kill the user process with exit code -1. */
     f->a0 = -1;
@@ -34,8 +34,8 @@
  *                             /   \
  *                            ▼     ▼
  *                    ┌───────────┐ ┌───────────┐
- *                    │ Kill user │ │ Kill/Panic│
- *                    │ process   │ │           │
+ *                    │ Fixup, or │ │ Kill/Panic│
+ *                    │ kill user │ │           │
  *                    └───────────┘ └───────────┘
  *
  * vm_handle_fault() checks (in order):
@@ -57,6 +57,8 @@
 #ifndef USERPROG_EXCEPTION_H
 #define USERPROG_EXCEPTION_H
 
+#include <stdint.h>
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * PAGE FAULT ERROR CODE BITS
  * ═══════════════════════════════════════════════════════════════════════════
@@ -91,6 +93,35 @@ void exception_init(void);
 /* Prints exception statistics (number of page faults). */
 void exception_print_stats(void);
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * EXCEPTION TABLE
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Kernel code that accesses user memory (userprog/uaccess.c) records each
+ * instruction that may fault in the __ex_table section, along with a fixup
+ * address.  When such an instruction faults on a user address that the VM
+ * system cannot resolve, the page fault handler resumes at the fixup
+ * instead of killing the process.
+ *
+ * Use inside an asm statement, with INSN and FIXUP as label references:
+ *
+ *   asm ("1: movb %1, %0\n\t"
+ *        "2:\n\t" EXCEPTION_TABLE_ENTRY("1b", "2b") ...);
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+#ifdef ARCH_RISCV64
+#define EXCEPTION_TABLE_ENTRY(INSN, FIXUP)                                                         \
+  ".pushsection __ex_table, \"a\"\n\t.balign 8\n\t.dword " INSN ", " FIXUP "\n\t.popsection\n\t"
+#else
+#define EXCEPTION_TABLE_ENTRY(INSN, FIXUP)                                                         \
+  ".pushsection __ex_table, \"a\"\n\t.balign 4\n\t.long " INSN ", " FIXUP "\n\t.popsection\n\t"
+#endif
+
+/* Returns the fixup address for a fault at kernel address PC, or 0 if
+   PC is not in the exception table. */
+uintptr_t exception_fixup(uintptr_t pc);
+
 #ifdef ARCH_RISCV64
 /* Forward declaration of RISC-V interrupt frame */
 struct intr_frame;
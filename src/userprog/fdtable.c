@@ -0,0 +1,230 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+
+/* Descriptors the allocator never hands out (stdin, stdout, stderr). */
+#define FD_RESERVED 3
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * BITMAP
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Returns the index of the lowest set bit in X, which must be nonzero. */
+static inline unsigned bit_scan_forward(uint32_t x) {
+  ASSERT(x != 0);
+#ifdef ARCH_I386
+  uint32_t bit;
+  asm("bsfl %1, %0" : "=r"(bit) : "rm"(x));
+  return bit;
+#else
+  /* Without Zbb, __builtin_ctz() would need libgcc. */
+  unsigned bit = 0;
+  if ((x & 0xffff) == 0) {
+    x >>= 16;
+    bit += 16;
+  }
+  if ((x & 0xff) == 0) {
+    x >>= 8;
+    bit += 8;
+  }
+  if ((x & 0xf) == 0) {
+    x >>= 4;
+    bit += 4;
+  }
+  if ((x & 0x3) == 0) {
+    x >>= 2;
+    bit += 2;
+  }
+  return bit + ((x & 1) == 0);
+#endif
+}
+
+/* Number of free_map and summary words for a table of SIZE entries. */
+static inline size_t map_words(int size) { return size / 32; }
+static inline size_t summary_words(int size) { return DIV_ROUND_UP(map_words(size), 32); }
+
+static void mark_free(struct fd_array* a, int fd) {
+  size_t w = fd / 32;
+  a->free_map[w] |= 1u << (fd % 32);
+  a->summary[w / 32] |= 1u << (w % 32);
+}
+
+static void mark_used(struct fd_array* a, int fd) {
+  size_t w = fd / 32;
+  a->free_map[w] &= ~(1u << (fd % 32));
+  if (a->free_map[w] == 0)
+    a->summary[w / 32] &= ~(1u << (w % 32));
+}
+
+/* Returns the lowest free descriptor in A, or -1 if there is none. */
+static int lowest_free(const struct fd_array* a) {
+  size_t cnt = summary_words(a->size);
+  for (size_t s = 0; s < cnt; s++) {
+    if (a->summary[s] != 0) {
+      size_t w = s * 32 + bit_scan_forward(a->summary[s]);
+      return w * 32 + bit_scan_forward(a->free_map[w]);
+    }
+  }
+  return -1;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * GENERATIONS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Sets up FDT's first generation, empty. */
+static void init_first(struct fd_table* fdt) {
+  struct fd_array* a = &fdt->first;
+
+  a->size = FD_TABLE_INLINE;
+  a->entries = fdt->first_entries;
+  a->free_map = fdt->first_free_map;
+  a->summary = fdt->first_summary;
+  a->prev = NULL;
+
+  memset(fdt->first_entries, 0, sizeof fdt->first_entries);
+  memset(fdt->first_free_map, 0, sizeof fdt->first_free_map);
+  memset(fdt->first_summary, 0, sizeof fdt->first_summary);
+  for (int fd = FD_RESERVED; fd < FD_TABLE_INLINE; fd++)
+    mark_free(a, fd);
+
+  fdt->cur = a;
+}
+
+/* Replaces FDT's current generation with one twice the size.  The caller
+   holds FDT's lock or is the table's only user.  Returns false if the
+   table is at FD_TABLE_MAX or memory is short. */
+static bool grow(struct fd_table* fdt) {
+  struct fd_array* old = fdt->cur;
+  if (old->size >= FD_TABLE_MAX)
+    return false;
+
+  int size = old->size * 2;
+  size_t entry_bytes = size * sizeof(struct fd_entry);
+  size_t map_bytes = map_words(size) * sizeof(uint32_t);
+  size_t summary_bytes = summary_words(size) * sizeof(uint32_t);
+  struct fd_array* a = malloc(sizeof *a + entry_bytes + map_bytes + summary_bytes);
+  if (a == NULL)
+    return false;
+
+  a->size = size;
+  a->entries = (struct fd_entry*)(a + 1);
+  a->free_map = (uint32_t*)((uint8_t*)a->entries + entry_bytes);
+  a->summary = (uint32_t*)((uint8_t*)a->free_map + map_bytes);
+  a->prev = old;
+
+  /* The new upper half is all free. */
+  size_t old_words = map_words(old->size);
+  memcpy(a->entries, old->entries, old->size * sizeof(struct fd_entry));
+  memset(a->entries + old->size, 0, entry_bytes - old->size * sizeof(struct fd_entry));
+  memcpy(a->free_map, old->free_map, old_words * sizeof(uint32_t));
+  memset(a->free_map + old_words, 0xff, map_bytes - old_words * sizeof(uint32_t));
+  memset(a->summary, 0, summary_bytes);
+  for (size_t w = 0; w < map_words(size); w++)
+    if (a->free_map[w] != 0)
+      a->summary[w / 32] |= 1u << (w % 32);
+
+  /* Lockless readers must see the contents before the pointer. */
+  barrier();
+  fdt->cur = a;
+  return true;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * TABLE OPERATIONS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+void fd_table_init(struct fd_table* fdt) {
+  lock_init(&fdt->lock);
+  init_first(fdt);
+}
+
+/* Closes every descriptor in FDT and frees all generations but the
+   first, leaving FDT empty. */
+void fd_table_destroy(struct fd_table* fdt) {
+  struct fd_array* a = fdt->cur;
+
+  for (int fd = 0; fd < a->size; fd++)
+    if (a->entries[fd].ofd != NULL)
+      ofd_close(a->entries[fd].ofd);
+
+  while (a != &fdt->first) {
+    struct fd_array* prev = a->prev;
+    free(a);
+    a = prev;
+  }
+  init_first(fdt);
+}
+
+int fd_table_install(struct fd_table* fdt, struct open_file_desc* ofd) {
+  ASSERT(ofd != NULL);
+
+  lock_acquire(&fdt->lock);
+  int fd = lowest_free(fdt->cur);
+  if (fd == -1 && grow(fdt))
+    fd = lowest_free(fdt->cur);
+  if (fd != -1) {
+    fdt->cur->entries[fd].ofd = ofd;
+    mark_used(fdt->cur, fd);
+  }
+  lock_release(&fdt->lock);
+  return fd;
+}
+
+void fd_table_set(struct fd_table* fdt, int fd, struct open_file_desc* ofd) {
+  ASSERT(fd >= 0 && fd < FD_TABLE_INLINE);
+  ASSERT(ofd != NULL);
+
+  lock_acquire(&fdt->lock);
+  struct fd_array* a = fdt->cur;
+  ASSERT(a->entries[fd].ofd == NULL);
+  a->entries[fd].ofd = ofd;
+  if (fd >= FD_RESERVED)
+    mark_used(a, fd);
+  lock_release(&fdt->lock);
+}
+
+struct open_file_desc* fd_table_remove(struct fd_table* fdt, int fd) {
+  struct open_file_desc* ofd = NULL;
+
+  lock_acquire(&fdt->lock);
+  struct fd_array* a = fdt->cur;
+  if (fd >= 0 && fd < a->size && a->entries[fd].ofd != NULL) {
+    ofd = a->entries[fd].ofd;
+    a->entries[fd].ofd = NULL;
+    if (fd >= FD_RESERVED)
+      mark_free(a, fd);
+  }
+  lock_release(&fdt->lock);
+  return ofd;
+}
+
+bool fd_table_copy(struct fd_table* dst, struct fd_table* src) {
+  bool success = true;
+
+  fd_table_destroy(dst);
+
+  lock_acquire(&src->lock);
+  while (dst->cur->size < src->cur->size) {
+    if (!grow(dst)) {
+      success = false;
+      break;
+    }
+  }
+  if (success) {
+    struct fd_array* d = dst->cur;
+    struct fd_array* s = src->cur;
+    for (int fd = 0; fd < s->size; fd++)
+      if (s->entries[fd].ofd != NULL)
+        d->entries[fd].ofd = ofd_dup(s->entries[fd].ofd);
+    memcpy(d->free_map, s->free_map, map_words(s->size) * sizeof(uint32_t));
+    memcpy(d->summary, s->summary, summary_words(s->size) * sizeof(uint32_t));
+  }
+  lock_release(&src->lock);
+
+  if (!success)
+    fd_table_destroy(dst);
+  return success;
+}
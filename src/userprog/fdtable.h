@@ -0,0 +1,89 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "userprog/filedesc.h"
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * PER-PROCESS FILE DESCRIPTOR TABLE
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Maps descriptor numbers to open file descriptions.  The table starts with
+ * FD_TABLE_INLINE entries stored inside struct fd_table itself and doubles
+ * whenever it fills, up to FD_TABLE_MAX.
+ *
+ * Free descriptors are tracked by a two-level bitmap, one bit per
+ * descriptor set while it is free, plus one summary bit per 32-bit word set
+ * while that word has any free bit.  The lowest free descriptor is found
+ * with two bit scans per summary word, and there is one summary word per
+ * 1024 descriptors.
+ *
+ * SYNCHRONIZATION:
+ *   - fd_table_get() takes no lock.  It reads the current generation of
+ *     the table through a single pointer.
+ *   - Everything that changes the table holds fdt->lock.
+ *   - Growth publishes a new generation.  Older generations stay allocated
+ *     until fd_table_destroy(), so a reader holding one never sees freed
+ *     memory.  Together they are smaller than the current one.
+ *
+ * Descriptors 0, 1, and 2 are only ever assigned by fd_table_set().  The
+ * allocator hands out 3 and up, even after the standard streams close.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Entries embedded in struct fd_table; one bitmap word. */
+#define FD_TABLE_INLINE 32
+
+/* Largest table size, a power of 2. */
+#define FD_TABLE_MAX 32768
+
+/* One generation of the table. */
+struct fd_array {
+  int size;                 /* Number of entries, a power of 2. */
+  struct fd_entry* entries; /* SIZE entries. */
+  uint32_t* free_map;       /* SIZE / 32 words; bit set while fd is free. */
+  uint32_t* summary;        /* One bit per free_map word that is nonzero. */
+  struct fd_array* prev;    /* Previous generation, or NULL. */
+};
+
+struct fd_table {
+  struct fd_array* cur; /* Current generation. */
+  struct lock lock;     /* Serializes changes to the table. */
+
+  /* Storage for the first generation. */
+  struct fd_array first;
+  struct fd_entry first_entries[FD_TABLE_INLINE];
+  uint32_t first_free_map[FD_TABLE_INLINE / 32];
+  uint32_t first_summary[1];
+};
+
+void fd_table_init(struct fd_table*);
+void fd_table_destroy(struct fd_table*);
+
+/* Returns the OFD for FD, or NULL if FD is out of range or unused. */
+static inline struct open_file_desc* fd_table_get(struct fd_table* fdt, int fd) {
+  struct fd_array* a = fdt->cur;
+  barrier();
+  return fd >= 0 && fd < a->size ? a->entries[fd].ofd : NULL;
+}
+
+/* Installs OFD at the lowest free descriptor (3 or greater) and returns
+   it, or returns -1 if the table is full.  The table takes over the
+   caller's reference to OFD only on success. */
+int fd_table_install(struct fd_table*, struct open_file_desc* ofd);
+
+/* Installs OFD at FD, which must be below FD_TABLE_INLINE and unused. */
+void fd_table_set(struct fd_table*, int fd, struct open_file_desc* ofd);
+
+/* Clears FD and returns its OFD, or NULL if FD was not in use.  The
+   caller takes over the table's reference. */
+struct open_file_desc* fd_table_remove(struct fd_table*, int fd);
+
+/* Replaces the contents of DST, which no other thread may be using, with
+   new references to every OFD in SRC.  Returns false if out of memory, in
+   which case DST is left empty. */
+bool fd_table_copy(struct fd_table* dst, struct fd_table* src);
+
+#endif /* userprog/fdtable.h */
@@ -3,7 +3,13 @@
 #include <stdio.h>
 #include "filesys/file.h"
 #include "filesys/directory.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "userprog/pipe.h"
+#include "userprog/poll.h"
+#include "userprog/uring.h"
+#ifdef VM
+#include "vm/shm.h"
+#endif
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * GLOBAL STATE
@@ -22,6 +28,17 @@ static struct open_file_desc console_stdin;
 static struct open_file_desc console_stdout;
 static struct open_file_desc console_stderr;
 
+/* Cache of dynamically created OFDs.  Each object's lock and epoll
+   item list are initialized once, by the constructor, and are always
+   free and empty when the OFD is freed. */
+static struct slab_cache ofd_cache;
+
+static void ofd_ctor(void* obj, void* aux UNUSED) {
+  struct open_file_desc* ofd = obj;
+  lock_init(&ofd->lock);
+  list_init(&ofd->epitems);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * INITIALIZATION
  * ═══════════════════════════════════════════════════════════════════════════*/
@@ -29,6 +46,7 @@ static struct open_file_desc console_stderr;
 void ofd_init(void) {
   list_init(&ofd_list);
   lock_init(&ofd_list_lock);
+  slab_cache_init(&ofd_cache, "open_file_desc", sizeof(struct open_file_desc), ofd_ctor, NULL);
 
   /* Initialize stdin OFD. */
   console_stdin.type = FD_CONSOLE;
@@ -37,6 +55,7 @@ void ofd_init(void) {
   console_stdin.flags = 0;
   console_stdin.ref_count = 1; /* Never goes to 0. */
   lock_init(&console_stdin.lock);
+  list_init(&console_stdin.epitems);
 
   /* Initialize stdout OFD. */
   console_stdout.type = FD_CONSOLE;
@@ -45,6 +64,7 @@ void ofd_init(void) {
   console_stdout.flags = 0;
   console_stdout.ref_count = 1;
   lock_init(&console_stdout.lock);
+  list_init(&console_stdout.epitems);
 
   /* Initialize stderr OFD. */
   console_stderr.type = FD_CONSOLE;
@@ -53,6 +73,7 @@ void ofd_init(void) {
   console_stderr.flags = 0;
   console_stderr.ref_count = 1;
   lock_init(&console_stderr.lock);
+  list_init(&console_stderr.epitems);
 
   /* Add console OFDs to global list (for debugging/introspection). */
   lock_acquire(&ofd_list_lock);
@@ -69,7 +90,7 @@ void ofd_init(void) {
 struct open_file_desc* ofd_create_file(struct file* file) {
   ASSERT(file != NULL);
 
-  struct open_file_desc* ofd = malloc(sizeof(struct open_file_desc));
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
   if (ofd == NULL)
     return NULL;
 
@@ -78,7 +99,6 @@ struct open_file_desc* ofd_create_file(struct file* file) {
   ofd->file = file;
   ofd->flags = 0;
   ofd->ref_count = 1;
-  lock_init(&ofd->lock);
 
   lock_acquire(&ofd_list_lock);
   list_push_back(&ofd_list, &ofd->elem);
@@ -90,7 +110,7 @@ struct open_file_desc* ofd_create_file(struct file* file) {
 struct open_file_desc* ofd_create_dir(struct dir* dir) {
   ASSERT(dir != NULL);
 
-  struct open_file_desc* ofd = malloc(sizeof(struct open_file_desc));
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
   if (ofd == NULL)
     return NULL;
 
@@ -99,7 +119,86 @@ struct open_file_desc* ofd_create_dir(struct dir* dir) {
   ofd->dir = dir;
   ofd->flags = 0;
   ofd->ref_count = 1;
-  lock_init(&ofd->lock);
+
+  lock_acquire(&ofd_list_lock);
+  list_push_back(&ofd_list, &ofd->elem);
+  lock_release(&ofd_list_lock);
+
+  return ofd;
+}
+
+struct open_file_desc* ofd_create_shm(struct shm_object* shm) {
+  ASSERT(shm != NULL);
+
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
+  if (ofd == NULL)
+    return NULL;
+
+  ofd->type = FD_SHM;
+  ofd->cmode = CONSOLE_READ; /* Not used for shared memory. */
+  ofd->shm = shm;
+  ofd->flags = 0;
+  ofd->ref_count = 1;
+
+  lock_acquire(&ofd_list_lock);
+  list_push_back(&ofd_list, &ofd->elem);
+  lock_release(&ofd_list_lock);
+
+  return ofd;
+}
+
+struct open_file_desc* ofd_create_pipe(struct pipe* pipe, bool writer) {
+  ASSERT(pipe != NULL);
+
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
+  if (ofd == NULL)
+    return NULL;
+
+  ofd->type = FD_PIPE;
+  ofd->cmode = writer ? CONSOLE_WRITE : CONSOLE_READ;
+  ofd->pipe = pipe;
+  ofd->flags = 0;
+  ofd->ref_count = 1;
+
+  lock_acquire(&ofd_list_lock);
+  list_push_back(&ofd_list, &ofd->elem);
+  lock_release(&ofd_list_lock);
+
+  return ofd;
+}
+
+struct open_file_desc* ofd_create_epoll(struct epoll* ep) {
+  ASSERT(ep != NULL);
+
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
+  if (ofd == NULL)
+    return NULL;
+
+  ofd->type = FD_EPOLL;
+  ofd->cmode = CONSOLE_READ; /* Not used for epoll. */
+  ofd->epoll = ep;
+  ofd->flags = 0;
+  ofd->ref_count = 1;
+
+  lock_acquire(&ofd_list_lock);
+  list_push_back(&ofd_list, &ofd->elem);
+  lock_release(&ofd_list_lock);
+
+  return ofd;
+}
+
+struct open_file_desc* ofd_create_uring(struct uring* ring) {
+  ASSERT(ring != NULL);
+
+  struct open_file_desc* ofd = slab_alloc(&ofd_cache);
+  if (ofd == NULL)
+    return NULL;
+
+  ofd->type = FD_URING;
+  ofd->cmode = CONSOLE_READ; /* Not used for rings. */
+  ofd->uring = ring;
+  ofd->flags = 0;
+  ofd->ref_count = 1;
 
   lock_acquire(&ofd_list_lock);
   list_push_back(&ofd_list, &ofd->elem);
@@ -161,14 +260,26 @@ void ofd_close(struct open_file_desc* ofd) {
     lock_release(&ofd->lock);
     lock_release(&ofd_list_lock);
 
-    /* Close the underlying file/directory. */
+    /* Stop epoll watching it, then close the underlying object. */
+    epoll_release(ofd);
     if (ofd->type == FD_FILE && ofd->file != NULL) {
       file_close(ofd->file);
     } else if (ofd->type == FD_DIR && ofd->dir != NULL) {
       dir_close(ofd->dir);
+    } else if (ofd->type == FD_PIPE) {
+      pipe_close(ofd->pipe, ofd->cmode == CONSOLE_WRITE);
+    } else if (ofd->type == FD_EPOLL) {
+      epoll_close(ofd->epoll);
+    } else if (ofd->type == FD_URING) {
+      uring_close(ofd->uring);
+    }
+#ifdef VM
+    else if (ofd->type == FD_SHM && ofd->shm != NULL) {
+      shm_unref(ofd->shm);
     }
+#endif
 
-    free(ofd);
+    slab_free(&ofd_cache, ofd);
   } else {
     lock_release(&ofd->lock);
     lock_release(&ofd_list_lock);
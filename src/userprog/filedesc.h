@@ -7,7 +7,11 @@
 
 /* Forward declarations. */
 struct file;
+struct shm_object;
 struct dir;
+struct pipe;
+struct epoll;
+struct uring;
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * OPEN FILE DESCRIPTION (OFD) - POSIX "open file description"
@@ -41,10 +45,14 @@ enum fd_type {
   FD_NONE,   /* Unused slot (should not occur for valid OFD). */
   FD_FILE,   /* Regular file. */
   FD_DIR,    /* Directory. */
-  FD_CONSOLE /* Console device (stdin/stdout/stderr). */
+  FD_CONSOLE, /* Console device (stdin/stdout/stderr). */
+  FD_SHM,     /* Shared memory object (shm_open). */
+  FD_PIPE,    /* One end of a pipe. */
+  FD_EPOLL,   /* Epoll instance (epoll_create). */
+  FD_URING    /* Asynchronous I/O ring (io_uring_setup). */
 };
 
-/* Console I/O mode (only used when type == FD_CONSOLE). */
+/* I/O direction (only used when type is FD_CONSOLE or FD_PIPE). */
 enum console_mode {
   CONSOLE_READ, /* stdin - read from keyboard. */
   CONSOLE_WRITE /* stdout/stderr - write to display. */
@@ -54,13 +62,19 @@ enum console_mode {
 struct open_file_desc {
   struct list_elem elem;   /* Element in global OFD list. */
   enum fd_type type;       /* Type: file, directory, or console. */
-  enum console_mode cmode; /* Console mode (if type == FD_CONSOLE). */
+  enum console_mode cmode; /* Direction (if type is FD_CONSOLE or FD_PIPE). */
 
   union {
     struct file* file; /* Underlying file (type == FD_FILE). */
     struct dir* dir;   /* Underlying directory (type == FD_DIR). */
+    struct shm_object* shm; /* Shared memory object (type == FD_SHM). */
+    struct pipe* pipe;      /* Pipe (type == FD_PIPE). */
+    struct epoll* epoll;    /* Epoll instance (type == FD_EPOLL). */
+    struct uring* uring;    /* I/O ring (type == FD_URING). */
   };
 
+  struct list epitems; /* Epoll items watching this OFD, under epoll's lock. */
+
   int flags;        /* File status flags (O_APPEND, etc. for future fcntl). */
   int ref_count;    /* Number of FDs referencing this OFD. */
   struct lock lock; /* Per-OFD lock for thread-safe operations. */
@@ -84,6 +98,23 @@ struct open_file_desc* ofd_create_file(struct file* file);
 /* Create a new OFD for a directory. Returns NULL on failure. */
 struct open_file_desc* ofd_create_dir(struct dir* dir);
 
+/* Create a new OFD for a shared memory object.  Takes over the caller's
+   reference to SHM on success. Returns NULL on failure. */
+struct open_file_desc* ofd_create_shm(struct shm_object* shm);
+
+/* Create a new OFD for the read end of PIPE, or the write end if WRITER.
+   Takes over the caller's hold on that end on success. Returns NULL on
+   failure. */
+struct open_file_desc* ofd_create_pipe(struct pipe* pipe, bool writer);
+
+/* Create a new OFD for epoll instance EP, taking it over on success.
+   Returns NULL on failure. */
+struct open_file_desc* ofd_create_epoll(struct epoll* ep);
+
+/* Create a new OFD for I/O ring RING, taking it over on success.
+   Returns NULL on failure. */
+struct open_file_desc* ofd_create_uring(struct uring* ring);
+
 /* Get the global console OFD (stdin, stdout, or stderr).
    fd must be STDIN_FILENO (0), STDOUT_FILENO (1), or STDERR_FILENO (2). */
 struct open_file_desc* ofd_get_console(int fd);
@@ -35,13 +35,15 @@ static uint64_t make_gdtr_operand(uint16_t limit, void* base);
 void gdt_init(void) {
   uint64_t gdtr_operand;
 
-  /* Initialize GDT. */
+  /* Initialize GDT.  SYSENTER and SYSEXIT assume the kernel
+     and user segments are laid out in exactly this order. */
   gdt[SEL_NULL / sizeof *gdt] = 0;
   gdt[SEL_KCSEG / sizeof *gdt] = make_code_desc(0);
   gdt[SEL_KDSEG / sizeof *gdt] = make_data_desc(0);
   gdt[SEL_UCSEG / sizeof *gdt] = make_code_desc(3);
   gdt[SEL_UDSEG / sizeof *gdt] = make_data_desc(3);
   gdt[SEL_TSS / sizeof *gdt] = make_tss_desc(tss_get());
+  gdt_set_thread_segment(NULL, 1);
 
   /* Load GDTR, TR.  See [IA32-v3a] 2.4.1 "Global Descriptor
      Table Register (GDTR)", 2.4.4 "Task Register (TR)", and
@@ -125,3 +127,13 @@ static uint64_t make_tss_desc(void* laddr) {
 static uint64_t make_gdtr_operand(uint16_t limit, void* base) {
   return limit | ((uint64_t)(uint32_t)base << 16);
 }
+
+/* Points the user thread segment, which user threads load into GS,
+   at the SIZE bytes at user address BASE.  The segment is read-only.
+   Takes effect for a thread the next time it loads GS, which happens
+   on every return to user mode. */
+void gdt_set_thread_segment(const void* base, size_t size) {
+  ASSERT(size > 0);
+  gdt[SEL_UTSEG / sizeof *gdt] =
+      make_seg_desc((uint32_t)base, size - 1, CLS_CODE_DATA, 0, 3, GRAN_BYTE);
+}
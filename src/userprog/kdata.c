@@ -0,0 +1,148 @@
+#include "userprog/kdata.h"
+#include <bitmap.h>
+#include <debug.h>
+#include "arch/common/cpu.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#ifdef ARCH_I386
+#include "userprog/gdt.h"
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * GLOBAL STATE
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* The region, at its kernel address.  NULL until kdata_init(). */
+static struct kdata* kdata;
+
+/* Entries of kdata->threads in use.  Entry 0 is permanently taken.
+   Protected by disabling interrupts. */
+static struct bitmap* thread_map;
+
+/* Cycle counter calibration: the counter is compared against the
+   timer over KDATA_CALIBRATE_TICKS ticks, starting at the first tick
+   seen after kdata_init(). */
+#define KDATA_CALIBRATE_TICKS TIMER_FREQ
+static int64_t calibrate_start_tick;
+static uint64_t calibrate_start_cycles;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * INITIALIZATION AND MAPPING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Allocates and initializes the kernel data region. */
+void kdata_init(void) {
+  ASSERT(sizeof *kdata == KDATA_SIZE);
+
+  thread_map = bitmap_create(KDATA_THREAD_CNT);
+  if (thread_map == NULL)
+    PANIC("kdata: cannot allocate thread map");
+  bitmap_mark(thread_map, 0);
+
+  struct kdata* k = palloc_get_multiple(PAL_ASSERT | PAL_ZERO, KDATA_PAGES);
+  k->timer_freq = TIMER_FREQ;
+  k->ticks = timer_ticks();
+
+  /* Publish only once initialized: the timer interrupt checks KDATA. */
+  barrier();
+  kdata = k;
+}
+
+bool kdata_map(uint32_t* pd) {
+  ASSERT(kdata != NULL);
+
+  for (size_t i = 0; i < KDATA_PAGES; i++) {
+    void* upage = (uint8_t*)KDATA_BASE + i * PGSIZE;
+    if (!pagedir_set_page(pd, upage, (uint8_t*)kdata + i * PGSIZE, false))
+      return false;
+  }
+  return true;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * CLOCK
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+void kdata_tick(int64_t ticks) {
+  uint64_t now = cpu_cycles();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (kdata == NULL)
+    return;
+
+  kdata->seq++;
+  barrier();
+
+  kdata->ticks = ticks;
+  kdata->tick_cycles = now;
+  if (kdata->cycles_per_tick == 0) {
+    if (calibrate_start_tick == 0) {
+      calibrate_start_tick = ticks;
+      calibrate_start_cycles = now;
+    } else if (ticks - calibrate_start_tick >= KDATA_CALIBRATE_TICKS) {
+      kdata->cycles_per_tick =
+          (now - calibrate_start_cycles) / (uint64_t)(ticks - calibrate_start_tick);
+    }
+  }
+
+  barrier();
+  kdata->seq++;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * THREAD IDENTITIES
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Gives the current user thread an entry in the thread table and
+   points its thread pointer at it.  If the table is full, the thread
+   keeps entry 0 and user code falls back to system calls. */
+void kdata_thread_attach(void) {
+  struct thread* t = thread_current();
+
+  ASSERT(t->pcb != NULL);
+  ASSERT(t->kdata_slot == 0);
+
+  enum intr_level old_level = intr_disable();
+  size_t slot = bitmap_scan_and_flip(thread_map, 0, 1, false);
+  if (slot != BITMAP_ERROR) {
+    kdata->threads[slot].tid = t->tid;
+    kdata->threads[slot].pid = t->pcb->main_thread->tid;
+    t->kdata_slot = slot;
+  }
+  intr_set_level(old_level);
+
+  kdata_activate(t);
+}
+
+/* Releases T's thread table entry, if it has one. */
+void kdata_thread_detach(struct thread* t) {
+  if (t->kdata_slot == 0)
+    return;
+
+  enum intr_level old_level = intr_disable();
+  kdata->threads[t->kdata_slot].tid = 0;
+  kdata->threads[t->kdata_slot].pid = 0;
+  bitmap_reset(thread_map, t->kdata_slot);
+  t->kdata_slot = 0;
+  intr_set_level(old_level);
+}
+
+/* Points the thread pointer at T's entry.  Called on every switch to a
+   user thread; the new base takes effect when GS is reloaded on the
+   way back to user mode.  RISC-V has no thread pointer support yet. */
+void kdata_activate(struct thread* t) {
+#ifdef ARCH_I386
+  if (t->pcb != NULL) {
+    struct kdata* user_kdata = (struct kdata*)KDATA_BASE;
+    gdt_set_thread_segment(&user_kdata->threads[t->kdata_slot], sizeof(struct kdata_thread));
+  }
+#else
+  (void)t;
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef USERPROG_KDATA_H
+#define USERPROG_KDATA_H
+
+#include <kdata.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * KERNEL DATA PAGE
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * One region, laid out as struct kdata (see lib/kdata.h), mapped read-only
+ * into every user address space at KDATA_BASE.  User programs read the
+ * clock and their own identity from it without a system call.
+ *
+ * The region is owned by the kernel, not by any process: page directories
+ * map it but never free or copy it.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+void kdata_init(void);
+
+/* Clock, called from the timer interrupt with the new tick count. */
+void kdata_tick(int64_t ticks);
+
+/* Maps the region into page directory PD.  Returns false on failure. */
+bool kdata_map(uint32_t* pd);
+
+/* Returns true if user address UADDR lies within the region. */
+static inline bool kdata_contains(const void* uaddr) {
+  return (uintptr_t)uaddr - KDATA_BASE < KDATA_SIZE;
+}
+
+/* Thread identities. */
+void kdata_thread_attach(void);
+void kdata_thread_detach(struct thread*);
+void kdata_activate(struct thread*);
+
+#endif /* userprog/kdata.h */
@@ -0,0 +1,410 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "threads/waitq.h"
+#include "userprog/uaccess.h"
+
+/* Data buffered in one slot: PAGE[OFS, OFS + LEN). */
+struct pipe_slot {
+  uint8_t* page;
+  uint16_t ofs;
+  uint16_t len;
+};
+
+struct pipe {
+  struct lock lock;                   /* Protects everything below. */
+  struct condition readable;          /* Data arrived or the writer left. */
+  struct condition writable;          /* Space freed or the reader left. */
+  struct wait_queue wq;               /* Woken alongside both conditions. */
+  struct pipe_slot slots[PIPE_SLOTS]; /* Ring of buffered data. */
+  unsigned head;                      /* Index of the oldest slot in use. */
+  unsigned cnt;                       /* Number of slots in use. */
+  unsigned size;                      /* Bytes buffered. */
+  int readers;                        /* Open read ends. */
+  int writers;                        /* Open write ends. */
+  uint8_t* spare;                     /* Page kept for the next slot, or NULL. */
+};
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * RING
+ * ─────────────────────────────────────────────────────────────────────────────
+ * All of these require the pipe's lock.
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Returns the Ith slot in use, counting from the oldest. */
+static struct pipe_slot* slot_at(struct pipe* p, unsigned i) {
+  return &p->slots[(p->head + i) % PIPE_SLOTS];
+}
+
+/* Returns the number of bytes that can be appended. */
+static unsigned pipe_space(struct pipe* p) {
+  unsigned space = (PIPE_SLOTS - p->cnt) * PGSIZE;
+  if (p->cnt > 0) {
+    struct pipe_slot* tail = slot_at(p, p->cnt - 1);
+    space += PGSIZE - (tail->ofs + tail->len);
+  }
+  return space;
+}
+
+/* Returns a page for a new slot, or NULL if memory is short.  Reusing
+   the last freed page saves a trip through the page allocator for
+   every page that streams through. */
+static uint8_t* get_page(struct pipe* p) {
+  uint8_t* page = p->spare;
+  if (page != NULL) {
+    p->spare = NULL;
+    return page;
+  }
+  return palloc_get_page(0);
+}
+
+static void put_page(struct pipe* p, uint8_t* page) {
+  if (p->spare == NULL)
+    p->spare = page;
+  else
+    palloc_free_page(page);
+}
+
+/* Appends a new slot holding the LEN bytes at PAGE + OFS.  There must be
+   a free slot. */
+static void push_slot(struct pipe* p, uint8_t* page, unsigned ofs, unsigned len) {
+  ASSERT(p->cnt < PIPE_SLOTS);
+
+  struct pipe_slot* s = slot_at(p, p->cnt++);
+  s->page = page;
+  s->ofs = ofs;
+  s->len = len;
+  p->size += len;
+}
+
+/* Removes the oldest slot, whatever it holds, and returns its page. */
+static uint8_t* pop_slot(struct pipe* p) {
+  struct pipe_slot* s = slot_at(p, 0);
+  uint8_t* page = s->page;
+
+  p->size -= s->len;
+  s->page = NULL;
+  p->head = (p->head + 1) % PIPE_SLOTS;
+  p->cnt--;
+  return page;
+}
+
+/* Drops the first SIZE bytes of the oldest slot, freeing the slot once
+   it is empty. */
+static void consume(struct pipe* p, unsigned size) {
+  struct pipe_slot* s = slot_at(p, 0);
+
+  ASSERT(size <= s->len);
+  s->ofs += size;
+  s->len -= size;
+  p->size -= size;
+  if (s->len == 0)
+    put_page(p, pop_slot(p));
+}
+
+/* Appends PAGE[OFS, LEN) to the ring: first into the room left in the
+   last slot, then, if a slot is free, by adding *PAGE itself as a slot,
+   in which case *PAGE becomes NULL.  Returns the number of bytes
+   appended. */
+static unsigned append(struct pipe* p, uint8_t** page, unsigned ofs, unsigned len) {
+  unsigned done = 0;
+
+  if (p->cnt > 0) {
+    struct pipe_slot* tail = slot_at(p, p->cnt - 1);
+    unsigned room = PGSIZE - (tail->ofs + tail->len);
+    done = len - ofs < room ? len - ofs : room;
+    memcpy(tail->page + tail->ofs + tail->len, *page + ofs, done);
+    tail->len += done;
+    p->size += done;
+  }
+  if (ofs + done < len && p->cnt < PIPE_SLOTS) {
+    push_slot(p, *page, ofs + done, len - ofs - done);
+    *page = NULL;
+    done = len - ofs;
+  }
+  return done;
+}
+
+/* Wakes readers that data arrived. */
+static void wake_readers(struct pipe* p) {
+  cond_broadcast(&p->readable, &p->lock);
+  wait_queue_wake(&p->wq, POLLIN);
+}
+
+/* Waits until the pipe holds data or has no writer. */
+static void wait_readable(struct pipe* p) {
+  while (p->size == 0 && p->writers > 0)
+    cond_wait(&p->readable, &p->lock);
+}
+
+/* Wakes writers if reading just opened up PIPE_BUF bytes of space, which
+   was SPACE before.  Writers never wait while that much is free, so
+   smaller gains are left to accumulate. */
+static void wake_writers(struct pipe* p, unsigned space) {
+  if (space < PIPE_BUF && pipe_space(p) >= PIPE_BUF) {
+    cond_broadcast(&p->writable, &p->lock);
+    wait_queue_wake(&p->wq, POLLOUT);
+  }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * LIFETIME
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+struct pipe* pipe_create(void) {
+  struct pipe* p = malloc(sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  lock_init(&p->lock);
+  cond_init(&p->readable);
+  cond_init(&p->writable);
+  wait_queue_init(&p->wq);
+  p->head = 0;
+  p->cnt = 0;
+  p->size = 0;
+  p->readers = 1;
+  p->writers = 1;
+  p->spare = NULL;
+  return p;
+}
+
+void pipe_close(struct pipe* p, bool writer) {
+  lock_acquire(&p->lock);
+  if (writer) {
+    p->writers--;
+    cond_broadcast(&p->readable, &p->lock);
+    wait_queue_wake(&p->wq, POLLHUP);
+  } else {
+    p->readers--;
+    cond_broadcast(&p->writable, &p->lock);
+    wait_queue_wake(&p->wq, POLLERR);
+  }
+  bool unused = p->readers == 0 && p->writers == 0;
+  lock_release(&p->lock);
+
+  if (unused) {
+    ASSERT(list_empty(&p->wq.entries));
+    while (p->cnt > 0)
+      consume(p, slot_at(p, 0)->len);
+    if (p->spare != NULL)
+      palloc_free_page(p->spare);
+    free(p);
+  }
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * POLLING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+unsigned pipe_poll(struct pipe* p, bool writer, struct wait_entry* entry) {
+  unsigned events = 0;
+
+  lock_acquire(&p->lock);
+  if (entry != NULL)
+    wait_queue_add(&p->wq, entry);
+  if (writer) {
+    if (p->readers == 0)
+      events = POLLOUT | POLLERR;
+    else if (pipe_space(p) >= PIPE_BUF)
+      events = POLLOUT;
+  } else {
+    if (p->size > 0)
+      events |= POLLIN;
+    if (p->writers == 0)
+      events |= POLLHUP;
+  }
+  lock_release(&p->lock);
+  return events;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * READING AND WRITING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+int pipe_read(struct pipe* p, void* ubuf, unsigned size, bool nowait, bool* fault) {
+  uint8_t* dst = ubuf;
+  unsigned done = 0;
+  bool no_mem = false;
+
+  if (size == 0)
+    return 0;
+
+  lock_acquire(&p->lock);
+  if (nowait && p->size == 0 && p->writers > 0) {
+    lock_release(&p->lock);
+    return PIPE_AGAIN;
+  }
+  wait_readable(p);
+
+  /* Data goes to the user with the lock released, since the copy may
+     fault in pages.  A slot read whole leaves the ring with its page;
+     part of one is copied to a spare page first. */
+  while (done < size && p->cnt > 0) {
+    struct pipe_slot* s = slot_at(p, 0);
+    unsigned n = size - done < s->len ? size - done : s->len;
+    unsigned space = pipe_space(p);
+    uint8_t* page;
+    unsigned ofs = 0;
+    if (n == s->len) {
+      ofs = s->ofs;
+      page = pop_slot(p);
+    } else {
+      page = get_page(p);
+      if (page == NULL) {
+        no_mem = done == 0;
+        break;
+      }
+      memcpy(page, s->page + s->ofs, n);
+      consume(p, n);
+    }
+    wake_writers(p, space);
+    lock_release(&p->lock);
+
+    bool ok = copy_to_user(dst + done, page + ofs, n);
+
+    lock_acquire(&p->lock);
+    put_page(p, page);
+    if (!ok) {
+      *fault = true;
+      break;
+    }
+    done += n;
+  }
+  lock_release(&p->lock);
+
+  return *fault || no_mem ? -1 : (int)done;
+}
+
+int pipe_write(struct pipe* p, const void* ubuf, unsigned size, bool nowait, bool* fault) {
+  const uint8_t* src = ubuf;
+  unsigned done = 0;
+  bool again = false;
+
+  if (size == 0)
+    return 0;
+
+  /* Each page's worth is copied in with the lock released, since the copy
+     may fault in pages, into a page that can then join the ring as is. */
+  while (done < size) {
+    unsigned n = size - done < PGSIZE ? size - done : PGSIZE;
+    lock_acquire(&p->lock);
+    uint8_t* page = get_page(p);
+    lock_release(&p->lock);
+    if (page == NULL)
+      break;
+    if (!copy_from_user(page, src + done, n)) {
+      *fault = true;
+      lock_acquire(&p->lock);
+      put_page(p, page);
+      lock_release(&p->lock);
+      break;
+    }
+
+    /* A small write waits until it fits whole; a large one takes any room. */
+    unsigned need = size <= PIPE_BUF ? n : 1;
+    unsigned ofs = 0;
+    lock_acquire(&p->lock);
+    while (ofs < n) {
+      while (p->readers > 0 && pipe_space(p) < need && !nowait)
+        cond_wait(&p->writable, &p->lock);
+      if (p->readers == 0)
+        break;
+      if (pipe_space(p) < need) {
+        again = true;
+        break;
+      }
+      ofs += append(p, &page, ofs, n);
+      wake_readers(p);
+    }
+    if (page != NULL)
+      put_page(p, page);
+    lock_release(&p->lock);
+
+    done += ofs;
+    if (ofs < n)
+      break;
+  }
+
+  if (*fault)
+    return -1;
+  return done > 0 ? (int)done : again ? PIPE_AGAIN : -1;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * SPLICING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+int pipe_splice_from_file(struct pipe* p, struct file* file, off_t ofs, unsigned size) {
+  unsigned done = 0;
+  int result = -1;
+
+  lock_acquire(&p->lock);
+  while (done < size && p->readers > 0) {
+    uint8_t* page = get_page(p);
+    if (page == NULL)
+      break;
+
+    /* The file is read straight into the page that joins the ring. */
+    unsigned want = size - done < PGSIZE ? size - done : PGSIZE;
+    lock_release(&p->lock);
+    off_t n = file_read_at(file, page, want, ofs + done);
+    lock_acquire(&p->lock);
+
+    while (p->readers > 0 && p->cnt == PIPE_SLOTS)
+      cond_wait(&p->writable, &p->lock);
+    if (n <= 0 || p->readers == 0) {
+      put_page(p, page);
+      if (n == 0)
+        result = 0;
+      break;
+    }
+
+    push_slot(p, page, 0, n);
+    done += n;
+    wake_readers(p);
+    if ((unsigned)n < want)
+      break;
+  }
+  lock_release(&p->lock);
+
+  return done > 0 ? (int)done : result;
+}
+
+int pipe_splice_to_file(struct pipe* p, struct file* file, off_t ofs, unsigned size) {
+  unsigned done = 0;
+  bool failed = false;
+
+  if (size == 0)
+    return 0;
+
+  lock_acquire(&p->lock);
+  wait_readable(p);
+
+  /* Pipe pages are written straight to the file. */
+  unsigned space = pipe_space(p);
+  while (done < size && p->cnt > 0) {
+    struct pipe_slot* s = slot_at(p, 0);
+    unsigned n = size - done < s->len ? size - done : s->len;
+    off_t written = file_write_at(file, s->page + s->ofs, n, ofs + done);
+    if (written <= 0) {
+      failed = true;
+      break;
+    }
+    consume(p, written);
+    done += written;
+    if ((unsigned)written < n)
+      break;
+  }
+  wake_writers(p, space);
+
+  lock_release(&p->lock);
+  return done == 0 && failed ? -1 : (int)done;
+}
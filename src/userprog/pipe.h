@@ -0,0 +1,75 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct wait_entry;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * PIPES
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * A pipe buffers data in a ring of PIPE_SLOTS slots, each holding part of
+ * one kernel page.  write() fills the last slot's page and then new pages;
+ * read() drains the first slot and frees its page once empty.
+ *
+ * splice() moves data between a pipe and a file without passing through
+ * user memory: file data is read straight into a fresh page that then
+ * joins the ring, and pipe pages are written straight to the file.
+ *
+ * BLOCKING:
+ *   - Readers wait while the pipe is empty and has writers.  An empty pipe
+ *     with no writers reads as end of file.
+ *   - Writers wait for space while the pipe has readers.  A write of at
+ *     most PIPE_BUF bytes waits until all of it fits and is never
+ *     interleaved with other writes.  Writing with no readers fails.
+ *   - Wakeups are batched: a writer wakes readers once per call, and
+ *     readers wake writers only once at least PIPE_BUF bytes are free.
+ *     The pipe's wait queue is woken at the same points, for poll().
+ *
+ * Each end is held by one open file description (FD_PIPE), so dup and
+ * fork share an end rather than adding one.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Largest write guaranteed not to be interleaved with other writes. */
+#define PIPE_BUF 4096
+
+/* Pages a pipe can hold. */
+#define PIPE_SLOTS 16
+
+struct pipe;
+
+/* Creates a pipe with one reader and one writer. */
+struct pipe* pipe_create(void);
+
+/* Releases one end of PIPE, the write end if WRITER.  Frees PIPE once
+   both ends are released. */
+void pipe_close(struct pipe*, bool writer);
+
+/* Result of a transfer that would have had to wait. */
+#define PIPE_AGAIN (-2)
+
+/* Transfers up to SIZE bytes between PIPE and the user buffer UBUF.
+   Return the number of bytes transferred, 0 at end of file for reads,
+   or -1 if memory runs out or a write finds no reader.  Set *FAULT and
+   return -1 if UBUF is not valid user memory.  If NOWAIT, transfer only
+   what can be without waiting, and return PIPE_AGAIN if that is
+   nothing. */
+int pipe_read(struct pipe*, void* ubuf, unsigned size, bool nowait, bool* fault);
+int pipe_write(struct pipe*, const void* ubuf, unsigned size, bool nowait, bool* fault);
+
+/* Returns the poll events ready on PIPE's read end, or write end if
+   WRITER.  If ENTRY is nonnull, also adds it to the queue woken as they
+   change. */
+unsigned pipe_poll(struct pipe*, bool writer, struct wait_entry* entry);
+
+/* Moves up to SIZE bytes from FILE at offset OFS into PIPE, or from PIPE
+   into FILE at offset OFS.  Return the number of bytes moved, 0 at end of
+   file (or end of pipe), or -1 if no reader remains or memory runs out. */
+int pipe_splice_from_file(struct pipe*, struct file*, off_t ofs, unsigned size);
+int pipe_splice_to_file(struct pipe*, struct file*, off_t ofs, unsigned size);
+
+#endif /* userprog/pipe.h */
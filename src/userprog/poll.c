@@ -0,0 +1,444 @@
+#include "userprog/poll.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include "devices/input.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/waitq.h"
+#include "userprog/fdtable.h"
+#include "userprog/filedesc.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+
+/* Events reported whether asked for or not. */
+#define ALWAYS_EVENTS (POLLERR | POLLHUP)
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * READINESS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Returns POLLIN if a key is waiting, adding ENTRY (if nonnull) to the
+   queue woken as keys arrive. */
+static unsigned input_poll(struct wait_entry* entry) {
+  struct wait_queue* wq = input_wait_queue();
+
+  enum intr_level old_level = intr_disable();
+  if (entry != NULL && wq != NULL)
+    wait_queue_add(wq, entry);
+  unsigned events = input_empty() ? 0 : POLLIN;
+  intr_set_level(old_level);
+  return events;
+}
+
+unsigned ofd_poll(struct open_file_desc* ofd, struct wait_entry* entry) {
+  switch (ofd->type) {
+    case FD_FILE:
+      return POLLIN | POLLOUT;
+    case FD_DIR:
+      return POLLIN;
+    case FD_CONSOLE:
+      return ofd->cmode == CONSOLE_WRITE ? POLLOUT : input_poll(entry);
+    case FD_PIPE:
+      return pipe_poll(ofd->pipe, ofd->cmode == CONSOLE_WRITE, entry);
+    default:
+      return 0;
+  }
+}
+
+/* Converts a timeout of MS milliseconds (forever if negative) into an
+   absolute deadline in timer ticks, or -1 for none. */
+static int64_t timeout_deadline(int ms) {
+  if (ms < 0)
+    return -1;
+  return timer_ticks() + DIV_ROUND_UP((int64_t)ms * TIMER_FREQ, 1000);
+}
+
+/* Returns the ticks left until DEADLINE, or -1 if there is none. */
+static int64_t ticks_left(int64_t deadline) {
+  if (deadline < 0)
+    return -1;
+  int64_t left = deadline - timer_ticks();
+  return left > 0 ? left : 0;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * POLL
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Per-descriptor state for one poll() call. */
+struct poll_slot {
+  struct open_file_desc* ofd; /* Reference held for the call, or NULL. */
+  struct wait_entry entry;    /* On the OFD's wait queue while waiting. */
+};
+
+static void poll_wake(struct wait_entry* entry, unsigned events UNUSED) {
+  waiter_wake(entry->aux);
+}
+
+/* Sets each FDS[i].revents and returns how many are nonzero.  Adds the
+   slots' wait entries to their queues if ADD_ENTRIES. */
+static int poll_scan(struct pollfd* fds, struct poll_slot* slots, unsigned nfds,
+                     bool add_entries) {
+  int ready = 0;
+
+  for (unsigned i = 0; i < nfds; i++) {
+    short revents = 0;
+    if (fds[i].fd >= 0 && slots[i].ofd == NULL)
+      revents = POLLNVAL;
+    else if (fds[i].fd >= 0)
+      revents = ofd_poll(slots[i].ofd, add_entries ? &slots[i].entry : NULL) &
+                (fds[i].events | ALWAYS_EVENTS);
+    fds[i].revents = revents;
+    if (revents != 0)
+      ready++;
+  }
+  return ready;
+}
+
+int poll_fds(struct pollfd* ufds, unsigned nfds, int timeout, bool* fault) {
+  struct fd_table* fdt = &thread_current()->pcb->fd_table;
+  struct pollfd* fds = NULL;
+  struct poll_slot* slots = NULL;
+  struct waiter w;
+
+  if (nfds > FD_TABLE_MAX)
+    return -1;
+  if (nfds > 0) {
+    fds = malloc(nfds * (sizeof *fds + sizeof *slots));
+    if (fds == NULL)
+      return -1;
+    slots = (struct poll_slot*)(fds + nfds);
+    if (!copy_from_user(fds, ufds, nfds * sizeof *fds)) {
+      free(fds);
+      *fault = true;
+      return -1;
+    }
+  }
+
+  /* Hold each OFD so that its wait queue outlives our entry on it. */
+  waiter_init(&w);
+  for (unsigned i = 0; i < nfds; i++) {
+    slots[i].ofd = fds[i].fd >= 0 ? ofd_dup(fd_table_get(fdt, fds[i].fd)) : NULL;
+    wait_entry_init(&slots[i].entry, poll_wake, &w);
+  }
+
+  /* Entries go on the queues during the first scan, so no wakeup between
+     that scan and sleeping is missed.  Later scans only look. */
+  int64_t deadline = timeout_deadline(timeout);
+  bool wait = timeout != 0;
+  int ready = poll_scan(fds, slots, nfds, wait);
+  while (ready == 0 && wait) {
+    if (!waiter_wait(&w, ticks_left(deadline)))
+      wait = false;
+    ready = poll_scan(fds, slots, nfds, false);
+  }
+
+  for (unsigned i = 0; i < nfds; i++) {
+    wait_queue_remove(&slots[i].entry);
+    ofd_close(slots[i].ofd);
+  }
+  if (nfds > 0 && !copy_to_user(ufds, fds, nfds * sizeof *fds)) {
+    *fault = true;
+    ready = -1;
+  }
+  free(fds);
+  return ready;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * EPOLL
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+struct epoll {
+  struct lock lock;    /* Protects ITEMS and the items' settings. */
+  struct list items;   /* All epitems, under LOCK. */
+  struct list ready;   /* Epitems that may be ready; interrupts off. */
+  struct list waiters; /* ep_waiters in epoll_wait(); interrupts off. */
+};
+
+/* One watched descriptor. */
+struct epitem {
+  struct list_elem elem;       /* In ep->items. */
+  struct list_elem ofd_elem;   /* In ofd->epitems. */
+  struct list_elem ready_elem; /* In ep->ready, or a local list, while on_ready. */
+  bool on_ready;               /* On a ready list?  Interrupts off. */
+  bool disabled;               /* EPOLLONESHOT item already reported? */
+  struct wait_entry wait;      /* On the watched object's queue. */
+  struct epoll* ep;            /* Owning instance. */
+  struct open_file_desc* ofd;  /* Watched OFD. */
+  int fd;                      /* Descriptor it was added as. */
+  struct epoll_event event;    /* Interest and the caller's data. */
+};
+
+/* A thread in epoll_wait(). */
+struct ep_waiter {
+  struct list_elem elem; /* In ep->waiters. */
+  struct waiter waiter;
+};
+
+/* Most events one epoll_wait() reports, which bounds its kernel buffer. */
+#define EPOLL_MAX_EVENTS 256
+
+/* Protects every OFD's epitems list.  Taken before any instance's lock. */
+static struct lock epoll_lock;
+
+void poll_init(void) { lock_init(&epoll_lock); }
+
+/* Returns the events ITEM reports, given the events ready on its OFD. */
+static unsigned item_events(const struct epitem* item, unsigned events) {
+  if (item->disabled)
+    return 0;
+  return events & (item->event.events | ALWAYS_EVENTS);
+}
+
+/* Puts ITEM on its ready list and wakes the instance's waiters.
+   Interrupts must be off. */
+static void item_ready(struct epitem* item) {
+  struct epoll* ep = item->ep;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+  if (item->on_ready)
+    return;
+  item->on_ready = true;
+  list_push_back(&ep->ready, &item->ready_elem);
+  for (struct list_elem* e = list_begin(&ep->waiters); e != list_end(&ep->waiters);
+       e = list_next(e))
+    waiter_wake(&list_entry(e, struct ep_waiter, elem)->waiter);
+}
+
+static void item_wake(struct wait_entry* entry, unsigned events) {
+  struct epitem* item = entry->aux;
+  if (item_events(item, events) != 0)
+    item_ready(item);
+}
+
+/* Checks ITEM now, adding ENTRY (if nonnull) to its OFD's wait queue,
+   and queues ITEM if it has events to report. */
+static void item_check(struct epitem* item, struct wait_entry* entry) {
+  unsigned events = item_events(item, ofd_poll(item->ofd, entry));
+  if (events != 0) {
+    enum intr_level old_level = intr_disable();
+    item_ready(item);
+    intr_set_level(old_level);
+  }
+}
+
+/* Returns EP's item for FD and OFD, or NULL. */
+static struct epitem* item_find(struct epoll* ep, int fd, struct open_file_desc* ofd) {
+  ASSERT(lock_held_by_current_thread(&epoll_lock));
+
+  for (struct list_elem* e = list_begin(&ofd->epitems); e != list_end(&ofd->epitems);
+       e = list_next(e)) {
+    struct epitem* item = list_entry(e, struct epitem, ofd_elem);
+    if (item->ep == ep && item->fd == fd)
+      return item;
+  }
+  return NULL;
+}
+
+static void item_remove(struct epitem* item) {
+  ASSERT(lock_held_by_current_thread(&epoll_lock));
+  ASSERT(lock_held_by_current_thread(&item->ep->lock));
+
+  wait_queue_remove(&item->wait);
+  enum intr_level old_level = intr_disable();
+  if (item->on_ready)
+    list_remove(&item->ready_elem);
+  intr_set_level(old_level);
+  list_remove(&item->elem);
+  list_remove(&item->ofd_elem);
+  free(item);
+}
+
+struct epoll* epoll_create(void) {
+  struct epoll* ep = malloc(sizeof *ep);
+  if (ep == NULL)
+    return NULL;
+  lock_init(&ep->lock);
+  list_init(&ep->items);
+  list_init(&ep->ready);
+  list_init(&ep->waiters);
+  return ep;
+}
+
+void epoll_close(struct epoll* ep) {
+  lock_acquire(&epoll_lock);
+  lock_acquire(&ep->lock);
+  while (!list_empty(&ep->items))
+    item_remove(list_entry(list_front(&ep->items), struct epitem, elem));
+  lock_release(&ep->lock);
+  lock_release(&epoll_lock);
+
+  ASSERT(list_empty(&ep->waiters));
+  free(ep);
+}
+
+void epoll_release(struct open_file_desc* ofd) {
+  if (list_empty(&ofd->epitems))
+    return;
+
+  lock_acquire(&epoll_lock);
+  while (!list_empty(&ofd->epitems)) {
+    struct epitem* item = list_entry(list_front(&ofd->epitems), struct epitem, ofd_elem);
+    struct epoll* ep = item->ep;
+    lock_acquire(&ep->lock);
+    item_remove(item);
+    lock_release(&ep->lock);
+  }
+  lock_release(&epoll_lock);
+}
+
+int epoll_ctl(struct epoll* ep, int op, int fd, struct open_file_desc* ofd,
+              const struct epoll_event* event) {
+  /* An epoll instance cannot be watched, which rules out cycles. */
+  if (ofd == NULL || ofd->type == FD_EPOLL)
+    return -1;
+
+  int result = -1;
+  lock_acquire(&epoll_lock);
+  lock_acquire(&ep->lock);
+  struct epitem* item = item_find(ep, fd, ofd);
+  switch (op) {
+    case EPOLL_CTL_ADD:
+      if (item != NULL)
+        break;
+      item = malloc(sizeof *item);
+      if (item == NULL)
+        break;
+      item->on_ready = false;
+      item->disabled = false;
+      item->ep = ep;
+      item->ofd = ofd;
+      item->fd = fd;
+      item->event = *event;
+      wait_entry_init(&item->wait, item_wake, item);
+      list_push_back(&ep->items, &item->elem);
+      list_push_back(&ofd->epitems, &item->ofd_elem);
+      item_check(item, &item->wait);
+      result = 0;
+      break;
+
+    case EPOLL_CTL_MOD:
+      if (item == NULL)
+        break;
+      item->event = *event;
+      item->disabled = false;
+      item_check(item, NULL);
+      result = 0;
+      break;
+
+    case EPOLL_CTL_DEL:
+      if (item == NULL)
+        break;
+      item_remove(item);
+      result = 0;
+      break;
+  }
+  lock_release(&ep->lock);
+  lock_release(&epoll_lock);
+  return result;
+}
+
+/* Stores up to MAXEVENTS items from EP's ready list into EVENTS,
+   rechecking each, and returns the number stored.  The caller holds EP's
+   lock. */
+static int collect(struct epoll* ep, struct epoll_event* events, int maxevents) {
+  struct list requeue;
+  int cnt = 0;
+
+  ASSERT(lock_held_by_current_thread(&ep->lock));
+
+  list_init(&requeue);
+  while (cnt < maxevents) {
+    enum intr_level old_level = intr_disable();
+    if (list_empty(&ep->ready)) {
+      intr_set_level(old_level);
+      break;
+    }
+    struct epitem* item = list_entry(list_pop_front(&ep->ready), struct epitem, ready_elem);
+    item->on_ready = false;
+    intr_set_level(old_level);
+
+    /* Wakeups only say the item may be ready; ask its OFD. */
+    unsigned ready = item_events(item, ofd_poll(item->ofd, NULL));
+    if (ready == 0)
+      continue;
+
+    events[cnt].events = ready;
+    events[cnt].data = item->event.data;
+    cnt++;
+
+    /* Level-triggered items stay queued until a recheck finds them idle.
+       They wait on REQUEUE so this call reports each item once. */
+    if (item->event.events & EPOLLONESHOT) {
+      item->disabled = true;
+    } else if (!(item->event.events & EPOLLET)) {
+      old_level = intr_disable();
+      if (!item->on_ready) {
+        item->on_ready = true;
+        list_push_back(&requeue, &item->ready_elem);
+      }
+      intr_set_level(old_level);
+    }
+  }
+
+  enum intr_level old_level = intr_disable();
+  while (!list_empty(&requeue))
+    list_push_back(&ep->ready, list_pop_front(&requeue));
+  intr_set_level(old_level);
+  return cnt;
+}
+
+int epoll_wait(struct epoll* ep, struct epoll_event* uevents, int maxevents, int timeout,
+               bool* fault) {
+  struct ep_waiter w;
+
+  if (maxevents <= 0)
+    return -1;
+  if (maxevents > EPOLL_MAX_EVENTS)
+    maxevents = EPOLL_MAX_EVENTS;
+
+  /* Events are gathered here under EP's lock and copied out after, so a
+     fault on UEVENTS never happens with the lock held. */
+  struct epoll_event* events = malloc(maxevents * sizeof *events);
+  if (events == NULL)
+    return -1;
+
+  waiter_init(&w.waiter);
+  int64_t deadline = timeout_deadline(timeout);
+  bool wait = timeout != 0;
+
+  lock_acquire(&ep->lock);
+  int cnt = collect(ep, events, maxevents);
+  while (cnt == 0 && wait) {
+    /* Join the waiters before dropping the lock, so an item readied in
+       between still wakes us. */
+    enum intr_level old_level = intr_disable();
+    bool idle = list_empty(&ep->ready);
+    list_push_back(&ep->waiters, &w.elem);
+    intr_set_level(old_level);
+    lock_release(&ep->lock);
+
+    if (idle && !waiter_wait(&w.waiter, ticks_left(deadline)))
+      wait = false;
+
+    lock_acquire(&ep->lock);
+    old_level = intr_disable();
+    list_remove(&w.elem);
+    intr_set_level(old_level);
+    cnt = collect(ep, events, maxevents);
+  }
+  lock_release(&ep->lock);
+
+  if (cnt > 0 && !copy_to_user(uevents, events, cnt * sizeof *events)) {
+    *fault = true;
+    cnt = -1;
+  }
+  free(events);
+  return cnt;
+}
@@ -0,0 +1,87 @@
+#ifndef USERPROG_POLL_H
+#define USERPROG_POLL_H
+
+#include <poll.h>
+#include <stdbool.h>
+
+struct open_file_desc;
+struct wait_entry;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * READINESS: POLL AND EPOLL
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Every OFD type reports its ready events through ofd_poll().  Types whose
+ * readiness changes (pipes, keyboard input) also have a wait queue
+ * (threads/waitq.h) that ofd_poll() can add an entry to; files,
+ * directories, and console output are always ready and have none.
+ *
+ * poll() adds one entry per descriptor to those queues and sleeps until
+ * any is woken, then rescans all the descriptors.  It costs O(nfds) per
+ * call.
+ *
+ * An epoll instance keeps its interest set in the kernel.  Each watched
+ * descriptor has an item whose wait entry stays on the object's queue, and
+ * wakeups move the item to the instance's ready list.  epoll_wait()
+ * only looks at the ready list, so it costs O(ready), not O(watched).
+ *   - Level-triggered items go back on the ready list after being
+ *     reported, and drop off once a recheck finds them not ready.
+ *   - Edge-triggered (EPOLLET) items are reported once per wakeup.
+ *   - EPOLLONESHOT items are reported once, then ignored until
+ *     EPOLL_CTL_MOD.
+ *
+ * An item is identified by its descriptor number and OFD.  Items hold no
+ * reference to the OFD; ofd_close() calls epoll_release() when the last
+ * reference goes, as Linux does when the last descriptor closes.
+ *
+ * SYNCHRONIZATION:
+ *   - Each instance's lock protects its interest set.  epoll_wait() holds
+ *     only that, and copies events out to the user after releasing it.
+ *   - A global lock protects every OFD's item list, so it is held to add
+ *     or remove items, along with the instance's lock.
+ *   - Ready lists and waiter lists are touched by wake functions, which
+ *     may run from interrupt handlers, so they are protected by disabling
+ *     interrupts.
+ *   - Lock order: the global lock, an instance's lock, then any lock
+ *     ofd_poll() takes.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+struct epoll;
+
+void poll_init(void);
+
+/* Returns the events ready on OFD.  If ENTRY is nonnull and OFD's object
+   has a wait queue, also adds ENTRY to it. */
+unsigned ofd_poll(struct open_file_desc* ofd, struct wait_entry* entry);
+
+/* Waits up to TIMEOUT milliseconds (forever if negative) for events on the
+   NFDS descriptors in the user array UFDS, as poll().  Returns the number
+   of descriptors with events, or -1 if NFDS is too large or memory is
+   short.  Sets *FAULT if UFDS is not valid user memory. */
+int poll_fds(struct pollfd* ufds, unsigned nfds, int timeout, bool* fault);
+
+/* Creates an empty epoll instance, or returns NULL if memory is short. */
+struct epoll* epoll_create(void);
+
+/* Stops watching everything and frees EP. */
+void epoll_close(struct epoll* ep);
+
+/* Removes every epoll item watching OFD. */
+void epoll_release(struct open_file_desc* ofd);
+
+/* Applies epoll_ctl() operation OP to descriptor FD, whose OFD is OFD (NULL
+   if FD is not open), with EVENT giving the events and data for ADD and
+   MOD.  Returns 0 on success, -1 on failure. */
+int epoll_ctl(struct epoll* ep, int op, int fd, struct open_file_desc* ofd,
+              const struct epoll_event* event);
+
+/* Waits up to TIMEOUT milliseconds (forever if negative) for ready items
+   and stores up to MAXEVENTS of them, but no more than 256, in the user
+   array UEVENTS.  Returns the number stored, or -1 if MAXEVENTS is not
+   positive or memory is short.  Sets *FAULT if UEVENTS is not valid user
+   memory. */
+int epoll_wait(struct epoll* ep, struct epoll_event* uevents, int maxevents, int timeout,
+               bool* fault);
+
+#endif /* userprog/poll.h */
@@ -64,6 +64,7 @@
  * ║    process_exit()                                                        ║
  * ║           │                                                              ║
  * ║           ├─► Set is_exiting = true                                      ║
+ * ║           ├─► Wake parked pthreads so they exit                          ║
  * ║           ├─► Wait for thread_count == 1  (other threads exit)           ║
  * ║           ├─► Destroy page directory                                     ║
  * ║           ├─► Close all file descriptors                                 ║
@@ -99,6 +100,7 @@
  */
 
 #include "userprog/process.h"
+#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
 #include <round.h>
@@ -106,14 +108,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include "userprog/gdt.h"
+#include "userprog/kdata.h"
 #include "userprog/pagedir.h"
+#include "userprog/systrace.h"
 #include "userprog/tss.h"
+#include "userprog/uring.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #ifndef ARCH_RISCV64
 #include "threads/flags.h"
 #endif
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/malloc.h"
@@ -140,13 +146,15 @@
 static thread_func start_process NO_RETURN; /* For process_execute. */
 static thread_func fork_process NO_RETURN;  /* For process_fork. */
 static thread_func start_pthread NO_RETURN; /* For pthread_execute. */
+static void enter_pthread(struct intr_frame*) NO_RETURN;
 
 /* ELF loading and stack setup. */
 static bool load(char* cmd_line, void (**eip)(void), void** esp, int argc, char** argv);
 static bool setup_thread(void** esp, pthread_fun tf, void* arg);
+static void* push_thread_args(pthread_fun tf, void* arg);
 
-/* Utility functions. */
-int find_free_fd(void);
+/* Thread pool. */
+static void drain_thread_pool(struct process* pcb);
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * PCB INITIALIZATION
@@ -162,21 +170,22 @@ static void pcb_init(struct process* pcb, struct thread* main_thread) {
   pcb->my_status = NULL;
   pcb->parent_process = NULL;
   pcb->executable = NULL;
+  list_init(&pcb->urings);
+  pcb->trace_gen = 0;
+  pcb->trace_children_gen = 0;
 
-  /* File descriptor table - initialize all slots to unused */
-  for (int i = 0; i < MAX_FILE_DESCRIPTOR; i++) {
-    pcb->fd_table[i].ofd = NULL;
-  }
-
-  /* Initialize standard file descriptors for console I/O.
+  /* File descriptor table, with standard file descriptors for console I/O.
      These share the global console OFDs from the GOFD table. */
-  pcb->fd_table[STDIN_FILENO].ofd = ofd_dup(ofd_get_console(STDIN_FILENO));
-  pcb->fd_table[STDOUT_FILENO].ofd = ofd_dup(ofd_get_console(STDOUT_FILENO));
-  pcb->fd_table[STDERR_FILENO].ofd = ofd_dup(ofd_get_console(STDERR_FILENO));
+  fd_table_init(&pcb->fd_table);
+  fd_table_set(&pcb->fd_table, STDIN_FILENO, ofd_dup(ofd_get_console(STDIN_FILENO)));
+  fd_table_set(&pcb->fd_table, STDOUT_FILENO, ofd_dup(ofd_get_console(STDOUT_FILENO)));
+  fd_table_set(&pcb->fd_table, STDERR_FILENO, ofd_dup(ofd_get_console(STDERR_FILENO)));
 
   /* Threading support */
   list_init(&pcb->threads);
   list_init(&pcb->thread_statuses);
+  list_init(&pcb->thread_pool);
+  pcb->pool_threads = 0;
   list_push_back(&pcb->threads, &main_thread->pcb_elem);
 
   /* Create pthread_status for main thread (so other threads can join it) */
@@ -200,21 +209,11 @@ static void pcb_init(struct process* pcb, struct thread* main_thread) {
   pcb->is_exiting = false;
   pcb->exit_code = 0;
 
-  /* User-level synchronization tables */
-  for (int i = 0; i < MAX_LOCKS; i++) {
-    pcb->lock_table[i] = NULL;
-  }
-  for (int i = 0; i < MAX_SEMAS; i++) {
-    pcb->sema_table[i] = NULL;
-  }
-  pcb->next_lock_id = 0;
-  pcb->next_sema_id = 0;
+  /* User-level synchronization objects */
+  usync_table_init(&pcb->usync);
 
-  /* Stack slot management */
-  for (int i = 0; i < MAX_THREADS; i++) {
-    pcb->stack_slots[i] = false;
-  }
-  pcb->stack_slots[0] = true;                               /* Slot 0 reserved for main thread */
+  /* Stack slot management.  Slot 0 belongs to the main thread. */
+  pcb->stack_slots = NULL;
   main_thread->user_stack = ((uint8_t*)PHYS_BASE) - PGSIZE; /* Main thread's stack */
 
 #ifdef VM
@@ -224,6 +223,9 @@ static void pcb_init(struct process* pcb, struct thread* main_thread) {
   /* Initialize memory-mapped files list */
   list_init(&pcb->mmap_list);
   lock_init(&pcb->mmap_lock);
+
+  /* Per-process fault and eviction counters start from zero. */
+  memset(&pcb->vmstat, 0, sizeof pcb->vmstat);
 #endif
 }
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -388,7 +390,8 @@ static void start_process(void* aux) {
     success = load(file_name, (void (**)(void)) & if_.sepc, (void**)&if_.sp, load_info->argc,
                    load_info->argv);
 #else
-    if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.gs = SEL_UTSEG;
     if_.cs = SEL_UCSEG;
     if_.eflags = FLAG_IF | FLAG_MBS;
     success = load(file_name, &if_.eip, &if_.esp, load_info->argc, load_info->argv);
@@ -433,10 +436,13 @@ static void start_process(void* aux) {
   t->pcb->my_status->ref_count += 1;
 
   t->pcb->parent_process = parent_process;
+  systrace_fork(parent_process, t->pcb);
 
   load_info->load_success = success;
   sema_up(&load_info->loaded_signal);
 
+  kdata_thread_attach();
+
   /* Start the user process by simulating a return from an interrupt.
      x86: uses intr_exit in threads/intr-stubs.S
      RISC-V: uses user_entry() which executes sret */
@@ -477,6 +483,7 @@ pid_t process_fork(struct intr_frame* parent_interrupt_frame) {
   load_info.child_status->ref_count = 0;
   load_info.child_status->tid = -1;
   load_info.parent_if = parent_interrupt_frame;
+  load_info.parent_thread = thread_current();
   sema_init(&load_info.child_status->wait_sem, 0);
   load_info.file_name = thread_current()->pcb->process_name;
 
@@ -530,7 +537,7 @@ static void fork_process(void* aux) {
   if (success) {
     t->pcb->pagedir = pagedir_create();
 
-    if (t->pcb->pagedir == NULL) {
+    if (t->pcb->pagedir == NULL || !kdata_map(t->pcb->pagedir)) {
       success = pagedir_success = false;
     } else {
 #ifdef VM
@@ -540,6 +547,11 @@ static void fork_process(void* aux) {
       uint32_t* child_pagedir = t->pcb->pagedir;
       uint32_t* parent_pagedir = load_info->parent_process->main_thread->pcb->pagedir;
       spt_clone(&t->pcb->spt, &load_info->parent_process->spt, child_pagedir, parent_pagedir);
+
+      /* MAP_SHARED regions are not copied but attached again, so parent
+         and child keep seeing the same pages. */
+      if (!mmap_inherit(load_info->parent_process))
+        success = false;
 #else
       /* Without VM: directly duplicate all pages from parent to child. */
       if (!pagedir_dup(t->pcb->pagedir, load_info->parent_process->main_thread->pcb->pagedir)) {
@@ -554,28 +566,13 @@ static void fork_process(void* aux) {
      This implements POSIX fork semantics where parent and child share
      the same file description (position, flags, etc.). */
   if (success) {
-    struct fd_entry* parent_fd = load_info->parent_process->fd_table;
-    for (int i = 0; i < MAX_FILE_DESCRIPTOR; i++) {
-      if (parent_fd[i].ofd != NULL) {
-        /* Close existing OFD before overwriting (fixes ref count leak).
-           pcb_init() already set up console OFDs for slots 0,1,2. */
-        if (t->pcb->fd_table[i].ofd != NULL) {
-          ofd_close(t->pcb->fd_table[i].ofd);
-        }
-        /* Share the same OFD - increments reference count */
-        t->pcb->fd_table[i].ofd = ofd_dup(parent_fd[i].ofd);
-      }
-    }
+    /* Replaces the console OFDs pcb_init() installed. */
+    success = fd_table_copy(&t->pcb->fd_table, &load_info->parent_process->fd_table);
   }
   /* Failed to duplicate file descriptor, close all the OFDs already opened */
   /* Only cleanup if PCB was successfully allocated (t->pcb is not NULL) */
   if (!success && pcb_success) {
-    for (int i = 0; i < MAX_FILE_DESCRIPTOR; i++) {
-      if (t->pcb->fd_table[i].ofd != NULL) {
-        ofd_close(t->pcb->fd_table[i].ofd);
-        t->pcb->fd_table[i].ofd = NULL;
-      }
-    }
+    fd_table_destroy(&t->pcb->fd_table);
   }
 
   /* If we failed but created a pagedir, destroy it to free resources */
@@ -617,8 +614,9 @@ static void fork_process(void* aux) {
     t->pcb->executable = NULL;
   }
 
-  /* Copy the parent's interrupt frame to the child */
+  /* Copy the parent's interrupt frame and FPU registers to the child */
   memcpy(&if_, load_info->parent_if, sizeof(if_));
+  fpu_copy(t, load_info->parent_thread);
   /* CRITICAL: Child process must return 0 from fork().
      The parent's interrupt frame may have a different value in the return register. */
 #ifdef ARCH_RISCV64
@@ -642,6 +640,7 @@ static void fork_process(void* aux) {
   t->pcb->my_status->ref_count += 1;
 
   t->pcb->parent_process = parent_process;
+  systrace_fork(parent_process, t->pcb);
 
   load_info->load_success = success;
   sema_up(&load_info->loaded_signal);
@@ -650,6 +649,7 @@ static void fork_process(void* aux) {
      This ensures that when the child starts executing, it uses its own
      page directory with the duplicated memory mappings. */
   process_activate();
+  kdata_thread_attach();
 
   /* Start the user process by simulating a return from an interrupt.
      x86: uses intr_exit in threads/intr-stubs.S
@@ -737,11 +737,15 @@ void process_exit(void) {
   cur->pcb->is_exiting = true;
   /* Wake up any threads waiting in pthread_exit_main */
   cond_broadcast(&cur->pcb->exit_cond, &cur->pcb->exit_lock);
-  while (cur->pcb->thread_count > 1) {
+  drain_thread_pool(cur->pcb);
+  while (cur->pcb->thread_count > 1 || cur->pcb->pool_threads > 0) {
     cond_wait(&cur->pcb->exit_cond, &cur->pcb->exit_lock);
   }
   lock_release(&cur->pcb->exit_lock);
 
+  /* I/O ring workers use the address space, so stop them first. */
+  uring_exit(cur->pcb);
+
 #ifdef VM
   /* Clean up memory-mapped files (must be before spt_destroy). */
   mmap_destroy_all();
@@ -773,12 +777,7 @@ void process_exit(void) {
   struct process* pcb_to_free = cur->pcb;
 
   /* Close all open file descriptors (including console FDs which have OFDs) */
-  for (int i = 0; i < MAX_FILE_DESCRIPTOR; i++) {
-    if (pcb_to_free->fd_table[i].ofd != NULL) {
-      ofd_close(pcb_to_free->fd_table[i].ofd);
-      pcb_to_free->fd_table[i].ofd = NULL;
-    }
-  }
+  fd_table_destroy(&pcb_to_free->fd_table);
 
   /* Close the executable (also re-enables writes via file_allow_write) */
   if (pcb_to_free->executable != NULL) {
@@ -798,21 +797,11 @@ void process_exit(void) {
     free(ps);
   }
 
-  /* Clean up user-level locks */
-  for (int i = 0; i < MAX_LOCKS; i++) {
-    if (pcb_to_free->lock_table[i] != NULL) {
-      free(pcb_to_free->lock_table[i]);
-      pcb_to_free->lock_table[i] = NULL;
-    }
-  }
+  /* Clean up user-level synchronization objects */
+  usync_table_destroy(&pcb_to_free->usync);
 
-  /* Clean up user-level semaphores */
-  for (int i = 0; i < MAX_SEMAS; i++) {
-    if (pcb_to_free->sema_table[i] != NULL) {
-      free(pcb_to_free->sema_table[i]);
-      pcb_to_free->sema_table[i] = NULL;
-    }
-  }
+  if (pcb_to_free->stack_slots != NULL)
+    bitmap_destroy(pcb_to_free->stack_slots);
 
   if (pcb_to_free->my_status != NULL) {
     sema_up(&pcb_to_free->my_status->wait_sem);
@@ -848,20 +837,9 @@ void process_activate(void) {
   /* Set thread's kernel stack for use in processing interrupts.
      This does nothing if this is not a user process. */
   tss_update();
-}
 
-/* Finds and returns the first free file descriptor index (>= 3).
-   Returns -1 if all file descriptors are in use.
-   FDs 0, 1, 2 are reserved for stdin/stdout/stderr. */
-int find_free_fd(void) {
-  struct thread* t = thread_current();
-  struct fd_entry* fd_table = t->pcb->fd_table;
-  for (int i = 3; i < MAX_FILE_DESCRIPTOR; i++) {
-    if (fd_table[i].ofd == NULL) {
-      return i;
-    }
-  }
-  return -1;
+  /* Point the thread pointer at this thread's identity. */
+  kdata_activate(t);
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -950,7 +928,7 @@ bool load(char* file_name, void (**eip)(void), void** esp, int argc, char** argv
 
   /* Allocate and activate page directory. */
   t->pcb->pagedir = pagedir_create();
-  if (t->pcb->pagedir == NULL)
+  if (t->pcb->pagedir == NULL || !kdata_map(t->pcb->pagedir))
     goto done;
   process_activate();
 
@@ -1279,6 +1257,13 @@ bool is_main_thread(struct thread* t, struct process* p) { return p->main_thread
 /* Gets the PID of a process */
 pid_t get_pid(struct process* p) { return (pid_t)p->main_thread->tid; }
 
+/* Frees PCB's stack slot SLOT. */
+static void release_stack_slot(struct process* pcb, size_t slot) {
+  lock_acquire(&pcb->exit_lock);
+  bitmap_reset(pcb->stack_slots, slot);
+  lock_release(&pcb->exit_lock);
+}
+
 /* Creates a new stack for the thread and sets up its arguments.
    Allocates a new stack page, sets up the stack for calling sf(tf, arg),
    and stores the initial stack pointer into *ESP.
@@ -1288,15 +1273,17 @@ static bool setup_thread(void** esp, pthread_fun tf, void* arg) {
   struct process* pcb = t->pcb;
 
   /* Find a free stack slot */
-  int slot = -1;
-  for (int i = 1; i < MAX_THREADS; i++) { /* Slot 0 is main thread */
-    if (!pcb->stack_slots[i]) {
-      slot = i;
-      pcb->stack_slots[i] = true;
-      break;
-    }
+  size_t slot = BITMAP_ERROR;
+  lock_acquire(&pcb->exit_lock);
+  if (pcb->stack_slots == NULL) {
+    pcb->stack_slots = bitmap_create(MAX_THREADS);
+    if (pcb->stack_slots != NULL)
+      bitmap_mark(pcb->stack_slots, 0); /* Slot 0 is main thread */
   }
-  if (slot == -1)
+  if (pcb->stack_slots != NULL)
+    slot = bitmap_scan_and_flip(pcb->stack_slots, 1, 1, false);
+  lock_release(&pcb->exit_lock);
+  if (slot == BITMAP_ERROR)
     return false; /* No free slots */
 
   /* Calculate stack base address for this slot */
@@ -1305,31 +1292,38 @@ static bool setup_thread(void** esp, pthread_fun tf, void* arg) {
   /* Allocate a page for the stack */
   uint8_t* kpage = palloc_get_page(PAL_USER | PAL_ZERO);
   if (kpage == NULL) {
-    pcb->stack_slots[slot] = false;
+    release_stack_slot(pcb, slot);
     return false;
   }
 
   /* Install the page at the stack address */
   if (!install_page(stack_base, kpage, true)) {
     palloc_free_page(kpage);
-    pcb->stack_slots[slot] = false;
+    release_stack_slot(pcb, slot);
     return false;
   }
 
   /* Save stack base in thread for cleanup later */
   t->user_stack = stack_base;
 
-  /* Set up the stack for calling sf(tf, arg)
-     Stack layout (growing downward):
-       +------------+  <- stack_base + PGSIZE (high address)
-       |    arg     |
-       +------------+
-       |    tf      |
-       +------------+
-       | ret addr   |  <- fake return address (NULL)
-       +------------+  <- esp points here
-  */
-  uint8_t* stack_ptr = stack_base + PGSIZE;
+  *esp = push_thread_args(tf, arg);
+  return true;
+}
+
+/* Sets up the current thread's user stack for calling sf(tf, arg) and
+   returns the initial stack pointer.  A thread from the pool reuses
+   whatever its stack held before.
+   Stack layout (growing downward):
+     +------------+  <- user_stack + PGSIZE (high address)
+     |    arg     |
+     +------------+
+     |    tf      |
+     +------------+
+     | ret addr   |  <- fake return address (NULL)
+     +------------+  <- esp points here
+*/
+static void* push_thread_args(pthread_fun tf, void* arg) {
+  uint8_t* stack_ptr = (uint8_t*)thread_current()->user_stack + PGSIZE;
 
   /* Push arg */
   stack_ptr -= sizeof(void*);
@@ -1343,8 +1337,29 @@ static bool setup_thread(void** esp, pthread_fun tf, void* arg) {
   stack_ptr -= sizeof(void*);
   *(void**)stack_ptr = NULL;
 
-  *esp = stack_ptr;
-  return true;
+  return stack_ptr;
+}
+
+/* Unmaps and frees the current thread's user stack and its slot. */
+static void free_thread_stack(void) {
+  struct thread* cur = thread_current();
+  struct process* pcb = cur->pcb;
+
+  if (cur->user_stack == NULL)
+    return;
+
+  /* Calculate stack slot from stack base address */
+  size_t slot = ((uint8_t*)PHYS_BASE - (uint8_t*)cur->user_stack) / PGSIZE - 1;
+
+  /* Get the physical page and free it */
+  void* kpage = pagedir_get_page(pcb->pagedir, cur->user_stack);
+  if (kpage != NULL) {
+    pagedir_clear_page(pcb->pagedir, cur->user_stack);
+    palloc_free_page(kpage);
+  }
+  cur->user_stack = NULL;
+
+  release_stack_slot(pcb, slot);
 }
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -1363,16 +1378,166 @@ struct pthread_load_info {
   bool success;             /* True if thread initialized successfully. */
 };
 
+/* A thread parked in its process's thread pool.  Lives on the parked
+   thread's kernel stack; pthread_execute() fills in the entry point and
+   ups WAKE. */
+struct pthread_park {
+  struct list_elem elem;  /* Element in pcb->thread_pool. */
+  struct semaphore wake;  /* Upped to hand over work or to drain the pool. */
+  struct thread* thread;  /* The parked thread. */
+  stub_fun sfun;          /* Stub function, or NULL if the thread should exit. */
+  pthread_fun tfun;       /* Thread function to run in userspace. */
+  void* arg;              /* Argument for the thread function. */
+};
+
+/* Returns a new pthread_status for the thread with TID, or NULL if
+   memory is short. */
+static struct pthread_status* new_pthread_status(tid_t tid) {
+  struct pthread_status* ts = malloc(sizeof(struct pthread_status));
+  if (ts != NULL) {
+    ts->tid = tid;
+    sema_init(&ts->exit_sema, 0);
+    ts->is_joined = false;
+    ts->has_exited = false;
+    ts->retval = NULL;
+  }
+  return ts;
+}
+
+/* Fills IF_ for entering user mode at SF with stack pointer ESP. */
+static void init_pthread_frame(struct intr_frame* if_, stub_fun sf, void* esp) {
+  memset(if_, 0, sizeof *if_);
+#ifdef ARCH_RISCV64
+  /* RISC-V: Set sstatus for user mode return */
+  if_->sstatus = SSTATUS_SPIE | SSTATUS_SUM;
+  if_->sp = (uint64_t)esp;
+  if_->sepc = (uint64_t)sf;
+#else
+  if_->fs = if_->es = if_->ds = if_->ss = SEL_UDSEG;
+  if_->gs = SEL_UTSEG;
+  if_->cs = SEL_UCSEG;
+  if_->eflags = FLAG_IF | FLAG_MBS;
+  if_->esp = esp;
+  if_->eip = (void (*)(void))sf;
+#endif
+}
+
+/* Starts the current thread running user code by simulating a return
+   from an interrupt with IF_.
+   x86: uses intr_exit in threads/intr-stubs.S
+   RISC-V: uses user_entry() which executes sret */
+static void enter_pthread(struct intr_frame* if_) {
+  kdata_thread_attach();
+
+#ifdef ARCH_RISCV64
+  user_entry(if_);
+#else
+  asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(if_) : "memory");
+#endif
+  NOT_REACHED();
+}
+
+/* Hands SF, TF and ARG to a thread parked in the current process's pool,
+   giving it a fresh tid.  Returns that tid, or TID_ERROR if the pool is
+   empty. */
+static tid_t unpark_pthread(stub_fun sf, pthread_fun tf, void* arg) {
+  struct process* pcb = thread_current()->pcb;
+  tid_t tid = TID_ERROR;
+
+  lock_acquire(&pcb->exit_lock);
+  if (!pcb->is_exiting && !list_empty(&pcb->thread_pool)) {
+    struct pthread_status* ts = new_pthread_status(thread_allocate_tid());
+    if (ts != NULL) {
+      struct pthread_park* park =
+          list_entry(list_pop_front(&pcb->thread_pool), struct pthread_park, elem);
+      struct thread* t = park->thread;
+
+      tid = t->tid = ts->tid;
+      t->my_status = ts;
+      list_push_back(&pcb->threads, &t->pcb_elem);
+      list_push_back(&pcb->thread_statuses, &ts->elem);
+      pcb->thread_count++;
+      pcb->pool_threads--;
+
+      park->sfun = sf;
+      park->tfun = tf;
+      park->arg = arg;
+      sema_up(&park->wake);
+    }
+  }
+  lock_release(&pcb->exit_lock);
+  return tid;
+}
+
+/* Parks the current thread in its process's thread pool.  The caller
+   holds exit_lock, has taken the thread off the process's thread list
+   and counted it in pool_threads.  Releases exit_lock.
+
+   If pthread_execute() hands the thread work, it starts running that in
+   user mode and this function does not return.  It returns, with the
+   user stack still mapped, if the process is exiting. */
+static void park_pthread(void) {
+  struct thread* t = thread_current();
+  struct process* pcb = t->pcb;
+  struct pthread_park park;
+
+  ASSERT(lock_held_by_current_thread(&pcb->exit_lock));
+
+  if (pcb->is_exiting) {
+    lock_release(&pcb->exit_lock);
+    return;
+  }
+  park.thread = t;
+  park.sfun = NULL;
+  sema_init(&park.wake, 0);
+  list_push_back(&pcb->thread_pool, &park.elem);
+  lock_release(&pcb->exit_lock);
+
+  /* Parked threads give up their kdata entry. */
+  kdata_thread_detach(t);
+  sema_down(&park.wake);
+  if (park.sfun == NULL)
+    return;
+
+  /* Start the new pthread with a fresh FPU, as a new thread would. */
+  fpu_reset(t);
+
+  struct intr_frame if_;
+  init_pthread_frame(&if_, park.sfun, push_thread_args(park.tfun, park.arg));
+  enter_pthread(&if_);
+}
+
+/* Wakes every thread parked in PCB's pool with no work, so each frees
+   its stack and exits.  The caller holds exit_lock and has set
+   is_exiting; it must then wait for pool_threads to reach 0. */
+static void drain_thread_pool(struct process* pcb) {
+  ASSERT(lock_held_by_current_thread(&pcb->exit_lock));
+
+  while (!list_empty(&pcb->thread_pool)) {
+    struct pthread_park* park =
+        list_entry(list_pop_front(&pcb->thread_pool), struct pthread_park, elem);
+    sema_up(&park->wake);
+  }
+}
+
 /* Starts a new thread with a new user stack running SF (the stub function), 
    which will call TF (the user thread function) with ARG as its argument 
    in userspace. The newly created thread may be scheduled (and may even exit) 
    before pthread_execute() returns.
 
+   A thread parked in the process's pool, if there is one, runs SF
+   instead of a new kernel thread, and pthread_execute() returns without
+   waiting for it.
+
    Returns the new thread's TID, or TID_ERROR if the thread cannot be created properly.
 
    This function is fully implemented and behaves similarly to process_execute().
 */
 tid_t pthread_execute(stub_fun sf, pthread_fun tf, void* arg) {
+  tid_t tid = unpark_pthread(sf, tf, arg);
+  if (tid != TID_ERROR)
+    return tid;
+
   /* Prepare the pthread_load_info struct for the new thread. */
   struct pthread_load_info* load_info = malloc(sizeof(struct pthread_load_info));
   if (!load_info)
@@ -1386,7 +1551,7 @@ tid_t pthread_execute(stub_fun sf, pthread_fun tf, void* arg) {
   load_info->sfun = sf;
 
   /* The best name for this function is "pthread_execute". */
-  tid_t tid = thread_create("pthread_create", PRI_DEFAULT, start_pthread, load_info);
+  tid = thread_create("pthread_create", PRI_DEFAULT, start_pthread, load_info);
   if (tid == TID_ERROR) {
     free(load_info);
     return TID_ERROR;
@@ -1413,7 +1578,7 @@ static void start_pthread(void* exec_) {
   struct pthread_load_info* load_info = (struct pthread_load_info*)exec_;
   struct thread* t = thread_current();
   struct intr_frame if_;
-  bool success = true;
+  void* esp;
 
   t->pcb = load_info->pcb;
 
@@ -1421,17 +1586,12 @@ static void start_pthread(void* exec_) {
   process_activate();
 
   /* Allocate pthread_status for join synchronization */
-  struct pthread_status* ts = malloc(sizeof(struct pthread_status));
+  struct pthread_status* ts = new_pthread_status(t->tid);
   if (ts == NULL) {
     load_info->success = false;
     sema_up(&load_info->started);
     thread_exit();
   }
-  ts->tid = t->tid;
-  sema_init(&ts->exit_sema, 0);
-  ts->is_joined = false;
-  ts->has_exited = false;
-  ts->retval = NULL;
   t->my_status = ts;
 
   /* Check if process is exiting before we start */
@@ -1449,22 +1609,8 @@ static void start_pthread(void* exec_) {
   t->pcb->thread_count++;
   lock_release(&t->pcb->exit_lock);
 
-  /* Set up interrupt frame */
-  memset(&if_, 0, sizeof if_);
-#ifdef ARCH_RISCV64
-  /* RISC-V: Set sstatus for user mode return */
-  if_.sstatus = SSTATUS_SPIE | SSTATUS_SUM;
-  /* Setup thread allocates new stack and sets up sp */
-  success = setup_thread((void**)&if_.sp, load_info->tfun, load_info->arg);
-#else
-  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
-  if_.cs = SEL_UCSEG;
-  if_.eflags = FLAG_IF | FLAG_MBS;
-  /* Setup thread allocates new stack and sets up esp */
-  success = setup_thread(&if_.esp, load_info->tfun, load_info->arg);
-#endif
-
-  if (!success) {
+  /* Setup thread allocates new stack and sets up the stack pointer */
+  if (!setup_thread(&esp, load_info->tfun, load_info->arg)) {
     /* Failed to set up stack - clean up and exit */
     lock_acquire(&t->pcb->exit_lock);
     list_remove(&t->pcb_elem);
@@ -1479,25 +1625,13 @@ static void start_pthread(void* exec_) {
   }
 
   /* Set entry point to the stub function */
-#ifdef ARCH_RISCV64
-  if_.sepc = (uint64_t)load_info->sfun;
-#else
-  if_.eip = (void (*)(void))load_info->sfun;
-#endif
+  init_pthread_frame(&if_, load_info->sfun, esp);
 
   /* Signal success to parent */
   load_info->success = true;
   sema_up(&load_info->started);
 
-  /* Start the user thread by simulating a return from an interrupt.
-     x86: uses intr_exit in threads/intr-stubs.S
-     RISC-V: uses user_entry() which executes sret */
-#ifdef ARCH_RISCV64
-  user_entry(&if_);
-#else
-  asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
-#endif
-  NOT_REACHED();
+  enter_pthread(&if_);
 }
 
 /* Waits for thread with TID to die, if that thread was spawned
@@ -1556,6 +1690,10 @@ tid_t pthread_join(tid_t tid, void** retval) {
    be freed on thread_exit(), so all we have to do is deallocate the
    thread's userspace stack. Wake any waiters on this thread.
 
+   Unless the process is exiting or its pool is full, the thread instead
+   parks in the pool with its stack still mapped, for pthread_execute()
+   to reuse.
+
    The main thread should not use this function. See
    pthread_exit_main() below. */
 void pthread_exit(void* retval) {
@@ -1568,29 +1706,25 @@ void pthread_exit(void* retval) {
     NOT_REACHED();
   }
 
-  /* Store return value and signal any thread waiting to join us */
+  /* Store return value and signal any thread waiting to join us.  The
+     joiner frees the status, so forget it. */
   if (cur->my_status != NULL) {
     cur->my_status->retval = retval;
     sema_up(&cur->my_status->exit_sema);
+    cur->my_status = NULL;
   }
 
-  /* Free the user stack page */
-  if (cur->user_stack != NULL) {
-    /* Calculate stack slot from stack base address */
-    int slot = ((uint8_t*)PHYS_BASE - (uint8_t*)cur->user_stack) / PGSIZE - 1;
-
-    /* Get the physical page and free it */
-    void* kpage = pagedir_get_page(pcb->pagedir, cur->user_stack);
-    if (kpage != NULL) {
-      pagedir_clear_page(pcb->pagedir, cur->user_stack);
-      palloc_free_page(kpage);
-    }
+  /* Decide whether to park.  Counting the thread in pool_threads first
+     keeps process_exit() from destroying the page directory under it. */
+  lock_acquire(&pcb->exit_lock);
+  bool park = !pcb->is_exiting && cur->user_stack != NULL && pcb->pool_threads < PTHREAD_POOL_MAX;
+  if (park)
+    pcb->pool_threads++;
+  lock_release(&pcb->exit_lock);
 
-    /* Mark stack slot as free */
-    if (slot >= 0 && slot < MAX_THREADS) {
-      pcb->stack_slots[slot] = false;
-    }
-  }
+  /* Free the user stack page */
+  if (!park)
+    free_thread_stack();
 
   /* Update thread count and remove from threads list */
   lock_acquire(&pcb->exit_lock);
@@ -1599,6 +1733,16 @@ void pthread_exit(void* retval) {
 
   /* Signal in case main thread is waiting in pthread_exit_main */
   cond_broadcast(&pcb->exit_cond, &pcb->exit_lock);
+
+  if (park) {
+    /* Returns only if the process is exiting. */
+    park_pthread();
+    free_thread_stack();
+
+    lock_acquire(&pcb->exit_lock);
+    pcb->pool_threads--;
+    cond_broadcast(&pcb->exit_cond, &pcb->exit_lock);
+  }
   lock_release(&pcb->exit_lock);
 
   thread_exit();
@@ -82,9 +82,12 @@
 #define USERPROG_PROCESS_H
 
 #include "threads/thread.h"
+#include "userprog/fdtable.h"
 #include "userprog/filedesc.h"
+#include "userprog/usync.h"
 #include "vm/page.h"
 #include <stdint.h>
+#include <vmstat.h>
 
 /* Forward declarations. */
 struct file;
@@ -97,17 +100,28 @@ struct dir;
 /* Maximum stack pages (8 MB total stack space). */
 #define MAX_STACK_PAGES (1 << 11)
 
-/* Maximum threads per process. */
-#define MAX_THREADS 127
+/* Maximum threads per process.  Each has a one-page user stack slot in
+   the stack region below PHYS_BASE, slot 0 being the main thread's. */
+#define MAX_THREADS MAX_STACK_PAGES
+
+/* Most exited threads a process keeps parked for reuse by pthread_create.
+   RISC-V's user_entry() keeps the caller's stack pointer as the trap stack,
+   so a thread re-entering user mode from inside pthread_exit() would lose
+   that much kernel stack each time; it does not pool threads. */
+#ifdef ARCH_RISCV64
+#define PTHREAD_POOL_MAX 0
+#else
+#define PTHREAD_POOL_MAX 16
+#endif
 
 /* Maximum command-line arguments. */
 #define MAX_ARGS 64
 
 /* Maximum file descriptors per process. */
-#define MAX_FILE_DESCRIPTOR 128
+#define MAX_FILE_DESCRIPTOR FD_TABLE_MAX
 
 /* ═══════════════════════════════════════════════════════════════════════════
- * USER-LEVEL SYNCHRONIZATION LIMITS
+ * USER-LEVEL SYNCHRONIZATION HANDLES
  * ═══════════════════════════════════════════════════════════════════════════*/
 
 /* User-level lock/semaphore handle types.
@@ -115,9 +129,6 @@ struct dir;
 typedef int lock_t; /* Lock handle type. */
 typedef int sema_t; /* Semaphore handle type. */
 
-#define MAX_LOCKS 256
-#define MAX_SEMAS 256
-
 /* ═══════════════════════════════════════════════════════════════════════════
  * PID AND THREAD FUNCTION TYPES
  * ═══════════════════════════════════════════════════════════════════════════*/
@@ -134,6 +145,8 @@ typedef void (*stub_fun)(pthread_fun, void*); /* Stub wrapper function. */
  * ═══════════════════════════════════════════════════════════════════════════
  *
  * Each process has a file descriptor table indexed 0 to MAX_FILE_DESCRIPTOR-1.
+ * It starts small and doubles as descriptors are opened; all threads of the
+ * process share it under its own lock.  See userprog/fdtable.h.
  * FDs 0, 1, 2 are reserved for STDIN/STDOUT/STDERR.
  *
  * File descriptors point to Open File Descriptions (OFDs) in a global table.
@@ -181,8 +194,9 @@ struct process {
   /* ═══════════════════════════════════════════════════════════════════════
    * FILE SYSTEM STATE
    * ═══════════════════════════════════════════════════════════════════════*/
-  struct fd_entry fd_table[MAX_FILE_DESCRIPTOR]; /* File descriptor table. */
-  struct file* executable;                       /* Executable file (write-denied while running). */
+  struct fd_table fd_table; /* File descriptor table. */
+  struct file* executable;  /* Executable file (write-denied while running). */
+  struct list urings;       /* I/O rings created here (userprog/uring.h). */
 
   /* ═══════════════════════════════════════════════════════════════════════
    * MULTI-THREADING SUPPORT
@@ -192,6 +206,13 @@ struct process {
   struct list threads;         /* All threads in this process. */
   struct list thread_statuses; /* pthread_status list for join/cleanup. */
 
+  /* Threads that called pthread_exit() are parked here, user stack still
+     mapped, and pthread_create hands them a new tid and entry point instead
+     of creating a kernel thread.  Parked threads are not in THREADS and
+     not counted by THREAD_COUNT.  Protected by EXIT_LOCK. */
+  struct list thread_pool; /* struct pthread_park, in userprog/process.c. */
+  int pool_threads;        /* Threads parked or on their way into the pool. */
+
   /* ═══════════════════════════════════════════════════════════════════════
    * EXIT SYNCHRONIZATION (Mesa-style Monitor)
    * ─────────────────────────────────────────────────────────────────────────
@@ -207,13 +228,11 @@ struct process {
   /* ═══════════════════════════════════════════════════════════════════════
    * USER-LEVEL SYNCHRONIZATION
    * ─────────────────────────────────────────────────────────────────────────
-   * Kernel-managed locks and semaphores for user programs.
-   * User code gets a handle (lock_t/sema_t), kernel stores actual struct.
+   * Kernel-managed locks, semaphores, condition variables, barriers and
+   * reader-writer locks for user programs.  User code gets a handle
+   * (lock_t, sema_t, ...), the kernel stores the object (userprog/usync.h).
    * ═══════════════════════════════════════════════════════════════════════*/
-  struct lock* lock_table[MAX_LOCKS];      /* Maps lock_t → struct lock*. */
-  struct semaphore* sema_table[MAX_SEMAS]; /* Maps sema_t → struct semaphore*. */
-  int next_lock_id;                        /* Next available lock ID. */
-  int next_sema_id;                        /* Next available semaphore ID. */
+  struct usync_table usync; /* Maps handles to objects. */
 
   /* ═══════════════════════════════════════════════════════════════════════
    * PTHREAD STACK MANAGEMENT
@@ -221,7 +240,8 @@ struct process {
    * Each pthread needs its own user stack. We allocate stack pages at
    * fixed offsets from PHYS_BASE to avoid collisions.
    * ═══════════════════════════════════════════════════════════════════════*/
-  bool stack_slots[MAX_THREADS]; /* true = slot in use. */
+  struct bitmap* stack_slots; /* MAX_THREADS bits, set = slot in use; created
+                                 by the first pthread_create.  EXIT_LOCK. */
 
   /* ═══════════════════════════════════════════════════════════════════════
    * MEMORY-MAPPED FILES
@@ -231,6 +251,23 @@ struct process {
    * ═══════════════════════════════════════════════════════════════════════*/
   struct list mmap_list; /* List of mmap_region structs. */
   struct lock mmap_lock; /* Protects mmap_list and mmap operations. */
+
+  /* ═══════════════════════════════════════════════════════════════════════
+   * VM STATISTICS
+   * ─────────────────────────────────────────────────────────────────────────
+   * Fault and eviction counters charged to this process.
+   * See vm/vmstat.h; readable from user space via SYS_VMSTAT.
+   * ═══════════════════════════════════════════════════════════════════════*/
+  struct vmstat vmstat;
+
+  /* ═══════════════════════════════════════════════════════════════════════
+   * SYSTEM CALL TRACING
+   * ─────────────────────────────────────────────────────────────────────────
+   * SYSTRACE_CHILDREN generations this process is traced in, and asked
+   * for its new children to be traced in.  See userprog/systrace.h.
+   * ═══════════════════════════════════════════════════════════════════════*/
+  unsigned trace_gen;
+  unsigned trace_children_gen;
 };
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -302,8 +339,9 @@ struct process_load_info {
   struct process_status* child_status; /* Status struct for this child. */
   struct process* parent_process;      /* Parent's PCB. */
 
-  /* For fork: parent's interrupt frame to copy. */
+  /* For fork: parent's interrupt frame and thread to copy. */
   struct intr_frame* parent_if;
+  struct thread* parent_thread;
 };
 
 /* ═══════════════════════════════════════════════════════════════════════════
@@ -330,7 +368,6 @@ void process_activate(void);
 
 bool is_main_thread(struct thread*, struct process*);
 pid_t get_pid(struct process*);
-int find_free_fd(void);
 
 /* ═══════════════════════════════════════════════════════════════════════════
  * PTHREAD FUNCTIONS
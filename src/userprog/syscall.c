@@ -36,30 +36,49 @@
  * ║                                                                          ║
  * ║  SECURITY:                                                               ║
  * ║  ─────────                                                               ║
- * ║  • Invalid user pointers are caught by the page fault handler            ║
- * ║  • When kernel faults on user address, process exits with -1             ║
- * ║  • This approach is simpler and handles lazy-loaded pages correctly      ║
+ * ║  • User memory is only touched through userprog/uaccess.h: arguments,    ║
+ * ║    paths and small structures are copied in and out, large buffers are   ║
+ * ║    pinned so the filesystem can use them directly                        ║
+ * ║  • A bad pointer makes the copy or pin fail; the process exits with -1   ║
+ * ║    from here, never from inside the page fault handler                   ║
  * ║                                                                          ║
  * ║  SYSCALL CATEGORIES:                                                     ║
  * ║  ────────────────────                                                    ║
  * ║  • Process:  exit, exec, wait, fork, halt                                ║
  * ║  • File:     create, remove, open, close, read, write, seek, tell, size  ║
  * ║  • Directory: chdir, mkdir, readdir, isdir                               ║
+ * ║  • Pipes:    pipe, splice                                                ║
+ * ║  • Readiness: poll, epoll_create, epoll_ctl, epoll_wait                  ║
+ * ║  • Async I/O: io_uring_setup, io_uring_enter                             ║
+ * ║  • Tracing:  systrace                                                    ║
  * ║  • Threading: pt_create, pt_exit, pt_join, get_tid                       ║
  * ║  • Sync:     lock_init/acquire/release, sema_init/up/down                ║
+ * ║              cond_init/wait/signal/broadcast, barrier_init/wait          ║
+ * ║              rwlock_init/acquire/release                                 ║
+ * ║  • Memory:   mmap, munmap, mmap2, vmstat, shm_open, shm_unlink           ║
  * ║                                                                          ║
  * ╚══════════════════════════════════════════════════════════════════════════╝
  */
 
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <round.h>
 #include <string.h>
 #include <syscall-nr.h>
+#include <uio.h>
+#include <limits.h>
+#include "arch/common/cpu.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "devices/input.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "userprog/pipe.h"
+#include "userprog/poll.h"
 #include "userprog/process.h"
+#include "userprog/systrace.h"
+#include "userprog/uaccess.h"
+#include "userprog/uring.h"
 #include "filesys/file.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
@@ -68,6 +87,8 @@
 #include "filesys/filesys.h"
 #include "filesys/wal.h"
 #include "vm/mmap.h"
+#include "vm/shm.h"
+#include "vm/vmstat.h"
 
 #ifdef ARCH_RISCV64
 #include "arch/riscv64/csr.h"
@@ -103,7 +124,8 @@ void syscall_handler(struct intr_frame*);
    RISC-V: syscall_handler is called directly from trap handler (ECALL). */
 void syscall_init(void) {
 #ifndef ARCH_RISCV64
-  /* x86: Register INT 0x30 handler. DPL=3 allows user-mode invocation. */
+  /* x86: Register INT 0x30 handler. DPL=3 allows user-mode invocation.
+     SYSENTER, when available, is set up by tss_init(). */
   intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
 #endif
   /* RISC-V: No registration needed - trap handler calls syscall_handler directly */
@@ -117,18 +139,289 @@ static void exit_process(struct intr_frame* f, int exit_code) {
   process_exit();
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * ARGUMENT HELPERS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Number of arguments each system call takes, so that exactly those are
+   copied in from the user stack.  Calls not listed take none. */
+static const uint8_t syscall_arg_cnt[] = {
+    [SYS_EXIT] = 1,         [SYS_EXEC] = 1,         [SYS_WAIT] = 1,       [SYS_CREATE] = 2,
+    [SYS_REMOVE] = 1,       [SYS_OPEN] = 1,         [SYS_FILESIZE] = 1,   [SYS_READ] = 3,
+    [SYS_WRITE] = 3,        [SYS_SEEK] = 2,         [SYS_TELL] = 1,       [SYS_CLOSE] = 1,
+    [SYS_PRACTICE] = 1,     [SYS_PT_CREATE] = 3,    [SYS_PT_JOIN] = 1,    [SYS_LOCK_INIT] = 1,
+    [SYS_LOCK_ACQUIRE] = 1, [SYS_LOCK_RELEASE] = 1, [SYS_SEMA_INIT] = 2,  [SYS_SEMA_DOWN] = 1,
+    [SYS_SEMA_UP] = 1,      [SYS_MMAP] = 2,         [SYS_MUNMAP] = 1,     [SYS_CHDIR] = 1,
+    [SYS_MKDIR] = 1,        [SYS_READDIR] = 2,      [SYS_ISDIR] = 1,      [SYS_INUMBER] = 1,
+    [SYS_LINK] = 2,         [SYS_SYMLINK] = 2,      [SYS_READLINK] = 3,   [SYS_PIPE] = 1,
+    [SYS_MMAP2] = 6,        [SYS_VMSTAT] = 2,       [SYS_SHM_OPEN] = 2,   [SYS_SHM_UNLINK] = 1,
+    [SYS_PREAD] = 4,        [SYS_PWRITE] = 4,       [SYS_READV] = 3,      [SYS_WRITEV] = 3,
+    [SYS_COPY_FILE_RANGE] = 3, [SYS_SPLICE] = 3,    [SYS_POLL] = 3,       [SYS_EPOLL_CTL] = 4,
+    [SYS_EPOLL_WAIT] = 4,   [SYS_IO_URING_SETUP] = 2, [SYS_IO_URING_ENTER] = 3, [SYS_SYSTRACE] = 3,
+    [SYS_COND_INIT] = 1,    [SYS_COND_WAIT] = 2,    [SYS_COND_SIGNAL] = 2, [SYS_COND_BROADCAST] = 2,
+    [SYS_BARRIER_INIT] = 2, [SYS_BARRIER_WAIT] = 1, [SYS_RWLOCK_INIT] = 1, [SYS_RWLOCK_ACQUIRE] = 2,
+    [SYS_RWLOCK_RELEASE] = 2,
+};
+
+/* Longest path, counting the null terminator, that system calls accept.
+   The filesystem allows at most MAX_PATH_COMPONENTS names of NAME_MAX
+   characters each, which fits with room to spare. */
+#define SYSCALL_PATH_MAX 256
+
+/* Copies the path at user address UPATH into PATH.  A path that is too
+   long is returned as "", which every filesystem call rejects.  Returns
+   false if UPATH is not a valid user string. */
+static bool copy_path(char path[SYSCALL_PATH_MAX], const char* upath) {
+  int len = strncpy_from_user(path, upath, SYSCALL_PATH_MAX);
+  if (len < 0)
+    return false;
+  if (len == SYSCALL_PATH_MAX)
+    path[0] = '\0';
+  return true;
+}
+
+/* Calls FN with kernel copies of the user paths UPATH1 and UPATH2.  Returns
+   FN's result, or -1 if either path is not a valid user string.  Kept out
+   of syscall_handler() so that the second path buffer only occupies the
+   stack for the calls that need it. */
+static int two_path_call(bool (*fn)(const char*, const char*), const char* upath1,
+                         const char* upath2) {
+  char path1[SYSCALL_PATH_MAX];
+  char path2[SYSCALL_PATH_MAX];
+
+  if (!copy_path(path1, upath1) || !copy_path(path2, upath2))
+    return -1;
+  return fn(path1, path2);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * I/O HELPERS
  * ═══════════════════════════════════════════════════════════════════════════*/
 
-/* Reads SIZE bytes from keyboard input into BUFFER. */
-static int read_from_input(char* buffer, unsigned size) {
+/* Largest piece of a user buffer pinned at once by user_io(). */
+#define USER_IO_CHUNK (16 * PGSIZE)
+
+/* Transfers SIZE bytes between OFD and BUFFER, which is pinned user memory,
+   at file offset OFFSET where that means anything.  Returns the number of
+   bytes transferred. */
+typedef int user_io_func(struct open_file_desc* ofd, void* buffer, unsigned size, off_t offset);
+
+/* Hands user buffer UBUF of SIZE bytes to IO one piece at a time, each
+   piece pinned for the duration of the call so that IO may access it
+   directly while holding filesystem or console locks.  WRITE is true if IO
+   stores into the buffer.  The first piece goes to OFFSET and each later
+   one follows on.  Stops after a short transfer.  Returns the number of
+   bytes transferred, or -1 if UBUF is not valid user memory. */
+static int user_io(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write,
+                   off_t offset, user_io_func* io) {
+  unsigned done = 0;
+
+  while (done < size) {
+    uint8_t* piece = (uint8_t*)ubuf + done;
+    unsigned piece_size = USER_IO_CHUNK - pg_ofs(piece);
+    if (piece_size > size - done)
+      piece_size = size - done;
+
+    if (!uaccess_pin(piece, piece_size, write))
+      return -1;
+    int n = io(ofd, piece, piece_size, offset + done);
+    uaccess_unpin(piece, piece_size);
+
+    if (n <= 0)
+      break;
+    done += n;
+    if ((unsigned)n < piece_size)
+      break;
+  }
+  return done;
+}
+
+static int file_read_io(struct open_file_desc* ofd, void* buffer, unsigned size, off_t offset) {
+  return file_read_at(ofd->file, buffer, size, offset);
+}
+
+static int file_write_io(struct open_file_desc* ofd, void* buffer, unsigned size, off_t offset) {
+  return file_write_at(ofd->file, buffer, size, offset);
+}
+
+static int console_write_io(struct open_file_desc* ofd UNUSED, void* buffer, unsigned size,
+                            off_t offset UNUSED) {
+  putbuf(buffer, size);
+  return size;
+}
+
+/* Reads SIZE bytes from keyboard input into user buffer UBUF.  Returns
+   -1 if UBUF is not writable user memory.  Keystrokes may take forever
+   to arrive, so nothing is pinned meanwhile. */
+static int read_from_input(char* ubuf, unsigned size) {
   for (unsigned i = 0; i < size; i++) {
-    buffer[i] = input_getc();
+    char c = input_getc();
+    if (!copy_to_user(ubuf + i, &c, 1))
+      return -1;
   }
   return size;
 }
 
+/* Like read_from_input(), but reads only keys already waiting.  Returns
+   SYSCALL_IO_AGAIN if there are none. */
+static int read_waiting_input(char* ubuf, unsigned size) {
+  unsigned i;
+  for (i = 0; i < size; i++) {
+    enum intr_level old_level = intr_disable();
+    bool empty = input_empty();
+    char c = empty ? 0 : input_getc();
+    intr_set_level(old_level);
+    if (empty)
+      break;
+    if (!copy_to_user(ubuf + i, &c, 1))
+      return -1;
+  }
+  return i > 0 ? (int)i : SYSCALL_IO_AGAIN;
+}
+
+/* Result of segment_io() and vector_io() for a transfer that failed with
+   valid user memory, such as a write to a pipe with no reader.  The
+   caller returns -1 rather than ending the process. */
+#define IO_ERROR (-2)
+
+/* Transfers SIZE bytes between OFD, at file offset OFFSET, and user buffer
+   UBUF.  WRITE is true to write to OFD.  OFD must be a file, or the console
+   or a pipe in the matching direction.  Returns the number of bytes
+   transferred, IO_ERROR, or -1 if UBUF is not valid user memory. */
+static int segment_io(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write,
+                      off_t offset) {
+  if (ofd->type == FD_PIPE) {
+    /* The pipe copies through its own pages, so nothing is pinned. */
+    bool fault = false;
+    int n = write ? pipe_write(ofd->pipe, ubuf, size, false, &fault)
+                  : pipe_read(ofd->pipe, ubuf, size, false, &fault);
+    return fault ? -1 : n < 0 ? IO_ERROR : n;
+  }
+  if (ofd->type == FD_CONSOLE)
+    return write ? user_io(ofd, ubuf, size, false, 0, console_write_io)
+                 : read_from_input(ubuf, size);
+  return user_io(ofd, ubuf, size, !write, offset, write ? file_write_io : file_read_io);
+}
+
+/* Segments of a readv() or writev() vector copied in at once. */
+#define IOV_BATCH 16
+
+/* Like segment_io(), but for the IOVCNT segments described by the user
+   array UIOV, in order, the first at OFFSET and each following on.  Stops
+   after a short transfer. */
+static int vector_io(struct open_file_desc* ofd, const struct iovec* uiov, int iovcnt, bool write,
+                     off_t offset) {
+  struct iovec iov[IOV_BATCH];
+  int total = 0;
+
+  for (int i = 0; i < iovcnt; i += IOV_BATCH) {
+    int cnt = iovcnt - i < IOV_BATCH ? iovcnt - i : IOV_BATCH;
+    if (!copy_from_user(iov, uiov + i, cnt * sizeof *iov))
+      return -1;
+
+    for (int j = 0; j < cnt; j++) {
+      /* The total must fit in the return value. */
+      unsigned len = iov[j].iov_len;
+      if (len > (unsigned)(INT_MAX - total))
+        len = INT_MAX - total;
+
+      int n = segment_io(ofd, iov[j].iov_base, len, write, offset + total);
+      if (n < 0)
+        return n == IO_ERROR && total > 0 ? total : n;
+      total += n;
+      if ((unsigned)n < len || total == INT_MAX)
+        return total;
+    }
+  }
+  return total;
+}
+
+/* Returns the OFD for FD if it can be read (or written, if WRITE), or
+   NULL if FD is not open or is a directory, shared memory object, or
+   console stream or pipe end of the wrong direction. */
+static struct open_file_desc* get_io_ofd(int fd, bool write) {
+  struct open_file_desc* ofd = fd_table_get(&thread_current()->pcb->fd_table, fd);
+  if (ofd == NULL)
+    return NULL;
+  if (ofd->type == FD_CONSOLE || ofd->type == FD_PIPE)
+    return ofd->cmode == (write ? CONSOLE_WRITE : CONSOLE_READ) ? ofd : NULL;
+  return ofd->type == FD_FILE && ofd->file != NULL ? ofd : NULL;
+}
+
+/* Starts a transfer at OFD's current position and returns the position.
+   A file's position is held under OFD's lock until end_stream_io(), so
+   concurrent transfers through one OFD cover disjoint ranges. */
+static off_t begin_stream_io(struct open_file_desc* ofd) {
+  if (ofd->type != FD_FILE)
+    return 0;
+  lock_acquire(&ofd->lock);
+  return file_tell(ofd->file);
+}
+
+/* Finishes a transfer begun at POS by begin_stream_io() that moved
+   N bytes, or -1 if it failed. */
+static void end_stream_io(struct open_file_desc* ofd, off_t pos, int n) {
+  if (ofd->type != FD_FILE)
+    return;
+  if (n > 0)
+    file_seek(ofd->file, pos + n);
+  lock_release(&ofd->lock);
+}
+
+/* Copies up to SIZE bytes from IN's file position to OUT's, advancing
+   both.  The OFDs stay locked, in address order, throughout.  Returns
+   the number of bytes copied, or -1 if the two ranges overlap within
+   one file. */
+static int copy_range(struct open_file_desc* in, struct open_file_desc* out, unsigned size) {
+  struct open_file_desc* first = in < out ? in : out;
+  struct open_file_desc* second = in < out ? out : in;
+  int copied = -1;
+
+  if (size > INT_MAX)
+    size = INT_MAX;
+
+  lock_acquire(&first->lock);
+  if (second != first)
+    lock_acquire(&second->lock);
+
+  off_t in_pos = file_tell(in->file);
+  off_t out_pos = file_tell(out->file);
+  unsigned distance = in_pos < out_pos ? out_pos - in_pos : in_pos - out_pos;
+  if (file_get_inode(in->file) != file_get_inode(out->file) || distance >= size) {
+    copied = file_copy_at(out->file, out_pos, in->file, in_pos, size);
+    file_seek(in->file, in_pos + copied);
+    file_seek(out->file, out_pos + copied);
+  }
+
+  if (second != first)
+    lock_release(&second->lock);
+  lock_release(&first->lock);
+  return copied;
+}
+
+/* Moves up to SIZE bytes between IN and OUT, one a pipe and the other a
+   file, starting at and advancing the file's position.  Returns the number
+   of bytes moved, or -1 if neither combination applies or the transfer
+   failed. */
+static int splice_io(struct open_file_desc* in, struct open_file_desc* out, unsigned size) {
+  if (size > INT_MAX)
+    size = INT_MAX;
+
+  if (in->type == FD_FILE && out->type == FD_PIPE) {
+    off_t pos = begin_stream_io(in);
+    int n = pipe_splice_from_file(out->pipe, in->file, pos, size);
+    end_stream_io(in, pos, n);
+    return n;
+  }
+  if (in->type == FD_PIPE && out->type == FD_FILE) {
+    off_t pos = begin_stream_io(out);
+    int n = pipe_splice_to_file(in->pipe, out->file, pos, size);
+    end_stream_io(out, pos, n);
+    return n;
+  }
+  return -1;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * FILE DESCRIPTOR HELPERS
  * ─────────────────────────────────────────────────────────────────────────────
@@ -136,24 +429,52 @@ static int read_from_input(char* buffer, unsigned size) {
  * Now uses the Global Open File Description Table (GOFD).
  * ═══════════════════════════════════════════════════════════════════════════*/
 
-/* Validates that FD is a valid file descriptor index.
-   Returns true if valid, false otherwise. */
-static bool is_valid_fd(int fd) { return fd >= 0 && fd < MAX_FILE_DESCRIPTOR; }
+/* Gets the OFD from fd_table, or NULL if fd is invalid or slot unused. */
+static struct open_file_desc* get_ofd(int fd) {
+  return fd_table_get(&thread_current()->pcb->fd_table, fd);
+}
 
-/* Gets the fd_entry for the given FD, or NULL if invalid.
-   Does NOT check if the slot is in use - caller must check ofd != NULL. */
-static struct fd_entry* get_fd_entry(int fd) {
-  if (!is_valid_fd(fd))
-    return NULL;
-  return &thread_current()->pcb->fd_table[fd];
+/* Installs OFD at the lowest free descriptor and returns it.  If the
+   table is full, closes OFD and returns -1. */
+static int install_ofd(struct open_file_desc* ofd) {
+  int fd = fd_table_install(&thread_current()->pcb->fd_table, ofd);
+  if (fd == -1)
+    ofd_close(ofd);
+  return fd;
 }
 
-/* Gets the OFD from fd_table, or NULL if fd is invalid or slot unused. */
-static struct open_file_desc* get_ofd(int fd) {
-  struct fd_entry* entry = get_fd_entry(fd);
-  if (entry == NULL)
-    return NULL;
-  return entry->ofd;
+/* Creates a pipe and installs its read and write ends, storing their
+   descriptors in FDS.  Returns false, with nothing installed, on
+   failure. */
+static bool open_pipe(int fds[2]) {
+  struct pipe* pipe = pipe_create();
+  if (pipe == NULL)
+    return false;
+
+  struct open_file_desc* rd = ofd_create_pipe(pipe, false);
+  if (rd == NULL) {
+    pipe_close(pipe, false);
+    pipe_close(pipe, true);
+    return false;
+  }
+  struct open_file_desc* wr = ofd_create_pipe(pipe, true);
+  if (wr == NULL) {
+    ofd_close(rd);
+    pipe_close(pipe, true);
+    return false;
+  }
+
+  fds[0] = install_ofd(rd);
+  if (fds[0] == -1) {
+    ofd_close(wr);
+    return false;
+  }
+  fds[1] = install_ofd(wr);
+  if (fds[1] == -1) {
+    ofd_close(fd_table_remove(&thread_current()->pcb->fd_table, fds[0]));
+    return false;
+  }
+  return true;
 }
 
 /* Gets a file from fd_table (via OFD), or NULL if fd is invalid or not a file. */
@@ -172,11 +493,170 @@ static struct dir* get_dir_from_fd(int fd) {
   return ofd->dir;
 }
 
+/* Copies the shared memory object name at user address UNAME into NAME,
+   which has room for SHM_NAME_MAX + 1 bytes.  A name that is too long is
+   returned as "", which shm_open() and shm_unlink() reject.  Returns false
+   if UNAME is not a valid user string. */
+static bool copy_shm_name(char name[SHM_NAME_MAX + 1], const char* uname) {
+  int len = strncpy_from_user(name, uname, SHM_NAME_MAX + 1);
+  if (len < 0)
+    return false;
+  if (len > SHM_NAME_MAX)
+    name[0] = '\0';
+  return true;
+}
+
+/* Handles mmap2() with MAP_SHARED.  Anonymous mappings get a fresh object
+   that lives as long as some mapping of it (including inherited ones);
+   otherwise FD must name a shm_open() object and OFFSET must be page
+   aligned. */
+static void* map_shared(void* addr, size_t length, int flags, int fd, off_t offset) {
+  if (flags & MAP_ANONYMOUS) {
+    struct shm_object* obj = shm_create(DIV_ROUND_UP(length, PGSIZE));
+    if (obj == NULL)
+      return MAP_FAILED;
+    void* result = mmap_create_shared(addr, length, flags, obj, 0);
+    shm_unref(obj); /* The mapping holds its own reference. */
+    return result;
+  }
+
+  struct open_file_desc* ofd = get_ofd(fd);
+  if (ofd == NULL || ofd->type != FD_SHM || offset < 0 || offset % PGSIZE != 0)
+    return MAP_FAILED;
+  return mmap_create_shared(addr, length, flags, ofd->shm, offset / PGSIZE);
+}
+
+/* Opens PATH and installs it as a new descriptor, as a directory or a
+   regular file according to what it names.  Returns the descriptor, or -1
+   on failure. */
+static int open_path(const char* path) {
+  struct file* open_file = filesys_open(path);
+  if (open_file == NULL)
+    return -1;
+
+  /* Check if it's a directory or regular file, create appropriate OFD */
+  struct inode* inode = file_get_inode(open_file);
+  struct open_file_desc* ofd;
+
+  if (inode_is_dir(inode)) {
+    struct dir* open_dir = dir_open(inode_reopen(inode));
+    file_close(open_file);
+    if (open_dir == NULL)
+      return -1;
+    ofd = ofd_create_dir(open_dir);
+    if (ofd == NULL) {
+      dir_close(open_dir);
+      return -1;
+    }
+  } else {
+    ofd = ofd_create_file(open_file);
+    if (ofd == NULL) {
+      file_close(open_file);
+      return -1;
+    }
+  }
+  return install_ofd(ofd);
+}
+
+/* Creates an I/O ring over the user memory at UMEM and installs it.
+   Returns the descriptor, or -1 on failure, setting *FAULT if UMEM is not
+   writable user memory. */
+static int open_uring(unsigned entries, void* umem, bool* fault) {
+  struct uring* ring = uring_create(entries, umem, fault);
+  if (ring == NULL)
+    return -1;
+  struct open_file_desc* ofd = ofd_create_uring(ring);
+  if (ofd == NULL) {
+    uring_close(ring);
+    return -1;
+  }
+  return install_ofd(ofd);
+}
+
+/* Reads the handle at UHANDLE and returns the current process's user
+   synchronization object of KIND that it names, or NULL if UHANDLE is NULL
+   or names no such object.  Sets *FAULT if UHANDLE is not readable. */
+static struct usync* get_usync(const int* uhandle, enum usync_kind kind, bool* fault) {
+  int id;
+
+  if (uhandle == NULL)
+    return NULL;
+  /* Read user memory before looking anything up */
+  if (!copy_from_user(&id, uhandle, sizeof id)) {
+    *fault = true;
+    return NULL;
+  }
+  return usync_get(&thread_current()->pcb->usync, id, kind);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * OPERATIONS SHARED WITH I/O RINGS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+struct open_file_desc* syscall_io_ofd(int fd, bool write) { return get_io_ofd(fd, write); }
+
+int syscall_io(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write, off_t offset,
+               bool* fault) {
+  int bytes;
+
+  if (size == 0)
+    return 0;
+
+  /* The console and file system access the pinned user buffer directly;
+     pipes copy in and out of their own pages. */
+  if (offset < 0) {
+    off_t pos = begin_stream_io(ofd);
+    bytes = segment_io(ofd, ubuf, size, write, pos);
+    end_stream_io(ofd, pos, bytes);
+  } else if (ofd->type == FD_FILE) {
+    /* Positional I/O leaves the file position, and so OFD's lock, alone. */
+    bytes = segment_io(ofd, ubuf, size, write, offset);
+  } else {
+    return -1;
+  }
+
+  if (bytes < 0 && bytes != IO_ERROR)
+    *fault = true;
+  return bytes < 0 ? -1 : bytes;
+}
+
+int syscall_io_nowait(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write,
+                      bool* fault) {
+  int bytes;
+
+  if (size == 0)
+    return 0;
+
+  if (ofd->type == FD_PIPE) {
+    bytes = write ? pipe_write(ofd->pipe, ubuf, size, true, fault)
+                  : pipe_read(ofd->pipe, ubuf, size, true, fault);
+    return bytes == PIPE_AGAIN ? SYSCALL_IO_AGAIN : bytes;
+  }
+  if (ofd->type == FD_CONSOLE && !write) {
+    bytes = read_waiting_input(ubuf, size);
+    if (bytes == -1)
+      *fault = true;
+    return bytes;
+  }
+  return syscall_io(ofd, ubuf, size, write, -1, fault);
+}
+
+int syscall_open(const char* upath, bool* fault) {
+  char path[SYSCALL_PATH_MAX];
+
+  if (!copy_path(path, upath)) {
+    *fault = true;
+    return -1;
+  }
+  return open_path(path);
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * MAIN SYSCALL HANDLER
  * ─────────────────────────────────────────────────────────────────────────────
  * Dispatches system calls to their handlers based on syscall number.
- * x86: Arguments read from user stack (f->esp), syscall# at esp[0].
+ * x86: Arguments copied from user stack (f->esp), syscall# at esp[0], or
+ *      from registers for SYSENTER (see <sysenter.h>).
  * RISC-V: Arguments in a0-a5 registers, syscall# in a7.
  * Return value stored in SYSCALL_RETURN(f, (x86) or f->a0 (RISC-V).
  * ═══════════════════════════════════════════════════════════════════════════*/
@@ -206,23 +686,44 @@ void syscall_handler(struct intr_frame* f) {
      (not the kernel stack pointer) to check for valid stack growth. */
   thread_current()->syscall_esp = (void*)f->esp;
 
-  uint32_t* args = ((uint32_t*)f->esp);
-
-  /* Basic check: ensure syscall arguments are in user space.
-     Page faults catch unmapped addresses, but kernel addresses are mapped
-     and readable - we must explicitly reject them to prevent reading
-     kernel memory. Check that args[0..3] are all in user space
-     (4 args covers all syscalls). */
-  if (!is_user_vaddr(&args[3])) {
-    thread_current()->pcb->my_status->exit_code = -1;
-    printf("%s: exit(%d)\n", thread_current()->pcb->process_name, -1);
-    process_exit();
-    NOT_REACHED();
+  uint32_t args_array[7] = {0};
+  uint32_t* args = args_array;
+
+  if (f->vec_no == INTR_SYSENTER) {
+    /* SYSENTER (see sysenter_entry in intr-stubs.S): syscall number in EAX,
+       up to SYSENTER_MAX_ARGS arguments in EBX, ESI, EDI.  Nothing to
+       validate, since nothing is read from user memory.  Unused slots read
+       as 0 in case a caller passes a larger syscall this way. */
+    args_array[0] = f->eax;
+    args_array[1] = f->ebx;
+    args_array[2] = f->esi;
+    args_array[3] = f->edi;
+  } else {
+    /* "int $0x30": copy in the syscall number, then exactly as many
+       arguments as it takes, so that a call whose last argument ends
+       at the top of mapped memory still works. */
+    const uint32_t* usp = (const uint32_t*)f->esp;
+    if (!copy_from_user(&args_array[0], usp, sizeof args_array[0])) {
+      exit_process(f, -1);
+      NOT_REACHED();
+    }
+    size_t arg_cnt = args_array[0] < sizeof syscall_arg_cnt ? syscall_arg_cnt[args_array[0]] : 0;
+    if (!copy_from_user(&args_array[1], usp + 1, arg_cnt * sizeof args_array[1])) {
+      exit_process(f, -1);
+      NOT_REACHED();
+    }
   }
 
-  uint32_t syscall_num = args[0]; /* May fault - page_fault() handles it */
+  uint32_t syscall_num = args[0];
 #endif
 
+  /* Kernel copy of a path argument, shared by every case so that the
+     handler's frame on the small kernel stack holds only one. */
+  char path[SYSCALL_PATH_MAX];
+
+  /* Cycle count at entry if the call may be traced, otherwise 0. */
+  uint64_t trace_start = systrace_active() ? cpu_cycles() : 0;
+
   switch (syscall_num) {
 
       /* ═══════════════════════════════════════════════════════════════════════
@@ -238,8 +739,21 @@ void syscall_handler(struct intr_frame* f) {
       break;
 
     case SYS_EXEC: {
-      char* cmd_line = (char*)args[1];
+      /* Command lines may be up to a page long, too much for the stack. */
+      char* cmd_line = palloc_get_page(0);
+      if (cmd_line == NULL) {
+        SYSCALL_RETURN(f, -1);
+        break;
+      }
+      int len = strncpy_from_user(cmd_line, (const char*)args[1], PGSIZE);
+      if (len < 0) {
+        palloc_free_page(cmd_line);
+        exit_process(f, -1);
+        break;
+      }
+      cmd_line[PGSIZE - 1] = '\0';
       pid_t pid = process_execute(cmd_line);
+      palloc_free_page(cmd_line);
       SYSCALL_RETURN(f, (pid == TID_ERROR) ? -1 : pid);
       break;
     }
@@ -261,188 +775,250 @@ void syscall_handler(struct intr_frame* f) {
    * FILE SYSCALLS
    * ═══════════════════════════════════════════════════════════════════════*/
     case SYS_CREATE: {
-      char* file_name = (char*)args[1];
       unsigned initial_size = args[2];
-      /* NULL pointer should cause process to exit with -1 */
-      if (file_name == NULL) {
+      if (!copy_path(path, (const char*)args[1])) {
         exit_process(f, -1);
         break;
       }
-      SYSCALL_RETURN(f, filesys_create(file_name, initial_size));
+      SYSCALL_RETURN(f, filesys_create(path, initial_size));
       break;
     }
     case SYS_REMOVE: {
-      char* file_name = (char*)args[1];
-      SYSCALL_RETURN(f, filesys_remove(file_name));
+      if (!copy_path(path, (const char*)args[1])) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, filesys_remove(path));
       break;
     }
     case SYS_OPEN: {
-      char* file_name = (char*)args[1];
-
-      struct file* open_file = filesys_open(file_name);
-      if (open_file == NULL) {
-        SYSCALL_RETURN(f, -1);
+      if (!copy_path(path, (const char*)args[1])) {
+        exit_process(f, -1);
         break;
       }
+      SYSCALL_RETURN(f, open_path(path));
+      break;
+    }
+    case SYS_CLOSE: {
+      int fd = args[1];
 
-      int free_fd = find_free_fd();
-      if (free_fd == -1) {
-        file_close(open_file);
+      /* Close the OFD (handles console, file, and directory types) */
+      struct open_file_desc* ofd = fd_table_remove(&thread_current()->pcb->fd_table, fd);
+      if (ofd == NULL) {
         SYSCALL_RETURN(f, -1);
         break;
       }
+      ofd_close(ofd);
+      break;
+    }
+    case SYS_READ:
+    case SYS_WRITE: {
+      int fd = args[1];
+      void* buffer = (void*)args[2];
+      unsigned size = args[3];
+      bool write = syscall_num == SYS_WRITE;
+      bool fault = false;
 
-      /* Check if it's a directory or regular file, create appropriate OFD */
-      struct inode* inode = file_get_inode(open_file);
-      struct fd_entry* entry = get_fd_entry(free_fd);
-      struct open_file_desc* ofd;
+      /* Validate fd and get OFD */
+      struct open_file_desc* ofd = get_io_ofd(fd, write);
+      if (ofd == NULL) {
+        SYSCALL_RETURN(f, size == 0 ? 0 : -1);
+        break;
+      }
 
-      if (inode_is_dir(inode)) {
-        struct dir* open_dir = dir_open(inode_reopen(inode));
-        file_close(open_file);
-        if (open_dir == NULL) {
-          SYSCALL_RETURN(f, -1);
-          break;
-        }
-        ofd = ofd_create_dir(open_dir);
-        if (ofd == NULL) {
-          dir_close(open_dir);
-          SYSCALL_RETURN(f, -1);
-          break;
-        }
-      } else {
-        ofd = ofd_create_file(open_file);
-        if (ofd == NULL) {
-          file_close(open_file);
-          SYSCALL_RETURN(f, -1);
-          break;
-        }
+      int bytes = syscall_io(ofd, buffer, size, write, -1, &fault);
+      if (fault) {
+        exit_process(f, -1);
+        break;
       }
-      entry->ofd = ofd;
-      SYSCALL_RETURN(f, free_fd);
+      SYSCALL_RETURN(f, bytes);
       break;
     }
-    case SYS_CLOSE: {
+    case SYS_PREAD:
+    case SYS_PWRITE: {
       int fd = args[1];
+      void* buffer = (void*)args[2];
+      unsigned size = args[3];
+      off_t offset = args[4];
+      bool write = syscall_num == SYS_PWRITE;
 
-      /* Validate fd range */
-      if (!is_valid_fd(fd)) {
+      /* Positional I/O leaves the file position, and so OFD's lock, alone. */
+      struct open_file_desc* ofd = get_io_ofd(fd, write);
+      if (ofd == NULL || ofd->type != FD_FILE || offset < 0) {
         SYSCALL_RETURN(f, -1);
         break;
       }
 
-      struct fd_entry* entry = &thread_current()->pcb->fd_table[fd];
-
-      /* Close the OFD (handles console, file, and directory types) */
-      if (entry->ofd != NULL) {
-        ofd_close(entry->ofd);
-        entry->ofd = NULL;
+      int bytes = segment_io(ofd, buffer, size, write, offset);
+      if (bytes < 0) {
+        exit_process(f, -1);
+        break;
       }
+      SYSCALL_RETURN(f, bytes);
       break;
     }
-    case SYS_READ: {
+    case SYS_READV:
+    case SYS_WRITEV: {
       int fd = args[1];
-      char* buffer = (char*)args[2];
-      int size = args[3];
+      const struct iovec* iov = (const struct iovec*)args[2];
+      int iovcnt = args[3];
+      bool write = syscall_num == SYS_WRITEV;
 
-      if (size == 0) {
-        SYSCALL_RETURN(f, 0);
+      struct open_file_desc* ofd = get_io_ofd(fd, write);
+      if (ofd == NULL || iovcnt < 0 || iovcnt > IOV_MAX) {
+        SYSCALL_RETURN(f, -1);
         break;
       }
 
-      /* Validate buffer is in user space (reject kernel addresses) */
-      if (!is_user_vaddr(buffer) || !is_user_vaddr(buffer + size - 1)) {
+      /* All segments go through one position update, as a single read or write. */
+      off_t pos = begin_stream_io(ofd);
+      int bytes = vector_io(ofd, iov, iovcnt, write, pos);
+      end_stream_io(ofd, pos, bytes);
+
+      if (bytes < 0 && bytes != IO_ERROR) {
         exit_process(f, -1);
         break;
       }
+      SYSCALL_RETURN(f, bytes < 0 ? -1 : bytes);
+      break;
+    }
+    case SYS_COPY_FILE_RANGE: {
+      unsigned size = args[3];
 
-      /* Validate fd and get OFD */
-      struct open_file_desc* ofd = get_ofd(fd);
-      if (ofd == NULL) {
+      struct open_file_desc* in = get_io_ofd(args[1], false);
+      struct open_file_desc* out = get_io_ofd(args[2], true);
+      if (in == NULL || out == NULL || in->type != FD_FILE || out->type != FD_FILE) {
         SYSCALL_RETURN(f, -1);
         break;
       }
+      SYSCALL_RETURN(f, size == 0 ? 0 : copy_range(in, out, size));
+      break;
+    }
+    case SYS_PIPE: {
+      int* upipefd = (int*)args[1];
+      int fds[2];
 
-      if (ofd->type == FD_CONSOLE) {
-        if (ofd->cmode == CONSOLE_READ) {
-          SYSCALL_RETURN(f, read_from_input(buffer, size));
-        } else {
-          SYSCALL_RETURN(f, -1); /* Can't read from stdout/stderr */
-        }
+      if (!open_pipe(fds)) {
+        SYSCALL_RETURN(f, -1);
         break;
       }
-
-      if (ofd->type == FD_FILE && ofd->file != NULL) {
-        /* Read into kernel buffer first, then copy to user buffer.
-           This ensures we don't hold filesystem locks if user buffer is bad. */
-        char* kbuf = malloc(size);
-        if (kbuf == NULL) {
-          SYSCALL_RETURN(f, -1);
-          break;
-        }
-        int bytes_read = file_read(ofd->file, kbuf, size);
-        if (bytes_read > 0) {
-          memcpy(buffer, kbuf, bytes_read); /* May fault on bad user ptr - no locks held */
-        }
-        free(kbuf);
-        SYSCALL_RETURN(f, bytes_read);
+      if (!copy_to_user(upipefd, fds, sizeof fds)) {
+        struct fd_table* fdt = &thread_current()->pcb->fd_table;
+        ofd_close(fd_table_remove(fdt, fds[0]));
+        ofd_close(fd_table_remove(fdt, fds[1]));
+        exit_process(f, -1);
         break;
       }
-
-      /* FD_NONE, FD_DIR, or invalid entry */
-      SYSCALL_RETURN(f, -1);
+      SYSCALL_RETURN(f, 0);
       break;
     }
-    case SYS_WRITE: {
-      int fd = args[1];
-      void* buffer = (void*)args[2];
-      uint32_t size = args[3];
+    case SYS_SPLICE: {
+      unsigned size = args[3];
 
-      if (size == 0) {
-        SYSCALL_RETURN(f, 0);
+      struct open_file_desc* in = get_io_ofd(args[1], false);
+      struct open_file_desc* out = get_io_ofd(args[2], true);
+      if (in == NULL || out == NULL) {
+        SYSCALL_RETURN(f, -1);
         break;
       }
-
-      /* Validate buffer is in user space (reject kernel addresses) */
-      if (!is_user_vaddr(buffer) || !is_user_vaddr(buffer + size - 1)) {
+      SYSCALL_RETURN(f, size == 0 ? 0 : splice_io(in, out, size));
+      break;
+    }
+    case SYS_POLL: {
+      bool fault = false;
+      int ready = poll_fds((struct pollfd*)args[1], args[2], args[3], &fault);
+      if (fault) {
         exit_process(f, -1);
         break;
       }
-
-      /* Validate fd and get OFD */
-      struct open_file_desc* ofd = get_ofd(fd);
+      SYSCALL_RETURN(f, ready);
+      break;
+    }
+    case SYS_EPOLL_CREATE: {
+      struct epoll* ep = epoll_create();
+      if (ep == NULL) {
+        SYSCALL_RETURN(f, -1);
+        break;
+      }
+      struct open_file_desc* ofd = ofd_create_epoll(ep);
       if (ofd == NULL) {
+        epoll_close(ep);
         SYSCALL_RETURN(f, -1);
         break;
       }
+      SYSCALL_RETURN(f, install_ofd(ofd));
+      break;
+    }
+    case SYS_EPOLL_CTL: {
+      int op = args[2];
+      int fd = args[3];
+      struct epoll_event event;
 
-      if (ofd->type == FD_CONSOLE) {
-        if (ofd->cmode == CONSOLE_WRITE) {
-          putbuf(buffer, size);
-          SYSCALL_RETURN(f, size);
-        } else {
-          SYSCALL_RETURN(f, -1); /* Can't write to stdin */
-        }
+      struct open_file_desc* epofd = get_ofd(args[1]);
+      if (epofd == NULL || epofd->type != FD_EPOLL) {
+        SYSCALL_RETURN(f, -1);
+        break;
+      }
+      if (op != EPOLL_CTL_DEL && !copy_from_user(&event, (void*)args[4], sizeof event)) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, epoll_ctl(epofd->epoll, op, fd, get_ofd(fd), &event));
+      break;
+    }
+    case SYS_EPOLL_WAIT: {
+      struct epoll_event* events = (struct epoll_event*)args[2];
+      int maxevents = args[3];
+      int timeout = args[4];
+      bool fault = false;
+
+      struct open_file_desc* epofd = get_ofd(args[1]);
+      if (epofd == NULL || epofd->type != FD_EPOLL) {
+        SYSCALL_RETURN(f, -1);
         break;
       }
 
-      if (ofd->type == FD_FILE && ofd->file != NULL) {
-        /* Copy user buffer to kernel buffer first.
-           This ensures we don't hold filesystem locks if user buffer is bad. */
-        char* kbuf = malloc(size);
-        if (kbuf == NULL) {
-          SYSCALL_RETURN(f, -1);
-          break;
-        }
-        memcpy(kbuf, buffer, size); /* May fault on bad user ptr - no locks held */
-        int bytes_written = file_write(ofd->file, kbuf, size);
-        free(kbuf);
-        SYSCALL_RETURN(f, bytes_written);
+      /* Hold the instance in case another thread closes it meanwhile. */
+      ofd_dup(epofd);
+      int cnt = epoll_wait(epofd->epoll, events, maxevents, timeout, &fault);
+      ofd_close(epofd);
+      if (fault) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, cnt);
+      break;
+    }
+    case SYS_IO_URING_SETUP: {
+      bool fault = false;
+      int fd = open_uring(args[1], (void*)args[2], &fault);
+      if (fault) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, fd);
+      break;
+    }
+    case SYS_IO_URING_ENTER: {
+      unsigned to_submit = args[2];
+      unsigned min_complete = args[3];
+      bool fault = false;
+
+      struct open_file_desc* ringofd = get_ofd(args[1]);
+      if (ringofd == NULL || ringofd->type != FD_URING) {
+        SYSCALL_RETURN(f, -1);
         break;
       }
 
-      /* FD_NONE, FD_DIR, or invalid entry */
-      SYSCALL_RETURN(f, -1);
+      /* Hold the ring in case another thread closes it meanwhile. */
+      ofd_dup(ringofd);
+      int submitted = uring_enter(ringofd->uring, to_submit, min_complete, &fault);
+      ofd_close(ringofd);
+      if (fault) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, submitted);
       break;
     }
     case SYS_SEEK: {
@@ -492,14 +1068,20 @@ void syscall_handler(struct intr_frame* f) {
    * ═══════════════════════════════════════════════════════════════════════*/
 
     case SYS_CHDIR: {
-      char* dir_path = (char*)args[1];
-      SYSCALL_RETURN(f, filesys_chdir(dir_path));
+      if (!copy_path(path, (const char*)args[1])) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, filesys_chdir(path));
       break;
     }
 
     case SYS_MKDIR: {
-      char* dir_path = (char*)args[1];
-      SYSCALL_RETURN(f, filesys_mkdir(dir_path));
+      if (!copy_path(path, (const char*)args[1])) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, filesys_mkdir(path));
       break;
     }
 
@@ -518,11 +1100,14 @@ void syscall_handler(struct intr_frame* f) {
       char entry_name[NAME_MAX + 1];
       while (dir_readdir(dir, entry_name)) {
         if (strcmp(entry_name, ".") != 0 && strcmp(entry_name, "..") != 0) {
-          strlcpy(name, entry_name, NAME_MAX + 1);
           success = true;
           break;
         }
       }
+      if (success && !copy_to_user(name, entry_name, strlen(entry_name) + 1)) {
+        exit_process(f, -1);
+        break;
+      }
       SYSCALL_RETURN(f, success);
       break;
     }
@@ -540,51 +1125,44 @@ void syscall_handler(struct intr_frame* f) {
    * ═══════════════════════════════════════════════════════════════════════*/
 
     case SYS_LINK: {
-      char* oldpath = (char*)args[1];
-      char* newpath = (char*)args[2];
-
-      /* Validate pointers */
-      if (oldpath == NULL || newpath == NULL) {
+      int result = two_path_call(filesys_link, (const char*)args[1], (const char*)args[2]);
+      if (result < 0) {
         exit_process(f, -1);
         break;
       }
-
-      SYSCALL_RETURN(f, filesys_link(oldpath, newpath));
+      SYSCALL_RETURN(f, result);
       break;
     }
 
     case SYS_SYMLINK: {
-      char* target = (char*)args[1];
-      char* linkpath = (char*)args[2];
-
-      /* Validate pointers */
-      if (target == NULL || linkpath == NULL) {
+      int result = two_path_call(filesys_symlink, (const char*)args[1], (const char*)args[2]);
+      if (result < 0) {
         exit_process(f, -1);
         break;
       }
-
-      SYSCALL_RETURN(f, filesys_symlink(target, linkpath));
+      SYSCALL_RETURN(f, result);
       break;
     }
 
     case SYS_READLINK: {
-      char* path = (char*)args[1];
       char* buf = (char*)args[2];
       size_t bufsize = (size_t)args[3];
 
-      /* Validate pointers */
-      if (path == NULL || buf == NULL) {
+      if (!copy_path(path, (const char*)args[1]) || buf == NULL) {
         exit_process(f, -1);
         break;
       }
 
-      /* Validate buffer is in user space */
-      if (!is_user_vaddr(buf) || (bufsize > 0 && !is_user_vaddr(buf + bufsize - 1))) {
+      /* No target is longer than a path; don't pin more than that. */
+      if (bufsize > SYSCALL_PATH_MAX)
+        bufsize = SYSCALL_PATH_MAX;
+      if (!uaccess_pin(buf, bufsize, true)) {
         exit_process(f, -1);
         break;
       }
-
-      SYSCALL_RETURN(f, filesys_readlink(path, buf, bufsize));
+      int len = filesys_readlink(path, buf, bufsize);
+      uaccess_unpin(buf, bufsize);
+      SYSCALL_RETURN(f, len);
       break;
     }
 
@@ -614,174 +1192,142 @@ void syscall_handler(struct intr_frame* f) {
       SYSCALL_RETURN(f, thread_current()->tid);
       break;
 
+    case SYS_GET_PID:
+      SYSCALL_RETURN(f, thread_current()->pcb->main_thread->tid);
+      break;
+
       /* ═══════════════════════════════════════════════════════════════════════
    * USER-LEVEL SYNCHRONIZATION SYSCALLS
    * ═══════════════════════════════════════════════════════════════════════*/
 
-    case SYS_LOCK_INIT: {
-      lock_t* user_lock = (lock_t*)args[1];
-
-      /* Check for NULL pointer - return false instead of crashing */
-      if (user_lock == NULL) {
+    case SYS_LOCK_INIT:
+    case SYS_SEMA_INIT:
+    case SYS_COND_INIT:
+    case SYS_BARRIER_INIT:
+    case SYS_RWLOCK_INIT: {
+      int* uhandle = (int*)args[1];
+      int arg = args[2];
+      enum usync_kind kind = syscall_num == SYS_LOCK_INIT      ? USYNC_LOCK
+                             : syscall_num == SYS_SEMA_INIT    ? USYNC_SEMA
+                             : syscall_num == SYS_COND_INIT    ? USYNC_COND
+                             : syscall_num == SYS_BARRIER_INIT ? USYNC_BARRIER
+                                                               : USYNC_RWLOCK;
+
+      /* Check for NULL pointer or bad initial value - return false instead of crashing */
+      if (uhandle == NULL || (kind == USYNC_SEMA && arg < 0) || (kind == USYNC_BARRIER && arg <= 0)) {
         SYSCALL_RETURN(f, false);
         break;
       }
 
-      struct process* pcb = thread_current()->pcb;
-      lock_acquire(&pcb->exit_lock);
-
-      if (pcb->next_lock_id >= MAX_LOCKS) {
-        lock_release(&pcb->exit_lock);
+      int id = usync_create(&thread_current()->pcb->usync, kind, arg);
+      if (id < 0) {
         SYSCALL_RETURN(f, false);
         break;
       }
-
-      struct lock* k_lock = malloc(sizeof(struct lock));
-      if (k_lock == NULL) {
-        lock_release(&pcb->exit_lock);
-        SYSCALL_RETURN(f, false);
+      if (!copy_to_user(uhandle, &id, sizeof id)) {
+        exit_process(f, -1);
         break;
       }
-
-      lock_init(k_lock);
-      int id = pcb->next_lock_id++;
-      pcb->lock_table[id] = k_lock;
-      lock_release(&pcb->exit_lock);
-
-      *user_lock = (lock_t)id; /* Safe: no locks held, validated non-NULL */
       SYSCALL_RETURN(f, true);
       break;
     }
 
-    case SYS_LOCK_ACQUIRE: {
-      lock_t* user_lock = (lock_t*)args[1];
-      if (user_lock == NULL) {
-        SYSCALL_RETURN(f, false);
+    case SYS_LOCK_ACQUIRE:
+    case SYS_LOCK_RELEASE: {
+      bool fault = false;
+      struct usync* obj = get_usync((int*)args[1], USYNC_LOCK, &fault);
+      if (fault) {
+        exit_process(f, -1);
         break;
       }
 
-      /* Read user memory before acquiring any locks */
-      int id = *user_lock;
-
-      struct process* pcb = thread_current()->pcb;
-      lock_acquire(&pcb->exit_lock);
-      struct lock* k_lock = (id >= 0 && id < MAX_LOCKS) ? pcb->lock_table[id] : NULL;
-      lock_release(&pcb->exit_lock);
-
-      if (k_lock == NULL || lock_held_by_current_thread(k_lock)) {
+      bool acquire = syscall_num == SYS_LOCK_ACQUIRE;
+      if (obj == NULL || lock_held_by_current_thread(&obj->lock) == acquire) {
         SYSCALL_RETURN(f, false);
       } else {
-        lock_acquire(k_lock);
+        if (acquire)
+          lock_acquire(&obj->lock);
+        else
+          lock_release(&obj->lock);
         SYSCALL_RETURN(f, true);
       }
       break;
     }
 
-    case SYS_LOCK_RELEASE: {
-      lock_t* user_lock = (lock_t*)args[1];
-      if (user_lock == NULL) {
-        SYSCALL_RETURN(f, false);
+    case SYS_SEMA_DOWN:
+    case SYS_SEMA_UP: {
+      bool fault = false;
+      struct usync* obj = get_usync((int*)args[1], USYNC_SEMA, &fault);
+      if (fault) {
+        exit_process(f, -1);
         break;
       }
 
-      /* Read user memory before acquiring any locks */
-      int id = *user_lock;
-      struct process* pcb = thread_current()->pcb;
-
-      lock_acquire(&pcb->exit_lock);
-      struct lock* k_lock = (id >= 0 && id < MAX_LOCKS) ? pcb->lock_table[id] : NULL;
-      lock_release(&pcb->exit_lock);
-
-      if (k_lock == NULL || !lock_held_by_current_thread(k_lock)) {
+      if (obj == NULL) {
         SYSCALL_RETURN(f, false);
       } else {
-        lock_release(k_lock);
+        if (syscall_num == SYS_SEMA_DOWN)
+          sema_down(&obj->sema);
+        else
+          sema_up(&obj->sema);
         SYSCALL_RETURN(f, true);
       }
       break;
     }
 
-    case SYS_SEMA_INIT: {
-      sema_t* user_sema = (sema_t*)args[1];
-      int val = (int)args[2];
-
-      /* Check for NULL pointer or negative value - return false instead of crashing */
-      if (user_sema == NULL || val < 0) {
-        SYSCALL_RETURN(f, false);
-        break;
-      }
-
-      struct process* pcb = thread_current()->pcb;
-      lock_acquire(&pcb->exit_lock);
-
-      if (pcb->next_sema_id >= MAX_SEMAS) {
-        lock_release(&pcb->exit_lock);
-        SYSCALL_RETURN(f, false);
+    case SYS_COND_WAIT:
+    case SYS_COND_SIGNAL:
+    case SYS_COND_BROADCAST: {
+      bool fault = false;
+      struct usync* cond = get_usync((int*)args[1], USYNC_COND, &fault);
+      struct usync* lock = get_usync((int*)args[2], USYNC_LOCK, &fault);
+      if (fault) {
+        exit_process(f, -1);
         break;
       }
 
-      struct semaphore* k_sema = malloc(sizeof(struct semaphore));
-      if (k_sema == NULL) {
-        lock_release(&pcb->exit_lock);
+      /* Like the kernel's, every condition operation needs the lock held */
+      if (cond == NULL || lock == NULL || !lock_held_by_current_thread(&lock->lock)) {
         SYSCALL_RETURN(f, false);
-        break;
+      } else {
+        if (syscall_num == SYS_COND_WAIT)
+          cond_wait(&cond->cond, &lock->lock);
+        else if (syscall_num == SYS_COND_SIGNAL)
+          cond_signal(&cond->cond, &lock->lock);
+        else
+          cond_broadcast(&cond->cond, &lock->lock);
+        SYSCALL_RETURN(f, true);
       }
-
-      sema_init(k_sema, val);
-      int id = pcb->next_sema_id++;
-      pcb->sema_table[id] = k_sema;
-      lock_release(&pcb->exit_lock);
-
-      *user_sema = (sema_t)id; /* Safe: no locks held, validated non-NULL */
-      SYSCALL_RETURN(f, true);
       break;
     }
 
-    case SYS_SEMA_DOWN: {
-      sema_t* user_sema = (sema_t*)args[1];
-      if (user_sema == NULL) {
-        SYSCALL_RETURN(f, false);
+    case SYS_BARRIER_WAIT: {
+      bool fault = false;
+      struct usync* obj = get_usync((int*)args[1], USYNC_BARRIER, &fault);
+      if (fault) {
+        exit_process(f, -1);
         break;
       }
-
-      /* Read user memory before acquiring any locks */
-      int id = *user_sema;
-
-      struct process* pcb = thread_current()->pcb;
-      lock_acquire(&pcb->exit_lock);
-      struct semaphore* k_sema = (id >= 0 && id < MAX_SEMAS) ? pcb->sema_table[id] : NULL;
-      lock_release(&pcb->exit_lock);
-
-      if (k_sema == NULL) {
-        SYSCALL_RETURN(f, false);
-      } else {
-        sema_down(k_sema);
-        SYSCALL_RETURN(f, true);
-      }
+      SYSCALL_RETURN(f, obj != NULL ? usync_barrier_wait(&obj->barrier) : -1);
       break;
     }
 
-    case SYS_SEMA_UP: {
-      sema_t* user_sema = (sema_t*)args[1];
-      if (user_sema == NULL) {
-        SYSCALL_RETURN(f, false);
+    case SYS_RWLOCK_ACQUIRE:
+    case SYS_RWLOCK_RELEASE: {
+      bool fault = false;
+      struct usync* obj = get_usync((int*)args[1], USYNC_RWLOCK, &fault);
+      bool reader = args[2] != 0;
+      if (fault) {
+        exit_process(f, -1);
         break;
       }
 
-      /* Read user memory before acquiring any locks */
-      int id = *user_sema;
-
-      struct process* pcb = thread_current()->pcb;
-      lock_acquire(&pcb->exit_lock);
-      struct semaphore* k_sema = (id >= 0 && id < MAX_SEMAS) ? pcb->sema_table[id] : NULL;
-      lock_release(&pcb->exit_lock);
-
-      if (k_sema == NULL) {
+      if (obj == NULL)
         SYSCALL_RETURN(f, false);
-      } else {
-        sema_up(k_sema);
-        SYSCALL_RETURN(f, true);
-      }
+      else if (syscall_num == SYS_RWLOCK_ACQUIRE)
+        SYSCALL_RETURN(f, usync_rwlock_acquire(&obj->rwlock, reader));
+      else
+        SYSCALL_RETURN(f, usync_rwlock_release(&obj->rwlock, reader));
       break;
     }
 
@@ -846,7 +1392,9 @@ void syscall_handler(struct intr_frame* f) {
       }
 
       void* result;
-      if (flags & MAP_ANONYMOUS) {
+      if (flags & MAP_SHARED) {
+        result = map_shared(addr, length, flags, fd, offset);
+      } else if (flags & MAP_ANONYMOUS) {
         /* Anonymous mapping - no file backing */
         result = mmap_create_anon(addr, length, flags);
       } else {
@@ -857,11 +1405,78 @@ void syscall_handler(struct intr_frame* f) {
       break;
     }
 
+    case SYS_VMSTAT: {
+      int scope = (int)args[1];
+      struct vmstat* buffer = (struct vmstat*)args[2];
+
+      /* The snapshot is taken with interrupts off, straight into the user
+         buffer, which therefore must stay resident throughout. */
+      if (buffer == NULL || !uaccess_pin(buffer, sizeof *buffer, true)) {
+        exit_process(f, -1);
+        break;
+      }
+      bool success = vmstat_snapshot(scope, buffer);
+      uaccess_unpin(buffer, sizeof *buffer);
+      SYSCALL_RETURN(f, success);
+      break;
+    }
+
+    case SYS_SHM_OPEN: {
+      char name[SHM_NAME_MAX + 1];
+      size_t size = (size_t)args[2];
+
+      if (!copy_shm_name(name, (const char*)args[1])) {
+        exit_process(f, -1);
+        break;
+      }
+
+      struct shm_object* obj = shm_open(name, size);
+      if (obj == NULL) {
+        SYSCALL_RETURN(f, -1);
+        break;
+      }
+
+      struct open_file_desc* ofd = ofd_create_shm(obj);
+      if (ofd == NULL) {
+        shm_unref(obj);
+        SYSCALL_RETURN(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, install_ofd(ofd));
+      break;
+    }
+
+    case SYS_SHM_UNLINK: {
+      char name[SHM_NAME_MAX + 1];
+      if (!copy_shm_name(name, (const char*)args[1])) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, shm_unlink(name));
+      break;
+    }
+
+    case SYS_SYSTRACE: {
+      bool fault = false;
+      int result = systrace_ctl((int)args[1], (void*)args[2], (size_t)args[3], &fault);
+      if (fault) {
+        exit_process(f, -1);
+        break;
+      }
+      SYSCALL_RETURN(f, result);
+      break;
+    }
+
     default:
       /* Unknown syscall - do nothing (return value undefined) */
       break;
   }
 
+  if (trace_start != 0 && systrace_active()) {
+    uint64_t trace_args[3] = {args[1], args[2], args[3]};
+    systrace_record(syscall_num, trace_args, SYSCALL_GET_RETURN(f), cpu_cycles() - trace_start);
+  }
+
   /* Check if process is exiting - thread should exit instead of returning to user */
   struct thread* cur = thread_current();
   if (cur->pcb != NULL && cur->pcb->is_exiting) {
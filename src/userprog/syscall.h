@@ -15,8 +15,12 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
-/* Forward declaration of interrupt frame */
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+/* Forward declarations */
 struct intr_frame;
+struct open_file_desc;
 
 /* Initializes the system call handler.
    Called once during kernel startup. */
@@ -27,4 +31,39 @@ void syscall_init(void);
    RISC-V: Called from trap handler on ECALL. */
 void syscall_handler(struct intr_frame* f);
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * OPERATIONS SHARED WITH I/O RINGS
+ * ─────────────────────────────────────────────────────────────────────────────
+ * The worker threads of userprog/uring.c carry out ring operations through
+ * these, in the submitting process's address space and descriptor table,
+ * so that they behave exactly as the equivalent system calls.
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Returns the OFD for FD if read() (or write(), if WRITE) accepts it, or
+   NULL. */
+struct open_file_desc* syscall_io_ofd(int fd, bool write);
+
+/* Transfers SIZE bytes between OFD, which syscall_io_ofd() accepted, and
+   user buffer UBUF: at file offset OFFSET, or at and advancing OFD's
+   position if OFFSET is negative.  Returns the number of bytes
+   transferred, or -1 on failure, setting *FAULT if UBUF is not valid user
+   memory. */
+int syscall_io(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write, off_t offset,
+               bool* fault);
+
+/* Result of syscall_io_nowait() when nothing can be transferred yet. */
+#define SYSCALL_IO_AGAIN (-2)
+
+/* Like syscall_io() at OFD's position, but for a pipe end or the
+   console's input transfers only what it can without waiting, returning
+   SYSCALL_IO_AGAIN if that is nothing.  ofd_poll() tells when to try
+   again. */
+int syscall_io_nowait(struct open_file_desc* ofd, void* ubuf, unsigned size, bool write,
+                      bool* fault);
+
+/* Opens the path at user address UPATH as open() does and returns the new
+   descriptor, or -1 on failure, setting *FAULT if UPATH is not a valid
+   user string. */
+int syscall_open(const char* upath, bool* fault);
+
 #endif /* userprog/syscall.h */
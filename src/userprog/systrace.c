@@ -0,0 +1,171 @@
+#include "userprog/systrace.h"
+#include <round.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+
+int systrace_mode = SYSTRACE_OFF;
+
+/* Whether events are logged as well as counted. */
+static bool log_events;
+
+/* SYSTRACE_CHILDREN generation.  Each time that mode is turned on, the
+   generation advances and the caller's trace_children_gen is set to it;
+   processes whose trace_gen matches are traced.  Starting a new
+   generation thus drops every process traced by an earlier one. */
+static unsigned generation;
+
+static struct systrace_stats stats;
+
+/* Event log: COUNT events starting at slot HEAD, oldest first.  The
+   pages are allocated the first time logging is turned on and kept. */
+#define RING_PAGES DIV_ROUND_UP(SYSTRACE_RING_SIZE * sizeof(struct systrace_event), PGSIZE)
+static struct systrace_event* ring;
+static unsigned ring_head;
+static unsigned ring_count;
+
+/* Returns true if PCB's system calls are recorded. */
+static bool is_traced(const struct process* pcb) {
+  if (pcb == NULL)
+    return false;
+  return systrace_mode == SYSTRACE_GLOBAL || pcb->trace_gen == generation;
+}
+
+void systrace_record(unsigned nr, const uint64_t args[3], int ret, uint64_t cycles) {
+  struct thread* t = thread_current();
+
+  enum intr_level old_level = intr_disable();
+  if (nr < SYSTRACE_NR && is_traced(t->pcb)) {
+    stats.calls[nr]++;
+    stats.cycles[nr] += cycles;
+    if (cycles > stats.max_cycles[nr])
+      stats.max_cycles[nr] = cycles;
+
+    if (log_events) {
+      struct systrace_event* e;
+      if (ring_count < SYSTRACE_RING_SIZE) {
+        e = &ring[(ring_head + ring_count++) % SYSTRACE_RING_SIZE];
+      } else {
+        e = &ring[ring_head];
+        ring_head = (ring_head + 1) % SYSTRACE_RING_SIZE;
+        stats.events_lost++;
+      }
+      e->pid = t->pcb->main_thread->tid;
+      e->tid = t->tid;
+      e->nr = nr;
+      e->ret = ret;
+      memcpy(e->args, args, sizeof e->args);
+      e->cycles = cycles;
+    }
+  }
+  intr_set_level(old_level);
+}
+
+void systrace_fork(struct process* parent, struct process* child) {
+  enum intr_level old_level = intr_disable();
+  if (parent->trace_children_gen == generation || parent->trace_gen == generation)
+    child->trace_gen = generation;
+  intr_set_level(old_level);
+}
+
+/* Empties the log and zeroes the statistics.  Must be called with
+   interrupts disabled. */
+static void reset(void) {
+  memset(&stats, 0, sizeof stats);
+  ring_head = ring_count = 0;
+}
+
+/* Moves up to MAX logged events into the pinned user buffer UBUF.
+   Returns the number moved. */
+static int drain(struct systrace_event* ubuf, size_t max) {
+  enum intr_level old_level = intr_disable();
+  size_t n = ring_count < max ? ring_count : max;
+  for (size_t i = 0; i < n; i++) {
+    ubuf[i] = ring[ring_head];
+    ring_head = (ring_head + 1) % SYSTRACE_RING_SIZE;
+  }
+  ring_count -= n;
+  intr_set_level(old_level);
+  return n;
+}
+
+int systrace_ctl(int op, void* ubuf, size_t size, bool* fault) {
+  struct process* pcb = thread_current()->pcb;
+  int mode = op & ~SYSTRACE_LOG;
+  enum intr_level old_level;
+
+  if ((op & SYSTRACE_LOG) && mode != SYSTRACE_GLOBAL && mode != SYSTRACE_CHILDREN)
+    return -1;
+
+  switch (mode) {
+    case SYSTRACE_OFF:
+      systrace_mode = SYSTRACE_OFF;
+      return 0;
+
+    case SYSTRACE_GLOBAL:
+    case SYSTRACE_CHILDREN:
+      if ((op & SYSTRACE_LOG) && ring == NULL) {
+        struct systrace_event* pages = palloc_get_multiple(0, RING_PAGES);
+        if (pages == NULL)
+          return -1;
+        old_level = intr_disable();
+        bool raced = ring != NULL; /* Another thread allocated it meanwhile. */
+        if (!raced)
+          ring = pages;
+        intr_set_level(old_level);
+        if (raced)
+          palloc_free_multiple(pages, RING_PAGES);
+      }
+      old_level = intr_disable();
+      if (mode == SYSTRACE_CHILDREN) {
+        /* Generation 0 is what every process starts with. */
+        if (++generation == 0)
+          generation = 1;
+        pcb->trace_children_gen = generation;
+      }
+      log_events = (op & SYSTRACE_LOG) != 0;
+      systrace_mode = mode;
+      intr_set_level(old_level);
+      return 0;
+
+    case SYSTRACE_RESET:
+      old_level = intr_disable();
+      reset();
+      intr_set_level(old_level);
+      return 0;
+
+    case SYSTRACE_STATS:
+      /* Copied with interrupts off, so the buffer must stay resident. */
+      if (ubuf == NULL || !uaccess_pin(ubuf, sizeof stats, true)) {
+        *fault = true;
+        return -1;
+      }
+      old_level = intr_disable();
+      memcpy(ubuf, &stats, sizeof stats);
+      intr_set_level(old_level);
+      uaccess_unpin(ubuf, sizeof stats);
+      return 0;
+
+    case SYSTRACE_EVENTS: {
+      if (size > SYSTRACE_RING_SIZE)
+        size = SYSTRACE_RING_SIZE;
+      if (size == 0)
+        return 0;
+      size_t bytes = size * sizeof(struct systrace_event);
+      if (ubuf == NULL || !uaccess_pin(ubuf, bytes, true)) {
+        *fault = true;
+        return -1;
+      }
+      int n = drain(ubuf, size);
+      uaccess_unpin(ubuf, bytes);
+      return n;
+    }
+
+    default:
+      return -1;
+  }
+}
@@ -0,0 +1,55 @@
+#ifndef USERPROG_SYSTRACE_H
+#define USERPROG_SYSTRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <systrace.h>
+
+struct process;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * SYSTEM CALL TRACING
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * syscall_handler() reads the cycle counter before dispatching a call and,
+ * once the call is done, hands its number, arguments, result and latency to
+ * systrace_record().  The statistics and event log are global; the record
+ * layout and the operations user space has on them are in lib/systrace.h.
+ *
+ * COST WHEN OFF: syscall_handler() tests systrace_active(), a single load
+ * of systrace_mode, before reading the cycle counter and again afterward.
+ * Nothing else is done.
+ *
+ * SCOPE: in SYSTRACE_CHILDREN mode a process is traced if its trace_gen
+ * matches the generation that turning the mode on started.  systrace_fork()
+ * sets it on each new process whose parent is traced or asked for its
+ * children to be traced in the current generation.
+ *
+ * SYNCHRONIZATION: updates and snapshots run with interrupts disabled, so
+ * recording never blocks and readers see consistent counters.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Current mode: SYSTRACE_OFF, SYSTRACE_GLOBAL or SYSTRACE_CHILDREN. */
+extern int systrace_mode;
+
+/* Returns true if any process may be traced. */
+static inline bool systrace_active(void) { return systrace_mode != SYSTRACE_OFF; }
+
+/* Records system call NR with arguments ARGS[0..2], which returned RET
+   after CYCLES, if the current process is traced. */
+void systrace_record(unsigned nr, const uint64_t args[3], int ret, uint64_t cycles);
+
+/* Sets up tracing for CHILD, just created by PARENT. */
+void systrace_fork(struct process* parent, struct process* child);
+
+/* Carries out SYS_SYSTRACE operation OP for the current process.  UBUF
+   receives a struct systrace_stats for SYSTRACE_STATS, or up to SIZE
+   events for SYSTRACE_EVENTS.  Returns the number of events moved for
+   SYSTRACE_EVENTS, otherwise 0, or -1 if OP is invalid or there is no
+   memory for the event log.  Sets *FAULT if UBUF is not writable user
+   memory. */
+int systrace_ctl(int op, void* ubuf, size_t size, bool* fault);
+
+#endif /* userprog/systrace.h */
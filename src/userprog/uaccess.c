@@ -0,0 +1,181 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/exception.h"
+#include "userprog/kdata.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/vm.h"
+#endif
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * FAULTING PRIMITIVES
+ * ─────────────────────────────────────────────────────────────────────────────
+ * Every instruction here that dereferences a user address has an exception
+ * table entry.  On an unresolvable fault, page_fault() resumes at the entry's
+ * fixup with the registers as they were at the fault.
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Copies SIZE bytes from SRC to DST, either of which may be a user
+   address.  Returns the number of bytes left uncopied after a fault,
+   0 on success. */
+static size_t raw_copy(void* dst, const void* src, size_t size) {
+#ifdef ARCH_RISCV64
+  asm volatile("1: beqz %0, 4f\n\t"
+               "2: lbu t0, 0(%2)\n\t"
+               "3: sb t0, 0(%1)\n\t"
+               "addi %2, %2, 1\n\t"
+               "addi %1, %1, 1\n\t"
+               "addi %0, %0, -1\n\t"
+               "j 1b\n\t"
+               "4:\n\t" EXCEPTION_TABLE_ENTRY("2b", "4b") EXCEPTION_TABLE_ENTRY("3b", "4b")
+               : "+r"(size), "+r"(dst), "+r"(src)
+               :
+               : "t0", "memory");
+#else
+  /* A fault leaves ECX holding the count still to be copied. */
+  asm volatile("1: rep movsb\n\t"
+               "2:\n\t" EXCEPTION_TABLE_ENTRY("1b", "2b")
+               : "+c"(size), "+D"(dst), "+S"(src)
+               :
+               : "memory");
+#endif
+  return size;
+}
+
+/* Reads the byte at user address USRC into *DST.  Returns false if the
+   read faulted. */
+static bool get_user_byte(char* dst, const char* usrc) {
+  int ok;
+  char c;
+
+#ifdef ARCH_RISCV64
+  asm volatile("li %0, 0\n\t"
+               "1: lbu %1, 0(%2)\n\t"
+               "li %0, 1\n\t"
+               "2:\n\t" EXCEPTION_TABLE_ENTRY("1b", "2b")
+               : "=&r"(ok), "=&r"(c)
+               : "r"(usrc)
+               : "memory");
+#else
+  asm volatile("xorl %0, %0\n\t"
+               "1: movb %2, %1\n\t"
+               "movl $1, %0\n\t"
+               "2:\n\t" EXCEPTION_TABLE_ENTRY("1b", "2b")
+               : "=&r"(ok), "=q"(c)
+               : "m"(*usrc));
+#endif
+  *dst = c;
+  return ok;
+}
+
+/* Returns true if the SIZE bytes at UADDR lie entirely in user space. */
+static bool user_range_ok(const void* uaddr, size_t size) {
+  uintptr_t start = (uintptr_t)uaddr;
+  uintptr_t end = start + size;
+  return end >= start && end <= (uintptr_t)PHYS_BASE;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * COPYING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+bool copy_from_user(void* dst, const void* usrc, size_t size) {
+  return user_range_ok(usrc, size) && raw_copy(dst, usrc, size) == 0;
+}
+
+bool copy_to_user(void* udst, const void* src, size_t size) {
+  return user_range_ok(udst, size) && raw_copy(udst, src, size) == 0;
+}
+
+int strncpy_from_user(char* dst, const char* usrc, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (!is_user_vaddr(usrc + i) || !get_user_byte(&dst[i], usrc + i))
+      return -1;
+    if (dst[i] == '\0')
+      return i;
+  }
+  return size;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * PINNING
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+#ifdef VM
+/* Number of times pin_page() faults a page in before giving up.  Each
+   retry means eviction took the page between the fault and the pin. */
+#define PIN_ATTEMPTS 4
+
+/* Makes UPAGE resident, and writable if WRITE, and pins its frame. */
+static bool pin_page(uint32_t* pd, void* upage, bool write) {
+  /* The kernel data region has no frame and is never evicted. */
+  if (kdata_contains(upage))
+    return !write;
+
+  for (int i = 0; i < PIN_ATTEMPTS; i++) {
+    void* kpage = pagedir_get_page(pd, upage);
+    if (kpage != NULL && (!write || pagedir_is_writable(pd, upage))) {
+      if (frame_pin_if_present(kpage)) {
+        if (pagedir_get_page(pd, upage) == kpage)
+          return true;
+        frame_unpin(kpage);
+      }
+    } else if (!vm_handle_fault(upage, false, write, kpage == NULL,
+                                thread_current()->syscall_esp)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/* Unpins the frames of the user pages from FIRST up to but not
+   including END. */
+static void unpin_pages(uint32_t* pd, uint8_t* first, uint8_t* end) {
+  for (uint8_t* upage = first; upage < end; upage += PGSIZE) {
+    void* kpage = pagedir_get_page(pd, upage);
+    if (kpage != NULL && !kdata_contains(upage))
+      frame_unpin(kpage);
+  }
+}
+#endif
+
+bool uaccess_pin(const void* ubuf, size_t size, bool write) {
+  if (size == 0)
+    return true;
+  if (!user_range_ok(ubuf, size))
+    return false;
+
+  uint32_t* pd = thread_current()->pcb->pagedir;
+  uint8_t* first = pg_round_down(ubuf);
+  uint8_t* last = pg_round_down((const uint8_t*)ubuf + size - 1);
+  for (uint8_t* upage = first; upage <= last; upage += PGSIZE) {
+#ifdef VM
+    if (!pin_page(pd, upage, write)) {
+      unpin_pages(pd, first, upage);
+      return false;
+    }
+#else
+    /* Without VM every valid page is already resident for good. */
+    if (pagedir_get_page(pd, upage) == NULL || (write && !pagedir_is_writable(pd, upage)))
+      return false;
+#endif
+  }
+  return true;
+}
+
+void uaccess_unpin(const void* ubuf, size_t size) {
+#ifdef VM
+  if (size == 0)
+    return;
+  uint8_t* first = pg_round_down(ubuf);
+  uint8_t* end = (uint8_t*)pg_round_down((const uint8_t*)ubuf + size - 1) + PGSIZE;
+  unpin_pages(thread_current()->pcb->pagedir, first, end);
+#else
+  (void)ubuf;
+  (void)size;
+#endif
+}
@@ -0,0 +1,52 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * USER MEMORY ACCESS
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * System calls reach user memory only through these functions.
+ *
+ * The copy functions check that the user range lies below PHYS_BASE and
+ * then simply perform the access.  A fault is first offered to the VM
+ * system, so lazily loaded and swapped-out pages work as usual.  If it
+ * cannot be resolved, page_fault() finds the faulting instruction in the
+ * exception table (see exception.c) and resumes at its fixup, which makes
+ * the copy report failure.  The process is never killed from inside the
+ * fault handler, so a bad pointer costs nothing until it is used.
+ *
+ * A fault may still sleep on disk I/O, so callers must not hold locks
+ * that eviction or page loading might need.  Code that must touch user
+ * memory under such locks (file_read() into a user buffer, for example)
+ * pins the range first: uaccess_pin() faults every page in and keeps it
+ * resident until uaccess_unpin().
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+   Returns false if any part of the source is not readable user memory. */
+bool copy_from_user(void* dst, const void* usrc, size_t size);
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+   Returns false if any part of the destination is not writable user
+   memory. */
+bool copy_to_user(void* udst, const void* src, size_t size);
+
+/* Copies the null-terminated string at user address USRC into DST, which
+   has room for SIZE bytes.  Returns the length of the string, or -1 if it
+   is not readable user memory.  If the string does not fit, returns SIZE
+   and DST is not null-terminated. */
+int strncpy_from_user(char* dst, const char* usrc, size_t size);
+
+/* Makes the SIZE bytes at user address UBUF resident, writable as well if
+   WRITE is true, and keeps them from being evicted.  Returns false, with
+   nothing pinned, if the range is not valid user memory. */
+bool uaccess_pin(const void* ubuf, size_t size, bool write);
+
+/* Releases a range pinned by uaccess_pin(). */
+void uaccess_unpin(const void* ubuf, size_t size);
+
+#endif /* userprog/uaccess.h */
@@ -0,0 +1,480 @@
+#include "userprog/uring.h"
+#include <debug.h>
+#include <limits.h>
+#include <list.h>
+#include <poll.h>
+#include <stdint.h>
+#include "filesys/cache.h"
+#include "filesys/directory.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/waitq.h"
+#include "userprog/fdtable.h"
+#include "userprog/filedesc.h"
+#include "userprog/poll.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+
+struct uring {
+  /* Set at creation. */
+  struct io_uring_rings* urings; /* Ring header, in user memory. */
+  struct io_uring_sqe* usqes;    /* SQ entries, in user memory. */
+  struct io_uring_cqe* ucqes;    /* CQ entries, in user memory. */
+  uint32_t sq_entries;           /* SQ size, a power of 2. */
+  uint32_t cq_entries;           /* CQ size, twice the SQ size. */
+  struct wait_queue stop_wq;     /* Woken when the ring stops. */
+
+  /* Under uring_lock, and also under LOCK for writes. */
+  struct process* pcb;       /* Creating process, or NULL once stopped. */
+  struct list_elem pcb_elem; /* Element in pcb->urings. */
+
+  /* Under LOCK. */
+  struct lock lock;
+  struct condition work; /* Signaled when requests are queued or RING stops. */
+  struct condition done; /* Broadcast when a request completes or a worker exits. */
+  uint32_t sq_head;      /* Kernel copy of urings->sq_head. */
+  uint32_t cq_tail;      /* Kernel copy of urings->cq_tail. */
+  struct list pending;   /* Requests no worker has started. */
+  unsigned pending_cnt;  /* Length of PENDING. */
+  unsigned inflight;     /* Requests queued or running. */
+  int workers;           /* Worker threads. */
+  int busy;              /* Workers running a request. */
+  bool stopped;          /* Takes no more requests; workers exit. */
+  int exiting;           /* uring_exit() calls not yet done with the ring. */
+};
+
+/* A submission handed to the workers. */
+struct uring_req {
+  struct list_elem elem;       /* Element in ring->pending. */
+  struct io_uring_sqe sqe;     /* Copy of the submission. */
+  struct open_file_desc* ofd;  /* Reference to sqe.fd's OFD, or NULL. */
+  struct dir* cwd;             /* Submitter's working directory, for OPEN. */
+  void* user_esp;              /* Submitter's user stack pointer. */
+};
+
+/* Protects every process's urings list and every ring's owner. */
+static struct lock uring_lock;
+
+void uring_init(void) { lock_init(&uring_lock); }
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * COMPLETIONS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Posts a completion of USER_DATA with result RES to RING's CQ.  The
+   caller holds RING's lock and has reserved the entry.  A completion that
+   cannot be stored because the ring memory has gone is dropped. */
+static void post(struct uring* ring, uint64_t user_data, int res) {
+  struct io_uring_cqe cqe = {.user_data = user_data, .res = res, .flags = 0};
+  uint32_t tail = ring->cq_tail;
+
+  if (!copy_to_user(&ring->ucqes[tail & (ring->cq_entries - 1)], &cqe, sizeof cqe))
+    return;
+  ring->cq_tail = tail + 1;
+  copy_to_user(&ring->urings->cq_tail, &ring->cq_tail, sizeof ring->cq_tail);
+}
+
+/* Returns how many completions RING's CQ holds that the program has not
+   consumed, or UINT32_MAX if the ring memory is not readable.  A
+   nonsensical cq_head counts as a full CQ. */
+static uint32_t cq_ready(struct uring* ring) {
+  uint32_t head;
+  if (!copy_from_user(&head, &ring->urings->cq_head, sizeof head))
+    return UINT32_MAX;
+  uint32_t ready = ring->cq_tail - head;
+  return ready <= ring->cq_entries ? ready : ring->cq_entries;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * WORKERS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Releases what REQ holds and frees it. */
+static void free_request(struct uring_req* req) {
+  ofd_close(req->ofd);
+  if (req->cwd != NULL)
+    dir_close(req->cwd);
+  free(req);
+}
+
+/* Closes descriptor FD of the current process, unless it is a ring, which
+   a worker must not stop. */
+static int close_fd(int fd) {
+  struct fd_table* fdt = &thread_current()->pcb->fd_table;
+  struct open_file_desc* ofd = fd_table_get(fdt, fd);
+  if (ofd == NULL || ofd->type == FD_URING)
+    return -1;
+  ofd_close(fd_table_remove(fdt, fd));
+  return 0;
+}
+
+static void worker_wake(struct wait_entry* entry, unsigned events UNUSED) {
+  waiter_wake(entry->aux);
+}
+
+/* Transfers LEN bytes between REQ's pipe end or console stream and UBUF,
+   as syscall_io() would, but never blocks inside the transfer: while
+   nothing can move, waits for the descriptor to become ready or for RING
+   to stop, so that stopping never waits on a peer or on the keyboard. */
+static int stream_io(struct uring* ring, struct uring_req* req, void* ubuf, unsigned len,
+                     bool write, bool* fault) {
+  unsigned ready = (write ? POLLOUT : POLLIN) | POLLERR | POLLHUP;
+  struct wait_entry io_entry, stop_entry;
+  struct waiter w;
+  int res;
+
+  waiter_init(&w);
+  wait_entry_init(&io_entry, worker_wake, &w);
+  wait_entry_init(&stop_entry, worker_wake, &w);
+  wait_queue_add(&ring->stop_wq, &stop_entry);
+  for (;;) {
+    res = syscall_io_nowait(req->ofd, ubuf, len, write, fault);
+    if (res != SYSCALL_IO_AGAIN)
+      break;
+
+    unsigned events = ofd_poll(req->ofd, &io_entry);
+    lock_acquire(&ring->lock);
+    bool stopped = ring->stopped;
+    lock_release(&ring->lock);
+    if (!stopped && (events & ready) == 0)
+      waiter_wait(&w, -1);
+    wait_queue_remove(&io_entry);
+    if (stopped) {
+      res = -1;
+      break;
+    }
+  }
+  wait_queue_remove(&stop_entry);
+  return res;
+}
+
+/* Carries out REQ, taken from RING, in the current worker and returns its
+   result. */
+static int run_request(struct uring* ring, struct uring_req* req) {
+  struct thread* t = thread_current();
+  const struct io_uring_sqe* sqe = &req->sqe;
+  void* uaddr = (void*)(uintptr_t)sqe->addr;
+  bool fault = false;
+  int res = -1;
+
+  /* Stack growth checks compare against the submitter's stack. */
+  t->syscall_esp = req->user_esp;
+
+  switch (sqe->opcode) {
+    case IORING_OP_READ:
+    case IORING_OP_WRITE: {
+      off_t offset = sqe->off == IORING_OFF_CURRENT ? -1 : (off_t)sqe->off;
+      unsigned len = sqe->len <= INT_MAX ? sqe->len : INT_MAX;
+      bool write = sqe->opcode == IORING_OP_WRITE;
+      if (offset < 0 && (req->ofd->type == FD_PIPE || req->ofd->type == FD_CONSOLE))
+        res = stream_io(ring, req, uaddr, len, write, &fault);
+      else
+        res = syscall_io(req->ofd, uaddr, len, write, offset, &fault);
+      break;
+    }
+    case IORING_OP_OPEN:
+      t->cwd = req->cwd;
+      res = syscall_open(uaddr, &fault);
+      t->cwd = NULL;
+      break;
+    case IORING_OP_CLOSE:
+      res = close_fd(sqe->fd);
+      break;
+    case IORING_OP_FSYNC:
+      cache_flush();
+      res = 0;
+      break;
+  }
+  return fault ? -1 : res;
+}
+
+/* Worker thread for ring RING_. */
+static void uring_worker(void* ring_) {
+  struct uring* ring = ring_;
+  struct thread* t = thread_current();
+
+  lock_acquire(&ring->lock);
+  t->pcb = ring->pcb;
+  process_activate();
+
+  for (;;) {
+    while (list_empty(&ring->pending) && !ring->stopped)
+      cond_wait(&ring->work, &ring->lock);
+    if (ring->stopped)
+      break;
+
+    struct uring_req* req = list_entry(list_pop_front(&ring->pending), struct uring_req, elem);
+    ring->pending_cnt--;
+    ring->busy++;
+    lock_release(&ring->lock);
+
+    int res = run_request(ring, req);
+
+    lock_acquire(&ring->lock);
+    post(ring, req->sqe.user_data, res);
+    ring->busy--;
+    ring->inflight--;
+    cond_broadcast(&ring->done, &ring->lock);
+    free_request(req);
+  }
+
+  ring->workers--;
+  cond_broadcast(&ring->done, &ring->lock);
+  lock_release(&ring->lock);
+
+  /* The process may be gone as soon as we stop using its address space. */
+  t->pcb = NULL;
+  process_activate();
+  thread_exit();
+}
+
+/* Starts workers until every pending request of RING has one or the pool
+   is full.  The caller holds RING's lock. */
+static void add_workers(struct uring* ring) {
+  while (ring->workers < URING_WORKERS &&
+         (unsigned)(ring->workers - ring->busy) < ring->pending_cnt) {
+    ring->workers++;
+    if (thread_create("io_uring", PRI_DEFAULT, uring_worker, ring) == TID_ERROR) {
+      ring->workers--;
+      break;
+    }
+  }
+}
+
+/* Detaches RING from its process, after which its workers take no more
+   requests.  The caller holds uring_lock and stops RING next. */
+static void unlink_ring(struct uring* ring) {
+  list_remove(&ring->pcb_elem);
+  lock_acquire(&ring->lock);
+  ring->pcb = NULL;
+  ring->stopped = true;
+  lock_release(&ring->lock);
+}
+
+/* Stops RING: drops its pending requests and waits for its workers to
+   exit.  Workers waiting on a pipe or the console give up.  Callers
+   must not hold uring_lock, which a process exit needs meanwhile. */
+static void stop(struct uring* ring) {
+  lock_acquire(&ring->lock);
+  ring->stopped = true;
+  cond_broadcast(&ring->work, &ring->lock);
+  wait_queue_wake(&ring->stop_wq, POLLHUP);
+  while (ring->workers > 0)
+    cond_wait(&ring->done, &ring->lock);
+
+  while (!list_empty(&ring->pending))
+    free_request(list_entry(list_pop_front(&ring->pending), struct uring_req, elem));
+  ring->pending_cnt = 0;
+  ring->inflight = 0;
+  lock_release(&ring->lock);
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * RINGS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+struct uring* uring_create(unsigned entries, void* umem, bool* fault) {
+  if (entries == 0 || entries > IORING_MAX_ENTRIES || (entries & (entries - 1)) != 0 ||
+      (uintptr_t)umem % 8 != 0)
+    return NULL;
+
+  struct io_uring_rings header = {.sq_entries = entries, .cq_entries = 2 * entries};
+  if (!copy_to_user(umem, &header, sizeof header)) {
+    *fault = true;
+    return NULL;
+  }
+
+  struct uring* ring = malloc(sizeof *ring);
+  if (ring == NULL)
+    return NULL;
+  ring->urings = umem;
+  ring->usqes = (struct io_uring_sqe*)((uint8_t*)umem + IORING_SQES_OFFSET);
+  ring->ucqes = (struct io_uring_cqe*)((uint8_t*)umem + IORING_CQES_OFFSET(entries));
+  ring->sq_entries = entries;
+  ring->cq_entries = 2 * entries;
+  wait_queue_init(&ring->stop_wq);
+  lock_init(&ring->lock);
+  cond_init(&ring->work);
+  cond_init(&ring->done);
+  ring->sq_head = 0;
+  ring->cq_tail = 0;
+  list_init(&ring->pending);
+  ring->pending_cnt = 0;
+  ring->inflight = 0;
+  ring->workers = 0;
+  ring->busy = 0;
+  ring->stopped = false;
+  ring->exiting = 0;
+
+  ring->pcb = thread_current()->pcb;
+  lock_acquire(&uring_lock);
+  list_push_back(&ring->pcb->urings, &ring->pcb_elem);
+  lock_release(&uring_lock);
+  return ring;
+}
+
+void uring_close(struct uring* ring) {
+  lock_acquire(&uring_lock);
+  if (ring->pcb != NULL)
+    unlink_ring(ring);
+  lock_release(&uring_lock);
+  stop(ring);
+
+  /* An exiting process may still be stopping the ring too. */
+  lock_acquire(&ring->lock);
+  while (ring->exiting > 0)
+    cond_wait(&ring->done, &ring->lock);
+  lock_release(&ring->lock);
+  free(ring);
+}
+
+void uring_exit(struct process* pcb) {
+  struct list rings;
+
+  /* Take the rings off PCB under uring_lock, marked so that closing one
+     meanwhile does not free it, and stop them after releasing it. */
+  list_init(&rings);
+  lock_acquire(&uring_lock);
+  while (!list_empty(&pcb->urings)) {
+    struct uring* ring = list_entry(list_front(&pcb->urings), struct uring, pcb_elem);
+    unlink_ring(ring);
+    ring->exiting++;
+    list_push_back(&rings, &ring->pcb_elem);
+  }
+  lock_release(&uring_lock);
+
+  while (!list_empty(&rings)) {
+    struct uring* ring = list_entry(list_pop_front(&rings), struct uring, pcb_elem);
+    stop(ring);
+    lock_acquire(&ring->lock);
+    ring->exiting--;
+    cond_broadcast(&ring->done, &ring->lock);
+    lock_release(&ring->lock);
+  }
+}
+
+/* Turns SQE into a request for the workers, or returns NULL after storing
+   in *RES the result of a submission that is already complete: a NOP, or
+   one that is invalid. */
+static struct uring_req* prepare(const struct io_uring_sqe* sqe, int* res) {
+  struct thread* cur = thread_current();
+  struct open_file_desc* ofd = NULL;
+
+  *res = -1;
+  if (sqe->pad[0] != 0 || sqe->pad[1] != 0 || sqe->pad[2] != 0 || sqe->pad2 != 0)
+    return NULL;
+
+  switch (sqe->opcode) {
+    case IORING_OP_NOP:
+      *res = 0;
+      return NULL;
+    case IORING_OP_READ:
+    case IORING_OP_WRITE:
+      if (sqe->off != IORING_OFF_CURRENT && sqe->off > INT_MAX)
+        return NULL;
+      ofd = syscall_io_ofd(sqe->fd, sqe->opcode == IORING_OP_WRITE);
+      if (ofd == NULL)
+        return NULL;
+      break;
+    case IORING_OP_FSYNC:
+      ofd = fd_table_get(&cur->pcb->fd_table, sqe->fd);
+      if (ofd == NULL || ofd->type != FD_FILE)
+        return NULL;
+      break;
+    case IORING_OP_OPEN:
+    case IORING_OP_CLOSE:
+      break;
+    default:
+      return NULL;
+  }
+
+  struct uring_req* req = malloc(sizeof *req);
+  if (req == NULL)
+    return NULL;
+  req->sqe = *sqe;
+  req->ofd = ofd != NULL ? ofd_dup(ofd) : NULL;
+  req->cwd = sqe->opcode == IORING_OP_OPEN && cur->cwd != NULL ? dir_reopen(cur->cwd) : NULL;
+  req->user_esp = cur->syscall_esp;
+  return req;
+}
+
+/* Consumes up to TO_SUBMIT submissions from RING, whose lock the caller
+   holds, as long as their completions are sure to fit in the CQ.
+   Returns the number consumed, or -1 if the ring memory is not valid. */
+static int submit(struct uring* ring, unsigned to_submit) {
+  uint32_t tail;
+  if (!copy_from_user(&tail, &ring->urings->sq_tail, sizeof tail))
+    return -1;
+
+  uint32_t ready = cq_ready(ring);
+  if (ready == UINT32_MAX)
+    return -1;
+  uint32_t used = ready + ring->inflight;
+  uint32_t room = used < ring->cq_entries ? ring->cq_entries - used : 0;
+  uint32_t avail = tail - ring->sq_head;
+  if (avail > ring->sq_entries)
+    avail = ring->sq_entries; /* Nonsensical tail: take one queue's worth. */
+
+  unsigned n = to_submit;
+  if (n > avail)
+    n = avail;
+  if (n > room)
+    n = room;
+
+  for (unsigned i = 0; i < n; i++) {
+    struct io_uring_sqe sqe;
+    if (!copy_from_user(&sqe, &ring->usqes[ring->sq_head & (ring->sq_entries - 1)], sizeof sqe))
+      return -1;
+    ring->sq_head++;
+
+    int res;
+    struct uring_req* req = prepare(&sqe, &res);
+    if (req == NULL) {
+      post(ring, sqe.user_data, res);
+      continue;
+    }
+    list_push_back(&ring->pending, &req->elem);
+    ring->pending_cnt++;
+    ring->inflight++;
+  }
+
+  if (!copy_to_user(&ring->urings->sq_head, &ring->sq_head, sizeof ring->sq_head))
+    return -1;
+  if (ring->pending_cnt > 0) {
+    cond_broadcast(&ring->work, &ring->lock);
+    add_workers(ring);
+  }
+  return n;
+}
+
+int uring_enter(struct uring* ring, unsigned to_submit, unsigned min_complete, bool* fault) {
+  lock_acquire(&ring->lock);
+  if (ring->pcb != thread_current()->pcb) {
+    lock_release(&ring->lock);
+    return -1;
+  }
+
+  int submitted = submit(ring, to_submit);
+  if (submitted < 0) {
+    lock_release(&ring->lock);
+    *fault = true;
+    return -1;
+  }
+
+  if (min_complete > ring->cq_entries)
+    min_complete = ring->cq_entries;
+  for (;;) {
+    uint32_t ready = cq_ready(ring);
+    if (ready == UINT32_MAX) {
+      *fault = true;
+      break;
+    }
+    if (ready >= min_complete || ring->inflight == 0 || ring->stopped)
+      break;
+    cond_wait(&ring->done, &ring->lock);
+  }
+  lock_release(&ring->lock);
+  return submitted;
+}
@@ -0,0 +1,77 @@
+#ifndef USERPROG_URING_H
+#define USERPROG_URING_H
+
+#include <io_uring.h>
+#include <stdbool.h>
+
+struct process;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * ASYNCHRONOUS I/O RINGS
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * An io_uring instance pairs a submission queue and a completion queue in
+ * user memory (layout in lib/io_uring.h) with a pool of kernel worker
+ * threads.  io_uring_enter() copies the new submissions in and queues them;
+ * workers take requests off the queue, carry them out as the equivalent
+ * system call would, and post completions straight into the user's CQ.  A
+ * program can keep many operations in flight for one trap per batch.
+ *
+ * WORKERS:
+ *   - Up to URING_WORKERS per ring, started on demand by io_uring_enter()
+ *     and parked on the ring once started, until it is closed.
+ *   - A worker runs in its ring's process: thread->pcb points at it, so the
+ *     process's page directory is active and user buffers, paths and
+ *     descriptors are reached exactly as from a system call.
+ *   - Operations run in no particular order relative to each other.
+ *
+ * FLOW CONTROL: the kernel never has more operations in flight than there
+ * are free CQ entries, so completions cannot overflow.  io_uring_enter()
+ * stops consuming submissions once the CQ would be full.
+ *
+ * LIFETIME:
+ *   - Only the creating process may submit; a forked child that inherits
+ *     the descriptor gets -1 from io_uring_enter().
+ *   - Closing the last descriptor, or the creating process exiting, stops
+ *     the ring: requests not yet started are dropped, and those running
+ *     are waited for.  Reads and writes of pipes and the console, which
+ *     can wait indefinitely, wait by polling, so stopping cuts them short.
+ *
+ * SYNCHRONIZATION:
+ *   - Per-ring lock protects the queue, counters, and the kernel's ring
+ *     indices.  Completions are posted under it, one at a time.
+ *   - A global lock protects each process's list of rings and each ring's
+ *     owner.  Lock order: global lock, then ring lock.  Stopping waits for
+ *     workers without the global lock.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Worker threads per ring. */
+#define URING_WORKERS 4
+
+struct uring;
+
+void uring_init(void);
+
+/* Creates a ring with an SQ of ENTRIES entries in the user memory at UMEM,
+   which must be IORING_MEM_SIZE(ENTRIES) bytes, 8-byte aligned, and stay
+   valid while the ring is in use.  Returns NULL if ENTRIES is not a power
+   of 2 up to IORING_MAX_ENTRIES, UMEM is misaligned, or memory is short.
+   Sets *FAULT if UMEM is not writable user memory. */
+struct uring* uring_create(unsigned entries, void* umem, bool* fault);
+
+/* Stops RING and frees it. */
+void uring_close(struct uring* ring);
+
+/* Consumes up to TO_SUBMIT new submissions from RING, then waits until at
+   least MIN_COMPLETE completions are ready to be consumed or nothing
+   remains in flight.  Returns the number of submissions consumed, or -1
+   if the caller's process does not own RING.  Sets *FAULT if the ring
+   memory is no longer valid user memory. */
+int uring_enter(struct uring* ring, unsigned to_submit, unsigned min_complete, bool* fault);
+
+/* Stops every ring PCB created.  Called by process_exit() before the
+   address space goes away. */
+void uring_exit(struct process* pcb);
+
+#endif /* userprog/uring.h */
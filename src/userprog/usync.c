@@ -0,0 +1,214 @@
+#include "userprog/usync.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * TABLE
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Points T at its embedded first generation, with every slot empty. */
+static void init_first(struct usync_table* t) {
+  t->first.size = USYNC_TABLE_INLINE;
+  t->first.objs = t->first_objs;
+  t->first.prev = NULL;
+  memset(t->first_objs, 0, sizeof t->first_objs);
+  t->cur = &t->first;
+  t->count = 0;
+}
+
+void usync_table_init(struct usync_table* t) {
+  lock_init(&t->lock);
+  init_first(t);
+}
+
+/* Frees OBJ and what it owns. */
+static void free_obj(struct usync* obj) {
+  if (obj->kind == USYNC_RWLOCK)
+    while (!list_empty(&obj->rwlock.readers))
+      free(list_entry(list_pop_front(&obj->rwlock.readers), struct usync_reader, elem));
+  free(obj);
+}
+
+void usync_table_destroy(struct usync_table* t) {
+  struct usync_array* a = t->cur;
+
+  for (int id = 0; id < t->count; id++)
+    free_obj(a->objs[id]);
+
+  while (a != &t->first) {
+    struct usync_array* prev = a->prev;
+    free(a);
+    a = prev;
+  }
+  init_first(t);
+}
+
+/* Replaces T's current generation with one twice the size.  The caller
+   holds T's lock.  Returns false if memory is short. */
+static bool grow(struct usync_table* t) {
+  struct usync_array* old = t->cur;
+  int size = old->size * 2;
+  if (size <= old->size)
+    return false;
+
+  size_t slot_bytes = size * sizeof(struct usync*);
+  struct usync_array* a = malloc(sizeof *a + slot_bytes);
+  if (a == NULL)
+    return false;
+
+  a->size = size;
+  a->objs = (struct usync**)(a + 1);
+  a->prev = old;
+  memcpy(a->objs, old->objs, old->size * sizeof(struct usync*));
+  memset(a->objs + old->size, 0, slot_bytes - old->size * sizeof(struct usync*));
+
+  /* Lockless readers must see the contents before the pointer. */
+  barrier();
+  t->cur = a;
+  return true;
+}
+
+int usync_create(struct usync_table* t, enum usync_kind kind, unsigned arg) {
+  ASSERT(kind != USYNC_BARRIER || arg > 0);
+
+  struct usync* obj = malloc(sizeof *obj);
+  if (obj == NULL)
+    return -1;
+
+  obj->kind = kind;
+  switch (kind) {
+    case USYNC_LOCK:
+      lock_init(&obj->lock);
+      break;
+    case USYNC_SEMA:
+      sema_init(&obj->sema, arg);
+      break;
+    case USYNC_COND:
+      cond_init(&obj->cond);
+      break;
+    case USYNC_BARRIER:
+      lock_init(&obj->barrier.lock);
+      cond_init(&obj->barrier.all_in);
+      obj->barrier.count = arg;
+      obj->barrier.arrived = 0;
+      obj->barrier.phase = 0;
+      break;
+    case USYNC_RWLOCK:
+      rw_lock_init(&obj->rwlock.rw);
+      obj->rwlock.writer = NULL;
+      list_init(&obj->rwlock.readers);
+      break;
+  }
+
+  lock_acquire(&t->lock);
+  int id = t->count;
+  if (id == t->cur->size && !grow(t)) {
+    lock_release(&t->lock);
+    free(obj);
+    return -1;
+  }
+  t->cur->objs[id] = obj;
+  t->count++;
+  lock_release(&t->lock);
+  return id;
+}
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * BARRIERS AND READER-WRITER LOCKS
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+bool usync_barrier_wait(struct usync_barrier* b) {
+  bool last;
+
+  lock_acquire(&b->lock);
+  unsigned phase = b->phase;
+  last = ++b->arrived == b->count;
+  if (last) {
+    b->arrived = 0;
+    b->phase++;
+    cond_broadcast(&b->all_in, &b->lock);
+  } else {
+    while (b->phase == phase)
+      cond_wait(&b->all_in, &b->lock);
+  }
+  lock_release(&b->lock);
+  return last;
+}
+
+/* Returns the current thread's record as a reader of RW, or NULL.  The
+   caller holds RW's lock. */
+static struct usync_reader* find_reader(struct usync_rwlock* rw) {
+  tid_t tid = thread_current()->tid;
+
+  for (struct list_elem* e = list_begin(&rw->readers); e != list_end(&rw->readers);
+       e = list_next(e)) {
+    struct usync_reader* r = list_entry(e, struct usync_reader, elem);
+    if (r->tid == tid)
+      return r;
+  }
+  return NULL;
+}
+
+bool usync_rwlock_acquire(struct usync_rwlock* rw, bool reader) {
+  struct thread* cur = thread_current();
+
+  if (rw->writer == cur)
+    return false;
+
+  if (!reader) {
+    /* Waiting to write while reading would wait forever. */
+    lock_acquire(&rw->rw.lock);
+    bool reading = find_reader(rw) != NULL;
+    lock_release(&rw->rw.lock);
+    if (reading)
+      return false;
+
+    rw_lock_acquire(&rw->rw, false);
+    rw->writer = cur;
+    return true;
+  }
+
+  rw_lock_acquire(&rw->rw, true);
+  lock_acquire(&rw->rw.lock);
+  struct usync_reader* r = find_reader(rw);
+  if (r == NULL) {
+    r = malloc(sizeof *r);
+    if (r != NULL) {
+      r->tid = cur->tid;
+      r->count = 0;
+      list_push_back(&rw->readers, &r->elem);
+    }
+  }
+  if (r != NULL)
+    r->count++;
+  lock_release(&rw->rw.lock);
+
+  if (r == NULL) {
+    rw_lock_release(&rw->rw, true);
+    return false;
+  }
+  return true;
+}
+
+bool usync_rwlock_release(struct usync_rwlock* rw, bool reader) {
+  if (reader) {
+    lock_acquire(&rw->rw.lock);
+    struct usync_reader* r = find_reader(rw);
+    bool held = r != NULL;
+    if (held && --r->count == 0) {
+      list_remove(&r->elem);
+      free(r);
+    }
+    lock_release(&rw->rw.lock);
+    if (!held)
+      return false;
+  } else {
+    if (rw->writer != thread_current())
+      return false;
+    rw->writer = NULL;
+  }
+  rw_lock_release(&rw->rw, reader);
+  return true;
+}
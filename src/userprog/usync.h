@@ -0,0 +1,132 @@
+#ifndef USERPROG_USYNC_H
+#define USERPROG_USYNC_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct thread;
+
+/* ═══════════════════════════════════════════════════════════════════════════
+ * USER-LEVEL SYNCHRONIZATION OBJECTS
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * Locks, semaphores, condition variables, barriers and reader-writer locks
+ * for user programs.  Each object lives in the kernel; user code holds an
+ * int handle that indexes its process's usync table.
+ *
+ * Every kind is built on the kernel primitives in threads/synch.h, so a
+ * blocked user thread sits on that primitive's wait list and a wakeup is
+ * one list operation.  A condition broadcast or the last thread into a
+ * barrier releases every waiter in a single system call.
+ *
+ * The table starts with USYNC_TABLE_INLINE slots inside struct usync_table
+ * and doubles whenever it fills, so the number of objects is bounded only
+ * by kernel memory.  Objects are freed with the process.
+ *
+ * SYNCHRONIZATION:
+ *   - usync_get() takes no lock.  It reads the current generation of the
+ *     table through a single pointer.
+ *   - usync_create() holds the table's lock.  Growth publishes a new
+ *     generation; older ones stay allocated until usync_table_destroy(),
+ *     so a reader holding one never sees freed memory.
+ *
+ * ═══════════════════════════════════════════════════════════════════════════*/
+
+/* Slots embedded in struct usync_table. */
+#define USYNC_TABLE_INLINE 16
+
+enum usync_kind {
+  USYNC_LOCK,    /* struct lock. */
+  USYNC_SEMA,    /* struct semaphore. */
+  USYNC_COND,    /* struct condition, used with a USYNC_LOCK. */
+  USYNC_BARRIER, /* struct usync_barrier. */
+  USYNC_RWLOCK,  /* struct usync_rwlock. */
+};
+
+/* A barrier for COUNT threads.  The last thread to arrive starts a new
+   phase and broadcasts ALL_IN. */
+struct usync_barrier {
+  struct lock lock;         /* Guards the fields below. */
+  struct condition all_in;  /* Waiters for the current phase to end. */
+  unsigned count;           /* Threads per phase. */
+  unsigned arrived;         /* Threads waiting in the current phase. */
+  unsigned phase;           /* Number of phases completed. */
+};
+
+/* A writer-preferring reader-writer lock that knows its holders, so a
+   thread can't release a lock it does not hold. */
+struct usync_rwlock {
+  struct rw_lock rw;
+  struct thread* writer; /* Holder of the write lock, or NULL. */
+  struct list readers;   /* usync_readers, under RW's lock. */
+};
+
+/* A thread holding a usync_rwlock for reading. */
+struct usync_reader {
+  struct list_elem elem; /* In usync_rwlock's readers. */
+  tid_t tid;             /* The thread. */
+  unsigned count;        /* Read locks it holds. */
+};
+
+struct usync {
+  enum usync_kind kind;
+  union {
+    struct lock lock;
+    struct semaphore sema;
+    struct condition cond;
+    struct usync_barrier barrier;
+    struct usync_rwlock rwlock;
+  };
+};
+
+/* One generation of the table. */
+struct usync_array {
+  int size;                  /* Number of slots. */
+  struct usync** objs;       /* SIZE slots; NULL past the last object. */
+  struct usync_array* prev;  /* Previous generation, or NULL. */
+};
+
+struct usync_table {
+  struct usync_array* cur; /* Current generation. */
+  int count;               /* Objects created; the next handle. */
+  struct lock lock;        /* Serializes usync_create(). */
+
+  /* Storage for the first generation. */
+  struct usync_array first;
+  struct usync* first_objs[USYNC_TABLE_INLINE];
+};
+
+void usync_table_init(struct usync_table*);
+
+/* Frees every object in the table and empties it. */
+void usync_table_destroy(struct usync_table*);
+
+/* Creates an object of KIND and returns its handle, or -1 if memory is
+   short.  ARG is the initial value of a semaphore or the thread count of
+   a barrier, which must not be 0; other kinds ignore it. */
+int usync_create(struct usync_table*, enum usync_kind kind, unsigned arg);
+
+/* Returns the object with handle ID if it is of KIND, otherwise NULL. */
+static inline struct usync* usync_get(struct usync_table* t, int id, enum usync_kind kind) {
+  struct usync_array* a = t->cur;
+  barrier();
+  struct usync* obj = id >= 0 && id < a->size ? a->objs[id] : NULL;
+  return obj != NULL && obj->kind == kind ? obj : NULL;
+}
+
+/* Waits at barrier B until its thread count have arrived.  Returns true
+   in exactly one thread of each phase, the last to arrive. */
+bool usync_barrier_wait(struct usync_barrier* b);
+
+/* Acquires RW for reading or, if READER is false, for writing.  Returns
+   false without blocking if the current thread already holds it for
+   writing, or for reading when asking to write, or if memory is short. */
+bool usync_rwlock_acquire(struct usync_rwlock* rw, bool reader);
+
+/* Releases RW, held for reading or, if READER is false, for writing.
+   Returns false if the current thread does not hold it that way. */
+bool usync_rwlock_release(struct usync_rwlock* rw, bool reader);
+
+#endif /* userprog/usync.h */
@@ -35,6 +35,23 @@ interface MaverickTestResult {
     callStack?: string;
     backtrace?: string;
   };
+  vmStats?: VmStats;
+}
+
+/** Per-class page-fault latency, from the kernel's "VM: <class> latency" lines. */
+interface VmFaultLatency {
+  avgCycles: number;
+  maxCycles: number;
+  /** log2(cycles) bucket -> fault count; only non-empty buckets appear. */
+  histogram: Record<string, number>;
+}
+
+/** Global VM counters printed by vmstat_print_stats() at shutdown. */
+interface VmStats {
+  faults: Record<string, number>;
+  evictions: Record<string, number>;
+  clock: { scans: number; steps: number; maxSteps: number };
+  latency: Record<string, VmFaultLatency>;
 }
 
 interface CliArgs {
@@ -277,6 +294,58 @@ function checkForPanic(output: string[]): MaverickTestResult["panic"] | undefine
   return { message, callStack };
 }
 
+/** Parses "name count, name count" lists such as "zero 3, file 12". */
+function parseCounts(list: string): Record<string, number> {
+  const counts: Record<string, number> = {};
+  for (const item of list.split(",")) {
+    const match = item.trim().match(/^(\S+) (\d+)$/);
+    if (match) counts[match[1]] = Number(match[2]);
+  }
+  return counts;
+}
+
+/** Extracts the "VM: ..." statistics the kernel prints at shutdown, if any. */
+function parseVmStats(output: string[]): VmStats | undefined {
+  const stats: VmStats = {
+    faults: {},
+    evictions: {},
+    clock: { scans: 0, steps: 0, maxSteps: 0 },
+    latency: {},
+  };
+  let found = false;
+
+  for (const line of output) {
+    let match: RegExpMatchArray | null;
+    if ((match = line.match(/^VM: faults: (.*)$/))) {
+      stats.faults = parseCounts(match[1]);
+      found = true;
+    } else if ((match = line.match(/^VM: evictions: (.*)$/))) {
+      stats.evictions = parseCounts(match[1]);
+    } else if ((match = line.match(/^VM: clock: (\d+) scans, (\d+) steps, (\d+) max$/))) {
+      stats.clock = {
+        scans: Number(match[1]),
+        steps: Number(match[2]),
+        maxSteps: Number(match[3]),
+      };
+    } else if (
+      (match = line.match(/^VM: (\S+) latency: avg (\d+), max (\d+) cycles, histogram(.*)$/))
+    ) {
+      const histogram: Record<string, number> = {};
+      for (const pair of match[4].trim().split(/\s+/)) {
+        const [bucket, count] = pair.split(":");
+        if (count !== undefined) histogram[bucket] = Number(count);
+      }
+      stats.latency[match[1]] = {
+        avgCycles: Number(match[2]),
+        maxCycles: Number(match[3]),
+        histogram,
+      };
+    }
+  }
+
+  return found ? stats : undefined;
+}
+
 function checkOutput(
   output: string[],
   testName: string,
@@ -475,6 +544,7 @@ async function main(): Promise<void> {
       errors: checkResult.errors,
       diff: checkResult.diff,
       panic,
+      vmStats: parseVmStats(output),
     };
     console.log(JSON.stringify(result, null, 2));
   } else {
@@ -37,9 +37,11 @@
 
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/shm.h"
 #include "vm/swap.h"
+#include "vm/vmstat.h"
 #include "filesys/file.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
@@ -67,10 +69,16 @@ static struct lock frame_lock;
    NULL means start from beginning of list. */
 static struct list_elem* clock_hand;
 
+/* Cache that frame_entry structs are allocated from. */
+static struct slab_cache frame_entry_cache;
+
 /* ============================================================================
  * INTERNAL HELPERS
  * ============================================================================ */
 
+static void* frame_alloc_entry(void* upage, struct thread* owner, struct shm_object* shm,
+                               size_t shm_page);
+
 /* Advance clock hand to next element, wrapping around if needed.
    Must be called with frame_lock held.
    Returns the new clock_hand position. */
@@ -107,6 +115,7 @@ void frame_init(void) {
   list_init(&frame_list);
   lock_init(&frame_lock);
   clock_hand = NULL;
+  slab_cache_init(&frame_entry_cache, "frame_entry", sizeof(struct frame_entry), NULL, NULL);
 }
 
 /* ============================================================================
@@ -129,15 +138,25 @@ void frame_init(void) {
    SYNCHRONIZATION:
    ----------------
    We pre-allocate the frame_entry struct before acquiring the lock to avoid
-   holding the lock during malloc (which could block). The frame is added to
+   holding the lock during slab_alloc (which could block). The frame is added to
    the list atomically with the lock held. Since the frame is newly allocated
    (either from palloc or eviction), no other thread can know about it yet,
    so there's no race between allocation and list insertion. */
-void* frame_alloc(void* upage) {
+void* frame_alloc(void* upage) { return frame_alloc_entry(upage, thread_current(), NULL, 0); }
+
+/* Allocate a frame to hold page PAGE_IDX of shared object OBJ.
+   Like frame_alloc(), the frame is zeroed and starts pinned. */
+void* frame_alloc_shared(struct shm_object* obj, size_t page_idx) {
+  return frame_alloc_entry(NULL, NULL, obj, page_idx);
+}
+
+/* Common body of frame_alloc() and frame_alloc_shared(). */
+static void* frame_alloc_entry(void* upage, struct thread* owner, struct shm_object* shm,
+                               size_t shm_page) {
   void* kpage;
 
-  /* Pre-allocate entry struct (malloc may block, don't hold lock). */
-  struct frame_entry* fe = (struct frame_entry*)malloc(sizeof(struct frame_entry));
+  /* Pre-allocate entry struct (slab_alloc may block, don't hold lock). */
+  struct frame_entry* fe = slab_alloc(&frame_entry_cache);
   if (fe == NULL)
     return NULL;
 
@@ -148,19 +167,21 @@ void* frame_alloc(void* upage) {
   if (kpage == NULL) {
     kpage = frame_evict();
     if (kpage == NULL) {
-      free(fe);
+      slab_free(&frame_entry_cache, fe);
       return NULL; /* All frames pinned, cannot evict. */
     }
     /* Zero the reclaimed frame. */
-    memset(kpage, 0, PGSIZE);
+    clear_page(kpage);
   }
 
   /* Initialize entry fields. */
   fe->kpage = kpage;
   fe->upage = upage;
-  fe->owner = thread_current();
+  fe->owner = owner;
+  fe->shm = shm;
+  fe->shm_page = shm_page;
   fe->ref_count = 1;
-  fe->pinned = true; /* Pin until caller is done setting up. */
+  fe->pin_count = 1; /* Pin until caller is done setting up. */
 
   /* Add to frame list atomically. */
   lock_acquire(&frame_lock);
@@ -178,14 +199,14 @@ void* frame_alloc(void* upage) {
    Returns true if registration succeeded, false on failure.
 
    SYNCHRONIZATION: This function holds frame_lock for the entire operation
-   to prevent TOCTOU race conditions. The malloc is done outside the lock
+   to prevent TOCTOU race conditions. The slab_alloc is done outside the lock
    for efficiency, but we re-check for duplicates after acquiring the lock. */
 bool frame_register(void* kpage, void* upage, struct thread* owner) {
   if (kpage == NULL)
     return false;
 
-  /* Allocate entry outside lock (malloc might block). */
-  struct frame_entry* fe = (struct frame_entry*)malloc(sizeof(struct frame_entry));
+  /* Allocate entry outside lock (slab_alloc might block). */
+  struct frame_entry* fe = slab_alloc(&frame_entry_cache);
   if (fe == NULL)
     return false;
 
@@ -193,8 +214,10 @@ bool frame_register(void* kpage, void* upage, struct thread* owner) {
   fe->kpage = kpage;
   fe->upage = upage;
   fe->owner = owner;
+  fe->shm = NULL;
+  fe->shm_page = 0;
   fe->ref_count = 1;
-  fe->pinned = true; /* Start pinned like frame_alloc. */
+  fe->pin_count = 1; /* Start pinned like frame_alloc. */
 
   /* Atomically check for existing and add if not present.
      This prevents TOCTOU race where another thread registers between
@@ -203,7 +226,7 @@ bool frame_register(void* kpage, void* upage, struct thread* owner) {
   struct frame_entry* existing = frame_find_entry(kpage);
   if (existing != NULL) {
     lock_release(&frame_lock);
-    free(fe); /* Discard our entry since duplicate exists. */
+    slab_free(&frame_entry_cache, fe); /* Discard our entry since duplicate exists. */
     return false;
   }
   list_push_back(&frame_list, &fe->elem);
@@ -267,7 +290,7 @@ void frame_free(void* kpage) {
   lock_release(&frame_lock);
 
   /* Free entry struct. */
-  free(fe);
+  slab_free(&frame_entry_cache, fe);
 
   /* Return page to palloc. */
   palloc_free_page(kpage);
@@ -283,7 +306,7 @@ void frame_pin(void* kpage) {
   lock_acquire(&frame_lock);
   struct frame_entry* fe = frame_find_entry(kpage);
   if (fe != NULL)
-    fe->pinned = true;
+    fe->pin_count++;
   lock_release(&frame_lock);
 }
 
@@ -300,7 +323,7 @@ bool frame_pin_if_present(void* kpage) {
   lock_acquire(&frame_lock);
   struct frame_entry* fe = frame_find_entry(kpage);
   if (fe != NULL) {
-    fe->pinned = true;
+    fe->pin_count++;
     lock_release(&frame_lock);
     return true;
   }
@@ -308,13 +331,13 @@ bool frame_pin_if_present(void* kpage) {
   return false;
 }
 
-/* Unpin a frame to allow eviction.
+/* Release one pin on a frame.
    Called when kernel is done accessing user memory. */
 void frame_unpin(void* kpage) {
   lock_acquire(&frame_lock);
   struct frame_entry* fe = frame_find_entry(kpage);
-  if (fe != NULL)
-    fe->pinned = false;
+  if (fe != NULL && fe->pin_count > 0)
+    fe->pin_count--;
   lock_release(&frame_lock);
 }
 
@@ -363,7 +386,7 @@ void* frame_evict(void) {
     struct frame_entry* fe = list_entry(e, struct frame_entry, elem);
 
     /* Skip pinned frames. */
-    if (fe->pinned) {
+    if (fe->pin_count > 0) {
       e = clock_advance(e);
       continue;
     }
@@ -377,6 +400,26 @@ void* frame_evict(void) {
       continue;
     }
 
+    /* Shared-object frames have no single owner; the object unmaps the
+       page from every process that maps it and picks the swap slot. */
+    if (fe->shm != NULL) {
+      enum shm_evict_result r = shm_evict_page(fe->shm, fe->shm_page, fe->kpage);
+      if (r != SHM_EVICT_DONE) {
+        e = clock_advance(e);
+        continue;
+      }
+      void* kpage = fe->kpage;
+      clock_hand = clock_advance(e);
+      if (clock_hand == e)
+        clock_hand = NULL;
+      list_remove(e);
+      vmstat_record_clock_scan(iterations);
+      vmstat_record_evict(NULL, VMSTAT_EVICT_SWAP);
+      lock_release(&frame_lock);
+      slab_free(&frame_entry_cache, fe);
+      return kpage;
+    }
+
     /* Check if owner's PCB is still valid. */
     if (fe->owner == NULL || fe->owner->pcb == NULL || fe->owner->pcb->pagedir == NULL) {
       /* Owner is gone, reclaim this frame directly. */
@@ -386,7 +429,9 @@ void* frame_evict(void) {
         clock_hand = NULL;
       list_remove(e);
       lock_release(&frame_lock);
-      free(fe);
+      slab_free(&frame_entry_cache, fe);
+      vmstat_record_clock_scan(iterations);
+      vmstat_record_evict(NULL, VMSTAT_EVICT_CLEAN);
       return kpage;
     }
 
@@ -453,6 +498,7 @@ void* frame_evict(void) {
        as potentially dirty. This ensures we never lose data that was written
        after the initial load. The cost is extra swap writes for clean pages,
        but this is acceptable for correctness. */
+    enum vmstat_evict outcome = VMSTAT_EVICT_CLEAN;
     bool dirty = pagedir_is_dirty(pd, upage);
     if (spte != NULL && spte->pinned_dirty) {
       dirty = true;
@@ -474,6 +520,7 @@ void* frame_evict(void) {
           /* Write succeeded, can reload from file later. */
           spte->status = PAGE_FILE;
           spte->kpage = NULL;
+          outcome = VMSTAT_EVICT_FILE;
         } else {
           /* Write failed, fall back to swap. */
           size_t swap_slot = swap_out(kpage);
@@ -485,6 +532,7 @@ void* frame_evict(void) {
             e = clock_advance(e);
             if (e == start) {
               lock_release(&frame_lock);
+              vmstat_record_clock_scan(iterations);
               return NULL;
             }
             continue;
@@ -493,6 +541,7 @@ void* frame_evict(void) {
           spte->swap_slot = swap_slot;
           spte->kpage = NULL;
           spte->pinned_dirty = true;
+          outcome = VMSTAT_EVICT_SWAP;
         }
       } else {
         /* Other dirty pages: write to swap. */
@@ -506,12 +555,14 @@ void* frame_evict(void) {
           e = clock_advance(e);
           if (e == start) {
             lock_release(&frame_lock);
+            vmstat_record_clock_scan(iterations);
             return NULL;
           }
           continue;
         }
 
         /* Update SPT entry to reflect page is now in swap. */
+        outcome = VMSTAT_EVICT_SWAP;
         if (spte != NULL) {
           spte->status = PAGE_SWAP;
           spte->swap_slot = swap_slot;
@@ -547,10 +598,14 @@ void* frame_evict(void) {
     /* Remove from frame table. */
     list_remove(e);
 
+    /* Charge the eviction while frame_lock still keeps OWNER's PCB alive. */
+    vmstat_record_clock_scan(iterations);
+    vmstat_record_evict(owner, outcome);
+
     lock_release(&frame_lock);
 
     /* Free the entry struct. */
-    free(fe);
+    slab_free(&frame_entry_cache, fe);
 
     /* Return the reclaimed frame. */
     return kpage;
@@ -558,5 +613,6 @@ void* frame_evict(void) {
 
   /* Exhausted max iterations - all frames pinned or all accessed even after second chance. */
   lock_release(&frame_lock);
+  vmstat_record_clock_scan(iterations);
   return NULL;
 }
@@ -53,6 +53,7 @@
 
 /* Forward declarations. */
 struct thread;
+struct shm_object;
 
 /* ============================================================================
  * FRAME TABLE ENTRY
@@ -61,33 +62,15 @@ struct thread;
  * Each entry represents one physical frame (4KB) allocated to a user process.
  * The entry tracks ownership and eviction-related metadata.
  *
- * CURRENT DESIGN (Simple - No Sharing):
- * -------------------------------------
- * Each frame has exactly ONE owner and ONE mapped virtual address.
- * This is sufficient for basic Pintos because:
- *   - fork() does eager copying (no copy-on-write)
- *   - No shared libraries
- *   - No MAP_SHARED mmap support
+ * OWNERSHIP MODELS:
+ * -----------------
+ * Private frames have exactly ONE owner and ONE mapped virtual address.
+ * COW sharing after fork() keeps that model and counts extra sharers in
+ * ref_count; the clock skips frames with ref_count > 1.
  *
- * FUTURE EXTENSION (Shared Pages / COW):
- * --------------------------------------
- * To support shared pages (COW, shared libraries, MAP_SHARED), replace
- * the single owner/upage with a list of mappings:
- *
- *   // Replace owner/upage with:
- *   struct list mappings;  // List of frame_mapping structs
- *
- *   struct frame_mapping {
- *       struct thread *owner;
- *       void *upage;
- *       struct list_elem elem;
- *   };
- *
- * Then update:
- *   - frame_alloc(): Create initial mapping, set ref_count = 1
- *   - frame_share(): Add new mapping, increment ref_count
- *   - frame_unmap(): Remove mapping, decrement ref_count, free if 0
- *   - frame_evict(): Update ALL page tables in mappings list
+ * Frames of a MAP_SHARED / shm object (shm != NULL) belong to the object
+ * instead, which tracks every mapping.  Eviction of such a frame is
+ * delegated to shm_evict_page(), which unmaps it from all of them.
  *
  * LIFECYCLE:
  * ----------
@@ -118,6 +101,14 @@ struct frame_entry {
        - Access the owner's SPT (to update page status) */
   struct thread* owner;
 
+  /* ===== Shared Objects (see vm/shm.h) ===== */
+
+  /* For frames holding a page of a shared memory object: the object and
+     the page's index in it.  Such frames have no owner or upage; the
+     object knows every mapping.  NULL for ordinary frames. */
+  struct shm_object* shm;
+  size_t shm_page;
+
   /* ===== Eviction Control ===== */
 
   /* Reference count for this frame.
@@ -125,12 +116,13 @@ struct frame_entry {
      track the number of mappings. Frame can only be freed when 0. */
   int ref_count;
 
-  /* If true, this frame cannot be evicted.
-     Set when:
+  /* Number of pins held on this frame.  It cannot be evicted while
+     this is nonzero.  Taken when:
        - Kernel is actively accessing user memory (during syscall)
        - Frame is being used for I/O operations
-     Must be cleared when operation completes. */
-  bool pinned;
+     Pins nest, since several threads or processes may access the same
+     frame at once, so each pin must be released by one frame_unpin(). */
+  int pin_count;
 
   /* ===== List Management ===== */
 
@@ -160,6 +152,10 @@ void frame_init(void);
    The frame is automatically tracked in the frame table. */
 void* frame_alloc(void* upage);
 
+/* Allocate a frame for page PAGE_IDX of shared memory object OBJ.
+   Same contract as frame_alloc(); eviction goes through shm_evict_page(). */
+void* frame_alloc_shared(struct shm_object* obj, size_t page_idx);
+
 /* Register an already-allocated page with the frame table.
    Used when a page was allocated via palloc_get_page directly (e.g., by
    pagedir_dup during fork) and needs to be tracked by the frame table.
@@ -199,7 +195,8 @@ void frame_pin(void* kpage);
    Use this when the frame might have been evicted between lookup and pin. */
 bool frame_pin_if_present(void* kpage);
 
-/* Unpin a frame to allow eviction. */
+/* Release one pin on a frame.  The frame may be evicted once every pin
+   taken on it, including the one it was allocated with, is released. */
 void frame_unpin(void* kpage);
 
 /* ============================================================================
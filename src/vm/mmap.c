@@ -10,10 +10,12 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/filedesc.h"
+#include "userprog/kdata.h"
 #include "userprog/pagedir.h"
 #include "userprog/process.h"
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/shm.h"
 #include "vm/swap.h"
 
 /* ============================================================================
@@ -53,6 +55,9 @@ static uint32_t* get_pagedir(void) {
 static struct mmap_region* mmap_find_region_locked(void* addr);
 static bool mmap_range_available(void* addr, size_t length);
 static void* find_free_address(size_t length);
+static void* choose_address(void* addr, size_t page_count);
+static struct mmap_region* map_shared_locked(void* addr, size_t length, int flags,
+                                             struct shm_object* obj, size_t first_page);
 
 /* Base address for mmap allocations when addr hint is NULL.
    Start above typical code/data segments but below stack. */
@@ -78,6 +83,17 @@ static void mmap_cleanup_pages(struct mmap_region* region) {
   struct spt* spt = get_spt();
   uint32_t* pd = get_pagedir();
 
+  /* Shared pages belong to their object: drop the SPT entries so no new
+     fault can reach the object, then detach (which clears the PTEs). */
+  if (region->shm != NULL) {
+    lock_acquire(&spt->spt_lock);
+    for (size_t i = 0; i < region->page_count; i++)
+      spt_remove(spt, (uint8_t*)region->start_addr + i * PGSIZE);
+    lock_release(&spt->spt_lock);
+    shm_detach(region->shm, region->start_addr);
+    return;
+  }
+
   for (size_t i = 0; i < region->page_count; i++) {
     void* upage = (uint8_t*)region->start_addr + i * PGSIZE;
 
@@ -144,7 +160,7 @@ static void mmap_cleanup_pages(struct mmap_region* region) {
       }
 
       /* Remove entry from SPT. */
-      hash_delete(&spt->pages, &entry->hash_elem);
+      spt_detach(spt, entry);
       lock_release(&spt->spt_lock);
 
       /* Phase 4: Perform I/O and free resources outside of locks. */
@@ -160,7 +176,7 @@ static void mmap_cleanup_pages(struct mmap_region* region) {
       if (status == PAGE_SWAP)
         swap_free(swap_slot);
 
-      free(entry);
+      spt_entry_free(entry);
     }
   }
 }
@@ -172,16 +188,16 @@ static struct file* get_file_from_fd(int fd) {
   ASSERT(t->pcb != NULL);
 
   /* Validate fd range (stdin=0, stdout=1 are not valid for mmap) */
-  if (fd < 2 || fd >= MAX_FILE_DESCRIPTOR) {
+  if (fd < 2) {
     return NULL;
   }
 
-  struct fd_entry* entry = &t->pcb->fd_table[fd];
-  if (entry->ofd == NULL || entry->ofd->type != FD_FILE || entry->ofd->file == NULL) {
+  struct open_file_desc* ofd = fd_table_get(&t->pcb->fd_table, fd);
+  if (ofd == NULL || ofd->type != FD_FILE || ofd->file == NULL) {
     return NULL;
   }
 
-  return entry->ofd->file;
+  return ofd->file;
 }
 
 /* ============================================================================
@@ -261,6 +277,8 @@ void* mmap_create(void* addr, size_t length, int fd, off_t offset) {
   region->offset = offset;
   region->flags = 0;
   region->is_anonymous = false;
+  region->shm = NULL;
+  region->shm_first_page = 0;
   /* TODO: inode_sector stored for potential future use (e.g., sharing detection) */
   region->inode_sector = inode_get_inumber(file_get_inode(map_file));
   region->writable = true;
@@ -268,7 +286,7 @@ void* mmap_create(void* addr, size_t length, int fd, off_t offset) {
   /* Create SPT entries for each page.
      IMPORTANT: Hold spt_lock during all SPT operations to prevent race
      condition with frame_evict() which does spt_find() under spt_lock.
-     Without this lock, hash_insert and hash_find could run concurrently,
+     Without this lock, spt_insert and spt_find could run concurrently,
      corrupting the hash table. */
   struct spt* spt = get_spt();
   size_t remaining = length;
@@ -333,6 +351,15 @@ static void* find_free_address(size_t length) {
   return NULL; /* No free range found */
 }
 
+/* Returns ADDR if the PAGE_COUNT pages starting there are free, or the
+   lowest free range if ADDR is NULL.  Returns NULL if neither works.
+   NOTE: Caller must hold mmap_lock. */
+static void* choose_address(void* addr, size_t page_count) {
+  if (addr == NULL)
+    return find_free_address(page_count * PGSIZE);
+  return mmap_range_available(addr, page_count * PGSIZE) ? addr : NULL;
+}
+
 void* mmap_create_anon(void* addr, size_t length, int flags) {
   /* Validate length */
   if (length == 0) {
@@ -351,19 +378,11 @@ void* mmap_create_anon(void* addr, size_t length, int flags) {
   struct lock* mmap_lock = get_mmap_lock();
   lock_acquire(mmap_lock);
 
-  /* Find address if not specified */
+  /* Find address if not specified, else check it is available */
+  addr = choose_address(addr, page_count);
   if (addr == NULL) {
-    addr = find_free_address(page_count * PGSIZE);
-    if (addr == NULL) {
-      lock_release(mmap_lock);
-      return MAP_FAILED;
-    }
-  } else {
-    /* Check that provided address range is available */
-    if (!mmap_range_available(addr, page_count * PGSIZE)) {
-      lock_release(mmap_lock);
-      return MAP_FAILED;
-    }
+    lock_release(mmap_lock);
+    return MAP_FAILED;
   }
 
   /* Allocate mmap_region */
@@ -381,6 +400,8 @@ void* mmap_create_anon(void* addr, size_t length, int flags) {
   region->offset = 0;
   region->flags = flags;
   region->is_anonymous = true;
+  region->shm = NULL;
+  region->shm_first_page = 0;
   region->inode_sector = 0;
   region->writable = true;
 
@@ -420,6 +441,105 @@ void* mmap_create_anon(void* addr, size_t length, int flags) {
   return addr;
 }
 
+/* Creates a MAP_SHARED region of OBJ at ADDR in the current process and
+   adds it to mmap_list.  Returns the region, or NULL on failure.
+   NOTE: Caller must hold mmap_lock and must have validated ADDR. */
+static struct mmap_region* map_shared_locked(void* addr, size_t length, int flags,
+                                             struct shm_object* obj, size_t first_page) {
+  size_t page_count = DIV_ROUND_UP(length, PGSIZE);
+
+  struct mmap_region* region = malloc(sizeof(struct mmap_region));
+  if (region == NULL)
+    return NULL;
+
+  region->start_addr = addr;
+  region->length = length;
+  region->page_count = page_count;
+  region->file = NULL;
+  region->offset = (off_t)(first_page * PGSIZE);
+  region->flags = flags;
+  region->is_anonymous = true;
+  region->shm = obj;
+  region->shm_first_page = first_page;
+  region->inode_sector = 0;
+  region->writable = true;
+
+  /* Attach before creating SPT entries, so the object already knows
+     about this mapping when the first fault arrives. */
+  if (!shm_attach(obj, addr, first_page, page_count)) {
+    free(region);
+    return NULL;
+  }
+
+  struct spt* spt = get_spt();
+  lock_acquire(&spt->spt_lock);
+  for (size_t i = 0; i < page_count; i++) {
+    void* upage = (uint8_t*)addr + i * PGSIZE;
+    if (!spt_create_shared_page(spt, upage, obj)) {
+      for (size_t j = 0; j < i; j++)
+        spt_remove(spt, (uint8_t*)addr + j * PGSIZE);
+      lock_release(&spt->spt_lock);
+      shm_detach(obj, addr);
+      free(region);
+      return NULL;
+    }
+  }
+  lock_release(&spt->spt_lock);
+
+  list_push_back(get_mmap_list(), &region->elem);
+  return region;
+}
+
+void* mmap_create_shared(void* addr, size_t length, int flags, struct shm_object* obj,
+                         size_t first_page) {
+  if (length == 0 || (addr != NULL && pg_ofs(addr) != 0))
+    return MAP_FAILED;
+
+  /* The mapping must lie within the object. */
+  size_t page_count = DIV_ROUND_UP(length, PGSIZE);
+  size_t obj_pages = shm_page_count(obj);
+  if (first_page > obj_pages || page_count > obj_pages - first_page)
+    return MAP_FAILED;
+
+  struct lock* mmap_lock = get_mmap_lock();
+  lock_acquire(mmap_lock);
+
+  addr = choose_address(addr, page_count);
+  struct mmap_region* region =
+      addr != NULL ? map_shared_locked(addr, length, flags, obj, first_page) : NULL;
+
+  lock_release(mmap_lock);
+  return region != NULL ? addr : MAP_FAILED;
+}
+
+bool mmap_inherit(struct process* parent) {
+  bool success = true;
+
+  /* The parent is blocked in fork(), but its other threads are not. */
+  lock_acquire(&parent->mmap_lock);
+  lock_acquire(get_mmap_lock());
+
+  struct list_elem* e;
+  for (e = list_begin(&parent->mmap_list); e != list_end(&parent->mmap_list);
+       e = list_next(e)) {
+    struct mmap_region* r = list_entry(e, struct mmap_region, elem);
+    if (r->shm == NULL)
+      continue;
+    if (map_shared_locked(r->start_addr, r->length, r->flags, r->shm, r->shm_first_page) ==
+        NULL) {
+      success = false;
+      break;
+    }
+  }
+
+  lock_release(get_mmap_lock());
+  lock_release(&parent->mmap_lock);
+
+  if (!success)
+    mmap_destroy_all();
+  return success;
+}
+
 int mmap_destroy(void* addr, size_t length) {
   /* Acquire lock to protect mmap_list */
   struct lock* mmap_lock = get_mmap_lock();
@@ -567,6 +687,11 @@ static bool mmap_range_available(void* addr, size_t length) {
     return false;
   }
 
+  /* The kernel data region is mapped in every process. */
+  if (addr_val < KDATA_BASE + KDATA_SIZE && end_val > KDATA_BASE) {
+    return false;
+  }
+
   /* Check for SPT conflicts.
      NOTE: We don't hold spt_lock here because:
      1. mmap_lock prevents concurrent mmaps to the same address range
@@ -9,6 +9,8 @@
 
 /* Forward declarations. */
 struct file;
+struct process;
+struct shm_object;
 
 /* ============================================================================
  * MEMORY-MAPPED FILES (mmap)
@@ -21,6 +23,8 @@ struct file;
  *   - Lazy loading: pages are loaded from disk on first access (page fault)
  *   - Automatic writeback: dirty pages are written back on unmap or exit
  *   - Per-process isolation: each process has its own mapping list
+ *   - MAP_SHARED: regions backed by a shared memory object (vm/shm.h) are
+ *     visible to every process mapping it and survive fork() in the child
  *
  * USAGE:
  *
@@ -76,6 +80,10 @@ struct mmap_region {
   int flags;         /* MAP_ANONYMOUS, MAP_PRIVATE, etc. */
   bool is_anonymous; /* True if no file backing (MAP_ANONYMOUS). */
 
+  /* Shared memory backing (MAP_SHARED), NULL for private mappings */
+  struct shm_object* shm; /* Object mapped by this region. */
+  size_t shm_first_page;  /* Object page mapped at start_addr. */
+
   /* Metadata */
   block_sector_t inode_sector; /* Inode sector (for future page sharing). */
   bool writable;               /* Write permission for this mapping. */
@@ -123,6 +131,33 @@ void* mmap_create(void* addr, size_t length, int fd, off_t offset);
  */
 void* mmap_create_anon(void* addr, size_t length, int flags);
 
+/* Create a MAP_SHARED mapping of a shared memory object.
+ *
+ * Maps LENGTH bytes of OBJ, starting at object page FIRST_PAGE, so that
+ * stores are visible to every process mapping the same pages.  The region
+ * takes its own reference to OBJ; the caller keeps its reference.
+ *
+ * @param addr        Hint address (NULL to let kernel choose, or page-aligned).
+ * @param length      Bytes to map (rounded up to page boundary internally).
+ * @param flags       Mapping flags (MAP_SHARED, optionally MAP_ANONYMOUS).
+ * @param obj         Shared memory object to map.
+ * @param first_page  First object page to map.
+ *
+ * @return The mapped address on success, MAP_FAILED on error (including a
+ *         range that extends past the end of OBJ).
+ */
+void* mmap_create_shared(void* addr, size_t length, int flags, struct shm_object* obj,
+                         size_t first_page);
+
+/* Give the current (just forked) process the MAP_SHARED regions of PARENT.
+ *
+ * Private regions are handled by spt_clone(); shared ones are re-attached
+ * to the same objects at the same addresses.  Call after spt_clone().
+ *
+ * @return true on success.  On failure the child's mappings are removed.
+ */
+bool mmap_inherit(struct process* parent);
+
 /* Remove a memory mapping.
  *
  * Unmaps the region and writes back any dirty pages to the file.
@@ -10,14 +10,15 @@
  *
  * HASH TABLE DESIGN:
  * ------------------
+ * - Table: lib/kernel/rhash.h, open addressing with Robin Hood probing
  * - Key: User virtual address (page-aligned, void*)
- * - Hash function: hash_bytes() on the address value
+ * - Hash function: rhash_int() on the page number
  * - Comparison: Direct pointer comparison (addresses are unique)
- * - Average lookup time: O(1)
+ * - Average lookup time: O(1), usually one or two adjacent slots
  *
  * MEMORY MANAGEMENT:
  * ------------------
- * - SPT entries are allocated with malloc() when created
+ * - SPT entries are allocated from a slab cache (spt_entry_alloc())
  * - Entries are freed automatically by spt_destroy() or spt_remove()
  * - Resources (frames, swap slots) are freed when entries are destroyed
  * - Files are NOT closed by SPT (managed by process or mmap)
@@ -42,7 +43,7 @@
 #include "vm/page.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "threads/thread.h"
@@ -56,53 +57,43 @@
  * HASH TABLE HELPERS
  * ============================================================================
  *
- * These functions are callbacks used by the hash table implementation to:
- * - Compute hash values for entries
- * - Compare entries for ordering
+ * These functions are used with the hash table implementation to:
+ * - Compute hash values for user pages
+ * - Match entries against a user page
  * - Clean up entries when the table is destroyed
  */
 
-/* Hash function for SPT entries.
+/* Hash function for SPT keys.
    
-   Computes a hash value based on the user virtual address. Uses hash_bytes()
-   which implements the Fowler-Noll-Vo hash algorithm for good distribution.
+   Computes a hash value from the page number of UPAGE with rhash_int(),
+   which mixes every bit into the low bits that select a slot.  Hashing
+   the raw address would leave the low 12 bits zero for every page.
    
-   @param e Hash element (embedded in spt_entry)
-   @param aux Auxiliary data (unused)
-   @return Hash value for the entry
+   @param upage Page-aligned user virtual address
+   @return Hash value for the page
    
-   The hash is computed over the entire pointer value (typically 4 bytes on
-   32-bit systems), ensuring different pages hash to different buckets. */
-static unsigned spt_hash_func(const struct hash_elem* e, void* aux UNUSED) {
-  struct spt_entry* entry = hash_entry(e, struct spt_entry, hash_elem);
-  return hash_bytes(&entry->upage, sizeof(entry->upage));
-}
+   User page numbers fit in 32 bits on both i386 and Sv39. */
+static unsigned spt_hash(const void* upage) { return rhash_int(pg_no(upage)); }
 
-/* Less function for SPT entries.
+/* Equality function for SPT entries.
    
-   Compares two entries by their user virtual addresses. Used by the hash
-   table to maintain ordering within buckets and detect duplicates.
+   Returns true if ENTRY is the entry for user page KEY.  Since virtual
+   addresses are unique per page, this is a pointer comparison.
    
-   @param a First hash element
-   @param b Second hash element
-   @param aux Auxiliary data (unused)
-   @return true if a->upage < b->upage, false otherwise
-   
-   Since virtual addresses are unique per page, this provides a total
-   ordering that allows efficient duplicate detection. */
-static bool spt_less_func(const struct hash_elem* a, const struct hash_elem* b, void* aux UNUSED) {
-  struct spt_entry* entry_a = hash_entry(a, struct spt_entry, hash_elem);
-  struct spt_entry* entry_b = hash_entry(b, struct spt_entry, hash_elem);
-  return entry_a->upage < entry_b->upage;
+   @param entry SPT entry in the table
+   @param key Page-aligned user virtual address
+   @param aux Auxiliary data (unused) */
+static bool spt_eq_func(const void* entry, const void* key, void* aux UNUSED) {
+  return ((const struct spt_entry*)entry)->upage == key;
 }
 
 /* Destroy function for SPT entries.
    
-   Called automatically by hash_destroy() for each entry in the table.
+   Called automatically by rhash_destroy() for each entry in the table.
    Frees all resources associated with the entry before freeing the entry
    structure itself.
    
-   @param e Hash element (embedded in spt_entry)
+   @param e SPT entry
    @param aux Auxiliary data (unused)
    
    Resource cleanup by status:
@@ -111,9 +102,9 @@ static bool spt_less_func(const struct hash_elem* a, const struct hash_elem* b,
    - PAGE_FILE:  No cleanup (file managed by process/mmap)
    - PAGE_ZERO:  No cleanup (no resources allocated)
    
-   After freeing resources, the entry structure itself is freed with free(). */
-static void spt_destroy_func(struct hash_elem* e, void* aux UNUSED) {
-  struct spt_entry* entry = hash_entry(e, struct spt_entry, hash_elem);
+   After freeing resources, the entry structure itself is freed with spt_entry_free(). */
+static void spt_destroy_func(void* e, void* aux UNUSED) {
+  struct spt_entry* entry = e;
 
   /* Free resources based on page status. */
   if (entry->status == PAGE_FRAME) {
@@ -127,24 +118,35 @@ static void spt_destroy_func(struct hash_elem* e, void* aux UNUSED) {
   /* For PAGE_ZERO, no resources to free. */
 
   /* Free the entry itself. */
-  free(entry);
+  spt_entry_free(entry);
 }
 
 /* ============================================================================
  * SPT LIFECYCLE
  * ============================================================================ */
 
+/* SPT entries of all processes. */
+static struct slab_cache spte_cache;
+
+void spt_cache_init(void) {
+  slab_cache_init(&spte_cache, "spt_entry", sizeof(struct spt_entry), NULL, NULL);
+}
+
+struct spt_entry* spt_entry_alloc(void) { return slab_alloc(&spte_cache); }
+
+void spt_entry_free(struct spt_entry* entry) { slab_free(&spte_cache, entry); }
+
 /* Initialize a supplemental page table.
    
-   Sets up the hash table with the appropriate hash and comparison functions.
-   The hash table starts with a small number of buckets and grows automatically
-   as entries are added.
+   Sets up the hash table with the appropriate comparison function.
+   The hash table allocates its slot array on the first insertion and grows
+   automatically as entries are added.
    
-   Implementation: Simply calls hash_init() with our helper functions.
+   Implementation: Simply calls rhash_init() with our helper function.
    The hash table will be empty after initialization. */
 void spt_init(void* spt) {
   struct spt* s = (struct spt*)spt;
-  hash_init(&s->pages, spt_hash_func, spt_less_func, NULL);
+  rhash_init(&s->pages, spt_eq_func, NULL);
   lock_init(&s->spt_lock);
 }
 
@@ -154,7 +156,7 @@ void spt_init(void* spt) {
    for each one, which frees associated resources (frames, swap slots) and
    the entry structure itself. Then destroys the hash table structure.
 
-   Implementation: Calls hash_destroy() which automatically calls our
+   Implementation: Calls rhash_destroy() which automatically calls our
    destroy function for each entry, ensuring proper cleanup of all resources.
 
    SYNCHRONIZATION: Must hold spt_lock during destruction to prevent
@@ -164,7 +166,7 @@ void spt_init(void* spt) {
 void spt_destroy(void* spt) {
   struct spt* s = (struct spt*)spt;
   lock_acquire(&s->spt_lock);
-  hash_destroy(&s->pages, spt_destroy_func);
+  rhash_destroy(&s->pages, spt_destroy_func);
   lock_release(&s->spt_lock);
 }
 
@@ -176,66 +178,64 @@ void spt_destroy(void* spt) {
    
    Implementation:
    1. Round down upage to page boundary (ensures we find the right entry)
-   2. Create a temporary key entry with the rounded address
-   3. Use hash_find() to locate the entry in O(1) average time
-   4. Convert hash_elem back to spt_entry using hash_entry() macro
+   2. Use rhash_find() with the rounded address as the key
    
    The rounding is important because addresses within a page should all
    map to the same entry (one entry per page, not per byte). */
 void* spt_find(void* spt, void* upage) {
   struct spt* s = (struct spt*)spt;
-  struct spt_entry key;
-  struct hash_elem* e;
 
-  key.upage = pg_round_down(upage);
-  e = hash_find(&s->pages, &key.hash_elem);
-  return e ? hash_entry(e, struct spt_entry, hash_elem) : NULL;
+  upage = pg_round_down(upage);
+  return rhash_find(&s->pages, spt_hash(upage), upage);
 }
 
 /* Insert a new SPT entry.
    
    Implementation:
-   1. Call hash_insert() which checks for duplicates
-   2. If duplicate exists, hash_insert() returns the old element
-   3. Return true only if no duplicate (old == NULL)
+   1. Call rhash_insert() which checks for duplicates
+   2. It returns false if a duplicate exists or the table cannot grow
    
    The entry must have entry->upage set and page-aligned. The entry
-   structure must be allocated with malloc() as it will be freed by
+   structure must be allocated with spt_entry_alloc() as it will be freed by
    the SPT when removed or destroyed. */
 bool spt_insert(void* spt, void* entry) {
   struct spt* s = (struct spt*)spt;
   struct spt_entry* e = (struct spt_entry*)entry;
-  struct hash_elem* old;
 
-  old = hash_insert(&s->pages, &e->hash_elem);
-  return old == NULL; /* Success if no duplicate */
+  return rhash_insert(&s->pages, spt_hash(e->upage), e->upage, e);
+}
+
+/* Remove ENTRY from the SPT without freeing it.
+   
+   Implementation: deletes by ENTRY's own key, so no lookup is needed first. */
+void spt_detach(void* spt, void* entry) {
+  struct spt* s = (struct spt*)spt;
+  struct spt_entry* e = (struct spt_entry*)entry;
+  void* removed UNUSED;
+
+  removed = rhash_delete(&s->pages, spt_hash(e->upage), e->upage);
+  ASSERT(removed == e);
 }
 
 /* Remove the SPT entry for UPAGE.
    
    Implementation:
-   1. Find the entry (using same key-based lookup as spt_find)
+   1. Delete the entry from the hash table by key
    2. If not found, return false
-   3. Delete from hash table
-   4. Free resources based on status (frame or swap slot)
+   3. Free resources based on status (frame or swap slot)
    5. Free the entry structure
    
    This function performs the same resource cleanup as spt_destroy_func(),
    but is called explicitly rather than during table destruction. */
 bool spt_remove(void* spt, void* upage) {
   struct spt* s = (struct spt*)spt;
-  struct spt_entry key;
-  struct hash_elem* e;
   struct spt_entry* entry;
 
-  key.upage = pg_round_down(upage);
-  e = hash_find(&s->pages, &key.hash_elem);
-  if (e == NULL)
+  upage = pg_round_down(upage);
+  entry = rhash_delete(&s->pages, spt_hash(upage), upage);
+  if (entry == NULL)
     return false;
 
-  entry = hash_entry(e, struct spt_entry, hash_elem);
-  hash_delete(&s->pages, e);
-
   /* Free resources based on page status. */
   if (entry->status == PAGE_FRAME) {
     frame_free(entry->kpage);
@@ -244,7 +244,7 @@ bool spt_remove(void* spt, void* upage) {
   }
 
   /* Free the entry itself. */
-  free(entry);
+  spt_entry_free(entry);
   return true;
 }
 
@@ -307,7 +307,7 @@ bool spt_load_page(void* entry) {
   switch (e->status) {
     case PAGE_ZERO:
       /* Zero the frame. */
-      memset(kpage, 0, PGSIZE);
+      clear_page(kpage);
       success = true;
       break;
 
@@ -336,7 +336,8 @@ bool spt_load_page(void* entry) {
 
     case PAGE_FRAME:
     case PAGE_COW:
-      /* Page already loaded - should not happen. */
+    case PAGE_SHARED:
+      /* Page already loaded, or not ours to load (shm_fault) - should not happen. */
       frame_free(kpage);
       return false;
   }
@@ -399,7 +400,7 @@ bool spt_create_file_page(void* spt, void* upage, struct file* file, off_t offse
   upage = pg_round_down(upage);
 
   /* Allocate a new spt_entry. */
-  entry = (struct spt_entry*)malloc(sizeof(struct spt_entry));
+  entry = spt_entry_alloc();
   if (entry == NULL)
     return false;
 
@@ -415,12 +416,13 @@ bool spt_create_file_page(void* spt, void* upage, struct file* file, off_t offse
   /* Initialize unused fields. */
   entry->kpage = NULL;
   entry->swap_slot = 0;
+  entry->shm = NULL;
   entry->is_mmap = false;      /* Executable pages, not mmap */
   entry->pinned_dirty = false; /* Not loaded from swap */
 
   /* Insert into SPT. */
   if (!spt_insert(spt, entry)) {
-    free(entry);
+    spt_entry_free(entry);
     return false;
   }
 
@@ -447,7 +449,7 @@ bool spt_create_zero_page(void* spt, void* upage, bool writable) {
   upage = pg_round_down(upage);
 
   /* Allocate a new spt_entry. */
-  entry = (struct spt_entry*)malloc(sizeof(struct spt_entry));
+  entry = spt_entry_alloc();
   if (entry == NULL)
     return false;
 
@@ -463,12 +465,45 @@ bool spt_create_zero_page(void* spt, void* upage, bool writable) {
   entry->file_offset = 0;
   entry->read_bytes = 0;
   entry->zero_bytes = 0;
+  entry->shm = NULL;
   entry->is_mmap = false;      /* Not an mmap page */
   entry->pinned_dirty = false; /* Not loaded from swap */
 
   /* Insert into SPT. */
   if (!spt_insert(spt, entry)) {
-    free(entry);
+    spt_entry_free(entry);
+    return false;
+  }
+
+  return true;
+}
+
+/* Create an SPT entry for a page of a shared memory object.
+
+   The entry only records which object backs the page; page contents,
+   frame and swap slot live in the object (see vm/shm.c). */
+bool spt_create_shared_page(void* spt, void* upage, struct shm_object* shm) {
+  struct spt_entry* entry = spt_entry_alloc();
+  if (entry == NULL)
+    return false;
+
+  entry->upage = pg_round_down(upage);
+  entry->status = PAGE_SHARED;
+  entry->writable = true;
+  entry->shm = shm;
+
+  /* Initialize unused fields. */
+  entry->kpage = NULL;
+  entry->swap_slot = 0;
+  entry->file = NULL;
+  entry->file_offset = 0;
+  entry->read_bytes = 0;
+  entry->zero_bytes = 0;
+  entry->is_mmap = true;
+  entry->pinned_dirty = false;
+
+  if (!spt_insert(spt, entry)) {
+    spt_entry_free(entry);
     return false;
   }
 
@@ -483,7 +518,7 @@ bool spt_create_zero_page(void* spt, void* upage, bool writable) {
    Returns the cloned entry on success, NULL on failure. */
 static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_t* child_pagedir,
                                          uint32_t* parent_pagedir) {
-  struct spt_entry* child_entry = malloc(sizeof(struct spt_entry));
+  struct spt_entry* child_entry = spt_entry_alloc();
   if (child_entry == NULL)
     return NULL;
 
@@ -498,6 +533,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
   child_entry->pinned_dirty = parent_entry->pinned_dirty;
   child_entry->kpage = NULL;
   child_entry->swap_slot = 0;
+  child_entry->shm = NULL;
 
   switch (parent_entry->status) {
     case PAGE_ZERO:
@@ -521,7 +557,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
 
       /* 1. Map parent's frame into child's page directory (read-only). */
       if (!pagedir_set_page(child_pagedir, child_entry->upage, parent_entry->kpage, false)) {
-        free(child_entry);
+        spt_entry_free(child_entry);
         return NULL;
       }
 
@@ -543,7 +579,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
          This avoids sharing swap slots between processes. */
       void* temp_kpage = frame_alloc(child_entry->upage);
       if (temp_kpage == NULL) {
-        free(child_entry);
+        spt_entry_free(child_entry);
         return NULL;
       }
 
@@ -561,7 +597,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
         }
         /* If restore also fails, parent data is lost - nothing we can do. */
         frame_free(temp_kpage);
-        free(child_entry);
+        spt_entry_free(child_entry);
         return NULL;
       }
       /* Update parent's swap slot (cast away const for this special case). */
@@ -573,7 +609,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
 
       if (child_slot == SWAP_SLOT_INVALID) {
         /* Child swap failed. Parent is OK (has parent_new_slot). */
-        free(child_entry);
+        spt_entry_free(child_entry);
         return NULL;
       }
 
@@ -583,7 +619,7 @@ static struct spt_entry* spt_clone_entry(struct spt_entry* parent_entry, uint32_
     }
 
     default:
-      free(child_entry);
+      spt_entry_free(child_entry);
       return NULL;
   }
 
@@ -615,15 +651,19 @@ bool spt_clone(void* child_spt, void* parent_spt, uint32_t* child_pagedir,
                uint32_t* parent_pagedir) {
   struct spt* parent = (struct spt*)parent_spt;
   struct spt* child = (struct spt*)child_spt;
-  struct hash_iterator i;
+  struct rhash_iterator i;
+  struct spt_entry* parent_entry;
 
   /* Pass 1: Create all child entries.
      Hold parent's spt_lock to prevent concurrent eviction from modifying entries. */
   lock_acquire(&parent->spt_lock);
 
-  hash_first(&i, &parent->pages);
-  while (hash_next(&i)) {
-    struct spt_entry* parent_entry = hash_entry(hash_cur(&i), struct spt_entry, hash_elem);
+  rhash_first(&i, &parent->pages);
+  while ((parent_entry = rhash_next(&i)) != NULL) {
+    /* Shared pages are not copied at all: mmap_inherit() attaches the
+       child to the same object after the SPT is cloned. */
+    if (parent_entry->status == PAGE_SHARED)
+      continue;
 
     /* For PAGE_FRAME/PAGE_COW entries, pin the frame first to prevent eviction.
        This must be done while holding spt_lock so the status doesn't change. */
@@ -667,7 +707,7 @@ bool spt_clone(void* child_spt, void* parent_spt, uint32_t* child_pagedir,
         frame_free(child_entry->kpage); /* Decrements ref_count */
       else if (child_entry->status == PAGE_SWAP)
         swap_free(child_entry->swap_slot);
-      free(child_entry);
+      spt_entry_free(child_entry);
       lock_release(&parent->spt_lock);
       return false;
     }
@@ -676,9 +716,8 @@ bool spt_clone(void* child_spt, void* parent_spt, uint32_t* child_pagedir,
   /* Pass 2: Mark parent PAGE_FRAME entries as PAGE_COW.
      Only runs after all child entries are successfully created.
      Still holding parent->spt_lock from Pass 1. */
-  hash_first(&i, &parent->pages);
-  while (hash_next(&i)) {
-    struct spt_entry* parent_entry = hash_entry(hash_cur(&i), struct spt_entry, hash_elem);
+  rhash_first(&i, &parent->pages);
+  while ((parent_entry = rhash_next(&i)) != NULL) {
     if (parent_entry->status == PAGE_FRAME) {
       parent_entry->status = PAGE_COW;
     }
@@ -27,8 +27,9 @@
  *
  * DATA STRUCTURE:
  * ---------------
- * This implementation uses a hash table (lib/kernel/hash.h) for O(1) average
- * lookup time. The hash table is keyed by user virtual address (page-aligned).
+ * This implementation uses an open-addressing hash table (lib/kernel/rhash.h)
+ * for O(1) average lookup time. The hash table is keyed by user virtual
+ * address (page-aligned) and stores pointers to the entries.
  * This is optimal for sparse address spaces where most virtual pages are
  * unused.
  *
@@ -38,6 +39,8 @@
  *   2. PAGE_FILE:   Page backed by file (executable or mmap)
  *   3. PAGE_SWAP:   Page swapped out to disk
  *   4. PAGE_FRAME:  Page loaded in physical memory
+ *   5. PAGE_COW:    Frame shared with a fork relative until written
+ *   6. PAGE_SHARED: Page of a shared memory object (vm/shm.h)
  *
  * INTEGRATION:
  * ------------
@@ -55,11 +58,12 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "filesys/off_t.h"
-#include "lib/kernel/hash.h"
+#include "lib/kernel/rhash.h"
 #include "threads/synch.h"
 
 /* Forward declarations. */
 struct file;
+struct shm_object;
 
 /* ============================================================================
  * PAGE STATUS
@@ -79,8 +83,11 @@ enum page_status {
                  The file, file_offset, read_bytes, and zero_bytes fields
                  specify how to load the page. */
   ,
-  PAGE_COW /* Page is marked for copy-on-write. Shared until a write occurs,
+  PAGE_COW, /* Page is marked for copy-on-write. Shared until a write occurs,
                 at which point a private copy is made for the process. */
+  PAGE_SHARED /* Page of a MAP_SHARED / shm object.  The object, not the
+                 entry, owns the frame or swap slot; the entry stays
+                 PAGE_SHARED whether or not the page is resident. */
 };
 
 /* ============================================================================
@@ -93,12 +100,13 @@ enum page_status {
  *
  * FIELD USAGE BY STATUS:
  * ----------------------
- * All entries use: upage, status, writable, hash_elem
+ * All entries use: upage, status, writable
  *
  * PAGE_ZERO:  Only core fields used (no additional data needed)
  * PAGE_FRAME: kpage points to the physical frame
  * PAGE_SWAP:  swap_slot contains the swap slot index
  * PAGE_FILE:  file, file_offset, read_bytes, zero_bytes specify file data
+ * PAGE_SHARED: shm points to the shared memory object
  */
 
 struct spt_entry {
@@ -129,6 +137,10 @@ struct spt_entry {
   size_t read_bytes; /* Number of bytes to read from file */
   size_t zero_bytes; /* Number of bytes to zero-fill after read_bytes */
 
+  /* For PAGE_SHARED: the shared memory object backing this page.
+     The owning mmap region holds the reference. */
+  struct shm_object* shm;
+
   /* Whether this is an mmap page (vs executable segment).
      Mmap pages are written back to file on eviction/unmap.
      Executable pages go to swap on eviction (never written back). */
@@ -140,10 +152,6 @@ struct spt_entry {
      The hardware dirty bit can be unreliable due to TLB caching,
      so this provides a guaranteed fallback. */
   bool pinned_dirty;
-
-  /* Hash table element for storing in the hash table.
-     Used internally by the hash table implementation. */
-  struct hash_elem hash_elem;
 };
 
 /* ============================================================================
@@ -165,7 +173,7 @@ struct spt_entry {
 struct spt {
   /* Hash table of spt_entry structures, keyed by user virtual address.
      Provides O(1) average-case lookup time. */
-  struct hash pages;
+  struct rhash pages;
 
   /* Lock protecting concurrent access to this SPT.
      Used during frame eviction when modifying entries from another thread. */
@@ -176,6 +184,17 @@ struct spt {
  * SPT LIFECYCLE
  * ============================================================================ */
 
+/* Initialize the slab cache that SPT entries are allocated from.
+   Called once from vm_init(), before any process is created. */
+void spt_cache_init(void);
+
+/* Allocate an uninitialized SPT entry, or return NULL. */
+struct spt_entry* spt_entry_alloc(void);
+
+/* Free an SPT entry allocated by spt_entry_alloc() that is not (or no
+   longer) in any table.  Does not release the entry's frame or swap slot. */
+void spt_entry_free(struct spt_entry* entry);
+
 /* Initialize a supplemental page table for a new process.
    
    This function initializes the hash table used to store SPT entries.
@@ -239,10 +258,21 @@ void* spt_find(void* spt, void* upage);
    @pre entry->upage does not already exist in the table
    @post Entry is owned by the SPT and will be freed by spt_destroy()
    
-   The entry must be allocated with malloc() and will be freed automatically
+   The entry must be allocated with spt_entry_alloc() and will be freed automatically
    when removed or when the SPT is destroyed. */
 bool spt_insert(void* spt, void* entry);
 
+/* Remove ENTRY from the SPT without freeing it or its resources.
+   
+   @param spt Pointer to an initialized struct spt.
+   @param entry An entry currently in the SPT.
+   
+   @pre Caller holds spt->spt_lock
+   @post Entry is owned by the caller, who must free it with spt_entry_free()
+   
+   Used by munmap, which writes back and frees the page outside the lock. */
+void spt_detach(void* spt, void* entry);
+
 /* Remove the SPT entry for UPAGE.
    
    Removes the entry from the SPT and frees associated resources:
@@ -356,6 +386,20 @@ bool spt_create_file_page(void* spt, void* upage, struct file* file, off_t offse
    when handling page faults below the stack pointer. */
 bool spt_create_zero_page(void* spt, void* upage, bool writable);
 
+/* Create an SPT entry for a page of shared memory object SHM.
+
+   @param spt Pointer to an initialized struct spt.
+   @param upage User virtual address (automatically rounded to page boundary).
+   @param shm Shared memory object; the caller's mapping keeps it alive.
+
+   @return true if entry was created and inserted, false on failure.
+
+   @post Entry is in SPT with status PAGE_SHARED
+
+   Used by mmap for MAP_SHARED regions.  Faults on the entry are resolved
+   by shm_fault(). */
+bool spt_create_shared_page(void* spt, void* upage, struct shm_object* shm);
+
 /* ============================================================================
  * FORK SUPPORT
  * ============================================================================ */
@@ -368,6 +412,7 @@ bool spt_create_zero_page(void* spt, void* upage, bool writable);
    - PAGE_FILE:  Copy the file metadata (lazy loading preserved)
    - PAGE_SWAP:  Copy swap data to a new swap slot
    - PAGE_ZERO:  Copy the entry (lazy loading preserved)
+   - PAGE_SHARED: Skipped; shared regions are re-attached by mmap_inherit()
 
    @param child_spt Pointer to child's initialized (empty) SPT.
    @param parent_spt Pointer to parent's SPT to clone.
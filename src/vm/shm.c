@@ -0,0 +1,382 @@
+/*
+ * ============================================================================
+ *                        SHARED MEMORY OBJECTS
+ * ============================================================================
+ *
+ * IMPLEMENTATION NOTES:
+ * ---------------------
+ * Objects are malloc'd with a separately allocated page array.  Named
+ * objects sit on a global list searched linearly (there are few of them).
+ * Each mapping records the mapping process, the user base address and the
+ * range of object pages it covers, which is all the clock needs to find
+ * every PTE that points at a shared frame.
+ *
+ * ============================================================================
+ */
+
+#include "vm/shm.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include <list.h>
+#include <round.h>
+#include <string.h>
+
+/* One page of a shared object. */
+struct shm_page {
+  void* kpage;      /* Resident frame, or NULL. */
+  size_t swap_slot; /* Swap slot while swapped out, else SWAP_SLOT_INVALID. */
+};
+
+/* One process's mapping of (part of) an object. */
+struct shm_mapping {
+  struct process* pcb;   /* Mapping process. */
+  void* base;            /* User address of object page FIRST_PAGE. */
+  size_t first_page;     /* First object page covered. */
+  size_t page_count;     /* Number of object pages covered. */
+  struct list_elem elem; /* Element in shm_object.mappings. */
+};
+
+struct shm_object {
+  char name[SHM_NAME_MAX + 1]; /* Name, or empty for unnamed objects. */
+  bool linked;                 /* On shm_list (name is visible)? */
+  int ref_count;               /* Mappings + descriptors + name link. */
+  size_t page_count;           /* Number of pages. */
+  struct shm_page* pages;      /* PAGE_COUNT page states. */
+  struct list mappings;        /* List of struct shm_mapping. */
+  struct lock lock;            /* Protects pages[] and mappings. */
+  struct list_elem elem;       /* Element in shm_list if linked. */
+};
+
+/* Named objects, protected by shm_list_lock. */
+static struct list shm_list;
+static struct lock shm_list_lock;
+
+/* ============================================================================
+ * INTERNAL HELPERS
+ * ============================================================================ */
+
+/* Allocates an object of PAGE_COUNT untouched pages with REF_COUNT
+   references, or returns NULL. */
+static struct shm_object* object_alloc(size_t page_count, int ref_count) {
+  struct shm_object* obj = malloc(sizeof *obj);
+  if (obj == NULL)
+    return NULL;
+
+  obj->pages = malloc(page_count * sizeof *obj->pages);
+  if (obj->pages == NULL) {
+    free(obj);
+    return NULL;
+  }
+  for (size_t i = 0; i < page_count; i++) {
+    obj->pages[i].kpage = NULL;
+    obj->pages[i].swap_slot = SWAP_SLOT_INVALID;
+  }
+
+  obj->name[0] = '\0';
+  obj->linked = false;
+  obj->ref_count = ref_count;
+  obj->page_count = page_count;
+  list_init(&obj->mappings);
+  lock_init(&obj->lock);
+  return obj;
+}
+
+/* Frees OBJ and all its frames and swap slots.  OBJ must have no
+   references left.  Holds the object lock while releasing frames so a
+   concurrent clock scan that already picked one of them backs off. */
+static void object_free(struct shm_object* obj) {
+  ASSERT(list_empty(&obj->mappings));
+
+  lock_acquire(&obj->lock);
+  for (size_t i = 0; i < obj->page_count; i++) {
+    struct shm_page* page = &obj->pages[i];
+    if (page->kpage != NULL)
+      frame_free(page->kpage);
+    else if (page->swap_slot != SWAP_SLOT_INVALID)
+      swap_free(page->swap_slot);
+  }
+  lock_release(&obj->lock);
+
+  free(obj->pages);
+  free(obj);
+}
+
+/* Returns the named object called NAME, or NULL.
+   Must be called with shm_list_lock held. */
+static struct shm_object* lookup_name(const char* name) {
+  struct list_elem* e;
+  for (e = list_begin(&shm_list); e != list_end(&shm_list); e = list_next(e)) {
+    struct shm_object* obj = list_entry(e, struct shm_object, elem);
+    if (strcmp(obj->name, name) == 0)
+      return obj;
+  }
+  return NULL;
+}
+
+/* Returns true if NAME is a usable object name. */
+static bool name_valid(const char* name) {
+  size_t len = strnlen(name, SHM_NAME_MAX + 1);
+  return len > 0 && len <= SHM_NAME_MAX;
+}
+
+/* Returns the user address at which mapping M maps object page IDX,
+   or NULL if M does not cover IDX. */
+static void* mapping_upage(const struct shm_mapping* m, size_t idx) {
+  if (idx < m->first_page || idx >= m->first_page + m->page_count)
+    return NULL;
+  return (uint8_t*)m->base + (idx - m->first_page) * PGSIZE;
+}
+
+/* Returns the current process's mapping of OBJ that covers UPAGE, or NULL.
+   Must be called with OBJ's lock held. */
+static struct shm_mapping* find_mapping(struct shm_object* obj, struct process* pcb,
+                                        void* upage) {
+  struct list_elem* e;
+  for (e = list_begin(&obj->mappings); e != list_end(&obj->mappings); e = list_next(e)) {
+    struct shm_mapping* m = list_entry(e, struct shm_mapping, elem);
+    uint8_t* start = m->base;
+    if (m->pcb == pcb && (uint8_t*)upage >= start &&
+        (uint8_t*)upage < start + m->page_count * PGSIZE)
+      return m;
+  }
+  return NULL;
+}
+
+/* ============================================================================
+ * OBJECT LIFECYCLE
+ * ============================================================================ */
+
+void shm_init(void) {
+  list_init(&shm_list);
+  lock_init(&shm_list_lock);
+}
+
+struct shm_object* shm_create(size_t page_count) {
+  if (page_count == 0)
+    return NULL;
+  return object_alloc(page_count, 1);
+}
+
+struct shm_object* shm_open(const char* name, size_t size) {
+  if (!name_valid(name))
+    return NULL;
+
+  lock_acquire(&shm_list_lock);
+  struct shm_object* obj = lookup_name(name);
+  if (obj != NULL) {
+    shm_ref(obj);
+  } else if (size > 0) {
+    /* One reference for the name, one for the caller. */
+    obj = object_alloc(DIV_ROUND_UP(size, PGSIZE), 2);
+    if (obj != NULL) {
+      strlcpy(obj->name, name, sizeof obj->name);
+      obj->linked = true;
+      list_push_back(&shm_list, &obj->elem);
+    }
+  }
+  lock_release(&shm_list_lock);
+  return obj;
+}
+
+bool shm_unlink(const char* name) {
+  if (!name_valid(name))
+    return false;
+
+  lock_acquire(&shm_list_lock);
+  struct shm_object* obj = lookup_name(name);
+  if (obj != NULL) {
+    list_remove(&obj->elem);
+    obj->linked = false;
+  }
+  lock_release(&shm_list_lock);
+
+  if (obj == NULL)
+    return false;
+  shm_unref(obj); /* The name's reference. */
+  return true;
+}
+
+void shm_ref(struct shm_object* obj) {
+  enum intr_level old_level = intr_disable();
+  obj->ref_count++;
+  intr_set_level(old_level);
+}
+
+void shm_unref(struct shm_object* obj) {
+  enum intr_level old_level = intr_disable();
+  bool last = --obj->ref_count == 0;
+  intr_set_level(old_level);
+
+  if (last)
+    object_free(obj);
+}
+
+size_t shm_page_count(const struct shm_object* obj) { return obj->page_count; }
+
+/* ============================================================================
+ * MAPPINGS
+ * ============================================================================ */
+
+bool shm_attach(struct shm_object* obj, void* base, size_t first_page, size_t page_count) {
+  ASSERT(first_page + page_count <= obj->page_count);
+
+  struct shm_mapping* m = malloc(sizeof *m);
+  if (m == NULL)
+    return false;
+  m->pcb = thread_current()->pcb;
+  m->base = base;
+  m->first_page = first_page;
+  m->page_count = page_count;
+
+  shm_ref(obj);
+  lock_acquire(&obj->lock);
+  list_push_back(&obj->mappings, &m->elem);
+  lock_release(&obj->lock);
+  return true;
+}
+
+void shm_detach(struct shm_object* obj, void* base) {
+  struct process* pcb = thread_current()->pcb;
+
+  lock_acquire(&obj->lock);
+  struct shm_mapping* m = find_mapping(obj, pcb, base);
+  if (m != NULL) {
+    /* Clear PTEs while holding the lock so the frames cannot be evicted
+       and reused before this process's view of them is gone. */
+    for (size_t i = 0; i < m->page_count; i++)
+      pagedir_clear_page(pcb->pagedir, (uint8_t*)m->base + i * PGSIZE);
+    list_remove(&m->elem);
+  }
+  lock_release(&obj->lock);
+
+  if (m != NULL) {
+    free(m);
+    shm_unref(obj);
+  }
+}
+
+/* ============================================================================
+ * FAULTS AND EVICTION
+ * ============================================================================ */
+
+bool shm_fault(struct shm_object* obj, void* upage, enum vmstat_fault* type) {
+  struct process* pcb = thread_current()->pcb;
+  void* kpage = NULL; /* Frame allocated for page KPAGE_IDX, if any. */
+  size_t kpage_idx = 0;
+  struct shm_mapping* m;
+  struct shm_page* page;
+  size_t idx;
+  bool success = false;
+
+  lock_acquire(&obj->lock);
+
+retry:
+  m = find_mapping(obj, pcb, upage);
+  if (m == NULL)
+    goto done;
+
+  /* Another thread of this process may have mapped it already. */
+  if (pagedir_get_page(pcb->pagedir, upage) != NULL) {
+    *type = VMSTAT_FAULT_SHARED;
+    success = true;
+    goto done;
+  }
+
+  idx = m->first_page + ((uint8_t*)upage - (uint8_t*)m->base) / PGSIZE;
+  page = &obj->pages[idx];
+
+  if (page->kpage == NULL && (kpage == NULL || kpage_idx != idx)) {
+    /* Allocating may evict, and evicting a page of this object
+       try-acquires its lock, which we must not hold then.  So allocate
+       unlocked and start over: the mapping may have changed or another
+       process may have brought the page in meanwhile.  The new frame is
+       pinned, so the clock leaves it alone until it is filled. */
+    lock_release(&obj->lock);
+    frame_free(kpage);
+    kpage = frame_alloc_shared(obj, idx);
+    kpage_idx = idx;
+    lock_acquire(&obj->lock);
+    if (kpage == NULL)
+      goto done;
+    goto retry;
+  }
+
+  if (page->kpage != NULL) {
+    /* Resident through another mapping: just map it here. */
+    *type = VMSTAT_FAULT_SHARED;
+  } else {
+    if (page->swap_slot != SWAP_SLOT_INVALID) {
+      swap_in(page->swap_slot, kpage);
+      page->swap_slot = SWAP_SLOT_INVALID;
+      *type = VMSTAT_FAULT_SWAP;
+    } else {
+      *type = VMSTAT_FAULT_ZERO; /* frame_alloc_shared() zeroes the frame. */
+    }
+    page->kpage = kpage;
+    frame_unpin(kpage);
+    kpage = NULL;
+  }
+
+  success = pagedir_set_page(pcb->pagedir, upage, page->kpage, true);
+
+done:
+  lock_release(&obj->lock);
+  frame_free(kpage); /* Not needed after all. */
+  return success;
+}
+
+enum shm_evict_result shm_evict_page(struct shm_object* obj, size_t page_idx, void* kpage) {
+  struct list_elem* e;
+
+  if (!lock_try_acquire(&obj->lock))
+    return SHM_EVICT_BUSY;
+  ASSERT(obj->pages[page_idx].kpage == kpage);
+
+  /* Second chance if any mapping used the page since the last pass. */
+  bool accessed = false;
+  for (e = list_begin(&obj->mappings); e != list_end(&obj->mappings); e = list_next(e)) {
+    struct shm_mapping* m = list_entry(e, struct shm_mapping, elem);
+    void* upage = mapping_upage(m, page_idx);
+    uint32_t* pd = m->pcb->pagedir;
+    if (upage != NULL && pd != NULL && pagedir_get_page(pd, upage) != NULL &&
+        pagedir_is_accessed(pd, upage)) {
+      pagedir_set_accessed(pd, upage, false);
+      accessed = true;
+    }
+  }
+  if (accessed) {
+    lock_release(&obj->lock);
+    return SHM_EVICT_SECOND;
+  }
+
+  /* Unmap everywhere before copying so no store can slip in after the
+     copy; any access now faults and waits on the object lock. */
+  for (e = list_begin(&obj->mappings); e != list_end(&obj->mappings); e = list_next(e)) {
+    struct shm_mapping* m = list_entry(e, struct shm_mapping, elem);
+    void* upage = mapping_upage(m, page_idx);
+    if (upage != NULL && m->pcb->pagedir != NULL)
+      pagedir_clear_page(m->pcb->pagedir, upage);
+  }
+  pagedir_activate(active_pd()); /* Flush stale TLB entries. */
+
+  /* Shared pages are writable by someone by construction, so always keep
+     their contents.  If swap is full the page stays resident, unmapped;
+     the next access simply maps it again. */
+  size_t slot = swap_out(kpage);
+  if (slot == SWAP_SLOT_INVALID) {
+    lock_release(&obj->lock);
+    return SHM_EVICT_BUSY;
+  }
+
+  obj->pages[page_idx].kpage = NULL;
+  obj->pages[page_idx].swap_slot = slot;
+  lock_release(&obj->lock);
+  return SHM_EVICT_DONE;
+}
@@ -0,0 +1,117 @@
+/*
+ * ============================================================================
+ *                        SHARED MEMORY OBJECTS
+ * ============================================================================
+ *
+ * A shared memory object is a fixed-size array of pages that every mapping
+ * of the object sees identically: a store through one process's mapping is
+ * visible through all others, with no copying.  Objects come from two
+ * places:
+ *
+ *   - mmap2(..., MAP_SHARED | MAP_ANONYMOUS, -1, 0) creates an unnamed
+ *     object that lives as long as some mapping of it does.  Mappings are
+ *     inherited across fork(), which is how related processes share it.
+ *
+ *   - shm_open(name, size) creates or opens a named object and returns a
+ *     file descriptor for it; mmap2(..., MAP_SHARED, fd, offset) maps it.
+ *     The name stays valid until shm_unlink(name).
+ *
+ * PAGE STATE:
+ * -----------
+ * Each page of an object is in one of three states, independent of how
+ * many processes map it:
+ *
+ *   - untouched: neither kpage nor swap slot; zero-filled on first fault
+ *   - resident:  kpage is a frame owned by the object (see frame.h)
+ *   - swapped:   swap_slot holds the contents; one slot per page, no
+ *                matter how many processes map it
+ *
+ * Process SPT entries for shared pages carry status PAGE_SHARED and a
+ * pointer to the object; they never own a frame or swap slot.  A fault
+ * on such an entry makes the page resident (if needed) and installs the
+ * object's frame in the faulting process's page directory.
+ *
+ * EVICTION:
+ * ---------
+ * A resident shared frame is a clock candidate like any other.  The clock
+ * asks shm_evict_page(), which gives the page a second chance if any
+ * mapping's accessed bit is set, and otherwise clears every mapping's PTE
+ * and writes the page to its swap slot.
+ *
+ * LIFETIME AND LOCKING:
+ * ---------------------
+ * An object is reference-counted: one reference per mapping, per open
+ * file description, and one for its name while linked.  Reference counts
+ * are updated with interrupts disabled so they may be taken under any
+ * lock.  Page state and the mapping list are protected by the object's
+ * lock.  Lock ordering: object lock -> frame_lock; the clock, which holds
+ * frame_lock, only ever tries the object lock and skips the frame if busy.
+ *
+ * ============================================================================
+ */
+
+#ifndef VM_SHM_H
+#define VM_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vm/vmstat.h"
+
+struct shm_object;
+struct process;
+
+/* Maximum length of a shared memory object name. */
+#define SHM_NAME_MAX 14
+
+/* Initialize the shared memory subsystem.  Called once from vm_init(). */
+void shm_init(void);
+
+/* Create an unnamed object of PAGE_COUNT zero-filled pages.
+   Returns the object holding one reference for the caller, or NULL. */
+struct shm_object* shm_create(size_t page_count);
+
+/* Open the object called NAME, creating it with SIZE bytes (rounded up
+   to whole pages) if it does not exist.  Returns the object holding one
+   reference for the caller, or NULL if NAME is invalid, SIZE is zero
+   when creating, or memory is exhausted. */
+struct shm_object* shm_open(const char* name, size_t size);
+
+/* Remove NAME from the namespace.  Existing mappings and descriptors
+   keep the object alive.  Returns false if NAME does not exist. */
+bool shm_unlink(const char* name);
+
+/* Take or drop a reference to OBJ.  Dropping the last reference frees
+   the object's frames and swap slots. */
+void shm_ref(struct shm_object* obj);
+void shm_unref(struct shm_object* obj);
+
+/* Number of pages in OBJ. */
+size_t shm_page_count(const struct shm_object* obj);
+
+/* Record that the current process maps PAGE_COUNT pages of OBJ, starting
+   at object page FIRST_PAGE, at user address BASE.  Takes a reference.
+   Returns false on allocation failure. */
+bool shm_attach(struct shm_object* obj, void* base, size_t first_page, size_t page_count);
+
+/* Undo shm_attach() for the mapping of OBJ at BASE in the current process:
+   clears its page-table entries and drops the mapping's reference. */
+void shm_detach(struct shm_object* obj, void* base);
+
+/* Resolve a fault at user page UPAGE in the current process, which maps
+   OBJ there.  Makes the page resident if needed and installs it in the
+   page directory.  Stores the fault class in *TYPE.  Returns false if
+   UPAGE is not (or no longer) part of a mapping of OBJ, or on failure. */
+bool shm_fault(struct shm_object* obj, void* upage, enum vmstat_fault* type);
+
+/* Result of asking a shared page to leave memory. */
+enum shm_evict_result {
+  SHM_EVICT_DONE,    /* Unmapped everywhere and written to swap. */
+  SHM_EVICT_SECOND,  /* Recently accessed; accessed bits cleared. */
+  SHM_EVICT_BUSY     /* Object busy or swap full; try another frame. */
+};
+
+/* Called by the clock with frame_lock held for the frame KPAGE holding
+   page PAGE_IDX of OBJ.  Never blocks on the object lock. */
+enum shm_evict_result shm_evict_page(struct shm_object* obj, size_t page_idx, void* kpage);
+
+#endif /* vm/shm.h */
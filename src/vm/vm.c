@@ -7,11 +7,14 @@
 #include "vm/vm.h"
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/shm.h"
 #include "vm/swap.h"
+#include "vm/vmstat.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "userprog/pagedir.h"
+#include "arch/common/cpu.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -24,9 +27,15 @@ void vm_init(void) {
   /* Initialize frame table. */
   frame_init();
 
+  /* Initialize the SPT entry cache. */
+  spt_cache_init();
+
   /* Initialize swap space. */
   swap_init();
 
+  /* Initialize the shared memory object namespace. */
+  shm_init();
+
   /* TODO: Any other global VM initialization. */
 }
 
@@ -34,8 +43,26 @@ void vm_init(void) {
  * PAGE FAULT HANDLING
  * ============================================================================ */
 
+static bool handle_fault(void* fault_addr, bool user, bool write, bool not_present, void* esp,
+                         enum vmstat_fault* type);
+
 /* Handle a page fault. Returns true if handled, false if invalid.
 
+   Every call is timed with the cycle counter and recorded in the VM
+   statistics under the class of fault it turned out to be (see
+   vm/vmstat.h); faults that cannot be resolved count as invalid. */
+bool vm_handle_fault(void* fault_addr, bool user, bool write, bool not_present, void* esp) {
+  uint64_t start = cpu_cycles();
+  enum vmstat_fault type = VMSTAT_FAULT_INVALID;
+
+  bool handled = handle_fault(fault_addr, user, write, not_present, esp, &type);
+  vmstat_record_fault(handled ? type : VMSTAT_FAULT_INVALID, cpu_cycles() - start);
+  return handled;
+}
+
+/* Does the work of vm_handle_fault(), storing the class of the fault
+   in *TYPE once it is known.
+
    SYNCHRONIZATION:
    ----------------
    This function must handle races with frame eviction. Key considerations:
@@ -51,7 +78,8 @@ void vm_init(void) {
 
    Solution for COW: Use frame_pin_if_present which atomically checks and pins.
    If it fails, the frame was evicted and we treat it as a not-present fault. */
-bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_present, void* esp) {
+static bool handle_fault(void* fault_addr, bool user, bool write, bool not_present, void* esp,
+                         enum vmstat_fault* type) {
   struct thread* t = thread_current();
 
   /* Must have a valid PCB. */
@@ -91,7 +119,7 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     if (!frame_pin_if_present(old_kpage)) {
       /* Frame was evicted. The SPT entry should now be PAGE_SWAP.
          Retry as a not-present fault to load from swap. */
-      return vm_handle_fault(fault_addr, user, write, true, esp);
+      return handle_fault(fault_addr, user, write, true, esp, type);
     }
 
     /* Allocate a new frame for the private copy.
@@ -103,7 +131,7 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     }
 
     /* Copy contents from shared frame to new frame. */
-    memcpy(new_kpage, old_kpage, PGSIZE);
+    copy_page(new_kpage, old_kpage);
 
     /* Unpin old frame now that copy is complete. */
     frame_unpin(old_kpage);
@@ -127,6 +155,7 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     /* Unpin the new frame. */
     frame_unpin(new_kpage);
 
+    *type = VMSTAT_FAULT_COW;
     return true;
   }
 
@@ -141,8 +170,8 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     /* Page not in SPT. Check if this is valid stack growth.
        IMPORTANT: We hold spt_lock during spt_create_zero_page to prevent
        a race condition with frame_evict. If we released the lock here,
-       frame_evict could call spt_find (hash_find) while spt_create_zero_page
-       does hash_insert, corrupting the hash table. */
+       frame_evict could call spt_find while spt_create_zero_page
+       does spt_insert, corrupting the hash table. */
     if (vm_is_stack_access(fault_addr, esp)) {
       /* Create a zero page for stack growth while holding SPT lock. */
       if (!spt_create_zero_page(spt, fault_page, true)) {
@@ -156,6 +185,7 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
         lock_release(&spt->spt_lock);
         return false;
       }
+      *type = VMSTAT_FAULT_STACK;
     } else {
       /* Not a valid access. */
       lock_release(&spt->spt_lock);
@@ -163,6 +193,18 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     }
   }
 
+  /* Shared pages are resolved by their object, which serializes faults
+     from all mapping processes.  Hold a reference so a concurrent munmap
+     cannot free the object once spt_lock is dropped. */
+  if (spte->status == PAGE_SHARED) {
+    struct shm_object* shm = spte->shm;
+    shm_ref(shm);
+    lock_release(&spt->spt_lock);
+    bool success = shm_fault(shm, fault_page, type);
+    shm_unref(shm);
+    return success;
+  }
+
   /* Check write permission. */
   if (write && !spte->writable) {
     lock_release(&spt->spt_lock);
@@ -175,6 +217,16 @@ bool vm_handle_fault(void* fault_addr, bool user UNUSED, bool write, bool not_pr
     return false;
   }
 
+  /* Classify by where the contents come from (stack growth already set). */
+  if (*type != VMSTAT_FAULT_STACK) {
+    if (spte->status == PAGE_SWAP)
+      *type = VMSTAT_FAULT_SWAP;
+    else if (spte->status == PAGE_FILE)
+      *type = VMSTAT_FAULT_FILE;
+    else
+      *type = VMSTAT_FAULT_ZERO;
+  }
+
   /* Release lock before loading - spt_load_page calls frame_alloc which
      could trigger eviction, and eviction needs to acquire spt_lock.
      The entry's status is not PAGE_FRAME, so eviction won't touch it. */
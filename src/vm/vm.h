@@ -12,6 +12,8 @@
  *   page.c   - Supplemental page table (per-process)
  *   frame.c  - Frame table (global, tracks physical pages)
  *   swap.c   - Swap space management
+ *   vmstat.c - Fault and eviction statistics
+ *   shm.c    - Shared memory objects (MAP_SHARED, shm_open)
  *
  * INTEGRATION POINTS:
  * -------------------
@@ -0,0 +1,140 @@
+/*
+ * ============================================================================
+ *                        VM EVENT STATISTICS
+ * ============================================================================
+ */
+
+#include "vm/vmstat.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "userprog/process.h"
+#include <stdio.h>
+#include <string.h>
+
+/* System-wide counters. */
+static struct vmstat global_stats;
+
+/* Short names for each fault class, in enum vmstat_fault order. */
+static const char* fault_names[VMSTAT_FAULT_CNT] = {"zero",  "file",   "swap",   "cow",
+                                                    "stack", "shared", "invalid"};
+
+/* ============================================================================
+ * INTERNAL HELPERS
+ * ============================================================================ */
+
+/* Returns the histogram bucket for a latency of CYCLES: floor(log2(CYCLES)),
+   clamped to the last bucket. */
+static unsigned hist_bucket(uint64_t cycles) {
+  unsigned bucket = 0;
+  while (cycles > 1 && bucket < VMSTAT_HIST_BUCKETS - 1) {
+    cycles >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/* Adds one fault of class TYPE taking CYCLES to S.
+   Must be called with interrupts disabled. */
+static void add_fault(struct vmstat* s, enum vmstat_fault type, uint64_t cycles,
+                      unsigned bucket) {
+  s->faults[type]++;
+  s->fault_cycles[type] += cycles;
+  if (cycles > s->fault_max_cycles[type])
+    s->fault_max_cycles[type] = cycles;
+  s->fault_hist[type][bucket]++;
+}
+
+/* Returns the statistics block of the current process, or NULL for
+   kernel threads. */
+static struct vmstat* current_stats(void) {
+  struct thread* t = thread_current();
+  return t->pcb != NULL ? &t->pcb->vmstat : NULL;
+}
+
+/* ============================================================================
+ * RECORDING
+ * ============================================================================ */
+
+void vmstat_record_fault(enum vmstat_fault type, uint64_t cycles) {
+  ASSERT(type < VMSTAT_FAULT_CNT);
+
+  unsigned bucket = hist_bucket(cycles);
+  struct vmstat* proc = current_stats();
+
+  enum intr_level old_level = intr_disable();
+  add_fault(&global_stats, type, cycles, bucket);
+  if (proc != NULL)
+    add_fault(proc, type, cycles, bucket);
+  intr_set_level(old_level);
+}
+
+void vmstat_record_evict(struct thread* owner, enum vmstat_evict outcome) {
+  ASSERT(outcome < VMSTAT_EVICT_CNT);
+
+  enum intr_level old_level = intr_disable();
+  global_stats.evictions[outcome]++;
+  if (owner != NULL && owner->pcb != NULL)
+    owner->pcb->vmstat.evictions[outcome]++;
+  intr_set_level(old_level);
+}
+
+void vmstat_record_clock_scan(unsigned steps) {
+  enum intr_level old_level = intr_disable();
+  global_stats.clock_scans++;
+  global_stats.clock_steps += steps;
+  if (steps > global_stats.clock_max_steps)
+    global_stats.clock_max_steps = steps;
+  intr_set_level(old_level);
+}
+
+/* ============================================================================
+ * REPORTING
+ * ============================================================================ */
+
+bool vmstat_snapshot(int scope, struct vmstat* dst) {
+  const struct vmstat* src;
+
+  if (scope == VMSTAT_GLOBAL)
+    src = &global_stats;
+  else if (scope == VMSTAT_PROCESS)
+    src = current_stats();
+  else
+    return false;
+  if (src == NULL)
+    return false;
+
+  enum intr_level old_level = intr_disable();
+  memcpy(dst, src, sizeof *dst);
+  intr_set_level(old_level);
+  return true;
+}
+
+/* Prints one line per fault class that saw any faults, with average and
+   maximum latency followed by the non-empty histogram buckets as
+   "log2:count" pairs. */
+static void print_latency(const struct vmstat* s) {
+  for (int type = 0; type < VMSTAT_FAULT_CNT; type++) {
+    if (s->faults[type] == 0)
+      continue;
+    printf("VM: %s latency: avg %llu, max %llu cycles, histogram", fault_names[type],
+           s->fault_cycles[type] / s->faults[type], s->fault_max_cycles[type]);
+    for (int b = 0; b < VMSTAT_HIST_BUCKETS; b++)
+      if (s->fault_hist[type][b] != 0)
+        printf(" %d:%u", b, (unsigned)s->fault_hist[type][b]);
+    printf("\n");
+  }
+}
+
+void vmstat_print_stats(void) {
+  const struct vmstat* s = &global_stats;
+
+  printf("VM: faults:");
+  for (int type = 0; type < VMSTAT_FAULT_CNT; type++)
+    printf("%s %s %llu", type == 0 ? "" : ",", fault_names[type], s->faults[type]);
+  printf("\n");
+  printf("VM: evictions: clean %llu, swap %llu, file %llu\n", s->evictions[VMSTAT_EVICT_CLEAN],
+         s->evictions[VMSTAT_EVICT_SWAP], s->evictions[VMSTAT_EVICT_FILE]);
+  printf("VM: clock: %llu scans, %llu steps, %llu max\n", s->clock_scans, s->clock_steps,
+         s->clock_max_steps);
+  print_latency(s);
+}
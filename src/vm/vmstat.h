@@ -0,0 +1,45 @@
+/*
+ * ============================================================================
+ *                        VM EVENT STATISTICS
+ * ============================================================================
+ *
+ * Counters for page faults, evictions and clock-hand scans, kept both
+ * globally and per process (struct process.vmstat).  The record layout is
+ * shared with user programs; see lib/vmstat.h.
+ *
+ * All recording functions are safe to call from any kernel context that
+ * may sleep or not: updates are done with interrupts disabled, so they
+ * never block and never lose increments to preemption.
+ *
+ * ============================================================================
+ */
+
+#ifndef VM_VMSTAT_H
+#define VM_VMSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vmstat.h>
+
+struct thread;
+
+/* Record a fault of class TYPE that took CYCLES to resolve, charged to
+   the current process (if any) and to the global counters. */
+void vmstat_record_fault(enum vmstat_fault type, uint64_t cycles);
+
+/* Record an eviction with outcome OUTCOME of a page owned by OWNER.
+   OWNER may be NULL or have no PCB, in which case only the global
+   counters are updated. */
+void vmstat_record_evict(struct thread* owner, enum vmstat_evict outcome);
+
+/* Record one pass of the eviction clock that examined STEPS frames. */
+void vmstat_record_clock_scan(unsigned steps);
+
+/* Copy the counters selected by SCOPE (VMSTAT_GLOBAL or VMSTAT_PROCESS)
+   into DST.  Returns false if SCOPE is invalid. */
+bool vmstat_snapshot(int scope, struct vmstat* dst);
+
+/* Print global VM statistics (called at shutdown). */
+void vmstat_print_stats(void);
+
+#endif /* vm/vmstat.h */